@@ -168,6 +168,19 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* Run-time stats on the DWT cycle counter (DWT->CYCCNT, enabled by
+   binlog_start()), for the CPU load of the network benchmark only: they cost
+   a counter read on every context switch, so they follow the W5500_BENCH_ENABLE
+   project symbol. The counter is 32 bits and wraps every
+   2^32 / SystemCoreClock seconds (about 30 s at 144 MHz, 25 s at 170 MHz);
+   w5500_bench.c extends it to 64 bits every BENCH_SLICE_MS. Any other reader
+   (vTaskGetRunTimeStats()) must sample at least that often. */
+#ifdef W5500_BENCH_ENABLE
+#define configGENERATE_RUN_TIME_STATS            1
+#define INCLUDE_xTaskGetIdleTaskHandle           1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         (*(volatile uint32_t *)0xE0001004UL)
+#endif
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
@@ -0,0 +1,138 @@
+/**
+ * @file    binlog.h
+ * @brief   Deferred binary logging
+ *
+ * @details A log call stores only a 16-bit format-string ID, a DWT cycle
+ *          timestamp and up to BINLOG_MAX_ARGS raw 32-bit arguments in a
+ *          lock-free RAM ring. Format strings are placed in the non-loaded
+ *          .binlog_fmt ELF section (see STM32G431RBTX_FLASH.ld): they cost no
+ *          flash and their section offset is the ID. A low-priority drain
+ *          task streams the records to ITM stimulus port BINLOG_ITM_PORT and
+ *          tools/binlog_decode.py turns the capture back into text using the
+ *          firmware ELF.
+ *
+ *          Levels are gated at compile time per module. A module defines,
+ *          before its first log call:
+ *
+ *            #define BINLOG_MODULE        "w5500_spi"
+ *            #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ *
+ *          Calls above BINLOG_MODULE_LEVEL compile to nothing. Arguments are
+ *          integers only (%d %u %x %c ...); %s is not supported.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _BINLOG_H_
+#define _BINLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*/
+/*                         CONFIGURATION                                      */
+/*============================================================================*/
+
+#define BINLOG_LEVEL_OFF        0
+#define BINLOG_LEVEL_ERROR      1
+#define BINLOG_LEVEL_WARN       2
+#define BINLOG_LEVEL_INFO       3
+#define BINLOG_LEVEL_DEBUG      4
+
+/* Ring size in records, must be a power of two */
+#ifndef BINLOG_RING_SLOTS
+#define BINLOG_RING_SLOTS       32
+#endif
+
+#define BINLOG_MAX_ARGS         8
+
+/* ITM stimulus port used for the binary stream (port 0 carries printf) */
+#ifndef BINLOG_ITM_PORT
+#define BINLOG_ITM_PORT         1
+#endif
+
+#ifndef BINLOG_DRAIN_PERIOD_MS
+#define BINLOG_DRAIN_PERIOD_MS  10
+#endif
+
+/* Format ID emitted by the drain task when records were dropped (ring full) */
+#define BINLOG_FMT_DROPPED      0xFFFFU
+
+#ifndef BINLOG_MODULE
+#define BINLOG_MODULE           "app"
+#endif
+
+#ifndef BINLOG_MODULE_LEVEL
+#define BINLOG_MODULE_LEVEL     BINLOG_LEVEL_INFO
+#endif
+
+/*============================================================================*/
+/*                         LOGGING MACROS                                     */
+/*============================================================================*/
+
+/* Format record stored in .binlog_fmt: "<level>\x1f<module>\x1f<format>" */
+#define BINLOG_FMT_ID(lvl_str, fmt) __extension__({                               \
+        static const char _binlog_fmt[]                                           \
+            __attribute__((section(".binlog_fmt"), used)) =                       \
+            lvl_str "\x1f" BINLOG_MODULE "\x1f" fmt;                              \
+        (uint16_t)(uintptr_t)_binlog_fmt; })
+
+#define BINLOG_LOG(lvl, lvl_str, fmt, ...)                                        \
+    do {                                                                          \
+        if ((lvl) <= BINLOG_MODULE_LEVEL) {                                       \
+            const uint32_t _binlog_args[] = { 0U, ##__VA_ARGS__ };                \
+            _Static_assert(sizeof(_binlog_args) / sizeof(uint32_t) - 1U           \
+                           <= BINLOG_MAX_ARGS, "binlog: too many arguments");     \
+            binlog_write(BINLOG_FMT_ID(lvl_str, fmt),                             \
+                         (uint8_t)(sizeof(_binlog_args) / sizeof(uint32_t) - 1U), \
+                         &_binlog_args[1]);                                       \
+        }                                                                         \
+    } while (0)
+
+#define BINLOG_ERROR(fmt, ...)  BINLOG_LOG(BINLOG_LEVEL_ERROR, "E", fmt, ##__VA_ARGS__)
+#define BINLOG_WARN(fmt, ...)   BINLOG_LOG(BINLOG_LEVEL_WARN,  "W", fmt, ##__VA_ARGS__)
+#define BINLOG_INFO(fmt, ...)   BINLOG_LOG(BINLOG_LEVEL_INFO,  "I", fmt, ##__VA_ARGS__)
+#define BINLOG_DEBUG(fmt, ...)  BINLOG_LOG(BINLOG_LEVEL_DEBUG, "D", fmt, ##__VA_ARGS__)
+
+/*============================================================================*/
+/*                         API                                                */
+/*============================================================================*/
+
+/**
+ * @brief Start the binary log: enable the cycle counter and ITM port and
+ *        create the drain task
+ * @note  Call once from MX_FREERTOS_Init(). Records written before this call
+ *        are kept in the ring and drained once the scheduler runs.
+ */
+void binlog_start(void);
+
+/**
+ * @brief Append one record to the ring (lock-free, task or ISR context)
+ * @note  Use the BINLOG_* macros instead of calling this directly.
+ * @param fmt_id Format-string ID (offset in .binlog_fmt)
+ * @param nargs  Number of arguments (<= BINLOG_MAX_ARGS)
+ * @param args   Raw argument words
+ */
+void binlog_write(uint16_t fmt_id, uint8_t nargs, const uint32_t *args);
+
+/**
+ * @brief Drain every committed record to the ITM port
+ * @return Number of records drained
+ */
+uint32_t binlog_flush(void);
+
+/**
+ * @brief Number of records dropped because the ring was full
+ */
+uint32_t binlog_get_dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _BINLOG_H_ */
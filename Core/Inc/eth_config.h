@@ -19,12 +19,57 @@ static const uint8_t ETH_CONFIG_SUBNET[4]  = {255, 255, 255, 0};
 static const uint8_t ETH_CONFIG_GATEWAY[4] = {192, 168, 68, 1};
 static const uint8_t ETH_CONFIG_DNS[4]     = {8, 8, 8, 8};
 
+// === Bring-up address ===
+// Applied by w5500_spi_init() so services can start at once; DHCP swaps its
+// lease in later and goes back to it when the lease is lost.
+#define ETH_CONFIG_BRINGUP_STATIC     0   // ETH_CONFIG_IP/SUBNET/GATEWAY/DNS
+#define ETH_CONFIG_BRINGUP_LINKLOCAL  1   // 169.254.x.y from the MAC,
+                                          // probed by eth_config_claim_linklocal()
+
+#ifndef ETH_CONFIG_BRINGUP_MODE
+#define ETH_CONFIG_BRINGUP_MODE  ETH_CONFIG_BRINGUP_STATIC
+#endif
+
+// Link-local candidates eth_config_claim_linklocal() tries before giving up
+#ifndef ETH_CONFIG_LINKLOCAL_TRIES
+#define ETH_CONFIG_LINKLOCAL_TRIES  10
+#endif
+
+// === Change notification ===
+// Fields that differ from the previously applied configuration
+#define ETH_CONFIG_CHANGED_MAC   0x01U
+#define ETH_CONFIG_CHANGED_IP    0x02U
+#define ETH_CONFIG_CHANGED_SN    0x04U
+#define ETH_CONFIG_CHANGED_GW    0x08U
+#define ETH_CONFIG_CHANGED_DNS   0x10U
+#define ETH_CONFIG_CHANGED_MODE  0x20U   // wiz_NetInfo.dhcp (static <-> DHCP)
+
+#ifndef ETH_CONFIG_MAX_LISTENERS
+#define ETH_CONFIG_MAX_LISTENERS 4
+#endif
+
+/**
+ * @brief Called after a new configuration is on the chip
+ * @details Runs in the thread that applied it (usually the DHCP task): keep it
+ *          short and signal the service's own thread to close and reopen its
+ *          sockets.
+ */
+typedef void (*eth_config_listener_t)(uint32_t changed, const wiz_NetInfo* net_info, void* ctx);
+
 // === Global configuration structure ===
 extern wiz_NetInfo g_network_info;
 
 // === Configuration functions ===
 void eth_config_init_static(void);
-void eth_config_set_netinfo(const wiz_NetInfo* net_info);
+void eth_config_init_linklocal(void);
+void eth_config_init_bringup(void);
+bool eth_config_claim_linklocal(void);
+bool eth_config_set_netinfo(const wiz_NetInfo* net_info);
 void eth_config_get_netinfo(wiz_NetInfo* net_info);
+void eth_config_invalidate(void);
+
+bool eth_config_subscribe(eth_config_listener_t listener, void* ctx);
+void eth_config_unsubscribe(eth_config_listener_t listener, void* ctx);
+uint32_t eth_config_get_generation(void);
 
 #endif // _ETH_CONFIG_H_
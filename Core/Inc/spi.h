@@ -29,7 +29,8 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include <stdbool.h>
+#include "cmsis_os2.h"
 /* USER CODE END Includes */
 
 extern SPI_HandleTypeDef hspi1;
@@ -37,6 +38,31 @@ extern SPI_HandleTypeDef hspi1;
 extern SPI_HandleTypeDef hspi2;
 
 /* USER CODE BEGIN Private defines */
+extern DMA_HandleTypeDef hdma_spi2_rx;
+extern DMA_HandleTypeDef hdma_spi2_tx;
+
+/* Cycle counter for occupancy statistics (enabled by binlog_start()), shared
+ * with the drivers that time their own calls against the bus counters */
+#ifndef SPI_BUS_CYCLES
+#define SPI_BUS_CYCLES()       (DWT->CYCCNT)
+#endif
+
+/* Bus manager: one device (chip select + statistics) on a managed SPI bus.
+ * Occupancy counters are DWT cycles, updated by the bus manager only. */
+typedef struct {
+  const char         *name;
+  SPI_HandleTypeDef  *hspi;
+  GPIO_TypeDef       *cs_port;          /* NULL: hardware NSS or no CS     */
+  uint16_t            cs_pin;
+  uint32_t            transactions;     /* outermost acquire/release pairs */
+  uint32_t            bytes;            /* payload bytes clocked           */
+  uint64_t            hold_cycles;      /* bus held by this client         */
+  uint64_t            wait_cycles;      /* blocked waiting for the bus     */
+  uint32_t            max_wait_cycles;
+} spi_client_t;
+
+#define SPI_CLIENT_INIT(client_name, handle, port, pin) \
+  { .name = (client_name), .hspi = (handle), .cs_port = (port), .cs_pin = (pin) }
 
 /* USER CODE END Private defines */
 
@@ -44,7 +70,13 @@ void MX_SPI1_Init(void);
 void MX_SPI2_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+bool spi_bus_acquire(spi_client_t *client, uint32_t timeout);
+void spi_bus_release(spi_client_t *client);
+void spi_bus_select(spi_client_t *client);
+void spi_bus_deselect(spi_client_t *client);
+HAL_StatusTypeDef spi_bus_transmit(spi_client_t *client, const uint8_t *data, uint16_t len);
+HAL_StatusTypeDef spi_bus_receive(spi_client_t *client, uint8_t *data, uint16_t len);
+HAL_StatusTypeDef spi_bus_set_prescaler(spi_client_t *client, uint32_t prescaler);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
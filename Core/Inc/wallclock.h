@@ -0,0 +1,128 @@
+/**
+ * @file    wallclock.h
+ * @brief   Nanosecond timestamps from the DWT cycle counter, disciplined to UTC
+ *
+ * @details The 32-bit DWT CYCCNT (enabled by binlog_start()) is extended to
+ *          64 bits in software and scaled to nanoseconds since start-up:
+ *          wallclock_mono_ns() never jumps and never slows down. A time
+ *          source (w5500_sntp) maps it onto UTC through wallclock_correct():
+ *
+ *            now = utc0 + d + d * rate_ppb / 1e9 + slew(d),  d = mono - mono0
+ *
+ *          Every correction re-anchors (mono0, utc0) at the current instant,
+ *          so changing the rate never makes wallclock_now_ns() jump. Small
+ *          offsets are slewed in at WALLCLOCK_SLEW_MAX_PPB instead of being
+ *          stepped, which keeps timestamps monotonic while the clock is
+ *          steered.
+ *
+ *          The extension only sees a counter wrap if it is read at least
+ *          once per CYCCNT period (2^32 / SystemCoreClock, about 29.8 s
+ *          at the board's 144 MHz): wallclock_poll() from the 1000 ms task
+ *          takes care of that. Every call is safe from tasks and ISRs.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _WALLCLOCK_H_
+#define _WALLCLOCK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*/
+/*                         CONFIGURATION                                      */
+/*============================================================================*/
+
+/* Largest frequency correction accepted by wallclock_correct() */
+#define WALLCLOCK_RATE_MAX_PPB  500000
+
+/* Rate at which offsets are slewed in (500 us per second) */
+#ifndef WALLCLOCK_SLEW_MAX_PPB
+#define WALLCLOCK_SLEW_MAX_PPB  500000
+#endif
+
+#define WALLCLOCK_NS_PER_S      1000000000LL
+
+/*============================================================================*/
+/*                         API                                                */
+/*============================================================================*/
+
+/**
+ * @brief Take the core clock for the cycle to nanosecond scale
+ * @note  Call once, after binlog_start() (which zeroes CYCCNT) and with
+ *        SystemCoreClock final. The clock restarts unsynchronised.
+ */
+void wallclock_init(void);
+
+/**
+ * @brief Keep the 64-bit extension in step with CYCCNT
+ * @note  Call at least once per counter period (every 1000 ms is plenty).
+ */
+void wallclock_poll(void);
+
+/**
+ * @brief Core cycles since binlog_start() started the counter, 64 bits
+ */
+uint64_t wallclock_cycles(void);
+
+/**
+ * @brief Local monotonic time in nanoseconds, not disciplined
+ */
+uint64_t wallclock_mono_ns(void);
+
+/**
+ * @brief Map a raw CYCCNT value taken earlier (an ISR stamp) onto
+ *        wallclock_mono_ns()
+ * @note  The stamp must be less than one counter period old.
+ */
+uint64_t wallclock_stamp_to_mono_ns(uint32_t cyccnt);
+
+/**
+ * @brief Disciplined time in nanoseconds since 1970-01-01 UTC
+ * @return Monotonic time until the first wallclock_correct()
+ */
+int64_t wallclock_now_ns(void);
+
+/**
+ * @brief Map a wallclock_mono_ns() stamp taken earlier onto UTC
+ * @note  Exact for stamps since the last correction; older stamps are
+ *        mapped with the current rate.
+ */
+int64_t wallclock_to_utc_ns(uint64_t mono_ns);
+
+/**
+ * @brief Steer the clock
+ * @param offset_ns  Error to remove (reference minus wallclock_now_ns())
+ * @param rate_ppb   Frequency correction from now on, clamped to
+ *                   +-WALLCLOCK_RATE_MAX_PPB
+ * @param step       True: apply @p offset_ns at once. False: slew it in at
+ *                   WALLCLOCK_SLEW_MAX_PPB; a slew still in progress is
+ *                   replaced.
+ */
+void wallclock_correct(int64_t offset_ns, int32_t rate_ppb, bool step);
+
+/**
+ * @brief Part of the last slewed offset not applied yet
+ */
+int64_t wallclock_get_slew_left_ns(void);
+
+/**
+ * @brief Frequency correction in use
+ */
+int32_t wallclock_get_rate_ppb(void);
+
+/**
+ * @brief True once a time source has set the clock
+ */
+bool wallclock_is_synced(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WALLCLOCK_H_ */
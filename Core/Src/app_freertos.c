@@ -27,7 +27,8 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "binlog.h"
+#include "wallclock.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -135,6 +136,8 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  binlog_start();
+  wallclock_init();
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -217,6 +220,7 @@ void StartTask03(void *argument)
   for(;;)
   {
 	task03++;
+	wallclock_poll();
 	printf("Task03: %lu\n", (unsigned long)task03);
 
 	HAL_GPIO_TogglePin(GPIOA, GPIO_PIN_5);
@@ -0,0 +1,225 @@
+/**
+ * @file    binlog.c
+ * @brief   Deferred binary logging: lock-free record ring and ITM drain task
+ *
+ * @details The ring is a bounded multi-producer / single-consumer queue of
+ *          fixed-size slots. Each slot carries a sequence number: a producer
+ *          claims a slot by advancing the head with a compare-and-swap
+ *          (LDREX/STREX on the Cortex-M4) and publishes it by storing
+ *          seq = pos + 1; the drain task consumes slots in order and hands
+ *          them back with seq = pos + BINLOG_RING_SLOTS. No interrupt masking
+ *          and no mutex is involved, so tasks and ISRs can log at any time,
+ *          including before the scheduler starts. When the ring is full the
+ *          record is dropped and counted.
+ *
+ *          Sequence numbers are stored relative to the slot index so that the
+ *          zero-initialised ring is already in its "all free" state.
+ *
+ *          Wire format on the ITM port (little endian):
+ *            u8  0xB0 | nargs
+ *            u16 format ID
+ *            u32 DWT cycle counter
+ *            u32 args[nargs]
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#include "binlog.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "cmsis_os2.h"
+#include "stm32g4xx.h"
+
+/*============================================================================*/
+/*                         PRIVATE DEFINES                                    */
+/*============================================================================*/
+
+#define BINLOG_RING_MASK        (BINLOG_RING_SLOTS - 1U)
+#define BINLOG_FRAME_SYNC       0xB0U
+
+#if (BINLOG_RING_SLOTS & BINLOG_RING_MASK) != 0
+#error "BINLOG_RING_SLOTS must be a power of two"
+#endif
+
+/*============================================================================*/
+/*                         PRIVATE TYPES                                      */
+/*============================================================================*/
+
+typedef struct {
+    uint32_t seq;                       /* sequence number - slot index */
+    uint16_t fmt_id;
+    uint8_t  nargs;
+    uint8_t  reserved;
+    uint32_t timestamp;
+    uint32_t args[BINLOG_MAX_ARGS];
+} binlog_slot_t;
+
+/*============================================================================*/
+/*                         PRIVATE VARIABLES                                  */
+/*============================================================================*/
+
+static binlog_slot_t binlog_ring[BINLOG_RING_SLOTS];
+static uint32_t binlog_head;            /* next slot to claim (producers) */
+static uint32_t binlog_tail;            /* next slot to drain (consumer)  */
+static uint32_t binlog_dropped;
+static uint32_t binlog_dropped_reported;
+
+/* Drain task, statically allocated: the FreeRTOS heap is only 3 KB */
+static StaticTask_t binlog_task_cb;
+static uint32_t binlog_task_stack[128];
+static const osThreadAttr_t binlog_task_attributes = {
+    .name       = "binlog",
+    .cb_mem     = &binlog_task_cb,
+    .cb_size    = sizeof(binlog_task_cb),
+    .stack_mem  = binlog_task_stack,
+    .stack_size = sizeof(binlog_task_stack),
+    .priority   = (osPriority_t) osPriorityLow,
+};
+
+/*============================================================================*/
+/*                         PRIVATE FUNCTIONS                                  */
+/*============================================================================*/
+
+/* Sequence number of the slot that position pos maps to */
+static inline uint32_t binlog_slot_seq(uint32_t pos)
+{
+    return __atomic_load_n(&binlog_ring[pos & BINLOG_RING_MASK].seq, __ATOMIC_ACQUIRE) +
+           (pos & BINLOG_RING_MASK);
+}
+
+static inline void binlog_slot_set_seq(uint32_t pos, uint32_t seq)
+{
+    __atomic_store_n(&binlog_ring[pos & BINLOG_RING_MASK].seq,
+                     seq - (pos & BINLOG_RING_MASK), __ATOMIC_RELEASE);
+}
+
+static bool binlog_itm_ready(void)
+{
+    return ((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0U) &&
+           ((ITM->TER & (1UL << BINLOG_ITM_PORT)) != 0U);
+}
+
+static void binlog_itm_u8(uint8_t v)
+{
+    while (ITM->PORT[BINLOG_ITM_PORT].u32 == 0U) { }
+    ITM->PORT[BINLOG_ITM_PORT].u8 = v;
+}
+
+static void binlog_itm_u16(uint16_t v)
+{
+    while (ITM->PORT[BINLOG_ITM_PORT].u32 == 0U) { }
+    ITM->PORT[BINLOG_ITM_PORT].u16 = v;
+}
+
+static void binlog_itm_u32(uint32_t v)
+{
+    while (ITM->PORT[BINLOG_ITM_PORT].u32 == 0U) { }
+    ITM->PORT[BINLOG_ITM_PORT].u32 = v;
+}
+
+static void binlog_emit(uint16_t fmt_id, uint8_t nargs, uint32_t timestamp, const uint32_t *args)
+{
+    binlog_itm_u8((uint8_t)(BINLOG_FRAME_SYNC | nargs));
+    binlog_itm_u16(fmt_id);
+    binlog_itm_u32(timestamp);
+    for (uint8_t i = 0; i < nargs; i++) {
+        binlog_itm_u32(args[i]);
+    }
+}
+
+static void binlog_task(void *argument)
+{
+    (void)argument;
+
+    for (;;) {
+        binlog_flush();
+        osDelay(BINLOG_DRAIN_PERIOD_MS);
+    }
+}
+
+/*============================================================================*/
+/*                         PUBLIC API IMPLEMENTATION                          */
+/*============================================================================*/
+
+void binlog_start(void)
+{
+    /* Cycle counter for timestamps */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    /* Open the binary stimulus port if a debugger enabled the ITM */
+    if ((ITM->TCR & ITM_TCR_ITMENA_Msk) != 0U) {
+        ITM->TER |= (1UL << BINLOG_ITM_PORT);
+    }
+
+    osThreadNew(binlog_task, NULL, &binlog_task_attributes);
+}
+
+void binlog_write(uint16_t fmt_id, uint8_t nargs, const uint32_t *args)
+{
+    binlog_slot_t *slot;
+    uint32_t pos;
+
+    pos = __atomic_load_n(&binlog_head, __ATOMIC_RELAXED);
+    for (;;) {
+        int32_t diff = (int32_t)(binlog_slot_seq(pos) - pos);
+
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&binlog_head, &pos, pos + 1U, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_fetch_add(&binlog_dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&binlog_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot = &binlog_ring[pos & BINLOG_RING_MASK];
+    slot->fmt_id    = fmt_id;
+    slot->nargs     = nargs;
+    slot->timestamp = DWT->CYCCNT;
+    for (uint8_t i = 0; i < nargs; i++) {
+        slot->args[i] = args[i];
+    }
+    binlog_slot_set_seq(pos, pos + 1U);
+}
+
+uint32_t binlog_flush(void)
+{
+    uint32_t count = 0;
+    bool sink = binlog_itm_ready();
+
+    for (;;) {
+        binlog_slot_t *slot = &binlog_ring[binlog_tail & BINLOG_RING_MASK];
+
+        if (binlog_slot_seq(binlog_tail) != binlog_tail + 1U) {
+            break;      /* empty, or the producer has not published yet */
+        }
+        if (sink) {
+            binlog_emit(slot->fmt_id, slot->nargs, slot->timestamp, slot->args);
+        }
+        binlog_slot_set_seq(binlog_tail, binlog_tail + BINLOG_RING_SLOTS);
+        binlog_tail++;
+        count++;
+    }
+
+    uint32_t dropped = __atomic_load_n(&binlog_dropped, __ATOMIC_RELAXED);
+    if (sink && (dropped != binlog_dropped_reported)) {
+        uint32_t lost = dropped - binlog_dropped_reported;
+        binlog_emit(BINLOG_FMT_DROPPED, 1U, DWT->CYCCNT, &lost);
+        binlog_dropped_reported = dropped;
+    }
+
+    return count;
+}
+
+uint32_t binlog_get_dropped(void)
+{
+    return __atomic_load_n(&binlog_dropped, __ATOMIC_RELAXED);
+}
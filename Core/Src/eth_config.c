@@ -1,8 +1,65 @@
 #include "eth_config.h"
+#include "w5500.h"
+#include "w5500_spi.h"
+#include "w5500_socket.h"
+#include "FreeRTOS.h"
+
+#define BINLOG_MODULE        "eth_config"
+#define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+#include "binlog.h"
 
 // Global network configuration structure
 wiz_NetInfo g_network_info;
 
+// GAR, SUBR, SHAR and SIPR are contiguous common registers (0x0001 - 0x0012)
+#define ETH_CONFIG_REG_GW    0
+#define ETH_CONFIG_REG_SN    4
+#define ETH_CONFIG_REG_MAC   8
+#define ETH_CONFIG_REG_IP    14
+#define ETH_CONFIG_REG_LEN   18
+
+// ARP retries of a link-local probe: three requests, RTR apart
+#define ETH_CONFIG_LINKLOCAL_RCR  2
+
+// Last configuration written to the chip, for the change mask and the diff
+static wiz_NetInfo eth_config_applied;
+static uint8_t eth_config_regs[ETH_CONFIG_REG_LEN];
+static bool eth_config_regs_valid;     // false until the first apply
+static uint32_t eth_config_generation;
+static uint8_t eth_config_linklocal_conflicts;   // candidates found taken
+
+static struct {
+    eth_config_listener_t fn;
+    void* ctx;
+} eth_config_listeners[ETH_CONFIG_MAX_LISTENERS];
+
+// Guards the state above. Taken before the SPI lock, never under it.
+static osMutexId_t eth_config_mutex;
+static StaticSemaphore_t eth_config_mutex_cb;
+
+static void eth_config_lock(void) {
+    if (eth_config_mutex == NULL) {
+        // w5500_spi_init() gets here before any service task runs
+        const osMutexAttr_t attr = {
+            .name      = "eth_config",
+            .attr_bits = osMutexRecursive | osMutexPrioInherit,
+            .cb_mem    = &eth_config_mutex_cb,
+            .cb_size   = sizeof(eth_config_mutex_cb),
+        };
+        eth_config_mutex = osMutexNew(&attr);
+    }
+    // Before the scheduler runs there is a single context
+    if ((eth_config_mutex != NULL) && (osKernelGetState() == osKernelRunning)) {
+        osMutexAcquire(eth_config_mutex, osWaitForever);
+    }
+}
+
+static void eth_config_unlock(void) {
+    if ((osKernelGetState() == osKernelRunning) && (eth_config_mutex != NULL)) {
+        osMutexRelease(eth_config_mutex);
+    }
+}
+
 /**
  * @brief Initializes g_network_info with static IP settings from eth_config.h
  */
@@ -15,43 +72,339 @@ void eth_config_init_static(void) {
 
     g_network_info.dhcp = NETINFO_STATIC;
 
-    printf("Initialized g_network_info with static values.\r\n");
+    BINLOG_INFO("Initialized g_network_info with static values");
 }
 
 /**
- * @brief Apply the provided network settings to the W5500 chip
+ * @brief Initializes g_network_info with a 169.254/16 link-local address
+ *        derived from ETH_CONFIG_MAC: 169.254.1.0 - 169.254.254.255, no gateway
+ * @details The same board gets the same address until a probe finds it
+ *          taken; eth_config_claim_linklocal() then moves on to the next one.
  */
-void eth_config_set_netinfo(const wiz_NetInfo* net_info) {
+void eth_config_init_linklocal(void) {
+    uint32_t hash = 2166136261UL;   // FNV-1a, stable per board
+    for (uint8_t i = 0; i < sizeof(ETH_CONFIG_MAC); i++) {
+        hash = (hash ^ ETH_CONFIG_MAC[i]) * 16777619UL;
+    }
+    if (eth_config_linklocal_conflicts > 0U) {
+        hash = (hash ^ eth_config_linklocal_conflicts) * 16777619UL;
+    }
+
+    memcpy(g_network_info.mac, ETH_CONFIG_MAC, sizeof(g_network_info.mac));
+    g_network_info.ip[0] = 169;
+    g_network_info.ip[1] = 254;
+    g_network_info.ip[2] = (uint8_t)(1U + (hash % 254U));
+    g_network_info.ip[3] = (uint8_t)(hash >> 8);
+    g_network_info.sn[0] = 255;
+    g_network_info.sn[1] = 255;
+    g_network_info.sn[2] = 0;
+    g_network_info.sn[3] = 0;
+    memset(g_network_info.gw,  0, sizeof(g_network_info.gw));
+    memset(g_network_info.dns, 0, sizeof(g_network_info.dns));
+
+    g_network_info.dhcp = NETINFO_STATIC;
+
+    BINLOG_INFO("Initialized g_network_info with link-local %d.%d.%d.%d",
+                g_network_info.ip[0], g_network_info.ip[1], g_network_info.ip[2], g_network_info.ip[3]);
+}
+
+// True if ip is on-link under the address on the chip (always, with none)
+static bool eth_config_on_link(const uint8_t* ip) {
+    bool on_link = true;
+
+    eth_config_lock();
+    for (uint8_t i = 0; i < 4U; i++) {
+        if (((ip[i] ^ eth_config_applied.ip[i]) & eth_config_applied.sn[i]) != 0U) {
+            on_link = false;
+        }
+    }
+    eth_config_unlock();
+    return on_link;
+}
+
+/**
+ * @brief ARP-probe the link-local address in g_network_info, picking the
+ *        next candidate while another host answers for it, then apply it
+ * @details Sleeps for up to three RTR periods per candidate: call from a
+ *          task once the kernel runs, after eth_config_init_linklocal() (the
+ *          DHCP client does when it falls back to the bring-up address).
+ *          The chip and the listeners see only the final candidate. The
+ *          address is applied even when it could not be probed.
+ *
+ *          The probe cannot change SIPR under live sockets, so its ARP
+ *          requests carry the address on the chip as sender. A candidate
+ *          off-link under that address (a dropped lease from another
+ *          subnet, which nothing may keep using) is probed after the chip
+ *          has been taken to 0.0.0.0, listeners told.
+ *
+ *          This is a conflict check, not a full link-local claim: the
+ *          requests go out RTR apart rather than 1-2 s, there are no
+ *          announcements and a conflict that shows up later is not
+ *          defended.
+ * @return bool true if nobody answered for the address now in use
+ */
+bool eth_config_claim_linklocal(void) {
+    uint8_t sock;
+    int8_t ret = W5500_SOCK_ERROR;
+
+    if (!eth_config_on_link(g_network_info.ip)) {
+        wiz_NetInfo candidate = g_network_info;
+        wiz_NetInfo none;
+        eth_config_lock();
+        none = eth_config_applied;
+        eth_config_unlock();
+        memset(none.ip, 0, sizeof(none.ip));
+        memset(none.sn, 0, sizeof(none.sn));
+        memset(none.gw, 0, sizeof(none.gw));
+        eth_config_set_netinfo(&none);
+        g_network_info = candidate;     // set_netinfo mirrored "none" into it
+    }
+
+    if (w5500_socket_alloc("linklocal", W5500_SOCK_ANY, &sock) != W5500_SOCK_OK) {
+        BINLOG_WARN("No free socket: link-local address not probed");
+        eth_config_set_netinfo(&g_network_info);
+        return false;
+    }
+    if (w5500_socket_open(sock, W5500_SOCK_UDP, 0) != W5500_SOCK_OK) {
+        w5500_socket_release(sock);
+        eth_config_set_netinfo(&g_network_info);
+        return false;
+    }
+    for (uint8_t i = 0; i < ETH_CONFIG_LINKLOCAL_TRIES; i++) {
+        ret = w5500_socket_arp_probe(sock, g_network_info.ip, ETH_CONFIG_LINKLOCAL_RCR);
+        if (ret != W5500_SOCK_BUSY) {
+            break;
+        }
+        BINLOG_WARN("Link-local %d.%d.%d.%d is taken", g_network_info.ip[0], g_network_info.ip[1],
+                    g_network_info.ip[2], g_network_info.ip[3]);
+        eth_config_linklocal_conflicts++;
+        eth_config_init_linklocal();
+    }
+    w5500_socket_release(sock);
+
+    if (ret == W5500_SOCK_BUSY) {
+        BINLOG_ERROR("No free link-local address after %d tries", ETH_CONFIG_LINKLOCAL_TRIES);
+    } else if (ret != W5500_SOCK_OK) {
+        BINLOG_WARN("Link-local address not probed");
+    }
+    // Only now does the address go on the chip and to the listeners
+    eth_config_set_netinfo(&g_network_info);
+    return ret == W5500_SOCK_OK;
+}
+
+/**
+ * @brief Initializes g_network_info with the ETH_CONFIG_BRINGUP_MODE address,
+ *        used from power-up until DHCP has a lease
+ */
+void eth_config_init_bringup(void) {
+#if (ETH_CONFIG_BRINGUP_MODE == ETH_CONFIG_BRINGUP_LINKLOCAL)
+    eth_config_init_linklocal();
+#else
+    eth_config_init_static();
+#endif
+}
+
+static uint32_t eth_config_diff(const wiz_NetInfo* prev, const wiz_NetInfo* next) {
+    uint32_t changed = 0;
 
-    //memcpy(&g_network_info, net_info, sizeof(wiz_NetInfo));
-    wiz_NetInfo local_info = {
-        .mac  = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED },
-        .dhcp = NETINFO_DHCP
-    };
+    if (memcmp(prev->mac, next->mac, sizeof(prev->mac)) != 0) changed |= ETH_CONFIG_CHANGED_MAC;
+    if (memcmp(prev->ip,  next->ip,  sizeof(prev->ip))  != 0) changed |= ETH_CONFIG_CHANGED_IP;
+    if (memcmp(prev->sn,  next->sn,  sizeof(prev->sn))  != 0) changed |= ETH_CONFIG_CHANGED_SN;
+    if (memcmp(prev->gw,  next->gw,  sizeof(prev->gw))  != 0) changed |= ETH_CONFIG_CHANGED_GW;
+    if (memcmp(prev->dns, next->dns, sizeof(prev->dns)) != 0) changed |= ETH_CONFIG_CHANGED_DNS;
+    if (prev->dhcp != next->dhcp)                            changed |= ETH_CONFIG_CHANGED_MODE;
+    return changed;
+}
 
-    setSHAR(local_info.mac);
+static void eth_config_notify(uint32_t changed, const wiz_NetInfo* net_info) {
+    eth_config_listener_t fn[ETH_CONFIG_MAX_LISTENERS];
+    void* ctx[ETH_CONFIG_MAX_LISTENERS];
 
-    // Apply static network information all at once
-    //wizchip_setnetinfo(&g_network_info);
+    // Snapshot: a listener may unsubscribe itself
+    eth_config_lock();
+    for (uint8_t i = 0; i < ETH_CONFIG_MAX_LISTENERS; i++) {
+        fn[i]  = eth_config_listeners[i].fn;
+        ctx[i] = eth_config_listeners[i].ctx;
+    }
+    eth_config_unlock();
 
-    HAL_Delay(10);  // Let it settle
+    for (uint8_t i = 0; i < ETH_CONFIG_MAX_LISTENERS; i++) {
+        if (fn[i] != NULL) {
+            fn[i](changed, net_info, ctx[i]);
+        }
+    }
+}
 
+/**
+ * @brief Pack the chip part of @p net_info in register order (GAR .. SIPR)
+ */
+static void eth_config_pack(const wiz_NetInfo* net_info, uint8_t* regs) {
+    memcpy(&regs[ETH_CONFIG_REG_GW],  net_info->gw,  sizeof(net_info->gw));
+    memcpy(&regs[ETH_CONFIG_REG_SN],  net_info->sn,  sizeof(net_info->sn));
+    memcpy(&regs[ETH_CONFIG_REG_MAC], net_info->mac, sizeof(net_info->mac));
+    memcpy(&regs[ETH_CONFIG_REG_IP],  net_info->ip,  sizeof(net_info->ip));
+}
 
-    // Read back static network information all at once
-    wiz_NetInfo current;
-    eth_config_get_netinfo(&current);
+/**
+ * @brief Forget what the chip holds: the next apply writes every register
+ * @details Call after a hardware reset of the W5500
+ */
+void eth_config_invalidate(void) {
+    eth_config_lock();
+    eth_config_regs_valid = false;
+    eth_config_unlock();
 }
 
+/**
+ * @brief Apply the provided network settings to the W5500 chip
+ * @details Only the bytes that differ from the cached register copy are
+ *          written, as one burst from the first to the last changed byte,
+ *          then read back in one burst. Nothing goes on the bus when only
+ *          DNS changed or nothing did, so this is cheap enough for every
+ *          DHCP renewal. The write and read-back run under the SPI lock, so
+ *          no socket call sees the new IP without its mask/gateway. It does
+ *          not sleep. Do not call it with the SPI lock held.
+ *          The result is mirrored in g_network_info and listeners are told
+ *          which fields changed.
+ * @return bool False if the read-back did not match twice (a failed SPI
+ *         burst counts as a mismatch)
+ */
+bool eth_config_set_netinfo(const wiz_NetInfo* net_info) {
+    wiz_NetInfo next = *net_info;   // net_info may be g_network_info itself
+    uint8_t regs[ETH_CONFIG_REG_LEN];
+    uint8_t check[ETH_CONFIG_REG_LEN];
+    uint8_t first = 0;
+    uint8_t last = ETH_CONFIG_REG_LEN;
+    bool ok = true;
+
+    eth_config_pack(&next, regs);
 
+    eth_config_lock();
+    uint32_t changed = eth_config_diff(&eth_config_applied, &next);
+    if (eth_config_regs_valid) {
+        while ((first < last) && (regs[first] == eth_config_regs[first])) {
+            first++;
+        }
+        while ((last > first) && (regs[last - 1U] == eth_config_regs[last - 1U])) {
+            last--;
+        }
+    }
+    if (first < last) {
+        uint16_t len = (uint16_t)(last - first);
+        w5500_spi_lock();
+        uint32_t errors = w5500_spi_get_errors();
+        for (uint8_t attempt = 0; attempt < 2U; attempt++) {
+            WIZCHIP_WRITE_BUF(WIZCHIP_OFFSET_INC(GAR, first), &regs[first], len);
+            WIZCHIP_READ_BUF(WIZCHIP_OFFSET_INC(GAR, first), check, len);
+            // A failed burst leaves check stale: never trust it to match
+            ok = (memcmp(check, &regs[first], len) == 0) && (w5500_spi_get_errors() == errors);
+            errors = w5500_spi_get_errors();
+            if (ok) {
+                break;
+            }
+        }
+        w5500_spi_unlock();
+    }
+    if (ok) {
+        memcpy(eth_config_regs, regs, sizeof(eth_config_regs));
+        eth_config_regs_valid = true;
+        eth_config_applied = next;
+        g_network_info = next;
+        if (changed != 0U) {
+            eth_config_generation++;
+        }
+    } else {
+        eth_config_regs_valid = false;
+    }
+    eth_config_unlock();
 
+    if (!ok) {
+        BINLOG_ERROR("Net Info read-back mismatch, bytes %d-%d", first, last - 1);
+        return false;
+    }
+    if (changed != 0U) {
+        BINLOG_INFO("Net Info changed 0x%02X (%d bytes written): IP %d.%d.%d.%d", changed,
+                    last - first, next.ip[0], next.ip[1], next.ip[2], next.ip[3]);
+        eth_config_notify(changed, &next);
+    }
+    return true;
+}
 
 /**
  * @brief Read the current W5500 configuration from the chip
+ * @details GAR .. SIPR in one burst; DNS and the mode are not chip
+ *          registers and come from the last applied configuration.
  */
 void eth_config_get_netinfo(wiz_NetInfo* net_info) {
-    wizchip_getnetinfo(net_info);
-    printf("Current W5500 Net Info: IP %d.%d.%d.%d, MAC %02X:%02X:%02X:%02X:%02X:%02X\r\n",
-           net_info->ip[0], net_info->ip[1], net_info->ip[2], net_info->ip[3],
-           net_info->mac[0], net_info->mac[1], net_info->mac[2],
-           net_info->mac[3], net_info->mac[4], net_info->mac[5]);
+    uint8_t regs[ETH_CONFIG_REG_LEN];
+
+    w5500_spi_lock();
+    WIZCHIP_READ_BUF(GAR, regs, sizeof(regs));
+    w5500_spi_unlock();
+    eth_config_lock();
+    memcpy(net_info->dns, eth_config_applied.dns, sizeof(net_info->dns));
+    net_info->dhcp = eth_config_applied.dhcp;
+    eth_config_unlock();
+
+    memcpy(net_info->gw,  &regs[ETH_CONFIG_REG_GW],  sizeof(net_info->gw));
+    memcpy(net_info->sn,  &regs[ETH_CONFIG_REG_SN],  sizeof(net_info->sn));
+    memcpy(net_info->mac, &regs[ETH_CONFIG_REG_MAC], sizeof(net_info->mac));
+    memcpy(net_info->ip,  &regs[ETH_CONFIG_REG_IP],  sizeof(net_info->ip));
+
+    BINLOG_INFO("Current W5500 Net Info: IP %d.%d.%d.%d",
+                net_info->ip[0], net_info->ip[1], net_info->ip[2], net_info->ip[3]);
+    BINLOG_INFO("Current W5500 Net Info: MAC %02X:%02X:%02X:%02X:%02X:%02X",
+                net_info->mac[0], net_info->mac[1], net_info->mac[2],
+                net_info->mac[3], net_info->mac[4], net_info->mac[5]);
+}
+
+
+
+/**
+ * @brief Call @p listener after every applied configuration change
+ * @return bool False if all ETH_CONFIG_MAX_LISTENERS slots are taken
+ */
+bool eth_config_subscribe(eth_config_listener_t listener, void* ctx) {
+    bool ok = false;
+
+    if (listener == NULL) {
+        return false;
+    }
+    eth_config_lock();
+    for (uint8_t i = 0; i < ETH_CONFIG_MAX_LISTENERS; i++) {
+        if (eth_config_listeners[i].fn == NULL) {
+            eth_config_listeners[i].fn  = listener;
+            eth_config_listeners[i].ctx = ctx;
+            ok = true;
+            break;
+        }
+    }
+    eth_config_unlock();
+
+    if (!ok) {
+        BINLOG_WARN("No free listener slot");
+    }
+    return ok;
+}
+
+/**
+ * @brief Remove a listener added with the same @p listener and @p ctx
+ */
+void eth_config_unsubscribe(eth_config_listener_t listener, void* ctx) {
+    eth_config_lock();
+    for (uint8_t i = 0; i < ETH_CONFIG_MAX_LISTENERS; i++) {
+        if ((eth_config_listeners[i].fn == listener) && (eth_config_listeners[i].ctx == ctx)) {
+            eth_config_listeners[i].fn  = NULL;
+            eth_config_listeners[i].ctx = NULL;
+        }
+    }
+    eth_config_unlock();
+}
+
+/**
+ * @brief Count of applied configuration changes, for services that poll
+ *        instead of subscribing: rebind when it differs from the last value seen
+ */
+uint32_t eth_config_get_generation(void) {
+    return eth_config_generation;
 }
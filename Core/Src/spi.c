@@ -21,6 +21,61 @@
 #include "spi.h"
 
 /* USER CODE BEGIN 0 */
+#include "FreeRTOS.h"
+
+/* SPI2 (W5500) burst transfers run on DMA1 CH1 (RX) / CH2 (TX) via DMAMUX */
+DMA_HandleTypeDef hdma_spi2_rx;
+DMA_HandleTypeDef hdma_spi2_tx;
+
+/*
+ * Bus manager
+ *
+ * Each SPI peripheral is owned by a spi_bus_t. A transaction runs between
+ * spi_bus_acquire() and spi_bus_release() and holds the bus mutex: FreeRTOS
+ * keeps the tasks blocked on it in priority order and lends the holder the
+ * priority of the highest waiter, so the mutex is the priority-ordered
+ * transaction queue and a low-priority client cannot starve a latency
+ * critical one. The mutex is recursive so a driver can wrap a multi-frame
+ * sequence around its own single-frame accesses.
+ *
+ * Bursts of at least SPI_BUS_DMA_MIN_LEN bytes issued from a task run on
+ * DMA when the bus has DMA channels linked: the caller blocks on a task
+ * notification and the CPU is free until the transfer completes.
+ */
+
+#define SPI_BUS_TIMEOUT        10000U
+
+/* Set to 0 to force the polled HAL_SPI_Receive/HAL_SPI_Transmit path */
+#ifndef SPI_BUS_USE_DMA
+#define SPI_BUS_USE_DMA        1
+#endif
+
+/* Bursts shorter than this stay polled: an address phase or single register
+ * access finishes before a DMA setup + context switch would */
+#ifndef SPI_BUS_DMA_MIN_LEN
+#define SPI_BUS_DMA_MIN_LEN    64U
+#endif
+
+/* Thread flags (task notification bits) set by the DMA completion callbacks */
+#define SPI_BUS_FLAG_DONE      0x00010000U
+#define SPI_BUS_FLAG_ERROR     0x00020000U
+
+typedef struct {
+  SPI_HandleTypeDef      *hspi;
+  osMutexId_t             mutex;
+  StaticSemaphore_t       mutex_cb;
+  osThreadId_t volatile   waiter;       /* task blocked on a DMA burst */
+  spi_client_t           *owner;
+  uint32_t                depth;        /* recursive acquire depth     */
+  uint32_t                t_acquired;
+} spi_bus_t;
+
+static spi_bus_t spi_buses[] = {
+  { .hspi = &hspi1 },
+  { .hspi = &hspi2 },
+};
+
+static void spi_bus_create(SPI_HandleTypeDef *hspi);
 
 /* USER CODE END 0 */
 
@@ -57,7 +112,7 @@ void MX_SPI1_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN SPI1_Init 2 */
-
+  spi_bus_create(&hspi1);
   /* USER CODE END SPI1_Init 2 */
 
 }
@@ -91,7 +146,14 @@ void MX_SPI2_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN SPI2_Init 2 */
-
+  /* Chip selects are driven per device by the bus manager (PB12 = W5500 CS) */
+  hspi2.Init.NSS = SPI_NSS_SOFT;
+  hspi2.Init.NSSPMode = SPI_NSS_PULSE_DISABLE;
+  if (HAL_SPI_Init(&hspi2) != HAL_OK)
+  {
+    Error_Handler();
+  }
+  spi_bus_create(&hspi2);
   /* USER CODE END SPI2_Init 2 */
 
 }
@@ -149,7 +211,62 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef* spiHandle)
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
   /* USER CODE BEGIN SPI2_MspInit 1 */
+    /* PB12 is the W5500 chip select, driven as a GPIO (idle high) */
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_12, GPIO_PIN_SET);
+    GPIO_InitStruct.Pin = GPIO_PIN_12;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    GPIO_InitStruct.Alternate = 0;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
 
+    /* DMA controller clock enable */
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    /* SPI2 DMA Init */
+    /* SPI2_RX Init */
+    hdma_spi2_rx.Instance = DMA1_Channel1;
+    hdma_spi2_rx.Init.Request = DMA_REQUEST_SPI2_RX;
+    hdma_spi2_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi2_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi2_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi2_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi2_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi2_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi2_rx.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_spi2_rx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(spiHandle,hdmarx,hdma_spi2_rx);
+
+    /* SPI2_TX Init */
+    hdma_spi2_tx.Instance = DMA1_Channel2;
+    hdma_spi2_tx.Init.Request = DMA_REQUEST_SPI2_TX;
+    hdma_spi2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi2_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi2_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi2_tx.Init.Priority = DMA_PRIORITY_HIGH;
+    if (HAL_DMA_Init(&hdma_spi2_tx) != HAL_OK)
+    {
+      Error_Handler();
+    }
+
+    __HAL_LINKDMA(spiHandle,hdmatx,hdma_spi2_tx);
+
+    /* DMA and SPI2 interrupts: priority 5 = configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY,
+     * the completion callbacks signal tasks through the RTOS FromISR API */
+    HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+    HAL_NVIC_SetPriority(SPI2_IRQn, 5, 0);
+    HAL_NVIC_EnableIRQ(SPI2_IRQn);
   /* USER CODE END SPI2_MspInit 1 */
   }
 }
@@ -194,11 +311,265 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* spiHandle)
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_12|GPIO_PIN_13|GPIO_PIN_14|GPIO_PIN_15);
 
   /* USER CODE BEGIN SPI2_MspDeInit 1 */
-
+    /* SPI2 DMA DeInit */
+    HAL_DMA_DeInit(spiHandle->hdmarx);
+    HAL_DMA_DeInit(spiHandle->hdmatx);
+
+    /* SPI2 interrupt DeInit */
+    HAL_NVIC_DisableIRQ(SPI2_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+    HAL_NVIC_DisableIRQ(DMA1_Channel2_IRQn);
   /* USER CODE END SPI2_MspDeInit 1 */
   }
 }
 
 /* USER CODE BEGIN 1 */
 
+static spi_bus_t *spi_bus_get(const SPI_HandleTypeDef *hspi)
+{
+  for (uint32_t i = 0; i < sizeof(spi_buses) / sizeof(spi_buses[0]); i++)
+  {
+    if (spi_buses[i].hspi == hspi)
+    {
+      return &spi_buses[i];
+    }
+  }
+  return NULL;
+}
+
+static void spi_bus_create(SPI_HandleTypeDef *hspi)
+{
+  spi_bus_t *bus = spi_bus_get(hspi);
+
+  if ((bus != NULL) && (bus->mutex == NULL))
+  {
+    const osMutexAttr_t attr = {
+      .name      = "spi_bus",
+      .attr_bits = osMutexRecursive | osMutexPrioInherit,
+      .cb_mem    = &bus->mutex_cb,
+      .cb_size   = sizeof(bus->mutex_cb),
+    };
+    bus->mutex = osMutexNew(&attr);
+  }
+}
+
+/**
+  * @brief  Start a transaction: wait for the bus (priority ordered) and own it
+  * @param  client  Device issuing the transaction
+  * @param  timeout Kernel ticks to wait (osWaitForever to block)
+  * @retval true if the bus is owned, false on timeout
+  * @note   Recursive. Before the scheduler runs there is a single context and
+  *         no locking happens.
+  */
+bool spi_bus_acquire(spi_client_t *client, uint32_t timeout)
+{
+  spi_bus_t *bus = spi_bus_get(client->hspi);
+  uint32_t t0 = SPI_BUS_CYCLES();
+
+  if ((bus == NULL) || (bus->mutex == NULL) || (osKernelGetState() != osKernelRunning))
+  {
+    return true;
+  }
+  if (osMutexAcquire(bus->mutex, timeout) != osOK)
+  {
+    return false;
+  }
+  if (bus->depth++ == 0U)
+  {
+    uint32_t now = SPI_BUS_CYCLES();
+    uint32_t waited = now - t0;
+
+    bus->owner = client;
+    bus->t_acquired = now;
+    client->wait_cycles += waited;
+    if (waited > client->max_wait_cycles)
+    {
+      client->max_wait_cycles = waited;
+    }
+  }
+  return true;
+}
+
+/**
+  * @brief  End a transaction started with spi_bus_acquire()
+  */
+void spi_bus_release(spi_client_t *client)
+{
+  spi_bus_t *bus = spi_bus_get(client->hspi);
+
+  if ((bus == NULL) || (bus->mutex == NULL) || (osKernelGetState() != osKernelRunning))
+  {
+    return;
+  }
+  if (--bus->depth == 0U)
+  {
+    client->hold_cycles += SPI_BUS_CYCLES() - bus->t_acquired;
+    client->transactions++;
+    bus->owner = NULL;
+  }
+  osMutexRelease(bus->mutex);
+}
+
+/**
+  * @brief  Assert / de-assert the client's chip select
+  */
+void spi_bus_select(spi_client_t *client)
+{
+  if (client->cs_port != NULL)
+  {
+    HAL_GPIO_WritePin(client->cs_port, client->cs_pin, GPIO_PIN_RESET);
+  }
+}
+
+void spi_bus_deselect(spi_client_t *client)
+{
+  if (client->cs_port != NULL)
+  {
+    HAL_GPIO_WritePin(client->cs_port, client->cs_pin, GPIO_PIN_SET);
+  }
+}
+
+/**
+  * @brief  Check whether a burst may run on DMA: enabled and linked, long
+  *         enough, and issued from a task once the scheduler runs
+  */
+static bool spi_bus_dma_allowed(const spi_bus_t *bus, uint16_t len)
+{
+#if SPI_BUS_USE_DMA
+  return (len >= SPI_BUS_DMA_MIN_LEN) &&
+         (bus->hspi->hdmarx != NULL) && (bus->hspi->hdmatx != NULL) &&
+         (osKernelGetState() == osKernelRunning);
+#else
+  (void)bus;
+  (void)len;
+  return false;
+#endif
+}
+
+/**
+  * @brief  Block the calling task until the running DMA burst completes
+  * @retval HAL_OK, HAL_ERROR on SPI/DMA error, HAL_TIMEOUT if no completion
+  *         arrived within SPI_BUS_TIMEOUT (the transfer is aborted)
+  */
+static HAL_StatusTypeDef spi_bus_dma_wait(spi_bus_t *bus)
+{
+  uint32_t flags = osThreadFlagsWait(SPI_BUS_FLAG_DONE | SPI_BUS_FLAG_ERROR,
+                                     osFlagsWaitAny, SPI_BUS_TIMEOUT);
+  bus->waiter = NULL;
+
+  if ((flags & osFlagsError) != 0U)
+  {
+    HAL_SPI_Abort(bus->hspi);
+    return HAL_TIMEOUT;
+  }
+  return ((flags & SPI_BUS_FLAG_ERROR) != 0U) ? HAL_ERROR : HAL_OK;
+}
+
+static HAL_StatusTypeDef spi_bus_transfer(spi_client_t *client, uint8_t *data, uint16_t len, bool rx)
+{
+  spi_bus_t *bus = spi_bus_get(client->hspi);
+  HAL_StatusTypeDef status;
+
+  if (bus == NULL)
+  {
+    return HAL_ERROR;
+  }
+  client->bytes += len;
+
+  if (spi_bus_dma_allowed(bus, len))
+  {
+    bus->waiter = osThreadGetId();
+    osThreadFlagsClear(SPI_BUS_FLAG_DONE | SPI_BUS_FLAG_ERROR);
+    status = rx ? HAL_SPI_Receive_DMA(bus->hspi, data, len)
+                : HAL_SPI_Transmit_DMA(bus->hspi, data, len);
+    if (status == HAL_OK)
+    {
+      return spi_bus_dma_wait(bus);
+    }
+    bus->waiter = NULL;
+  }
+  return rx ? HAL_SPI_Receive(bus->hspi, data, len, SPI_BUS_TIMEOUT)
+            : HAL_SPI_Transmit(bus->hspi, data, len, SPI_BUS_TIMEOUT);
+}
+
+/**
+  * @brief  Clock out / in a burst on the client's bus (call between
+  *         spi_bus_select() and spi_bus_deselect())
+  */
+HAL_StatusTypeDef spi_bus_transmit(spi_client_t *client, const uint8_t *data, uint16_t len)
+{
+  return spi_bus_transfer(client, (uint8_t *)data, len, false);
+}
+
+HAL_StatusTypeDef spi_bus_receive(spi_client_t *client, uint8_t *data, uint16_t len)
+{
+  return spi_bus_transfer(client, data, len, true);
+}
+
+/**
+  * @brief  Change the SCK prescaler of the client's bus between transactions
+  * @param  client    Device on the bus (every device on it gets the new SCK)
+  * @param  prescaler SPI_BAUDRATEPRESCALER_2 .. SPI_BAUDRATEPRESCALER_256
+  * @retval HAL_OK, HAL_ERROR for an invalid prescaler, HAL_BUSY if a
+  *         transfer is still running
+  */
+HAL_StatusTypeDef spi_bus_set_prescaler(spi_client_t *client, uint32_t prescaler)
+{
+  SPI_HandleTypeDef *hspi = client->hspi;
+  HAL_StatusTypeDef status = HAL_OK;
+
+  if (!IS_SPI_BAUDRATE_PRESCALER(prescaler))
+  {
+    return HAL_ERROR;
+  }
+  spi_bus_acquire(client, osWaitForever);
+  if (hspi->State != HAL_SPI_STATE_READY)
+  {
+    status = HAL_BUSY;
+  }
+  else
+  {
+    /* BR may only change with SPE clear; the next HAL transfer sets it */
+    __HAL_SPI_DISABLE(hspi);
+    MODIFY_REG(hspi->Instance->CR1, SPI_CR1_BR, prescaler);
+    hspi->Init.BaudRatePrescaler = prescaler;
+  }
+  spi_bus_release(client);
+  return status;
+}
+
+/* DMA completion: HAL callbacks run in the DMA/SPI interrupt and wake the
+ * task blocked on the burst */
+static void spi_bus_dma_notify(SPI_HandleTypeDef *hspi, uint32_t flag)
+{
+  spi_bus_t *bus = spi_bus_get(hspi);
+  osThreadId_t waiter = (bus != NULL) ? bus->waiter : NULL;
+
+  if (waiter != NULL)
+  {
+    osThreadFlagsSet(waiter, flag);
+  }
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  spi_bus_dma_notify(hspi, SPI_BUS_FLAG_DONE);
+}
+
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  spi_bus_dma_notify(hspi, SPI_BUS_FLAG_DONE);
+}
+
+/* HAL_SPI_Receive_DMA runs as TransmitReceive in 2-line master mode */
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  spi_bus_dma_notify(hspi, SPI_BUS_FLAG_DONE);
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+  spi_bus_dma_notify(hspi, SPI_BUS_FLAG_ERROR);
+}
+
 /* USER CODE END 1 */
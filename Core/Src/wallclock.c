@@ -0,0 +1,220 @@
+/**
+ * @file    wallclock.c
+ * @brief   Nanosecond timestamps from the DWT cycle counter, disciplined to UTC
+ *
+ * @details Cycles are scaled with a Q24 nanoseconds-per-cycle factor, so a
+ *          conversion is two 32x32->64 multiplies and no division. The
+ *          64-bit extension and the anchor are read and written with
+ *          interrupts masked: a handful of instructions, and callers in ISRs
+ *          see a consistent clock.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#include "wallclock.h"
+
+#include "stm32g4xx.h"
+
+/*============================================================================*/
+/*                         PRIVATE DEFINES                                    */
+/*============================================================================*/
+
+/* Cycle source and its frequency, overridable for host builds */
+#ifndef WALLCLOCK_CYCLES
+#define WALLCLOCK_CYCLES()      (DWT->CYCCNT)
+#endif
+#ifndef WALLCLOCK_HZ
+#define WALLCLOCK_HZ()          (SystemCoreClock)
+#endif
+
+#define WALLCLOCK_MULT_SHIFT    24
+
+/* |d| in us below which d * ppb cannot overflow (116 days) */
+#define WALLCLOCK_US_SAFE       10000000000000LL
+
+_Static_assert(WALLCLOCK_SLEW_MAX_PPB <= WALLCLOCK_RATE_MAX_PPB,
+               "wallclock: slew rate above the scaling limit");
+
+/*============================================================================*/
+/*                         PRIVATE VARIABLES                                  */
+/*============================================================================*/
+
+static uint32_t wallclock_mult;         /* ns per cycle, Q24              */
+static uint32_t wallclock_last;         /* CYCCNT at the last read        */
+static uint32_t wallclock_high;         /* wraps seen                     */
+
+static uint64_t wallclock_mono0;        /* anchor, local time             */
+static int64_t  wallclock_utc0;         /* anchor, disciplined time       */
+static int32_t  wallclock_rate;         /* ppb                            */
+static int64_t  wallclock_slew;         /* offset slewed in from mono0    */
+static bool     wallclock_synced;
+
+/*============================================================================*/
+/*                         PRIVATE FUNCTIONS                                  */
+/*============================================================================*/
+
+static inline uint32_t wallclock_lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void wallclock_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+/* Caller holds the lock */
+static uint64_t wallclock_cycles_locked(void)
+{
+    uint32_t now = WALLCLOCK_CYCLES();
+
+    if (now < wallclock_last) {
+        wallclock_high++;
+    }
+    wallclock_last = now;
+    return ((uint64_t)wallclock_high << 32) | now;
+}
+
+static uint64_t wallclock_cycles_to_ns(uint64_t cycles)
+{
+    uint32_t hi = (uint32_t)(cycles >> 32);
+    uint32_t lo = (uint32_t)cycles;
+
+    return ((uint64_t)hi * ((uint64_t)wallclock_mult << (32 - WALLCLOCK_MULT_SHIFT))) +
+           (((uint64_t)lo * wallclock_mult) >> WALLCLOCK_MULT_SHIFT);
+}
+
+/* d * ppb / 1e9 without overflowing on long intervals */
+static int64_t wallclock_scale(int64_t d, int32_t ppb)
+{
+    int64_t us = d / 1000;
+
+    if ((us > WALLCLOCK_US_SAFE) || (us < -WALLCLOCK_US_SAFE)) {
+        return ((us / 1000) * ppb) / 1000;
+    }
+    return (us * ppb) / 1000000;
+}
+
+/* Part of wallclock_slew applied after d ns */
+static int64_t wallclock_slewed(int64_t d)
+{
+    if ((wallclock_slew == 0) || (d <= 0)) {
+        return 0;
+    }
+    int64_t done = wallclock_scale(d, WALLCLOCK_SLEW_MAX_PPB);
+    if (wallclock_slew > 0) {
+        return (done < wallclock_slew) ? done : wallclock_slew;
+    }
+    return (-done > wallclock_slew) ? -done : wallclock_slew;
+}
+
+/* Caller holds the lock */
+static int64_t wallclock_to_utc_locked(uint64_t mono_ns)
+{
+    int64_t d = (int64_t)(mono_ns - wallclock_mono0);
+
+    return wallclock_utc0 + d + wallclock_scale(d, wallclock_rate) + wallclock_slewed(d);
+}
+
+/*============================================================================*/
+/*                         PUBLIC API IMPLEMENTATION                          */
+/*============================================================================*/
+
+void wallclock_init(void)
+{
+    uint32_t primask = wallclock_lock();
+    wallclock_mult   = (uint32_t)((1000000000ULL << WALLCLOCK_MULT_SHIFT) / WALLCLOCK_HZ());
+    wallclock_last   = WALLCLOCK_CYCLES();
+    wallclock_high   = 0;
+    wallclock_mono0  = 0;
+    wallclock_utc0   = 0;
+    wallclock_rate   = 0;
+    wallclock_slew   = 0;
+    wallclock_synced = false;
+    wallclock_unlock(primask);
+}
+
+void wallclock_poll(void)
+{
+    uint32_t primask = wallclock_lock();
+    (void)wallclock_cycles_locked();
+    wallclock_unlock(primask);
+}
+
+uint64_t wallclock_cycles(void)
+{
+    uint32_t primask = wallclock_lock();
+    uint64_t cycles = wallclock_cycles_locked();
+    wallclock_unlock(primask);
+    return cycles;
+}
+
+uint64_t wallclock_mono_ns(void)
+{
+    return wallclock_cycles_to_ns(wallclock_cycles());
+}
+
+uint64_t wallclock_stamp_to_mono_ns(uint32_t cyccnt)
+{
+    uint32_t primask = wallclock_lock();
+    uint64_t now = wallclock_cycles_locked();
+    wallclock_unlock(primask);
+    return wallclock_cycles_to_ns(now - (uint32_t)((uint32_t)now - cyccnt));
+}
+
+int64_t wallclock_now_ns(void)
+{
+    uint32_t primask = wallclock_lock();
+    int64_t now = wallclock_to_utc_locked(wallclock_cycles_to_ns(wallclock_cycles_locked()));
+    wallclock_unlock(primask);
+    return now;
+}
+
+int64_t wallclock_to_utc_ns(uint64_t mono_ns)
+{
+    uint32_t primask = wallclock_lock();
+    int64_t utc = wallclock_to_utc_locked(mono_ns);
+    wallclock_unlock(primask);
+    return utc;
+}
+
+void wallclock_correct(int64_t offset_ns, int32_t rate_ppb, bool step)
+{
+    if (rate_ppb > WALLCLOCK_RATE_MAX_PPB) {
+        rate_ppb = WALLCLOCK_RATE_MAX_PPB;
+    } else if (rate_ppb < -WALLCLOCK_RATE_MAX_PPB) {
+        rate_ppb = -WALLCLOCK_RATE_MAX_PPB;
+    }
+
+    uint32_t primask = wallclock_lock();
+    uint64_t mono = wallclock_cycles_to_ns(wallclock_cycles_locked());
+
+    wallclock_utc0  = wallclock_to_utc_locked(mono) + (step ? offset_ns : 0);
+    wallclock_mono0 = mono;
+    wallclock_rate  = rate_ppb;
+    wallclock_slew  = step ? 0 : offset_ns;
+    wallclock_synced = true;
+    wallclock_unlock(primask);
+}
+
+int64_t wallclock_get_slew_left_ns(void)
+{
+    uint32_t primask = wallclock_lock();
+    uint64_t mono = wallclock_cycles_to_ns(wallclock_cycles_locked());
+    int64_t left = wallclock_slew - wallclock_slewed((int64_t)(mono - wallclock_mono0));
+    wallclock_unlock(primask);
+    return left;
+}
+
+int32_t wallclock_get_rate_ppb(void)
+{
+    return wallclock_rate;
+}
+
+bool wallclock_is_synced(void)
+{
+    return wallclock_synced;
+}
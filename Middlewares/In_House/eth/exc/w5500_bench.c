@@ -0,0 +1,587 @@
+/**
+ * @file    w5500_bench.c
+ * @brief   On-board network benchmark: TCP/UDP throughput and UDP round trip
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_bench.h"
+
+ // Off by default: the run-time stats it needs tax every context switch
+ #ifdef W5500_BENCH_ENABLE
+
+ #include "w5500_socket.h"
+ #include "wallclock.h"
+ #include "FreeRTOS.h"
+ #include "task.h"
+ #include <string.h>
+
+ #define BINLOG_MODULE        "w5500_bench"
+ #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ #include "binlog.h"
+
+ // Control connection: anywhere but the data socket
+ #ifndef ETH_CONFIG_BENCH_CTRL_SOCK_MASK
+ #define ETH_CONFIG_BENCH_CTRL_SOCK_MASK ((uint8_t)~(1U << 2))
+ #endif
+ // Data: the stream socket of W5500_MEM_BULK_STREAM, so layouts compare.
+ // Claimed once by w5500_bench_init(): the other services allocate
+ // W5500_SOCK_ANY lowest first and would hold it by the time of a run
+ #ifndef ETH_CONFIG_BENCH_SOCK_MASK
+ #define ETH_CONFIG_BENCH_SOCK_MASK      (1U << 2)
+ #endif
+
+ #define BENCH_REQ_MS        5000    // connect to request
+ #define BENCH_SLICE_MS      100     // longest sleep in a run: control hang-up and
+                                     // the 32-bit idle counter are checked this often
+ #define BENCH_BLAST_BURST   32      // flat-out UDP blast: datagrams between checks
+
+ typedef struct {
+     uint64_t cycles;
+     uint64_t idle;
+     uint64_t spi_hold;
+     uint32_t spi_bytes;
+     uint32_t spi_transactions;
+ } bench_snap_t;
+
+ static uint8_t  bench_ctrl = W5500_MAX_SOCKET;   // none until init
+ static uint8_t  bench_data = W5500_MAX_SOCKET;   // none until init, open during a run
+ static uint8_t  bench_buffer[W5500_BENCH_MAX_LEN];
+ static uint64_t bench_idle;                      // idle task cycles, 64 bits
+ static uint32_t bench_idle_last;
+ static w5500_latency_stats_t bench_service;
+ static w5500_bench_result_t  bench_result;
+
+ /*============================================================================*/
+ /*                         MEASUREMENT                                        */
+ /*============================================================================*/
+
+ static uint32_t bench_ms_to_ticks(uint32_t ms)
+ {
+     return (uint32_t)(((uint64_t)ms * osKernelGetTickFreq()) / 1000U);
+ }
+
+ static uint32_t bench_cycles_to_ms(uint64_t cycles)
+ {
+     return (uint32_t)((cycles * 1000U) / SystemCoreClock);
+ }
+
+ // The kernel's idle counter is 32 bits of DWT cycles: extend it on every
+ // sample, which runs at least every BENCH_SLICE_MS during a run.
+ static uint64_t bench_idle_cycles(void)
+ {
+     uint32_t now = ulTaskGetIdleRunTimeCounter();
+
+     bench_idle += now - bench_idle_last;
+     bench_idle_last = now;
+     return bench_idle;
+ }
+
+ static void bench_snap(bench_snap_t *snap)
+ {
+     const spi_client_t *spi = w5500_spi_get_client();
+
+     w5500_spi_lock();
+     snap->cycles           = wallclock_cycles();
+     snap->idle             = bench_idle_cycles();
+     snap->spi_hold         = spi->hold_cycles;
+     snap->spi_bytes        = spi->bytes;
+     snap->spi_transactions = spi->transactions;
+     w5500_spi_unlock();
+ }
+
+ static uint16_t bench_permille(uint64_t part, uint64_t whole)
+ {
+     if (whole == 0U) {
+         return 0U;
+     }
+     part = (part * 1000U) / whole;
+     return (uint16_t)((part > 1000U) ? 1000U : part);
+ }
+
+ static void bench_report(w5500_bench_result_t *res, const bench_snap_t *t0, const bench_snap_t *t1)
+ {
+     uint64_t cycles = t1->cycles - t0->cycles;
+     uint64_t idle   = t1->idle - t0->idle;
+
+     res->core_hz           = SystemCoreClock;
+     res->sck_div           = w5500_spi_get_sck_div();
+     res->sck_hz            = HAL_RCC_GetPCLK1Freq() / res->sck_div;
+     res->elapsed_us        = (uint32_t)((cycles * 1000000U) / SystemCoreClock);
+     res->spi_bytes         = t1->spi_bytes - t0->spi_bytes;
+     res->spi_transactions  = t1->spi_transactions - t0->spi_transactions;
+     res->cpu_permille      = (uint16_t)(1000U - bench_permille(idle, cycles));
+     res->spi_busy_permille = bench_permille(t1->spi_hold - t0->spi_hold, cycles);
+     // Clocking time of the bytes, in core cycles
+     res->sck_permille      = bench_permille(((uint64_t)res->spi_bytes * 8U * res->core_hz) / res->sck_hz,
+                                             cycles);
+     if (bench_service.count != 0U) {
+         res->service_p50 = w5500_socket_latency_percentile(&bench_service, 50);
+         res->service_p99 = w5500_socket_latency_percentile(&bench_service, 99);
+         res->service_max = bench_service.max_cycles;
+     }
+ }
+
+ /*============================================================================*/
+ /*                         DATA PATHS                                         */
+ /*============================================================================*/
+
+ /**
+  * @brief Sleep until data-socket events, or the client hangs up
+  * @return W5500_POLL* events of the data socket
+  */
+ static uint8_t bench_wait(uint8_t events, uint32_t ms, bool *hup)
+ {
+     w5500_pollfd_t fds[2] = {
+         { .sock_num = bench_ctrl, .events = W5500_POLLHUP },
+         { .sock_num = bench_data, .events = events },
+     };
+
+     if ((w5500_socket_poll(fds, 2, bench_ms_to_ticks(ms)) > 0) &&
+         ((fds[0].revents & W5500_POLLHUP) != 0U)) {
+         *hup = true;
+     }
+     bench_idle_cycles();
+     return fds[1].revents;
+ }
+
+ // TCP sink: read everything queued into the bench buffer, as an
+ // application would, and release it
+ static void bench_tcp_drain(w5500_bench_result_t *res)
+ {
+     w5500_rx_span_t span;
+
+     while ((w5500_socket_peek(bench_data, &span) == W5500_SOCK_OK) && (span.len > 0))
+     {
+         while (span.len > 0)
+         {
+             uint16_t want = (span.len < sizeof(bench_buffer)) ? span.len : (uint16_t)sizeof(bench_buffer);
+             int32_t got = w5500_socket_peek_read(bench_data, &span, 0, bench_buffer, want);
+
+             if ((got <= 0) || (w5500_socket_consume(bench_data, &span, (uint16_t)got) != W5500_SOCK_OK)) {
+                 return;
+             }
+             res->rx_bytes += (uint32_t)got;
+             res->rx_packets++;
+         }
+     }
+ }
+
+ // UDP sink / echo: one pass over every queued datagram
+ static bool bench_udp_drain(const w5500_bench_req_t *req, w5500_bench_result_t *res,
+                             uint32_t *next_seq)
+ {
+     w5500_rx_span_t span;
+     uint8_t head[W5500_UDP_HDR_LEN];
+     bool got_any = false;
+
+     while ((w5500_socket_peek(bench_data, &span) == W5500_SOCK_OK) && (span.len > 0))
+     {
+         while (span.len >= W5500_UDP_HDR_LEN)
+         {
+             uint32_t t_read = SPI_BUS_CYCLES();
+             if (w5500_socket_peek_read(bench_data, &span, 0, head, sizeof(head)) != (int32_t)sizeof(head)) {
+                 return got_any;
+             }
+             uint16_t len     = w5500_bench_get16(&head[6]);
+             uint16_t pkt_len = (uint16_t)(W5500_UDP_HDR_LEN + len);
+             if (pkt_len > span.len) {
+                 break;      // desynchronised ring, dropped below
+             }
+             uint16_t want = (len < sizeof(bench_buffer)) ? len : (uint16_t)sizeof(bench_buffer);
+             int32_t got = w5500_socket_peek_read(bench_data, &span, W5500_UDP_HDR_LEN, bench_buffer, want);
+             if ((got < 0) || (w5500_socket_consume(bench_data, &span, pkt_len) != W5500_SOCK_OK)) {
+                 return got_any;
+             }
+             got_any = true;
+             res->rx_bytes += len;
+             res->rx_packets++;
+
+             if (req->mode == W5500_BENCH_UDP_ECHO) {
+                 if (w5500_socket_sendto(bench_data, bench_buffer, (uint16_t)got, &head[0],
+                                         w5500_bench_get16(&head[4])) < 0) {
+                     res->errors++;
+                 } else {
+                     res->tx_bytes += (uint32_t)got;
+                     res->tx_packets++;
+                     w5500_socket_latency_add(&bench_service, SPI_BUS_CYCLES() - t_read);
+                 }
+             } else if (got >= 4) {
+                 // Sequence number up front: gaps are losses until filled
+                 uint32_t seq = w5500_bench_get32(bench_buffer);
+                 if (seq == *next_seq) {
+                     (*next_seq)++;
+                 } else if ((int32_t)(seq - *next_seq) > 0) {
+                     res->lost += seq - *next_seq;
+                     *next_seq = seq + 1U;
+                 } else {
+                     res->reordered++;
+                     if (res->lost > 0U) {
+                         res->lost--;
+                     }
+                 }
+             }
+         }
+         if (span.len > 0) {
+             // Partial datagram: the chip writes whole ones, so the ring is
+             // desynchronised. Drop it.
+             w5500_socket_consume(bench_data, &span, span.len);
+         }
+     }
+     return got_any;
+ }
+
+ // UDP blast: the datagrams due by now, up to one burst
+ static void bench_udp_blast(const w5500_bench_req_t *req, w5500_bench_result_t *res,
+                             const uint8_t *dest_ip, uint64_t elapsed_cycles)
+ {
+     uint32_t due = BENCH_BLAST_BURST;
+
+     if (req->rate_pps != 0U) {
+         uint64_t owed = ((elapsed_cycles * req->rate_pps) / SystemCoreClock) + 1U;
+         owed = (owed > res->tx_packets + res->errors) ? owed - (res->tx_packets + res->errors) : 0U;
+         due = (owed < BENCH_BLAST_BURST) ? (uint32_t)owed : BENCH_BLAST_BURST;
+     }
+     for (uint32_t i = 0; i < due; i++) {
+         w5500_bench_put32(bench_buffer, res->tx_packets + res->errors);
+         if (w5500_socket_sendto(bench_data, bench_buffer, req->len, dest_ip, req->udp_port) < 0) {
+             res->errors++;
+         } else {
+             res->tx_bytes += req->len;
+             res->tx_packets++;
+         }
+     }
+ }
+
+ /*============================================================================*/
+ /*                         RUN                                                */
+ /*============================================================================*/
+
+ static uint8_t bench_setup(const w5500_bench_req_t *req, w5500_bench_result_t *res)
+ {
+     bool tcp = (req->mode == W5500_BENCH_TCP_SINK) || (req->mode == W5500_BENCH_TCP_SOURCE);
+     w5500_sock_regs_t regs;
+
+     if ((req->mode < W5500_BENCH_TCP_SINK) || (req->mode > W5500_BENCH_UDP_ECHO) ||
+         (req->len < 4U) || (req->len > W5500_BENCH_MAX_LEN) ||
+         (req->duration_ms == 0U) || (req->duration_ms > W5500_BENCH_MAX_MS) ||
+         ((req->mode == W5500_BENCH_UDP_BLAST) && (req->udp_port == 0U))) {
+         return W5500_BENCH_ERR_REQUEST;
+     }
+     if ((req->sck_div != 0U) && !w5500_spi_set_sck_div(req->sck_div)) {
+         return W5500_BENCH_ERR_SPI;
+     }
+     if (bench_data >= W5500_MAX_SOCKET) {
+         return W5500_BENCH_ERR_SOCKET;
+     }
+     // The data socket is still closed: only its neighbours can refuse
+     if (req->profile != W5500_BENCH_KEEP) {
+         if (w5500_socket_apply_profile((w5500_mem_profile_t)req->profile) != W5500_SOCK_OK) {
+             return W5500_BENCH_ERR_PROFILE;
+         }
+         res->profile = req->profile;
+     }
+     if ((w5500_socket_open(bench_data, tcp ? W5500_SOCK_TCP : W5500_SOCK_UDP,
+                            W5500_BENCH_DATA_PORT) != W5500_SOCK_OK) ||
+         (tcp && (w5500_socket_listen(bench_data) != W5500_SOCK_OK))) {
+         return W5500_BENCH_ERR_SOCKET;
+     }
+     w5500_socket_read_regs(bench_data, &regs);
+     res->tx_kb = regs.txbuf_size;
+     res->rx_kb = regs.rxbuf_size;
+     for (uint16_t i = 0; i < sizeof(bench_buffer); i++) {
+         bench_buffer[i] = (uint8_t)i;
+     }
+     memset(&bench_service, 0, sizeof(bench_service));
+     return W5500_BENCH_OK;
+ }
+
+ static void bench_teardown(uint16_t sck_div, bool profile)
+ {
+     if (bench_data < W5500_MAX_SOCKET) {
+         if (w5500_socket_is_connected(bench_data)) {
+             w5500_disconnect(bench_data);
+         }
+         w5500_socket_close(bench_data);     // the claim stays for the next run
+     }
+     if (w5500_spi_get_sck_div() != sck_div) {
+         w5500_spi_set_sck_div(sck_div);
+     }
+     if (profile && (w5500_socket_apply_profile(ETH_CONFIG_MEM_PROFILE) != W5500_SOCK_OK)) {
+         BINLOG_WARN("Socket layout of the run kept: sockets open");
+     }
+ }
+
+ /**
+  * @brief Run a set-up request to its end
+  * @return w5500_bench_status_t
+  */
+ static uint8_t bench_run(const w5500_bench_req_t *req, w5500_bench_result_t *res)
+ {
+     bench_snap_t t0;
+     bench_snap_t t1;
+     w5500_sock_regs_t ctrl_regs;
+     w5500_send_token_t token = 0;
+     uint32_t next_seq = 0;
+     uint16_t tx_half = (uint16_t)(res->tx_kb * 512U);
+     uint64_t t_ack = wallclock_cycles();
+     bool started = false;
+     bool hup = false;
+     bool done = false;
+
+     // UDP blast goes to the client's address, at its port
+     w5500_socket_read_regs(bench_ctrl, &ctrl_regs);
+     if (req->mode == W5500_BENCH_UDP_BLAST) {
+         bench_snap(&t0);
+         started = true;
+     }
+
+     while (!done && !hup)
+     {
+         uint64_t now = wallclock_cycles();
+         uint32_t ms = bench_cycles_to_ms(now - (started ? t0.cycles : t_ack));
+         uint32_t limit = started ? req->duration_ms : W5500_BENCH_IDLE_MS;
+         if (ms >= limit) {
+             if (!started) {
+                 return W5500_BENCH_ERR_TIMEOUT;
+             }
+             break;
+         }
+         uint32_t slice = ((limit - ms) < BENCH_SLICE_MS) ? (limit - ms) : BENCH_SLICE_MS;
+         uint8_t ev;
+
+         switch (req->mode)
+         {
+         case W5500_BENCH_TCP_SINK:
+             ev = bench_wait(W5500_POLLCON | W5500_POLLIN | W5500_POLLHUP, slice, &hup);
+             if (!started && ((ev & (W5500_POLLCON | W5500_POLLIN)) != 0U)) {
+                 bench_snap(&t0);
+                 started = true;
+             }
+             if ((ev & (W5500_POLLIN | W5500_POLLHUP)) != 0U) {
+                 bench_tcp_drain(res);
+             }
+             // The client closes after its last byte
+             done = (ev & W5500_POLLHUP) != 0U;
+             break;
+
+         case W5500_BENCH_TCP_SOURCE:
+         {
+             if (!started) {
+                 if ((bench_wait(W5500_POLLCON, slice, &hup) & W5500_POLLCON) != 0U) {
+                     bench_snap(&t0);
+                     started = true;
+                 }
+                 break;
+             }
+             int32_t n = w5500_socket_send_async(bench_data, bench_buffer, req->len, &token);
+             if (n > 0) {
+                 res->tx_bytes += (uint32_t)n;
+                 res->tx_packets++;
+             } else if (n == 0) {
+                 // Ring full: sleep until half of it is on the wire
+                 int8_t st = w5500_socket_send_wait(bench_data, token - tx_half, bench_ms_to_ticks(slice));
+                 if ((st != W5500_SOCK_OK) && (st != W5500_SOCK_BUSY)) {
+                     res->errors++;
+                     done = true;
+                 }
+                 bench_wait(0U, 0U, &hup);
+             } else {
+                 res->errors++;
+                 done = true;
+             }
+             break;
+         }
+
+         case W5500_BENCH_UDP_SINK:
+         case W5500_BENCH_UDP_ECHO:
+             // Datagrams in flight when the run ends are left in the ring
+             if ((bench_wait(W5500_POLLIN, slice, &hup) & W5500_POLLIN) != 0U) {
+                 if (!started) {
+                     bench_snap(&t0);
+                     started = true;
+                 }
+                 bench_udp_drain(req, res, &next_seq);
+             }
+             break;
+
+         case W5500_BENCH_UDP_BLAST:
+             bench_udp_blast(req, res, ctrl_regs.dipr, now - t0.cycles);
+             // Flat out: just check for a hang-up. Paced: sleep a tick.
+             bench_wait(0U, (req->rate_pps == 0U) ? 0U : 1U, &hup);
+             break;
+
+         default:
+             done = true;
+             break;
+         }
+     }
+
+     if (started && (req->mode == W5500_BENCH_TCP_SOURCE)) {
+         // Count the run to the last byte on the wire
+         w5500_socket_send_wait(bench_data, token, bench_ms_to_ticks(1000U));
+     }
+     if (!started) {
+         return hup ? W5500_BENCH_ERR_TIMEOUT : W5500_BENCH_OK;
+     }
+     bench_snap(&t1);
+     bench_report(res, &t0, &t1);
+     return W5500_BENCH_OK;
+ }
+
+ /*============================================================================*/
+ /*                         CONTROL CONNECTION                                 */
+ /*============================================================================*/
+
+ static bool bench_accept(void)
+ {
+     w5500_pollfd_t fd = { .sock_num = bench_ctrl, .events = W5500_POLLCON | W5500_POLLHUP };
+     int32_t n;
+
+     // Claimed once by w5500_bench_init(); the claim outlives each close
+     int8_t ret = w5500_socket_open(bench_ctrl, W5500_SOCK_TCP, W5500_BENCH_PORT);
+     if (ret == W5500_SOCK_BUSY) {
+         BINLOG_ERROR("Control socket %d claimed by another task", bench_ctrl);
+         return false;
+     }
+     if ((ret != W5500_SOCK_OK) || (w5500_socket_listen(bench_ctrl) != W5500_SOCK_OK)) {
+         return false;
+     }
+     while ((n = w5500_socket_poll(&fd, 1, osWaitForever)) == 0) {
+     }
+     if (n < 0) {
+         BINLOG_WARN("Poll of control socket %d failed, error %d", bench_ctrl, n);
+         return false;                   // the task backs off and reopens
+     }
+     return (fd.revents & W5500_POLLCON) != 0U;
+ }
+
+ /**
+  * @brief Wait for the request
+  * @return 1 decoded, 0 malformed, -1 none (timeout or hang-up)
+  */
+ static int bench_read_request(w5500_bench_req_t *req)
+ {
+     uint8_t buf[W5500_BENCH_REQ_LEN];
+     uint64_t t0 = wallclock_cycles();
+
+     for (;;) {
+         w5500_rx_span_t span;
+         w5500_pollfd_t fd = { .sock_num = bench_ctrl, .events = W5500_POLLIN | W5500_POLLHUP };
+
+         if ((w5500_socket_peek(bench_ctrl, &span) == W5500_SOCK_OK) &&
+             (span.len >= W5500_BENCH_REQ_LEN)) {
+             w5500_socket_peek_read(bench_ctrl, &span, 0, buf, sizeof(buf));
+             w5500_socket_consume(bench_ctrl, &span, W5500_BENCH_REQ_LEN);
+             return (w5500_bench_req_decode(buf, req) == 0) ? 1 : 0;
+         }
+         if (bench_cycles_to_ms(wallclock_cycles() - t0) >= BENCH_REQ_MS) {
+             return -1;
+         }
+         if ((w5500_socket_poll(&fd, 1, bench_ms_to_ticks(BENCH_SLICE_MS)) > 0) &&
+             ((fd.revents & W5500_POLLHUP) != 0U)) {
+             return -1;
+         }
+     }
+ }
+
+ static void bench_session(void)
+ {
+     w5500_bench_result_t *res = &bench_result;
+     w5500_bench_req_t req = { 0 };
+     uint8_t msg[W5500_BENCH_RES_LEN];
+     uint16_t sck_div = w5500_spi_get_sck_div();
+     int ok = bench_read_request(&req);
+
+     if (ok < 0) {
+         return;
+     }
+     memset(res, 0, sizeof(*res));
+     res->profile = W5500_BENCH_KEEP;
+     if (ok == 0) {
+         res->status = W5500_BENCH_ERR_REQUEST;
+     } else {
+         res->mode   = req.mode;
+         res->len    = req.len;
+         res->status = bench_setup(&req, res);
+     }
+     msg[0] = res->status;
+     msg[1] = res->mode;
+     w5500_bench_put16(&msg[2], W5500_BENCH_DATA_PORT);
+     if ((w5500_socket_send(bench_ctrl, msg, W5500_BENCH_ACK_LEN) == (int32_t)W5500_BENCH_ACK_LEN) &&
+         (res->status == W5500_BENCH_OK)) {
+         res->status = bench_run(&req, res);
+         w5500_bench_res_encode(res, msg);
+         w5500_socket_send(bench_ctrl, msg, W5500_BENCH_RES_LEN);
+         BINLOG_INFO("Run mode %d status %d: %d us, rx %d B, tx %d B, cpu %d, spi %d, sck %d permille",
+                     res->mode, res->status, res->elapsed_us, res->rx_bytes, res->tx_bytes,
+                     res->cpu_permille, res->spi_busy_permille, res->sck_permille);
+     }
+     bench_teardown(sck_div, res->profile != W5500_BENCH_KEEP);
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ bool w5500_bench_init(void)
+ {
+     if ((bench_data >= W5500_MAX_SOCKET) &&
+         (w5500_socket_alloc("bench", ETH_CONFIG_BENCH_SOCK_MASK, &bench_data) != W5500_SOCK_OK)) {
+         BINLOG_ERROR("Data socket (mask 0x%02X) already taken", ETH_CONFIG_BENCH_SOCK_MASK);
+         bench_data = W5500_MAX_SOCKET;
+         return false;
+     }
+     if ((bench_ctrl >= W5500_MAX_SOCKET) &&
+         (w5500_socket_alloc("bench-ctrl", ETH_CONFIG_BENCH_CTRL_SOCK_MASK, &bench_ctrl) != W5500_SOCK_OK)) {
+         BINLOG_ERROR("No free socket for the benchmark");
+         bench_ctrl = W5500_MAX_SOCKET;
+         return false;
+     }
+     bench_idle_last = ulTaskGetIdleRunTimeCounter();
+     BINLOG_INFO("Benchmark on socket %d, port %d, data on socket %d", bench_ctrl, W5500_BENCH_PORT,
+                 bench_data);
+     return true;
+ }
+
+ void w5500_bench_stop(void)
+ {
+     if (bench_data < W5500_MAX_SOCKET) {
+         w5500_socket_release(bench_data);
+         bench_data = W5500_MAX_SOCKET;
+     }
+     if (bench_ctrl < W5500_MAX_SOCKET) {
+         w5500_socket_release(bench_ctrl);
+         bench_ctrl = W5500_MAX_SOCKET;
+     }
+ }
+
+ void w5500_bench_get_result(w5500_bench_result_t *result)
+ {
+     if (result != NULL) {
+         *result = bench_result;
+     }
+ }
+
+ void w5500_bench_task(void *argument)
+ {
+     (void)argument;
+
+     for (;;) {
+         if (bench_ctrl >= W5500_MAX_SOCKET) {
+             osDelay(100);
+             continue;
+         }
+         if (!bench_accept()) {
+             osDelay(100);
+             continue;
+         }
+         bench_session();
+         if (w5500_socket_is_connected(bench_ctrl)) {
+             w5500_disconnect(bench_ctrl);
+         }
+         w5500_socket_close(bench_ctrl);
+     }
+ }
+
+ #endif /* W5500_BENCH_ENABLE */
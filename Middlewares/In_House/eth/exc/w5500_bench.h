@@ -0,0 +1,89 @@
+/**
+ * @file    w5500_bench.h
+ * @brief   On-board network benchmark: TCP/UDP throughput and UDP round trip
+ *
+ * @details An iperf-like service on top of w5500_socket, driven by the host
+ *          client in tools/w5500_net_bench. A client opens the control
+ *          connection (TCP W5500_BENCH_PORT, socket from
+ *          ETH_CONFIG_BENCH_CTRL_SOCK_MASK) and asks for one run:
+ *
+ *          - TCP sink / source: bulk stream into or out of the board
+ *            (zero-copy receive, w5500_socket_send_async() pipelining),
+ *          - UDP sink: datagrams into the board, loss and reordering from
+ *            their sequence numbers,
+ *          - UDP blast: datagrams out of the board at a set rate,
+ *          - UDP echo: datagrams returned to the sender, for round trips
+ *            and the board's share of them.
+ *
+ *          The data socket comes from ETH_CONFIG_BENCH_SOCK_MASK (socket 2,
+ *          the stream socket of W5500_MEM_BULK_STREAM) for the run only. A
+ *          run may set the SPI2 SCK divider and the socket buffer profile;
+ *          both are restored afterwards. The result (w5500_bench_proto.h)
+ *          carries payload bytes and packets over the elapsed time, core
+ *          load from the FreeRTOS idle task run time, and SPI2 occupancy
+ *          from the bus manager: the same figures for every SCK and layout,
+ *          so stack changes can be tracked run against run.
+ *
+ *          Built only with the W5500_BENCH_ENABLE project symbol, which
+ *          also turns on the FreeRTOS run-time stats it reads
+ *          (FreeRTOSConfig.h). Needs wallclock_init().
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_BENCH_H
+ #define W5500_BENCH_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <string.h>
+#include "stm32g4xx_hal.h" // For HAL (if needed)
+
+#include "w5500_spi.h"
+#include "eth_config.h"
+#include "w5500_bench_proto.h"
+
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #ifndef W5500_BENCH_IDLE_MS
+ #define W5500_BENCH_IDLE_MS    10000   /**< Ack to first data before a run is abandoned */
+ #endif
+
+ /**
+  * @brief Take the control and data sockets from the pool, for good
+  * @note  Call before the scheduler starts or from the benchmark task: the
+  *        pool refuses to reopen a socket claimed by another task. Call it
+  *        before the other services' init as well: they allocate
+  *        W5500_SOCK_ANY lowest first and would take the data socket
+  *        (ETH_CONFIG_BENCH_SOCK_MASK).
+  * @return bool True on success
+  */
+ bool w5500_bench_init(void);
+
+ /**
+  * @brief Close and release the sockets
+  * @note  Only between runs: stop the benchmark task first.
+  */
+ void w5500_bench_stop(void);
+
+ /**
+  * @brief Copy the result of the last run (also sent to the client)
+  */
+ void w5500_bench_get_result(w5500_bench_result_t *result);
+
+ /**
+  * @brief Benchmark thread body: accepts one client at a time and runs its
+  *        request. Runs keep the task busy for their whole duration, so
+  *        there is no polled variant.
+  */
+ void w5500_bench_task(void *argument);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_BENCH_H */
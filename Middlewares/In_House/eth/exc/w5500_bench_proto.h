@@ -0,0 +1,242 @@
+/**
+ * @file    w5500_bench_proto.h
+ * @brief   Wire format of the network benchmark (board service and host client)
+ *
+ * @details Plain C, no HAL: included by w5500_bench.c on the board and by
+ *          tools/w5500_net_bench on the host. Every field is big-endian.
+ *
+ *          One session per control connection (TCP W5500_BENCH_PORT):
+ *
+ *            client                         board
+ *            request (W5500_BENCH_REQ_LEN) ->
+ *                                        <- ack (W5500_BENCH_ACK_LEN)
+ *            data on W5500_BENCH_DATA_PORT (TCP or UDP, per mode)
+ *                                        <- result (W5500_BENCH_RES_LEN)
+ *                                           board closes the connection
+ *
+ *          The board times the run (duration_ms from the first data) and
+ *          closes the data connection at the end; a client closing its
+ *          side first (TCP sink) ends the run early.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_BENCH_PROTO_H
+ #define W5500_BENCH_PROTO_H
+
+#include <stdint.h>
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #define W5500_BENCH_PORT        5201U        /**< Control connection (TCP) */
+ #define W5500_BENCH_DATA_PORT   5202U        /**< Data: TCP listen or UDP bind */
+ #define W5500_BENCH_MAGIC       0x57354E42UL /**< "W5NB" */
+ #define W5500_BENCH_VERSION     1U
+ #define W5500_BENCH_MAX_LEN     1472U        /**< Largest chunk / datagram */
+ #define W5500_BENCH_MAX_MS      60000U       /**< Longest run */
+ #define W5500_BENCH_KEEP        0xFFU        /**< profile: keep the current layout */
+
+ #define W5500_BENCH_REQ_LEN     24U
+ #define W5500_BENCH_ACK_LEN     4U
+ #define W5500_BENCH_RES_LEN     76U
+
+ /**
+  * @brief Traffic pattern, named from the board's side
+  */
+ typedef enum {
+     W5500_BENCH_TCP_SINK   = 1,   /**< Client sends on TCP, board reads and drops */
+     W5500_BENCH_TCP_SOURCE = 2,   /**< Board sends on TCP, client reads */
+     W5500_BENCH_UDP_SINK   = 3,   /**< Client sends datagrams, board counts loss */
+     W5500_BENCH_UDP_BLAST  = 4,   /**< Board sends datagrams at rate_pps (0 = flat out) */
+     W5500_BENCH_UDP_ECHO   = 5    /**< Board returns every datagram to its sender */
+ } w5500_bench_mode_t;
+
+ /**
+  * @brief Ack and result status
+  */
+ typedef enum {
+     W5500_BENCH_OK          = 0,
+     W5500_BENCH_ERR_REQUEST = 1,  /**< Bad magic, version, mode, length or duration */
+     W5500_BENCH_ERR_SPI     = 2,  /**< SCK divider refused */
+     W5500_BENCH_ERR_PROFILE = 3,  /**< Layout change refused: sockets open (boot with it) */
+     W5500_BENCH_ERR_SOCKET  = 4,  /**< No data socket */
+     W5500_BENCH_ERR_TIMEOUT = 5   /**< No data within W5500_BENCH_IDLE_MS of the ack */
+ } w5500_bench_status_t;
+
+ /**
+  * @brief Run request (client to board)
+  */
+ typedef struct {
+     uint8_t  mode;          /**< w5500_bench_mode_t */
+     uint8_t  profile;       /**< w5500_mem_profile_t for the run, W5500_BENCH_KEEP */
+     uint16_t sck_div;       /**< SPI2 SCK divider for the run, 0 = keep */
+     uint16_t len;           /**< Bytes per send / datagram, 4 .. W5500_BENCH_MAX_LEN */
+     uint16_t udp_port;      /**< UDP blast: client port to send to */
+     uint32_t duration_ms;   /**< Run length from the first data */
+     uint32_t rate_pps;      /**< UDP blast: datagrams per second, 0 = flat out */
+ } w5500_bench_req_t;
+
+ /**
+  * @brief Run result (board to client)
+  *
+  * @details Setup fields make every result self-describing, so runs under
+  *          different SCK dividers and buffer layouts can be compared.
+  *          Rates are derived by the reader: Mbit/s = bytes * 8 / elapsed_us,
+  *          packets/s = packets * 1e6 / elapsed_us.
+  */
+ typedef struct {
+     uint8_t  mode;              /**< w5500_bench_mode_t */
+     uint8_t  status;            /**< w5500_bench_status_t */
+     uint8_t  tx_kb;             /**< Data socket TX buffer */
+     uint8_t  rx_kb;             /**< Data socket RX buffer */
+     uint16_t sck_div;           /**< SPI2 SCK divider used */
+     uint16_t len;               /**< Bytes per send / datagram */
+     uint32_t core_hz;           /**< SystemCoreClock */
+     uint32_t sck_hz;            /**< SPI2 SCK */
+     uint32_t elapsed_us;        /**< First to last data */
+     uint32_t rx_bytes;          /**< Payload received */
+     uint32_t rx_packets;        /**< Chunks / datagrams received */
+     uint32_t tx_bytes;          /**< Payload sent */
+     uint32_t tx_packets;        /**< Chunks / datagrams sent */
+     uint32_t lost;              /**< UDP sink: sequence numbers never seen */
+     uint32_t reordered;         /**< UDP sink: sequence numbers seen late */
+     uint32_t errors;            /**< Sends refused or failed */
+     uint16_t cpu_permille;      /**< Core busy (not in the idle task) */
+     uint16_t spi_busy_permille; /**< W5500 holding the SPI2 bus */
+     uint16_t sck_permille;      /**< SCK actually clocking bytes */
+     uint8_t  profile;           /**< Profile applied for the run, W5500_BENCH_KEEP */
+     uint8_t  reserved;
+     uint32_t spi_bytes;         /**< SPI2 payload bytes during the run */
+     uint32_t spi_transactions;  /**< SPI2 transactions during the run */
+     uint32_t service_p50;       /**< UDP echo: datagram read to reply sent, cycles */
+     uint32_t service_p99;
+     uint32_t service_max;
+ } w5500_bench_result_t;
+
+ /*============================================================================*/
+ /*                         ENCODING                                           */
+ /*============================================================================*/
+
+ static inline void w5500_bench_put16(uint8_t *p, uint16_t v)
+ {
+     p[0] = (uint8_t)(v >> 8);
+     p[1] = (uint8_t)v;
+ }
+
+ static inline void w5500_bench_put32(uint8_t *p, uint32_t v)
+ {
+     p[0] = (uint8_t)(v >> 24);
+     p[1] = (uint8_t)(v >> 16);
+     p[2] = (uint8_t)(v >> 8);
+     p[3] = (uint8_t)v;
+ }
+
+ static inline uint16_t w5500_bench_get16(const uint8_t *p)
+ {
+     return (uint16_t)((p[0] << 8) | p[1]);
+ }
+
+ static inline uint32_t w5500_bench_get32(const uint8_t *p)
+ {
+     return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+ }
+
+ static inline void w5500_bench_req_encode(const w5500_bench_req_t *req, uint8_t *buf)
+ {
+     w5500_bench_put32(&buf[0], W5500_BENCH_MAGIC);
+     buf[4] = W5500_BENCH_VERSION;
+     buf[5] = req->mode;
+     buf[6] = req->profile;
+     buf[7] = 0U;
+     w5500_bench_put16(&buf[8], req->sck_div);
+     w5500_bench_put16(&buf[10], req->len);
+     w5500_bench_put32(&buf[12], req->duration_ms);
+     w5500_bench_put32(&buf[16], req->rate_pps);
+     w5500_bench_put16(&buf[20], req->udp_port);
+     w5500_bench_put16(&buf[22], 0U);
+ }
+
+ /** @return 0 if magic and version match, -1 otherwise */
+ static inline int w5500_bench_req_decode(const uint8_t *buf, w5500_bench_req_t *req)
+ {
+     if ((w5500_bench_get32(&buf[0]) != W5500_BENCH_MAGIC) || (buf[4] != W5500_BENCH_VERSION)) {
+         return -1;
+     }
+     req->mode        = buf[5];
+     req->profile     = buf[6];
+     req->sck_div     = w5500_bench_get16(&buf[8]);
+     req->len         = w5500_bench_get16(&buf[10]);
+     req->duration_ms = w5500_bench_get32(&buf[12]);
+     req->rate_pps    = w5500_bench_get32(&buf[16]);
+     req->udp_port    = w5500_bench_get16(&buf[20]);
+     return 0;
+ }
+
+ static inline void w5500_bench_res_encode(const w5500_bench_result_t *res, uint8_t *buf)
+ {
+     buf[0] = res->mode;
+     buf[1] = res->status;
+     buf[2] = res->tx_kb;
+     buf[3] = res->rx_kb;
+     w5500_bench_put16(&buf[4], res->sck_div);
+     w5500_bench_put16(&buf[6], res->len);
+     w5500_bench_put32(&buf[8], res->core_hz);
+     w5500_bench_put32(&buf[12], res->sck_hz);
+     w5500_bench_put32(&buf[16], res->elapsed_us);
+     w5500_bench_put32(&buf[20], res->rx_bytes);
+     w5500_bench_put32(&buf[24], res->rx_packets);
+     w5500_bench_put32(&buf[28], res->tx_bytes);
+     w5500_bench_put32(&buf[32], res->tx_packets);
+     w5500_bench_put32(&buf[36], res->lost);
+     w5500_bench_put32(&buf[40], res->reordered);
+     w5500_bench_put32(&buf[44], res->errors);
+     w5500_bench_put16(&buf[48], res->cpu_permille);
+     w5500_bench_put16(&buf[50], res->spi_busy_permille);
+     w5500_bench_put16(&buf[52], res->sck_permille);
+     buf[54] = res->profile;
+     buf[55] = 0U;
+     w5500_bench_put32(&buf[56], res->spi_bytes);
+     w5500_bench_put32(&buf[60], res->spi_transactions);
+     w5500_bench_put32(&buf[64], res->service_p50);
+     w5500_bench_put32(&buf[68], res->service_p99);
+     w5500_bench_put32(&buf[72], res->service_max);
+ }
+
+ static inline void w5500_bench_res_decode(const uint8_t *buf, w5500_bench_result_t *res)
+ {
+     res->mode              = buf[0];
+     res->status            = buf[1];
+     res->tx_kb             = buf[2];
+     res->rx_kb             = buf[3];
+     res->sck_div           = w5500_bench_get16(&buf[4]);
+     res->len               = w5500_bench_get16(&buf[6]);
+     res->core_hz           = w5500_bench_get32(&buf[8]);
+     res->sck_hz            = w5500_bench_get32(&buf[12]);
+     res->elapsed_us        = w5500_bench_get32(&buf[16]);
+     res->rx_bytes          = w5500_bench_get32(&buf[20]);
+     res->rx_packets        = w5500_bench_get32(&buf[24]);
+     res->tx_bytes          = w5500_bench_get32(&buf[28]);
+     res->tx_packets        = w5500_bench_get32(&buf[32]);
+     res->lost              = w5500_bench_get32(&buf[36]);
+     res->reordered         = w5500_bench_get32(&buf[40]);
+     res->errors            = w5500_bench_get32(&buf[44]);
+     res->cpu_permille      = w5500_bench_get16(&buf[48]);
+     res->spi_busy_permille = w5500_bench_get16(&buf[50]);
+     res->sck_permille      = w5500_bench_get16(&buf[52]);
+     res->profile           = buf[54];
+     res->reserved          = 0U;
+     res->spi_bytes         = w5500_bench_get32(&buf[56]);
+     res->spi_transactions  = w5500_bench_get32(&buf[60]);
+     res->service_p50       = w5500_bench_get32(&buf[64]);
+     res->service_p99       = w5500_bench_get32(&buf[68]);
+     res->service_max       = w5500_bench_get32(&buf[72]);
+ }
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_BENCH_PROTO_H */
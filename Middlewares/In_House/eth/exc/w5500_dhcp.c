@@ -3,147 +3,828 @@
 /*  @brief   DHCP client implementation for W5500 Ethernet controller         */
 /*----------------------------------------------------------------------------*/
 /*  Centralized configuration using eth_config.h                              */
+/*  RFC 2131 client on a pool UDP socket. The ioLibrary DHCP engine has no    */
+/*  INIT-REBOOT and needs a 10 ms poll plus a 1 s tick, so it is not used.    */
 /*============================================================================*/
 
 #include "w5500_dhcp.h"
 #include "w5500_spi.h"
 #include "w5500_socket.h"
+#include "w5500_irq.h"
 #include "eth_config.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/socket.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/wizchip_conf.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Internet/DHCP/dhcp.h"
-#include "eth_config.h"
+#include "socket.h"
+#include "wizchip_conf.h"
 #include <string.h>
-#include <stdio.h>
-#include "stm32f1xx_hal.h"
+
+#define BINLOG_MODULE        "w5500_dhcp"
+#define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+#include "binlog.h"
 
 /*============================================================================*/
-/*                         DEBUG PRINT MACRO                                  */
+/*                         PRIVATE CONSTANTS                                  */
 /*============================================================================*/
-#ifdef W5500_DEBUG
-#define DEBUG_PRINT(...)  printf(__VA_ARGS__)
-#else
-#define DEBUG_PRINT(...)
+#define DHCP_MAX_RETRY_COUNT    5       // Unanswered DISCOVERs before the static fallback
+#define DHCP_REQUEST_TRIES      3       // Unanswered REQUESTs before a new DISCOVER
+#define DHCP_REBOOT_TRIES       2       // Unanswered INIT-REBOOT REQUESTs before DISCOVER
+
+#define DHCP_RETX_FIRST_MS      2000U   // First retransmit timeout, doubled per retry
+#define DHCP_RETX_MAX_MS        32000U
+#define DHCP_REBOOT_RETX_MS     1000U
+#define DHCP_RENEW_RETX_MIN_S   60U     // RFC 2131 4.4.5
+#define DHCP_DECLINE_WAIT_MS    10000U  // RFC 2131 3.1.5
+#define DHCP_DEFAULT_LEASE_S    3600U   // ACK without option 51
+#define DHCP_CONFLICT_RCR       2       // ARP retries of the conflict probe
+
+#define DHCP_SERVER_PORT        67
+#define DHCP_CLIENT_PORT        68
+
+// BOOTP header (RFC 2131 figure 1)
+#define DHCP_OFF_OP             0
+#define DHCP_OFF_HTYPE          1
+#define DHCP_OFF_HLEN           2
+#define DHCP_OFF_XID            4
+#define DHCP_OFF_FLAGS          10
+#define DHCP_OFF_CIADDR         12
+#define DHCP_OFF_YIADDR         16
+#define DHCP_OFF_CHADDR         28
+#define DHCP_OFF_COOKIE         236
+#define DHCP_OFF_OPTIONS        240
+#define DHCP_MIN_LEN            300     // BOOTP minimum, some relays drop less
+#define DHCP_FLAG_BROADCAST     0x8000U
+#define DHCP_MAGIC_COOKIE       0x63825363UL
+
+#define DHCP_BOOTREQUEST        1
+#define DHCP_BOOTREPLY          2
+
+// Message types (option 53)
+#define DHCP_DISCOVER           1
+#define DHCP_OFFER              2
+#define DHCP_REQUEST            3
+#define DHCP_DECLINE            4
+#define DHCP_ACK                5
+#define DHCP_NAK                6
+
+// Options
+#define DHCP_OPT_PAD            0
+#define DHCP_OPT_SUBNET         1
+#define DHCP_OPT_ROUTER         3
+#define DHCP_OPT_DNS            6
+#define DHCP_OPT_REQUESTED_IP   50
+#define DHCP_OPT_LEASE_TIME     51
+#define DHCP_OPT_MSG_TYPE       53
+#define DHCP_OPT_SERVER_ID      54
+#define DHCP_OPT_PARAM_LIST     55
+#define DHCP_OPT_T1             58
+#define DHCP_OPT_T2             59
+#define DHCP_OPT_CLIENT_ID      61
+#define DHCP_OPT_END            255
+
+// Default lease store: TAMP backup registers
+#ifndef ETH_CONFIG_DHCP_BKP_FIRST
+#define ETH_CONFIG_DHCP_BKP_FIRST   0
+#endif
+#define DHCP_BKP_WORDS          7
+#define DHCP_LEASE_MAGIC        0x44484350UL    // "DHCP"
+
+// Period of the remaining_s refresh while bound
+#ifndef ETH_CONFIG_DHCP_LEASE_SAVE_S
+#define ETH_CONFIG_DHCP_LEASE_SAVE_S    60U
 #endif
 
 /*============================================================================*/
-/*                         PRIVATE CONSTANTS                                  */
+/*                         PRIVATE TYPES                                      */
 /*============================================================================*/
-#define DHCP_MAX_RETRY_COUNT    5
+typedef struct {
+    uint8_t  type;
+    uint8_t  yiaddr[4];
+    uint8_t  server[4];
+    uint8_t  sn[4];
+    uint8_t  gw[4];
+    uint8_t  dns[4];
+    uint32_t lease_s;
+    uint32_t t1_s;
+    uint32_t t2_s;
+} dhcp_reply_t;
 
 /*============================================================================*/
 /*                         PRIVATE VARIABLES                                  */
 /*============================================================================*/
-static uint8_t dhcp_retry = 0;
-static bool ip_assigned_flag = false;
+static w5500_dhcp_state_t dhcp_state = W5500_DHCP_STOPPED;
+static uint8_t dhcp_retry = 0;          // Transmissions in the current state
 
-#define ETH_CONFIG_DHCP_SOCKET  0
+// Sockets the DHCP client may take from the pool
+#ifndef ETH_CONFIG_DHCP_SOCK_MASK
+#define ETH_CONFIG_DHCP_SOCK_MASK  W5500_SOCK_ANY
+#endif
 static uint8_t dhcp_buffer[548];
-static uint8_t dhcp_socket = ETH_CONFIG_DHCP_SOCKET;
+static uint8_t dhcp_socket = W5500_MAX_SOCKET;     // none while stopped
+
+static uint8_t  dhcp_mac[6];
+static uint32_t dhcp_xid;
+static w5500_dhcp_lease_t dhcp_lease;   // Offered, then bound lease
+
+// Kernel ticks. Wrap-safe: compared through dhcp_due()
+static uint32_t dhcp_deadline;          // Next retransmit or state timer
+static uint32_t dhcp_t_sent;            // Last REQUEST, lease times count from it
+static uint32_t dhcp_t1;
+static uint32_t dhcp_t2;
+static uint32_t dhcp_expiry;
+static uint32_t dhcp_save_at;
+
+static const uint8_t DHCP_BROADCAST_IP[4] = {255, 255, 255, 255};
+static const uint8_t DHCP_ZERO_IP[4]      = {0, 0, 0, 0};
 
 /*============================================================================*/
-/*                         CALLBACKS FROM DHCP LIBRARY                        */
+/*                         TIMERS                                             */
 /*============================================================================*/
 
+static bool dhcp_due(uint32_t now, uint32_t tick)
+{
+    return (int32_t)(now - tick) >= 0;
+}
+
+static uint32_t dhcp_ms_to_ticks(uint32_t ms)
+{
+    return (uint32_t)(((uint64_t)ms * osKernelGetTickFreq()) / 1000U);
+}
+
 /**
- * @brief Called when IP is successfully assigned or renewed.
+ * @brief Seconds to ticks, clamped so that every deadline stays within half
+ *        the tick counter range (about 24 days at 1 kHz)
  */
-static void on_dhcp_assigned(void)
+static uint32_t dhcp_s_to_ticks(uint32_t s)
 {
-    DEBUG_PRINT("[DHCP] IP assigned.\r\n");
+    uint32_t freq = osKernelGetTickFreq();
+    uint32_t max_s = (INT32_MAX / freq) - 1U;
 
-    getIPfromDHCP(g_network_info.ip);
-    getGWfromDHCP(g_network_info.gw);
-    getSNfromDHCP(g_network_info.sn);
-    getDNSfromDHCP(g_network_info.dns);
-    g_network_info.dhcp = NETINFO_DHCP;
+    return ((s < max_s) ? s : max_s) * freq;
+}
 
-    eth_config_set_netinfo(&g_network_info);
-    ip_assigned_flag = true;
+static uint32_t dhcp_backoff_ms(uint8_t retry)
+{
+    uint32_t ms = DHCP_RETX_FIRST_MS << ((retry < 8) ? retry : 8);
+
+    return (ms < DHCP_RETX_MAX_MS) ? ms : DHCP_RETX_MAX_MS;
 }
 
 /**
- * @brief Called when a conflict is detected on the assigned IP.
+ * @brief Retransmit time while RENEWING/REBINDING: half of what is left to
+ *        @p limit, at least DHCP_RENEW_RETX_MIN_S, never past @p limit
  */
-static void on_dhcp_conflict(void)
+static uint32_t dhcp_renew_deadline(uint32_t now, uint32_t limit)
 {
-    DEBUG_PRINT("[DHCP] IP conflict detected.\r\n");
-    w5500_dhcp_stop();
-    ip_assigned_flag = false;
+    uint32_t left = limit - now;
+    uint32_t wait = left / 2U;
+    uint32_t min  = dhcp_s_to_ticks(DHCP_RENEW_RETX_MIN_S);
+
+    if (wait < min) {
+        wait = min;
+    }
+    return (wait < left) ? now + wait : limit;
 }
 
 /*============================================================================*/
-/*                         PUBLIC API IMPLEMENTATION                          */
+/*                         LEASE STORE                                        */
 /*============================================================================*/
 
-bool w5500_dhcp_init(void)
+static uint32_t dhcp_bkp_word(const uint8_t *b)
 {
-    printf("Initializing DHCP...\r\n");
-    if (dhcp_socket >= W5500_MAX_SOCKET) {
-        DEBUG_PRINT("[DHCP] Error: Invalid socket number %d\r\n", dhcp_socket);
-        return false;
+    uint32_t w;
+    memcpy(&w, b, sizeof(w));
+    return w;
+}
+
+static uint32_t dhcp_bkp_check(const uint32_t *words)
+{
+    uint32_t check = DHCP_LEASE_MAGIC;
+    for (uint8_t i = 0; i < (DHCP_BKP_WORDS - 1); i++) {
+        check = ((check << 5) | (check >> 27)) ^ words[i];
     }
+    return check;
+}
 
-    // DHCP_init is void and cannot fail, so we don't check its return value
-    printf("Calling DHCP_init...\r\n");
-    DHCP_init(dhcp_socket, dhcp_buffer);
+static volatile uint32_t *dhcp_bkp_regs(void)
+{
+    // TAMP registers sit in the backup domain, clocked by RTCAPB
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_RTCAPB_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+    return &TAMP->BKP0R + ETH_CONFIG_DHCP_BKP_FIRST;
+}
 
-    printf("Calling reg_dhcp_cbfunc\r\n");
-    reg_dhcp_cbfunc(on_dhcp_assigned, on_dhcp_assigned, on_dhcp_conflict);
-    ip_assigned_flag = false;
-    dhcp_retry = 0;
+__attribute__((weak)) bool w5500_dhcp_lease_load(w5500_dhcp_lease_t *lease)
+{
+    volatile uint32_t *bkp = dhcp_bkp_regs();
+    uint32_t words[DHCP_BKP_WORDS];
 
-    DEBUG_PRINT("[DHCP] DHCP client initialized on socket %d.\r\n", dhcp_socket);
+    for (uint8_t i = 0; i < DHCP_BKP_WORDS; i++) {
+        words[i] = bkp[i];
+    }
+    if (words[DHCP_BKP_WORDS - 1] != dhcp_bkp_check(words)) {
+        return false;
+    }
+    memcpy(lease->ip,     &words[0], 4);
+    memcpy(lease->gw,     &words[1], 4);
+    memcpy(lease->sn,     &words[2], 4);
+    memcpy(lease->dns,    &words[3], 4);
+    memcpy(lease->server, &words[4], 4);
+    lease->remaining_s = words[5];
     return true;
 }
 
-void w5500_dhcp_task1000ms(void)
+__attribute__((weak)) void w5500_dhcp_lease_save(const w5500_dhcp_lease_t *lease)
+{
+    volatile uint32_t *bkp = dhcp_bkp_regs();
+    uint32_t words[DHCP_BKP_WORDS] = {0};
+
+    if (lease != NULL) {
+        words[0] = dhcp_bkp_word(lease->ip);
+        words[1] = dhcp_bkp_word(lease->gw);
+        words[2] = dhcp_bkp_word(lease->sn);
+        words[3] = dhcp_bkp_word(lease->dns);
+        words[4] = dhcp_bkp_word(lease->server);
+        words[5] = lease->remaining_s;
+        words[6] = dhcp_bkp_check(words);
+    } else {
+        words[6] = ~dhcp_bkp_check(words);     // never valid
+    }
+    for (uint8_t i = 0; i < DHCP_BKP_WORDS; i++) {
+        bkp[i] = words[i];
+    }
+}
+
+static void dhcp_store_lease(uint32_t now)
 {
-	printf("Calling w5500_dhcp_task1000ms\r\n");
-    DHCP_time_handler();
+    uint32_t freq = osKernelGetTickFreq();
+
+    dhcp_lease.remaining_s = dhcp_due(now, dhcp_expiry) ? 0U : (dhcp_expiry - now) / freq;
+    w5500_dhcp_lease_save(&dhcp_lease);
+    dhcp_save_at = now + dhcp_s_to_ticks(ETH_CONFIG_DHCP_LEASE_SAVE_S);
 }
 
+/*============================================================================*/
+/*                         MESSAGES                                           */
+/*============================================================================*/
 
-uint8_t w5500_dhcp_task10ms(void)
+static uint8_t *dhcp_put_opt(uint8_t *p, uint8_t code, const uint8_t *data, uint8_t len)
 {
-    uint8_t dhcp_state = DHCP_run();
-    printf("Calling w5500_dhcp_task10ms\r\n");
+    *p++ = code;
+    *p++ = len;
+    memcpy(p, data, len);
+    return p + len;
+}
 
-    if (!ip_assigned_flag) {
-        switch (dhcp_state) {
-            case DHCP_IP_ASSIGN:
-            case DHCP_IP_CHANGED:
-                DEBUG_PRINT("[DHCP] New IP acquired.\r\n");
+/**
+ * @brief Build a client message in dhcp_buffer
+ * @param type      DHCP_DISCOVER, DHCP_REQUEST or DHCP_DECLINE
+ * @param ciaddr    Client address (RENEWING/REBINDING), NULL for 0.0.0.0
+ * @param req_ip    Option 50, NULL to leave out
+ * @param server    Option 54, NULL to leave out
+ * @return uint16_t Message length
+ */
+static uint16_t dhcp_build(uint8_t type, const uint8_t *ciaddr,
+                           const uint8_t *req_ip, const uint8_t *server)
+{
+    static const uint8_t params[] = {
+        DHCP_OPT_SUBNET, DHCP_OPT_ROUTER, DHCP_OPT_DNS,
+        DHCP_OPT_LEASE_TIME, DHCP_OPT_T1, DHCP_OPT_T2
+    };
+    uint8_t *p;
+    uint8_t client_id[7];
+
+    memset(dhcp_buffer, 0, DHCP_OFF_OPTIONS);
+    dhcp_buffer[DHCP_OFF_OP]    = DHCP_BOOTREQUEST;
+    dhcp_buffer[DHCP_OFF_HTYPE] = 1;                // Ethernet
+    dhcp_buffer[DHCP_OFF_HLEN]  = 6;
+    dhcp_buffer[DHCP_OFF_XID + 0] = (uint8_t)(dhcp_xid >> 24);
+    dhcp_buffer[DHCP_OFF_XID + 1] = (uint8_t)(dhcp_xid >> 16);
+    dhcp_buffer[DHCP_OFF_XID + 2] = (uint8_t)(dhcp_xid >> 8);
+    dhcp_buffer[DHCP_OFF_XID + 3] = (uint8_t)dhcp_xid;
+    if (ciaddr != NULL) {
+        memcpy(&dhcp_buffer[DHCP_OFF_CIADDR], ciaddr, 4);
+    } else {
+        // No address to receive a unicast reply on
+        dhcp_buffer[DHCP_OFF_FLAGS]     = (uint8_t)(DHCP_FLAG_BROADCAST >> 8);
+        dhcp_buffer[DHCP_OFF_FLAGS + 1] = (uint8_t)DHCP_FLAG_BROADCAST;
+    }
+    memcpy(&dhcp_buffer[DHCP_OFF_CHADDR], dhcp_mac, sizeof(dhcp_mac));
+    dhcp_buffer[DHCP_OFF_COOKIE + 0] = (uint8_t)(DHCP_MAGIC_COOKIE >> 24);
+    dhcp_buffer[DHCP_OFF_COOKIE + 1] = (uint8_t)(DHCP_MAGIC_COOKIE >> 16);
+    dhcp_buffer[DHCP_OFF_COOKIE + 2] = (uint8_t)(DHCP_MAGIC_COOKIE >> 8);
+    dhcp_buffer[DHCP_OFF_COOKIE + 3] = (uint8_t)DHCP_MAGIC_COOKIE;
+
+    p = &dhcp_buffer[DHCP_OFF_OPTIONS];
+    p = dhcp_put_opt(p, DHCP_OPT_MSG_TYPE, &type, 1);
+    client_id[0] = 1;                               // htype
+    memcpy(&client_id[1], dhcp_mac, sizeof(dhcp_mac));
+    p = dhcp_put_opt(p, DHCP_OPT_CLIENT_ID, client_id, sizeof(client_id));
+    if (req_ip != NULL) {
+        p = dhcp_put_opt(p, DHCP_OPT_REQUESTED_IP, req_ip, 4);
+    }
+    if (server != NULL) {
+        p = dhcp_put_opt(p, DHCP_OPT_SERVER_ID, server, 4);
+    }
+    if (type != DHCP_DECLINE) {
+        p = dhcp_put_opt(p, DHCP_OPT_PARAM_LIST, params, sizeof(params));
+    }
+    *p++ = DHCP_OPT_END;
+
+    uint16_t len = (uint16_t)(p - dhcp_buffer);
+    if (len < DHCP_MIN_LEN) {
+        memset(p, 0, DHCP_MIN_LEN - len);
+        len = DHCP_MIN_LEN;
+    }
+    return len;
+}
+
+/**
+ * @brief Build and send one client message
+ * @details Sent from whatever address is on the chip. Before a lease that is
+ *          the bring-up address, not the 0.0.0.0 RFC 2131 4.1 asks for:
+ *          clearing SIPR would cut off the services running on it. Servers
+ *          go by ciaddr (0 here) and the broadcast flag, not the IP source.
+ */
+static void dhcp_send(uint8_t type, const uint8_t *ciaddr, const uint8_t *req_ip,
+                      const uint8_t *server, const uint8_t *dest_ip)
+{
+    uint16_t len = dhcp_build(type, ciaddr, req_ip, server);
+
+    if (w5500_socket_sendto(dhcp_socket, dhcp_buffer, len, dest_ip, DHCP_SERVER_PORT) < 0) {
+        BINLOG_WARN("Send of message type %d failed", type);
+    }
+}
+
+static uint32_t dhcp_get_u32(const uint8_t *b)
+{
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+}
+
+/**
+ * @brief Check a server message in dhcp_buffer and pull out its options
+ * @return bool True if it is a reply to our current transaction
+ */
+static bool dhcp_parse(uint16_t len, dhcp_reply_t *reply)
+{
+    if ((len <= DHCP_OFF_OPTIONS) ||
+        (dhcp_buffer[DHCP_OFF_OP] != DHCP_BOOTREPLY) ||
+        (dhcp_get_u32(&dhcp_buffer[DHCP_OFF_XID]) != dhcp_xid) ||
+        (memcmp(&dhcp_buffer[DHCP_OFF_CHADDR], dhcp_mac, sizeof(dhcp_mac)) != 0) ||
+        (dhcp_get_u32(&dhcp_buffer[DHCP_OFF_COOKIE]) != DHCP_MAGIC_COOKIE)) {
+        return false;
+    }
+
+    memset(reply, 0, sizeof(*reply));
+    memcpy(reply->yiaddr, &dhcp_buffer[DHCP_OFF_YIADDR], 4);
+
+    uint16_t i = DHCP_OFF_OPTIONS;
+    while (i < len) {
+        uint8_t code = dhcp_buffer[i++];
+        if (code == DHCP_OPT_PAD) {
+            continue;
+        }
+        if ((code == DHCP_OPT_END) || (i >= len)) {
+            break;
+        }
+        uint8_t olen = dhcp_buffer[i++];
+        if ((uint16_t)(i + olen) > len) {
+            break;
+        }
+        const uint8_t *v = &dhcp_buffer[i];
+        switch (code) {
+            case DHCP_OPT_MSG_TYPE:
+                if (olen >= 1) reply->type = v[0];
+                break;
+            case DHCP_OPT_SERVER_ID:
+                if (olen >= 4) memcpy(reply->server, v, 4);
+                break;
+            case DHCP_OPT_SUBNET:
+                if (olen >= 4) memcpy(reply->sn, v, 4);
                 break;
+            case DHCP_OPT_ROUTER:
+                if (olen >= 4) memcpy(reply->gw, v, 4);
+                break;
+            case DHCP_OPT_DNS:
+                if (olen >= 4) memcpy(reply->dns, v, 4);
+                break;
+            case DHCP_OPT_LEASE_TIME:
+                if (olen >= 4) reply->lease_s = dhcp_get_u32(v);
+                break;
+            case DHCP_OPT_T1:
+                if (olen >= 4) reply->t1_s = dhcp_get_u32(v);
+                break;
+            case DHCP_OPT_T2:
+                if (olen >= 4) reply->t2_s = dhcp_get_u32(v);
+                break;
+            default:
+                break;
+        }
+        i += olen;
+    }
+    return reply->type != 0;
+}
 
-            case DHCP_FAILED:
-                dhcp_retry++;
-                DEBUG_PRINT("[DHCP] Retry %d/%d\r\n", dhcp_retry, DHCP_MAX_RETRY_COUNT);
+/*============================================================================*/
+/*                         STATE MACHINE                                      */
+/*============================================================================*/
 
-                if (dhcp_retry > DHCP_MAX_RETRY_COUNT) {
-                    DEBUG_PRINT("[DHCP] Max retry exceeded. Falling back to static IP.\r\n");
-                    w5500_dhcp_stop();
+static void dhcp_new_xid(void)
+{
+    dhcp_xid = (dhcp_xid * 1664525UL) + 1013904223UL;
+    dhcp_xid ^= osKernelGetTickCount();
+}
 
-                    // Apply static config fallback
-                    eth_config_init_static();  // Load from eth_config.h
-                    eth_config_set_netinfo(&g_network_info);  // Apply to W5500
-                    printf("[DHCP] Static IP fallback applied.\r\n");
+/**
+ * @brief Enter @p state; its first message goes out on the next run
+ */
+static void dhcp_enter(w5500_dhcp_state_t state, uint32_t delay_ticks)
+{
+    dhcp_state = state;
+    dhcp_retry = 0;
+    dhcp_deadline = osKernelGetTickCount() + delay_ticks;
+    if ((state == W5500_DHCP_SELECTING) || (state == W5500_DHCP_REBOOTING) ||
+        (state == W5500_DHCP_RENEWING)) {
+        dhcp_new_xid();
+    }
+}
 
-                    ip_assigned_flag = true;  // Stop retry attempts
+static void dhcp_apply(const uint8_t *ip)
+{
+    memcpy(g_network_info.mac, dhcp_mac, sizeof(dhcp_mac));
+    memcpy(g_network_info.ip,  ip,             4);
+    memcpy(g_network_info.gw,  dhcp_lease.gw,  4);
+    memcpy(g_network_info.sn,  dhcp_lease.sn,  4);
+    memcpy(g_network_info.dns, dhcp_lease.dns, 4);
+    g_network_info.dhcp = NETINFO_DHCP;
+
+    eth_config_set_netinfo(&g_network_info);
+}
+
+/**
+ * @brief Stop using the lease (NAK, expiry or conflict) and start over on the
+ *        bring-up address, so services keep running while DHCP negotiates
+ */
+static void dhcp_drop_lease(uint32_t delay_ticks)
+{
+    w5500_dhcp_lease_save(NULL);
+    eth_config_init_bringup();
+#if (ETH_CONFIG_BRINGUP_MODE == ETH_CONFIG_BRINGUP_LINKLOCAL)
+    (void)eth_config_claim_linklocal();
+#else
+    eth_config_set_netinfo(&g_network_info);
+#endif
+    dhcp_enter(W5500_DHCP_SELECTING, delay_ticks);
+}
+
+static void dhcp_fallback_static(void)
+{
+    BINLOG_WARN("Max retry exceeded. Falling back to static IP");
+    w5500_dhcp_stop();
+
+    // Apply static config fallback
+    eth_config_init_static();  // Load from eth_config.h
+    eth_config_set_netinfo(&g_network_info);  // Apply to W5500
+    BINLOG_INFO("Static IP fallback applied");
+
+    dhcp_state = W5500_DHCP_STATIC;
+}
+
+/**
+ * @brief ARP probe of a freshly offered address (same check as the ioLibrary
+ *        client): a datagram that gets out means someone answered the ARP
+ * @details The ARP requests come from the bring-up address: it carries
+ *          service traffic, so SIPR is not cleared for the probe as the
+ *          ioLibrary client does. An offer off the bring-up subnet cannot be
+ *          probed (the chip would ARP the gateway) and is taken unprobed.
+ * @return bool True if another host holds the address
+ */
+static bool dhcp_conflict(void)
+{
+    int8_t ret = w5500_socket_arp_probe(dhcp_socket, dhcp_lease.ip, DHCP_CONFLICT_RCR);
+
+    if (ret == W5500_SOCK_ERROR) {
+        BINLOG_WARN("Offered address not probed");
+    }
+    return ret == W5500_SOCK_BUSY;
+}
+
+static void dhcp_bind(const dhcp_reply_t *reply)
+{
+    bool reboot = (dhcp_state == W5500_DHCP_REBOOTING);
+    bool fresh  = (dhcp_state == W5500_DHCP_REQUESTING) || reboot;
+    uint32_t lease_s = (reply->lease_s != 0U) ? reply->lease_s : DHCP_DEFAULT_LEASE_S;
+    uint32_t t1_s = (reply->t1_s != 0U) ? reply->t1_s : lease_s / 2U;
+    uint32_t t2_s = (reply->t2_s != 0U) ? reply->t2_s : (uint32_t)(((uint64_t)lease_s * 7U) / 8U);
+
+    memcpy(dhcp_lease.ip, reply->yiaddr, 4);
+    memcpy(dhcp_lease.sn, reply->sn, 4);
+    memcpy(dhcp_lease.gw, reply->gw, 4);
+    memcpy(dhcp_lease.dns, reply->dns, 4);
+    if (memcmp(reply->server, DHCP_ZERO_IP, 4) != 0) {
+        memcpy(dhcp_lease.server, reply->server, 4);
+    }
+
+    // Times count from the REQUEST that got this ACK
+    dhcp_t1     = dhcp_t_sent + dhcp_s_to_ticks(t1_s);
+    dhcp_t2     = dhcp_t_sent + dhcp_s_to_ticks(t2_s);
+    dhcp_expiry = dhcp_t_sent + dhcp_s_to_ticks(lease_s);
+
+    // A rebooted lease was ours and the server vouched for it: skip the
+    // probe so the address is usable after this single round trip. The
+    // probe runs before the address goes on the chip, so neither it nor
+    // the DECLINE comes from the contested address
+    if (fresh && !reboot && dhcp_conflict()) {
+        BINLOG_WARN("IP conflict detected");
+        dhcp_send(DHCP_DECLINE, NULL, dhcp_lease.ip, dhcp_lease.server, DHCP_BROADCAST_IP);
+        dhcp_drop_lease(dhcp_ms_to_ticks(DHCP_DECLINE_WAIT_MS));
+        return;
+    }
+
+    // Every ACK: a RENEW/REBIND may move the gateway, mask or DNS too, and
+    // eth_config_set_netinfo() only writes (and notifies) what changed
+    dhcp_apply(dhcp_lease.ip);
+
+    uint32_t now = osKernelGetTickCount();
+    dhcp_store_lease(now);
+    dhcp_state = W5500_DHCP_BOUND;
+    dhcp_retry = 0;
+    dhcp_deadline = dhcp_t1;
+
+    if (fresh) {
+        BINLOG_INFO("IP assigned %d.%d.%d.%d, lease %u s", dhcp_lease.ip[0], dhcp_lease.ip[1],
+                    dhcp_lease.ip[2], dhcp_lease.ip[3], lease_s);
+    } else {
+        BINLOG_INFO("Lease renewed, %u s", lease_s);
+    }
+}
+
+static void dhcp_handle(const dhcp_reply_t *reply)
+{
+    switch (dhcp_state) {
+        case W5500_DHCP_SELECTING:
+            // First OFFER wins
+            if ((reply->type == DHCP_OFFER) && (memcmp(reply->server, DHCP_ZERO_IP, 4) != 0)) {
+                memcpy(dhcp_lease.ip, reply->yiaddr, 4);
+                memcpy(dhcp_lease.server, reply->server, 4);
+                dhcp_state = W5500_DHCP_REQUESTING;
+                dhcp_retry = 0;
+                dhcp_deadline = osKernelGetTickCount();     // REQUEST now, same xid
+            }
+            break;
+
+        case W5500_DHCP_REQUESTING:
+        case W5500_DHCP_REBOOTING:
+        case W5500_DHCP_RENEWING:
+        case W5500_DHCP_REBINDING:
+            if (reply->type == DHCP_ACK) {
+                dhcp_bind(reply);
+            } else if (reply->type == DHCP_NAK) {
+                BINLOG_WARN("NAK in state %d", dhcp_state);
+                dhcp_drop_lease(0);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// RECV fires once per arrival burst: drain every queued datagram.
+// Each one is validated from its ring header and copied whole into
+// dhcp_buffer; anything else is released without being read.
+static void dhcp_receive(void)
+{
+    w5500_rx_span_t span;
+    uint8_t head[W5500_UDP_HDR_LEN];
+    dhcp_reply_t reply;
+
+    while ((w5500_socket_peek(dhcp_socket, &span) == W5500_SOCK_OK) && (span.len > 0)) {
+        while (span.len >= W5500_UDP_HDR_LEN) {
+            if (w5500_socket_peek_read(dhcp_socket, &span, 0, head, sizeof(head)) < (int32_t)sizeof(head)) {
+                return;
+            }
+            uint16_t src_port  = (uint16_t)((head[4] << 8) | head[5]);
+            uint16_t len       = (uint16_t)((head[6] << 8) | head[7]);
+            uint16_t dgram_len = (uint16_t)(W5500_UDP_HDR_LEN + len);
+            bool valid = false;
+
+            if ((src_port == DHCP_SERVER_PORT) && (len <= sizeof(dhcp_buffer)) &&
+                (dgram_len <= span.len) &&
+                (w5500_socket_peek_read(dhcp_socket, &span, W5500_UDP_HDR_LEN,
+                                        dhcp_buffer, len) == (int32_t)len)) {
+                valid = dhcp_parse(len, &reply);
+            }
+            if (w5500_socket_consume(dhcp_socket, &span,
+                                     (dgram_len < span.len) ? dgram_len : span.len) != W5500_SOCK_OK) {
+                return;
+            }
+            if (valid) {
+                dhcp_handle(&reply);
+                if (dhcp_socket >= W5500_MAX_SOCKET) {
+                    return;
                 }
-                break;
+            }
+        }
+        if (span.len > 0) {
+            // Partial header: the chip writes whole datagrams, so this is a
+            // desynchronised ring. Drop it.
+            w5500_socket_consume(dhcp_socket, &span, span.len);
+        }
+    }
+}
+
+/**
+ * @brief Retransmit or state timer expired
+ */
+static void dhcp_timeout(uint32_t now)
+{
+    switch (dhcp_state) {
+        case W5500_DHCP_SELECTING:
+            if (dhcp_retry >= DHCP_MAX_RETRY_COUNT) {
+                dhcp_fallback_static();
+                return;
+            }
+            if (dhcp_retry > 0) {
+                BINLOG_WARN("Retry %d/%d", dhcp_retry, DHCP_MAX_RETRY_COUNT);
+            }
+            dhcp_send(DHCP_DISCOVER, NULL, NULL, NULL, DHCP_BROADCAST_IP);
+            dhcp_deadline = now + dhcp_ms_to_ticks(dhcp_backoff_ms(dhcp_retry));
+            break;
+
+        case W5500_DHCP_REQUESTING:
+            if (dhcp_retry >= DHCP_REQUEST_TRIES) {
+                dhcp_enter(W5500_DHCP_SELECTING, 0);
+                return;
+            }
+            dhcp_send(DHCP_REQUEST, NULL, dhcp_lease.ip, dhcp_lease.server, DHCP_BROADCAST_IP);
+            dhcp_t_sent = now;
+            dhcp_deadline = now + dhcp_ms_to_ticks(dhcp_backoff_ms(dhcp_retry));
+            break;
+
+        case W5500_DHCP_REBOOTING:
+            if (dhcp_retry >= DHCP_REBOOT_TRIES) {
+                BINLOG_INFO("No answer to INIT-REBOOT, discovering");
+                dhcp_enter(W5500_DHCP_SELECTING, 0);
+                return;
+            }
+            // RFC 2131 4.3.2: requested IP, no server id, ciaddr 0
+            dhcp_send(DHCP_REQUEST, NULL, dhcp_lease.ip, NULL, DHCP_BROADCAST_IP);
+            dhcp_t_sent = now;
+            dhcp_deadline = now + dhcp_ms_to_ticks(DHCP_REBOOT_RETX_MS);
+            break;
+
+        case W5500_DHCP_BOUND:
+            dhcp_enter(W5500_DHCP_RENEWING, 0);
+            return;
+
+        case W5500_DHCP_RENEWING:
+            if (dhcp_due(now, dhcp_t2)) {
+                dhcp_enter(W5500_DHCP_REBINDING, 0);
+                return;
+            }
+            dhcp_send(DHCP_REQUEST, dhcp_lease.ip, NULL, NULL, dhcp_lease.server);
+            dhcp_t_sent = now;
+            dhcp_deadline = dhcp_renew_deadline(now, dhcp_t2);
+            break;
+
+        case W5500_DHCP_REBINDING:
+            if (dhcp_due(now, dhcp_expiry)) {
+                BINLOG_WARN("Lease expired");
+                dhcp_drop_lease(0);
+                return;
+            }
+            dhcp_send(DHCP_REQUEST, dhcp_lease.ip, NULL, NULL, DHCP_BROADCAST_IP);
+            dhcp_t_sent = now;
+            dhcp_deadline = dhcp_renew_deadline(now, dhcp_expiry);
+            break;
+
+        default:
+            return;
+    }
+    dhcp_retry++;
+}
+
+static bool dhcp_has_lease(void)
+{
+    return (dhcp_state == W5500_DHCP_BOUND) || (dhcp_state == W5500_DHCP_RENEWING) ||
+           (dhcp_state == W5500_DHCP_REBINDING);
+}
+
+/**
+ * @brief Process received replies and expired timers
+ * @param received  RECV was signalled for the socket
+ * @return uint32_t Ticks until the next timer, osWaitForever if none
+ */
+static uint32_t dhcp_run(bool received)
+{
+    if (dhcp_socket >= W5500_MAX_SOCKET) {
+        return osWaitForever;
+    }
+    if (received) {
+        dhcp_receive();
+    }
+
+    // A timer can move to a state whose first message is due at once
+    uint32_t now = osKernelGetTickCount();
+    while ((dhcp_socket < W5500_MAX_SOCKET) && dhcp_due(now, dhcp_deadline)) {
+        dhcp_timeout(now);
+        now = osKernelGetTickCount();
+    }
+    if (dhcp_socket >= W5500_MAX_SOCKET) {
+        return osWaitForever;
+    }
+
+    uint32_t next = dhcp_deadline;
+    if (dhcp_has_lease()) {
+        if (dhcp_due(now, dhcp_save_at)) {
+            dhcp_store_lease(now);
+        }
+        if ((int32_t)(dhcp_save_at - next) < 0) {
+            next = dhcp_save_at;
+        }
+    }
+    return dhcp_due(now, next) ? 0U : next - now;
+}
+
+/*============================================================================*/
+/*                         PUBLIC API IMPLEMENTATION                          */
+/*============================================================================*/
+
+bool w5500_dhcp_init(void)
+{
+    // Held until w5500_dhcp_stop()
+    if ((dhcp_socket >= W5500_MAX_SOCKET) &&
+        (w5500_socket_alloc("dhcp", ETH_CONFIG_DHCP_SOCK_MASK, &dhcp_socket) != W5500_SOCK_OK)) {
+        BINLOG_ERROR("No free socket for DHCP");
+        dhcp_socket = W5500_MAX_SOCKET;
+        return false;
+    }
+    if (w5500_socket_open(dhcp_socket, W5500_SOCK_UDP, DHCP_CLIENT_PORT) != W5500_SOCK_OK) {
+        BINLOG_ERROR("DHCP socket open failed");
+        w5500_socket_release(dhcp_socket);
+        dhcp_socket = W5500_MAX_SOCKET;
+        return false;
+    }
+
+    getSHAR(dhcp_mac);
+    dhcp_xid ^= HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2() ^ dhcp_get_u32(&dhcp_mac[2]);
+
+    memset(&dhcp_lease, 0, sizeof(dhcp_lease));
+    if (w5500_dhcp_lease_load(&dhcp_lease) && (dhcp_lease.remaining_s > 0U)) {
+        BINLOG_INFO("INIT-REBOOT with %d.%d.%d.%d", dhcp_lease.ip[0], dhcp_lease.ip[1],
+                    dhcp_lease.ip[2], dhcp_lease.ip[3]);
+        dhcp_enter(W5500_DHCP_REBOOTING, 0);
+    } else {
+        memset(&dhcp_lease, 0, sizeof(dhcp_lease));
+#if (ETH_CONFIG_BRINGUP_MODE == ETH_CONFIG_BRINGUP_LINKLOCAL)
+        // w5500_spi_init() applied the bring-up address unprobed
+        (void)eth_config_claim_linklocal();
+#endif
+        dhcp_enter(W5500_DHCP_SELECTING, 0);
+    }
+
+    BINLOG_INFO("DHCP client initialized on socket %d", dhcp_socket);
+    return true;
+}
+
+void w5500_dhcp_task(void *argument)
+{
+    (void)argument;
+
+    for (;;) {
+        if (dhcp_socket >= W5500_MAX_SOCKET) {
+            // Stopped or static fallback: wait for a re-init
+            osDelay(100);
+            continue;
         }
+        uint32_t events = w5500_irq_wait(dhcp_socket, W5500_IRQ_RECV, dhcp_run(false));
+        dhcp_run(events != 0);
     }
+}
 
+w5500_dhcp_state_t w5500_dhcp_task10ms(void)
+{
+    // Read the socket only if the INT dispatcher latched RECV
+    bool received = (dhcp_socket < W5500_MAX_SOCKET) &&
+                    (w5500_irq_wait(dhcp_socket, W5500_IRQ_RECV, 0) != 0);
+
+    dhcp_run(received);
     return dhcp_state;
 }
 
+w5500_dhcp_state_t w5500_dhcp_get_state(void)
+{
+    return dhcp_state;
+}
 
 void w5500_dhcp_stop(void)
 {
-    DHCP_stop();
-    ip_assigned_flag = false;
-    DEBUG_PRINT("[DHCP] DHCP client stopped.\r\n");
+    if (dhcp_socket < W5500_MAX_SOCKET) {
+        w5500_socket_close(dhcp_socket);
+        w5500_socket_release(dhcp_socket);
+        dhcp_socket = W5500_MAX_SOCKET;
+    }
+    dhcp_state = W5500_DHCP_STOPPED;
+    BINLOG_INFO("DHCP client stopped");
 }
 
 void w5500_getInfo(void)
@@ -151,12 +832,15 @@ void w5500_getInfo(void)
     wiz_NetInfo net;
     eth_config_get_netinfo(&net);
 
-    printf("--- W5500 Network Information (from DHCP) ---\r\n");
-    printf("  IP Address: %d.%d.%d.%d\r\n", net.ip[0], net.ip[1], net.ip[2], net.ip[3]);
-    printf("  Gateway:    %d.%d.%d.%d\r\n", net.gw[0], net.gw[1], net.gw[2], net.gw[3]);
-    printf("  Subnet Mask:%d.%d.%d.%d\r\n", net.sn[0], net.sn[1], net.sn[2], net.sn[3]);
-    printf("  DNS Server: %d.%d.%d.%d\r\n", net.dns[0], net.dns[1], net.dns[2], net.dns[3]);
-    printf("  DHCP Mode:  %s\r\n", net.dhcp == NETINFO_DHCP ? "DHCP" : "STATIC");
-    printf("  Lease Time: %lu seconds\r\n", getDHCPLeasetime());
-    printf("---------------------------------------------\r\n");
+    BINLOG_INFO("IP Address: %d.%d.%d.%d", net.ip[0], net.ip[1], net.ip[2], net.ip[3]);
+    BINLOG_INFO("Gateway:    %d.%d.%d.%d", net.gw[0], net.gw[1], net.gw[2], net.gw[3]);
+    BINLOG_INFO("Subnet Mask:%d.%d.%d.%d", net.sn[0], net.sn[1], net.sn[2], net.sn[3]);
+    BINLOG_INFO("DNS Server: %d.%d.%d.%d", net.dns[0], net.dns[1], net.dns[2], net.dns[3]);
+    BINLOG_INFO("DHCP Mode:  %c (D = DHCP, S = STATIC)", net.dhcp == NETINFO_DHCP ? 'D' : 'S');
+    BINLOG_INFO("DHCP State: %d", dhcp_state);
+    if (dhcp_has_lease()) {
+        uint32_t now = osKernelGetTickCount();
+        BINLOG_INFO("Lease Time: %u seconds left",
+                    dhcp_due(now, dhcp_expiry) ? 0U : (dhcp_expiry - now) / osKernelGetTickFreq());
+    }
 }
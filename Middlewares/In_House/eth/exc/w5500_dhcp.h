@@ -1,74 +1,138 @@
 /*============================================================================*/
-/** @section DHCP CLIENT SERVICE (Socket 0)
- *  @brief DHCP initialization, periodic handler, and IP assignment
+/** @section DHCP CLIENT SERVICE
+ *  @brief DHCP initialization, event-driven handler, and IP assignment
  *  @details All DHCP-related logic and state management for dynamic IP
- *           assignment. Socket defined by ETH_CONFIG_DHCP_SOCKET.
+ *           assignment. Socket taken from the w5500_socket pool
+ *           (ETH_CONFIG_DHCP_SOCK_MASK) and returned on stop.
+ *
+ *           The last lease is kept across resets (w5500_dhcp_lease_save()).
+ *           At init a saved lease is confirmed with an INIT-REBOOT REQUEST,
+ *           so the address is back after one round trip; DISCOVER/OFFER is
+ *           only run when there is no lease or the server refuses it.
+ *           The engine sleeps until a reply arrives or a lease/retransmit
+ *           timer expires (w5500_dhcp_task()).
+ *
+ *           Negotiation runs on the bring-up address applied by
+ *           w5500_spi_init() (ETH_CONFIG_BRINGUP_MODE), so services start
+ *           at once. The lease replaces it in one eth_config_set_netinfo()
+ *           call and eth_config listeners are told to rebind. A link-local
+ *           bring-up address is ARP-probed (eth_config_claim_linklocal())
+ *           at init without a saved lease and whenever a lease is dropped.
+ *           Unlike RFC 2131 4.1, DISCOVER and the REQUESTs before a lease go
+ *           out with the bring-up address as IP source rather than 0.0.0.0,
+ *           and the conflict probe of an offer comes from it too: SIPR is
+ *           never cleared while it carries service traffic.
  *============================================================================*/
  #ifndef _W5500_DHCP_H_
  #define _W5500_DHCP_H_
- 
+
  #ifdef __cplusplus
  extern "C" {
  #endif
- 
+
 #include <stdint.h> // For uint8_t
 #include <stdbool.h>
 #include <string.h>
-#include "stm32f1xx_hal.h" // For HAL (if needed)
+#include "stm32g4xx_hal.h" // For HAL (if needed)
 
 #include "w5500_spi.h"
 #include "eth_config.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/socket.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/wizchip_conf.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/W5500/w5500.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Internet/DHCP/dhcp.h"
+#include "socket.h"
+#include "wizchip_conf.h"
+#include "w5500.h"
+
+
+ /**
+  * @brief DHCP client states (RFC 2131 figure 5)
+  */
+ typedef enum {
+     W5500_DHCP_STOPPED = 0,   /**< Not initialised or stopped */
+     W5500_DHCP_SELECTING,     /**< DISCOVER sent, waiting for an OFFER */
+     W5500_DHCP_REQUESTING,    /**< REQUEST for an OFFER sent */
+     W5500_DHCP_REBOOTING,     /**< INIT-REBOOT REQUEST for the saved lease sent */
+     W5500_DHCP_BOUND,         /**< Address in use, waiting for T1 */
+     W5500_DHCP_RENEWING,      /**< Past T1, REQUEST unicast to the server */
+     W5500_DHCP_REBINDING,     /**< Past T2, REQUEST broadcast to any server */
+     W5500_DHCP_STATIC         /**< Gave up, static fallback applied */
+ } w5500_dhcp_state_t;
 
+ /**
+  * @brief Lease kept across resets
+  */
+ typedef struct {
+     uint8_t  ip[4];
+     uint8_t  gw[4];
+     uint8_t  sn[4];
+     uint8_t  dns[4];
+     uint8_t  server[4];       /**< Server identifier (option 54) */
+     uint32_t remaining_s;     /**< Seconds of lease left when saved */
+ } w5500_dhcp_lease_t;
 
- // Define the socket number to be used for DHCP.
- // You might want to adjust this based on your W5500's socket allocation.
- #define W5500_DHCP_DEFAULT_SOCKET 0
- 
  /**
   * @brief Initializes the W5500 DHCP client.
-  * This function sets up the DHCP socket and prepares the client for
-  * the DHCP negotiation process. It should be called once during system startup.
+  * Takes a socket from the pool, opens it on port 68 and starts with an
+  * INIT-REBOOT REQUEST when a saved lease exists, a DISCOVER otherwise.
+  * Nothing is sent until the first w5500_dhcp_task() / w5500_dhcp_task10ms().
   * @return bool True if initialization was successful, false otherwise
   */
  bool w5500_dhcp_init(void);
- 
+
+ /**
+  * @brief DHCP thread body.
+  * Blocks on the socket RECV event with the time left to the next
+  * retransmit or lease timer as timeout, so it only runs when there is
+  * something to do. Do not mix with w5500_dhcp_task10ms().
+  */
+ void w5500_dhcp_task(void *argument);
+
  /**
-  * @brief DHCP 1000ms (1 second) task handler.
-  * This function should be called periodically every 1000ms (1 second)
-  * to handle DHCP lease time tracking and renewal.
+  * @brief Polled alternative to w5500_dhcp_task().
+  * Any period works: timers run on the kernel tick and the socket is only
+  * read when the INT dispatcher latched RECV.
+  * @return Current DHCP state
   */
- void w5500_dhcp_task1000ms(void);
- 
+ w5500_dhcp_state_t w5500_dhcp_task10ms(void);
+
  /**
-  * @brief DHCP 10ms task handler.
-  * This function should be called frequently, ideally every 10ms,
-  * to process incoming DHCP messages and manage the DHCP state machine.
-  * @return Returns the current DHCP state (e.g., DHCP_RUNNING, DHCP_IP_ASSIGN, etc.)
-  * as defined in dhcp.h.
+  * @brief Current DHCP state
   */
- uint8_t w5500_dhcp_task10ms(void);
- 
+ w5500_dhcp_state_t w5500_dhcp_get_state(void);
+
  /**
   * @brief Stops the W5500 DHCP client.
   * This function closes the DHCP socket and stops the DHCP processing.
-  * To restart, call w5500_dhcp_init() and then continue calling w5500_dhcp_task10ms().
+  * The address in use and the saved lease are left as they are.
+  * To restart, call w5500_dhcp_init().
   */
  void w5500_dhcp_stop(void);
- 
+
+ /**
+  * @brief Load the lease saved by w5500_dhcp_lease_save().
+  * Weak: the default reads the TAMP backup registers from
+  * ETH_CONFIG_DHCP_BKP_FIRST (7 registers, kept while VDD or VBAT is up).
+  * Override to keep the lease in flash.
+  * @return bool True if @p lease holds a valid record
+  */
+ bool w5500_dhcp_lease_load(w5500_dhcp_lease_t *lease);
+
+ /**
+  * @brief Save the lease, or erase it when @p lease is NULL.
+  * Weak, see w5500_dhcp_lease_load(). Called on every ACK, on NAK/expiry
+  * (NULL) and every ETH_CONFIG_DHCP_LEASE_SAVE_S while bound to refresh
+  * remaining_s; a flash implementation may skip those refreshes.
+  */
+ void w5500_dhcp_lease_save(const w5500_dhcp_lease_t *lease);
+
  /**
   * @brief Retrieves and prints the network information obtained via DHCP.
   * This includes the allocated IP address, Gateway, Subnet Mask, and DNS server.
   * Requires <stdio.h> for printing.
   */
  void w5500_getInfo(void);
- 
+
  #ifdef __cplusplus
  }
  #endif
- 
+
  #endif // _W5500_DHCP_H_
- 
+
@@ -0,0 +1,685 @@
+/**
+ * @file    w5500_dns.c
+ * @brief   Caching DNS resolver (A records) for the W5500 socket layer
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_dns.h"
+ #include "w5500_socket.h"
+ #include "w5500_irq.h"
+ #include "eth_config.h"
+ #include "FreeRTOS.h"
+ #include "event_groups.h"
+ #include <string.h>
+
+ #define BINLOG_MODULE        "w5500_dns"
+ #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ #include "binlog.h"
+
+ // Sockets the resolver may take from the pool
+ #ifndef ETH_CONFIG_DNS_SOCK_MASK
+ #define ETH_CONFIG_DNS_SOCK_MASK W5500_SOCK_ANY
+ #endif
+
+ #define DNS_SERVER_PORT     53
+ #define DNS_MSG_MAX         512     // RFC 1035 UDP limit, no EDNS
+ #define DNS_HDR_LEN         12
+ #define DNS_QUERY_MAX       (DNS_HDR_LEN + W5500_DNS_NAME_MAX + 1 + 4)
+ #define DNS_FLAGS_RD        0x0100U
+ #define DNS_FLAGS_QR        0x8000U
+ #define DNS_RCODE_NXDOMAIN  3
+ #define DNS_TYPE_A          1
+ #define DNS_CLASS_IN        1
+
+ #define DNS_RETX_MS         1000U   // doubled per retry
+ #define DNS_MAX_TRIES       3
+ #define DNS_TTL_MIN_S       1U      // long enough for a waiter to collect it
+ #define DNS_TTL_MAX_S       86400U
+ #define DNS_NEG_TTL_S       30U     // NXDOMAIN / no A record
+ #define DNS_FAIL_TTL_S      5U      // timeout / server failure
+
+ typedef struct {
+     char     name[W5500_DNS_NAME_MAX];   // "" = free
+     uint8_t  ip[4];
+     int8_t   status;                     // W5500_DNS_OK or a cached failure
+     uint32_t expires;                    // kernel tick
+     uint32_t used;                       // last hit, for LRU eviction
+ } dns_entry_t;
+
+ typedef struct {
+     char     name[W5500_DNS_NAME_MAX];   // "" = free
+     uint16_t id;
+     uint8_t  tries;
+     uint32_t deadline;
+ } dns_query_t;
+
+ static uint8_t dns_socket = W5500_MAX_SOCKET;    // none until init
+ static uint8_t dns_buffer[DNS_MSG_MAX];
+ static dns_entry_t dns_cache[W5500_DNS_CACHE_SIZE];
+ static dns_query_t dns_queries[W5500_DNS_MAX_QUERIES];
+ static osEventFlagsId_t dns_done;                // bit n: query slot n completed
+ static StaticEventGroup_t dns_done_cb;
+ static osMutexId_t dns_mutex;                    // cache, queries and dns_socket
+ static StaticSemaphore_t dns_mutex_cb;
+ static uint32_t dns_seed;
+ static bool dns_subscribed;
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ static bool dns_due(uint32_t now, uint32_t tick)
+ {
+     return (int32_t)(now - tick) >= 0;
+ }
+
+ static char dns_lower(char c)
+ {
+     return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+ }
+
+ static bool dns_name_eq(const char *a, const char *b)
+ {
+     while ((*a != '\0') && (dns_lower(*a) == dns_lower(*b))) {
+         a++;
+         b++;
+     }
+     return dns_lower(*a) == dns_lower(*b);
+ }
+
+ static bool dns_parse_quad(const char *name, uint8_t ip[4])
+ {
+     uint8_t n = 0;
+     uint16_t v = 0;
+     bool digit = false;
+
+     for (;; name++) {
+         if ((*name >= '0') && (*name <= '9')) {
+             v = (uint16_t)(v * 10U + (uint16_t)(*name - '0'));
+             if (v > 255U) {
+                 return false;
+             }
+             digit = true;
+         } else if (((*name == '.') || (*name == '\0')) && digit && (n < 4)) {
+             ip[n++] = (uint8_t)v;
+             if (*name == '\0') {
+                 return n == 4;
+             }
+             v = 0;
+             digit = false;
+         } else {
+             return false;
+         }
+     }
+ }
+
+ static uint16_t dns_next_id(void)
+ {
+     // xorshift32, reseeded with the tick so ids differ across resets
+     dns_seed ^= osKernelGetTickCount();
+     dns_seed ^= dns_seed << 13;
+     dns_seed ^= dns_seed >> 17;
+     dns_seed ^= dns_seed << 5;
+     return (uint16_t)dns_seed;
+ }
+
+ static uint32_t dns_ttl_ticks(uint32_t ttl_s)
+ {
+     if (ttl_s < DNS_TTL_MIN_S) {
+         ttl_s = DNS_TTL_MIN_S;
+     } else if (ttl_s > DNS_TTL_MAX_S) {
+         ttl_s = DNS_TTL_MAX_S;
+     }
+     return ttl_s * osKernelGetTickFreq();
+ }
+
+ static uint32_t dns_ms_to_ticks(uint32_t ms)
+ {
+     return (uint32_t)(((uint64_t)ms * osKernelGetTickFreq()) / 1000U);
+ }
+
+ static uint16_t dns_get16(const uint8_t *b)
+ {
+     return (uint16_t)((b[0] << 8) | b[1]);
+ }
+
+ /*============================================================================*/
+ /*                         CACHE                                              */
+ /*============================================================================*/
+
+ static dns_entry_t *dns_cache_find(const char *name, uint32_t now)
+ {
+     for (uint8_t i = 0; i < W5500_DNS_CACHE_SIZE; i++) {
+         dns_entry_t *e = &dns_cache[i];
+         if (e->name[0] == '\0') {
+             continue;
+         }
+         if (dns_due(now, e->expires)) {
+             e->name[0] = '\0';
+         } else if (dns_name_eq(e->name, name)) {
+             e->used = now;
+             return e;
+         }
+     }
+     return NULL;
+ }
+
+ static void dns_cache_put(const char *name, int8_t status, const uint8_t *ip,
+                           uint32_t ttl_s, uint32_t now)
+ {
+     dns_entry_t *e = dns_cache_find(name, now);
+
+     // Free slot, else the least recently used one
+     for (uint8_t i = 0; (e == NULL) && (i < W5500_DNS_CACHE_SIZE); i++) {
+         if (dns_cache[i].name[0] == '\0') {
+             e = &dns_cache[i];
+         }
+     }
+     if (e == NULL) {
+         e = &dns_cache[0];
+         for (uint8_t i = 1; i < W5500_DNS_CACHE_SIZE; i++) {
+             if ((int32_t)(dns_cache[i].used - e->used) < 0) {
+                 e = &dns_cache[i];
+             }
+         }
+     }
+
+     strcpy(e->name, name);
+     e->status  = status;
+     e->expires = now + dns_ttl_ticks(ttl_s);
+     e->used    = now;
+     if (ip != NULL) {
+         memcpy(e->ip, ip, 4);
+     } else {
+         memset(e->ip, 0, 4);
+     }
+ }
+
+ /*============================================================================*/
+ /*                         QUERIES                                            */
+ /*============================================================================*/
+
+ /**
+  * @brief Append @p name as DNS labels at @p p
+  * @return Bytes written, 0 if a label is empty or longer than 63
+  */
+ static uint16_t dns_encode_name(uint8_t *p, const char *name)
+ {
+     uint8_t *start = p;
+
+     while (*name != '\0') {
+         const char *dot = strchr(name, '.');
+         size_t len = (dot != NULL) ? (size_t)(dot - name) : strlen(name);
+         if ((len == 0U) || (len > 63U)) {
+             return 0;
+         }
+         *p++ = (uint8_t)len;
+         memcpy(p, name, len);
+         p += len;
+         name += len;
+         if (*name == '.') {
+             name++;
+         }
+     }
+     *p++ = 0;
+     return (uint16_t)(p - start);
+ }
+
+ /**
+  * @brief Build the next transmission of @p q into @p msg and arm its
+  *        retransmit timer. Called with dns_mutex held; the caller sends
+  *        @p msg with dns_transmit() once it has dropped the mutex.
+  * @return Message length, 0 if no DNS server is configured
+  */
+ static uint16_t dns_prepare(dns_query_t *q, uint32_t now, uint8_t msg[DNS_QUERY_MAX], uint8_t server[4])
+ {
+     static const uint8_t zero_ip[4] = {0, 0, 0, 0};
+
+     if (memcmp(g_network_info.dns, zero_ip, 4) == 0) {
+         return 0;
+     }
+     memcpy(server, g_network_info.dns, 4);
+
+     memset(msg, 0, DNS_HDR_LEN);
+     msg[0] = (uint8_t)(q->id >> 8);
+     msg[1] = (uint8_t)q->id;
+     msg[2] = (uint8_t)(DNS_FLAGS_RD >> 8);
+     msg[5] = 1;                                 // QDCOUNT
+     uint16_t len = DNS_HDR_LEN;
+     len += dns_encode_name(&msg[len], q->name);
+     msg[len++] = 0;
+     msg[len++] = DNS_TYPE_A;
+     msg[len++] = 0;
+     msg[len++] = DNS_CLASS_IN;
+
+     q->deadline = now + dns_ms_to_ticks(DNS_RETX_MS << q->tries);
+     q->tries++;
+     return len;
+ }
+
+ // Outside dns_mutex: sendto() may sit out an ARP resolution
+ static void dns_transmit(uint8_t sock, const uint8_t *msg, uint16_t len, const uint8_t server[4])
+ {
+     if (w5500_socket_sendto(sock, msg, len, server, DNS_SERVER_PORT) < 0) {
+         BINLOG_WARN("Query send failed");
+     }
+ }
+
+ static void dns_complete(uint8_t slot, int8_t status, const uint8_t *ip, uint32_t ttl_s)
+ {
+     dns_query_t *q = &dns_queries[slot];
+
+     dns_cache_put(q->name, status, ip, ttl_s, osKernelGetTickCount());
+     q->name[0] = '\0';
+     osEventFlagsSet(dns_done, 1UL << slot);
+ }
+
+ /**
+  * @brief Skip a (possibly compressed) name
+  * @return Offset after it, 0 if it runs past @p len
+  */
+ static uint16_t dns_skip_name(uint16_t pos, uint16_t len)
+ {
+     while (pos < len) {
+         uint8_t l = dns_buffer[pos];
+         if (l == 0U) {
+             return (uint16_t)(pos + 1U);
+         }
+         if ((l & 0xC0U) == 0xC0U) {
+             return ((uint16_t)(pos + 2U) <= len) ? (uint16_t)(pos + 2U) : 0U;
+         }
+         pos = (uint16_t)(pos + 1U + l);
+     }
+     return 0;
+ }
+
+ /**
+  * @brief Match a reply in dns_buffer to its query and complete it
+  */
+ static void dns_handle(uint16_t len)
+ {
+     uint8_t slot;
+     uint8_t qname[W5500_DNS_NAME_MAX + 1];
+
+     if (len < DNS_HDR_LEN) {
+         return;
+     }
+     uint16_t id    = dns_get16(&dns_buffer[0]);
+     uint16_t flags = dns_get16(&dns_buffer[2]);
+     uint16_t an    = dns_get16(&dns_buffer[6]);
+     for (slot = 0; slot < W5500_DNS_MAX_QUERIES; slot++) {
+         if ((dns_queries[slot].name[0] != '\0') && (dns_queries[slot].id == id)) {
+             break;
+         }
+     }
+     if ((slot >= W5500_DNS_MAX_QUERIES) || ((flags & DNS_FLAGS_QR) == 0U) ||
+         (dns_get16(&dns_buffer[4]) != 1U)) {
+         return;
+     }
+
+     // The question must be ours: a matching id alone is easy to spoof
+     uint16_t qlen = dns_encode_name(qname, dns_queries[slot].name);
+     uint16_t pos  = DNS_HDR_LEN;
+     if ((uint16_t)(pos + qlen + 4U) > len) {
+         return;
+     }
+     for (uint16_t i = 0; i < qlen; i++) {
+         if (dns_lower((char)dns_buffer[pos + i]) != dns_lower((char)qname[i])) {
+             return;
+         }
+     }
+     pos = (uint16_t)(pos + qlen + 4U);
+
+     if ((flags & 0x000FU) == DNS_RCODE_NXDOMAIN) {
+         dns_complete(slot, W5500_DNS_NOT_FOUND, NULL, DNS_NEG_TTL_S);
+         return;
+     }
+     if ((flags & 0x000FU) != 0U) {
+         dns_complete(slot, W5500_DNS_ERROR, NULL, DNS_FAIL_TTL_S);
+         return;
+     }
+
+     // First A record; CNAMEs in front of it are skipped
+     while (an-- > 0U) {
+         pos = dns_skip_name(pos, len);
+         if ((pos == 0U) || ((uint16_t)(pos + 10U) > len)) {
+             break;
+         }
+         uint16_t type   = dns_get16(&dns_buffer[pos]);
+         uint16_t cls    = dns_get16(&dns_buffer[pos + 2U]);
+         uint32_t ttl    = ((uint32_t)dns_get16(&dns_buffer[pos + 4U]) << 16) |
+                           dns_get16(&dns_buffer[pos + 6U]);
+         uint16_t rdlen  = dns_get16(&dns_buffer[pos + 8U]);
+         pos = (uint16_t)(pos + 10U);
+         if ((uint16_t)(pos + rdlen) > len) {
+             break;
+         }
+         if ((type == DNS_TYPE_A) && (cls == DNS_CLASS_IN) && (rdlen == 4U)) {
+             dns_complete(slot, W5500_DNS_OK, &dns_buffer[pos], ttl);
+             return;
+         }
+         pos = (uint16_t)(pos + rdlen);
+     }
+     dns_complete(slot, W5500_DNS_NOT_FOUND, NULL, DNS_NEG_TTL_S);
+ }
+
+ // RECV fires once per arrival burst: drain every queued datagram.
+ static void dns_receive(void)
+ {
+     w5500_rx_span_t span;
+     uint8_t head[W5500_UDP_HDR_LEN];
+
+     while ((w5500_socket_peek(dns_socket, &span) == W5500_SOCK_OK) && (span.len > 0))
+     {
+         while (span.len >= W5500_UDP_HDR_LEN)
+         {
+             if (w5500_socket_peek_read(dns_socket, &span, 0, head, sizeof(head)) < (int32_t)sizeof(head)) {
+                 return;
+             }
+             uint16_t src_port  = (uint16_t)((head[4] << 8) | head[5]);
+             uint16_t len       = (uint16_t)((head[6] << 8) | head[7]);
+             uint16_t dgram_len = (uint16_t)(W5500_UDP_HDR_LEN + len);
+             bool valid = (src_port == DNS_SERVER_PORT) && (len <= sizeof(dns_buffer)) &&
+                          (dgram_len <= span.len) &&
+                          (w5500_socket_peek_read(dns_socket, &span, W5500_UDP_HDR_LEN,
+                                                  dns_buffer, len) == (int32_t)len);
+
+             if (w5500_socket_consume(dns_socket, &span,
+                                      (dgram_len < span.len) ? dgram_len : span.len) != W5500_SOCK_OK) {
+                 return;
+             }
+             if (valid) {
+                 dns_handle(len);
+             }
+         }
+         if (span.len > 0) {
+             // Partial header: the chip writes whole datagrams, so this is a
+             // desynchronised ring. Drop it.
+             w5500_socket_consume(dns_socket, &span, span.len);
+         }
+     }
+ }
+
+ /**
+  * @brief Handle replies and retransmits
+  * @return uint32_t Ticks to the next retransmit, osWaitForever if idle
+  */
+ static uint32_t dns_run(bool received)
+ {
+     uint8_t msg[DNS_QUERY_MAX];
+     uint8_t server[4];
+     uint8_t sock;
+     uint16_t len;
+     uint32_t wait;
+
+     // One retransmit per pass, sent after the mutex is dropped; another
+     // query that is due as well is picked up by the next pass
+     do {
+         len = 0;
+         wait = osWaitForever;
+         osMutexAcquire(dns_mutex, osWaitForever);
+         sock = dns_socket;
+         if (sock < W5500_MAX_SOCKET) {
+             if (received) {
+                 dns_receive();
+                 received = false;
+             }
+             uint32_t now = osKernelGetTickCount();
+             for (uint8_t i = 0; i < W5500_DNS_MAX_QUERIES; i++) {
+                 dns_query_t *q = &dns_queries[i];
+                 if (q->name[0] == '\0') {
+                     continue;
+                 }
+                 if (dns_due(now, q->deadline)) {
+                     if (len > 0U) {
+                         continue;
+                     }
+                     if ((q->tries >= DNS_MAX_TRIES) || ((len = dns_prepare(q, now, msg, server)) == 0U)) {
+                         BINLOG_WARN("Query timed out after %d tries", q->tries);
+                         dns_complete(i, W5500_DNS_TIMEOUT, NULL, DNS_FAIL_TTL_S);
+                         continue;
+                     }
+                 }
+                 uint32_t left = q->deadline - now;
+                 if (left < wait) {
+                     wait = left;
+                 }
+             }
+         }
+         osMutexRelease(dns_mutex);
+
+         if (len > 0U) {
+             dns_transmit(sock, msg, len, server);
+         }
+     } while (len > 0U);
+     return wait;
+ }
+
+ /**
+  * @brief w5500_dns_resolve() that also reports the query slot of a
+  *        PENDING result
+  */
+ static w5500_dns_status_t dns_lookup(const char *fqdn, uint8_t ip[4], uint8_t *slot)
+ {
+     w5500_dns_status_t status = W5500_DNS_PENDING;
+     uint8_t free_slot = W5500_DNS_MAX_QUERIES;
+     uint8_t msg[DNS_QUERY_MAX];
+     uint8_t server[4];
+     uint8_t sock = W5500_MAX_SOCKET;
+     uint16_t msg_len = 0;
+     char name[W5500_DNS_NAME_MAX];
+     size_t len;
+
+     if ((fqdn == NULL) || (ip == NULL) || ((len = strlen(fqdn)) >= W5500_DNS_NAME_MAX)) {
+         return W5500_DNS_ERROR;
+     }
+     // "host." and "host" are the same cache entry
+     memcpy(name, fqdn, len + 1U);
+     if ((len > 0U) && (name[len - 1U] == '.')) {
+         name[--len] = '\0';
+     }
+     if (len == 0U) {
+         return W5500_DNS_ERROR;
+     }
+     if (dns_parse_quad(name, ip)) {
+         return W5500_DNS_OK;
+     }
+
+     osMutexAcquire(dns_mutex, osWaitForever);
+     uint32_t now = osKernelGetTickCount();
+     dns_entry_t *e = dns_cache_find(name, now);
+     if (dns_socket >= W5500_MAX_SOCKET) {
+         status = W5500_DNS_ERROR;
+     } else if (e != NULL) {
+         memcpy(ip, e->ip, 4);
+         status = (w5500_dns_status_t)e->status;
+     } else {
+         // Join a query in flight for the same name
+         uint8_t joined = W5500_DNS_MAX_QUERIES;
+         for (uint8_t i = 0; i < W5500_DNS_MAX_QUERIES; i++) {
+             if (dns_queries[i].name[0] == '\0') {
+                 if (free_slot >= W5500_DNS_MAX_QUERIES) {
+                     free_slot = i;
+                 }
+             } else if (dns_name_eq(dns_queries[i].name, name)) {
+                 joined = i;
+                 break;
+             }
+         }
+         if (joined < W5500_DNS_MAX_QUERIES) {
+             *slot = joined;
+         } else if (free_slot >= W5500_DNS_MAX_QUERIES) {
+             status = W5500_DNS_BUSY;
+         } else {
+             dns_query_t *q = &dns_queries[free_slot];
+             uint8_t labels[W5500_DNS_NAME_MAX + 1];
+             if (dns_encode_name(labels, name) == 0U) {
+                 status = W5500_DNS_ERROR;
+             } else {
+                 strcpy(q->name, name);
+                 q->id = dns_next_id();
+                 q->tries = 0;
+                 osEventFlagsClear(dns_done, 1UL << free_slot);
+                 msg_len = dns_prepare(q, now, msg, server);
+                 if (msg_len == 0U) {
+                     q->name[0] = '\0';
+                     status = W5500_DNS_ERROR;   // no DNS server configured
+                 } else {
+                     *slot = free_slot;
+                     sock = dns_socket;
+                 }
+             }
+         }
+     }
+     osMutexRelease(dns_mutex);
+
+     if (msg_len > 0U) {
+         dns_transmit(sock, msg, msg_len, server);
+         // Wake the task so it arms the retransmit timer
+         w5500_irq_post(sock, W5500_IRQ_RECV);
+     }
+     return status;
+ }
+
+ static void dns_netinfo_changed(uint32_t changed, const wiz_NetInfo *net_info, void *ctx)
+ {
+     (void)net_info;
+     (void)ctx;
+
+     // New network or new server: cached answers may be wrong there
+     if ((changed & (ETH_CONFIG_CHANGED_IP | ETH_CONFIG_CHANGED_DNS)) != 0U) {
+         w5500_dns_flush();
+     }
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ bool w5500_dns_init(void)
+ {
+     if (dns_mutex == NULL) {
+         const osMutexAttr_t attr = {
+             .name      = "w5500_dns",
+             .attr_bits = osMutexRecursive | osMutexPrioInherit,
+             .cb_mem    = &dns_mutex_cb,
+             .cb_size   = sizeof(dns_mutex_cb),
+         };
+         dns_mutex = osMutexNew(&attr);
+         if (dns_mutex == NULL) {
+             return false;
+         }
+     }
+     if (dns_done == NULL) {
+         const osEventFlagsAttr_t attr = {
+             .name    = "w5500_dns",
+             .cb_mem  = &dns_done_cb,
+             .cb_size = sizeof(dns_done_cb),
+         };
+         dns_done = osEventFlagsNew(&attr);
+         if (dns_done == NULL) {
+             return false;
+         }
+     }
+     if ((dns_socket >= W5500_MAX_SOCKET) &&
+         (w5500_socket_alloc("dns", ETH_CONFIG_DNS_SOCK_MASK, &dns_socket) != W5500_SOCK_OK)) {
+         BINLOG_ERROR("No free socket for DNS");
+         dns_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+     // Any local port: the chip picks one
+     if (w5500_socket_open(dns_socket, W5500_SOCK_UDP, 0) != W5500_SOCK_OK) {
+         w5500_socket_release(dns_socket);
+         dns_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+     if (!dns_subscribed) {
+         dns_subscribed = eth_config_subscribe(dns_netinfo_changed, NULL);
+     }
+     dns_seed ^= HAL_GetUIDw0() ^ HAL_GetUIDw1() ^ HAL_GetUIDw2();
+
+     BINLOG_INFO("DNS resolver on socket %d", dns_socket);
+     return true;
+ }
+
+ void w5500_dns_stop(void)
+ {
+     osMutexAcquire(dns_mutex, osWaitForever);
+     if (dns_socket < W5500_MAX_SOCKET) {
+         w5500_socket_close(dns_socket);
+         w5500_socket_release(dns_socket);
+         dns_socket = W5500_MAX_SOCKET;
+     }
+     // Waiters wake up and get W5500_DNS_ERROR from the closed resolver
+     for (uint8_t i = 0; i < W5500_DNS_MAX_QUERIES; i++) {
+         dns_queries[i].name[0] = '\0';
+     }
+     memset(dns_cache, 0, sizeof(dns_cache));
+     if (dns_done != NULL) {
+         osEventFlagsSet(dns_done, (1UL << W5500_DNS_MAX_QUERIES) - 1U);
+     }
+     osMutexRelease(dns_mutex);
+ }
+
+ w5500_dns_status_t w5500_dns_resolve(const char *name, uint8_t ip[4])
+ {
+     uint8_t slot;
+     return dns_lookup(name, ip, &slot);
+ }
+
+ w5500_dns_status_t w5500_dns_wait(const char *name, uint8_t ip[4], uint32_t timeout)
+ {
+     uint32_t start = osKernelGetTickCount();
+
+     for (;;) {
+         uint8_t slot = 0;
+         w5500_dns_status_t status = dns_lookup(name, ip, &slot);
+         if (status != W5500_DNS_PENDING) {
+             return status;
+         }
+
+         uint32_t left = timeout;
+         if (timeout != osWaitForever) {
+             uint32_t spent = osKernelGetTickCount() - start;
+             if (spent >= timeout) {
+                 return W5500_DNS_TIMEOUT;
+             }
+             left = timeout - spent;
+         }
+         // No clear: every waiter of the slot must see the bit, the next
+         // query started on the slot clears it
+         osEventFlagsWait(dns_done, 1UL << slot, osFlagsWaitAny | osFlagsNoClear, left);
+     }
+ }
+
+ void w5500_dns_flush(void)
+ {
+     osMutexAcquire(dns_mutex, osWaitForever);
+     memset(dns_cache, 0, sizeof(dns_cache));
+     osMutexRelease(dns_mutex);
+ }
+
+ void w5500_dns_task(void *argument)
+ {
+     (void)argument;
+
+     for (;;) {
+         if (dns_socket >= W5500_MAX_SOCKET) {
+             // No socket (pool exhausted or stopped): wait for a re-init
+             osDelay(100);
+             continue;
+         }
+         uint32_t events = w5500_irq_wait(dns_socket, W5500_IRQ_RECV, dns_run(false));
+         dns_run(events != 0);
+     }
+ }
+
+ void w5500_dns_task100ms(void)
+ {
+     // Read the socket only if the INT dispatcher latched RECV
+     bool received = (dns_socket < W5500_MAX_SOCKET) &&
+                     (w5500_irq_wait(dns_socket, W5500_IRQ_RECV, 0) != 0);
+
+     dns_run(received);
+ }
@@ -0,0 +1,105 @@
+/**
+ * @file    w5500_dns.h
+ * @brief   Caching DNS resolver (A records) for the W5500 socket layer
+ *
+ * @details Queries go to g_network_info.dns from a pool UDP socket
+ *          (ETH_CONFIG_DNS_SOCK_MASK). Answers, NXDOMAIN and timeouts are
+ *          kept in a fixed W5500_DNS_CACHE_SIZE entry cache for their TTL,
+ *          so repeated lookups resolve without network traffic. Lookups of
+ *          a name already in flight join that query instead of sending
+ *          another one. The cache is flushed when eth_config reports a new
+ *          IP or DNS server.
+ *
+ *          w5500_dns_resolve() never blocks; w5500_dns_wait() sleeps on the
+ *          query's completion event. Replies and retransmits are handled by
+ *          w5500_dns_task() (or w5500_dns_task100ms()).
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_DNS_H
+ #define W5500_DNS_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <string.h>
+#include "stm32g4xx_hal.h" // For HAL (if needed)
+
+#include "w5500_spi.h"
+#include "eth_config.h"
+
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #ifndef W5500_DNS_CACHE_SIZE
+ #define W5500_DNS_CACHE_SIZE   8      /**< Cached names (answers and failures) */
+ #endif
+ #ifndef W5500_DNS_MAX_QUERIES
+ #define W5500_DNS_MAX_QUERIES  4      /**< Names in flight at once */
+ #endif
+ #define W5500_DNS_NAME_MAX     64     /**< Longest name, terminator included */
+
+ /**
+  * @brief Resolver results
+  */
+ typedef enum {
+     W5500_DNS_OK        =  0,   /**< Address returned */
+     W5500_DNS_PENDING   =  1,   /**< Query in flight, wait or ask again */
+     W5500_DNS_ERROR     = -1,   /**< Bad name, no socket, no server or server failure */
+     W5500_DNS_NOT_FOUND = -2,   /**< NXDOMAIN or no A record */
+     W5500_DNS_TIMEOUT   = -3,   /**< No answer from the server */
+     W5500_DNS_BUSY      = -4    /**< All W5500_DNS_MAX_QUERIES slots in use */
+ } w5500_dns_status_t;
+
+ /**
+  * @brief Take a socket from the pool and subscribe to netinfo changes
+  * @return bool True on success
+  */
+ bool w5500_dns_init(void);
+
+ /**
+  * @brief Close the socket, drop the cache and fail pending lookups
+  */
+ void w5500_dns_stop(void);
+
+ /**
+  * @brief Look @p name up without blocking
+  * @param name  Host name, or a dotted quad (returned as is)
+  * @param ip    Address on W5500_DNS_OK
+  * @return w5500_dns_status_t  OK from the cache, PENDING when a query was
+  *         started or joined, a cached failure, or an error
+  */
+ w5500_dns_status_t w5500_dns_resolve(const char *name, uint8_t ip[4]);
+
+ /**
+  * @brief w5500_dns_resolve() that sleeps until the query completes
+  * @param timeout  Kernel ticks, osWaitForever allowed
+  * @return w5500_dns_status_t  Never PENDING; TIMEOUT if @p timeout ran out
+  */
+ w5500_dns_status_t w5500_dns_wait(const char *name, uint8_t ip[4], uint32_t timeout);
+
+ /**
+  * @brief Forget every cached name
+  */
+ void w5500_dns_flush(void);
+
+ /**
+  * @brief DNS thread body: blocks on RECV with the next retransmit as
+  *        timeout. Do not mix with w5500_dns_task100ms().
+  */
+ void w5500_dns_task(void *argument);
+
+ /**
+  * @brief Polled alternative to w5500_dns_task()
+  * @note  Touches the chip only when the INT dispatcher latched RECV
+  */
+ void w5500_dns_task100ms(void);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_DNS_H */
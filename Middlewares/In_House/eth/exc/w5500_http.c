@@ -0,0 +1,828 @@
+/**
+ * @file    w5500_http.c
+ * @brief   Event-driven HTTP/1.1 server on the W5500
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_http.h"
+ #include "w5500_router.h"
+ #include "cmsis_os.h"
+ #include <string.h>
+
+ #define BINLOG_MODULE        "w5500_http"
+ #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ #include "binlog.h"
+
+ // Sockets the server may take from the pool
+ #ifndef ETH_CONFIG_HTTP_SOCK_MASK
+ #define ETH_CONFIG_HTTP_SOCK_MASK W5500_SOCK_ANY
+ #endif
+
+ #define HTTP_CHUNK          256U    // RX ring bytes parsed per read
+ #define HTTP_RETRY_MS       100U    // socket that failed to open
+ #define HTTP_TYPE_MAX       64U     // handler Content-Type, so the header fits http_scratch
+
+ typedef enum {
+     HTTP_IDLE = 0,      // not open (open failed): retried
+     HTTP_LISTEN,
+     HTTP_READ,          // parsing a request
+     HTTP_SEND,          // queueing a response
+     HTTP_FLUSH,         // last response on the wire, then disconnect
+     HTTP_CLOSING        // FIN sent: listen again once the socket is closed
+ } http_state_t;
+
+ typedef enum {
+     HTTP_P_LINE = 0,    // request line
+     HTTP_P_HEADER,
+     HTTP_P_BODY,        // request body, discarded
+     HTTP_P_DONE
+ } http_parse_t;
+
+ typedef struct {
+     uint8_t  sock_num;
+     uint8_t  state;         // http_state_t
+     uint8_t  parse;         // http_parse_t
+     bool     rx_pending;    // RX ring may hold unread bytes (POLLIN is an edge)
+     bool     keep_alive;
+     bool     http10;
+     bool     peer_closed;
+     bool     line_over;     // current line did not fit
+     bool     inm_valid;     // inm holds a whole If-None-Match value
+     bool     head_sent;
+     bool     not_modified;
+     uint16_t status;        // status of a built response, 0 for a file
+     uint8_t  allow;         // W5500_ROUTE_BIT()s for a 405
+     uint16_t line_len;
+     uint16_t hdr_len;
+     uint16_t inm_len;
+     uint32_t body_left;     // request body still to skip
+     const w5500_webfs_file_t* file;
+     const char* type;       // Content-Type of a built response
+     const uint8_t* tx_data; // body being streamed
+     uint32_t tx_len;        // Content-Length (nothing is streamed for HEAD)
+     uint32_t tx_off;
+     w5500_send_token_t token;
+     uint32_t deadline;      // tick: keep-alive expiry, stall limit while sending or closing
+     uint32_t t_req;         // SPI_BUS_CYCLES() of the parsed request
+     uint32_t served;        // responses on this connection
+     w5500_http_req_t req;
+     char     line[W5500_HTTP_LINE_MAX];
+     char     hdr[W5500_HTTP_HDR_MAX];
+     char     inm[W5500_HTTP_ETAG_MAX];
+     char     body[W5500_HTTP_BODY_MAX];    // w5500_http_resp_t.buf
+ } http_conn_t;
+
+ static http_conn_t http_conns[W5500_HTTP_MAX_CONN];
+ static uint8_t http_conn_count;
+ static w5500_http_handler_t http_handler;
+ static w5500_http_stats_t http_stats;
+ static char http_scratch[W5500_WEBFS_HEAD_MAX + 32U];   // RX chunk, response header
+
+ // By w5500_http_method_t
+ static const char* const http_methods[W5500_HTTP_OTHER] = { "GET", "HEAD", "POST", "PUT", "DELETE" };
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ static uint32_t http_ms_to_ticks(uint32_t ms)
+ {
+     uint32_t ticks = (uint32_t)(((uint64_t)ms * osKernelGetTickFreq()) / 1000U);
+     return (ticks != 0U) ? ticks : 1U;
+ }
+
+ static char http_lower(char c)
+ {
+     return ((c >= 'A') && (c <= 'Z')) ? (char)(c + ('a' - 'A')) : c;
+ }
+
+ // Case-insensitive compare of n bytes against a lower-case literal
+ static bool http_ieq(const char* s, const char* lit, uint16_t n)
+ {
+     for (uint16_t i = 0; i < n; i++) {
+         if (http_lower(s[i]) != lit[i]) {
+             return false;
+         }
+     }
+     return lit[n] == '\0';
+ }
+
+ // Comma-separated token list contains a token (case-insensitive)
+ static bool http_has_token(const char* v, uint16_t len, const char* token)
+ {
+     uint16_t i = 0;
+
+     while (i < len) {
+         while ((i < len) && ((v[i] == ' ') || (v[i] == '\t') || (v[i] == ','))) {
+             i++;
+         }
+         uint16_t start = i;
+         while ((i < len) && (v[i] != ',') && (v[i] != ' ') && (v[i] != '\t')) {
+             i++;
+         }
+         if ((i > start) && http_ieq(&v[start], token, (uint16_t)(i - start))) {
+             return true;
+         }
+     }
+     return false;
+ }
+
+ static const char* http_reason(uint16_t status)
+ {
+     switch (status) {
+     case 200: return "OK";
+     case 201: return "Created";
+     case 202: return "Accepted";
+     case 204: return "No Content";
+     case 400: return "Bad Request";
+     case 401: return "Unauthorized";
+     case 403: return "Forbidden";
+     case 404: return "Not Found";
+     case 405: return "Method Not Allowed";
+     case 409: return "Conflict";
+     case 413: return "Content Too Large";
+     case 414: return "URI Too Long";
+     case 415: return "Unsupported Media Type";
+     case 422: return "Unprocessable Content";
+     case 501: return "Not Implemented";
+     case 503: return "Service Unavailable";
+     case 505: return "HTTP Version Not Supported";
+     default:  break;
+     }
+     if (status < 300U) {
+         return "OK";
+     }
+     return (status < 500U) ? "Client Error" : "Internal Server Error";
+ }
+
+ static void http_put(char* buf, uint16_t* len, const char* s)
+ {
+     size_t n = strlen(s);
+     memcpy(&buf[*len], s, n);
+     *len = (uint16_t)(*len + n);
+ }
+
+ static void http_put_u32(char* buf, uint16_t* len, uint32_t v)
+ {
+     char digits[10];
+     uint8_t n = 0;
+
+     do {
+         digits[sizeof(digits) - 1U - n] = (char)('0' + (v % 10U));
+         v /= 10U;
+         n++;
+     } while (v != 0U);
+     memcpy(&buf[*len], &digits[sizeof(digits) - n], n);
+     *len = (uint16_t)(*len + n);
+ }
+
+ /*============================================================================*/
+ /*                         CONNECTION STATE                                   */
+ /*============================================================================*/
+
+ static void http_request_reset(http_conn_t* c)
+ {
+     c->parse        = HTTP_P_LINE;
+     c->line_len     = 0;
+     c->hdr_len      = 0;
+     c->line_over    = false;
+     c->inm_valid    = false;
+     c->inm_len      = 0;
+     c->body_left    = 0;
+     c->status       = 0;
+     c->allow        = 0;
+     c->file         = NULL;
+     c->type         = NULL;
+     c->head_sent    = false;
+     c->not_modified = false;
+     c->tx_data      = NULL;
+     c->tx_len       = 0;
+     c->tx_off       = 0;
+     memset(&c->req, 0, sizeof(c->req));
+ }
+
+ static void http_listen(http_conn_t* c)
+ {
+     c->state = HTTP_IDLE;
+     c->peer_closed = false;
+     c->deadline = osKernelGetTickCount() + http_ms_to_ticks(HTTP_RETRY_MS);
+     // The pool claim outlives the close: the socket is still ours
+     int8_t ret = w5500_socket_open(c->sock_num, W5500_SOCK_TCP, W5500_HTTP_PORT);
+     if (ret == W5500_SOCK_BUSY) {
+         BINLOG_ERROR("Socket %d claimed by another task", c->sock_num);
+         return;
+     }
+     if ((ret == W5500_SOCK_OK) && (w5500_socket_listen(c->sock_num) == W5500_SOCK_OK)) {
+         c->state = HTTP_LISTEN;
+     }
+ }
+
+ // FIN (after the queued data); listening again waits for the close to
+ // complete in the poll loop, so a slow peer stalls no other connection
+ static void http_close(http_conn_t* c)
+ {
+     if (w5500_disconnect_async(c->sock_num) != W5500_SOCK_OK) {
+         http_listen(c);
+         return;
+     }
+     c->state    = HTTP_CLOSING;
+     c->deadline = osKernelGetTickCount() + http_ms_to_ticks(W5500_HTTP_IDLE_MS);
+ }
+
+ static void http_accept(http_conn_t* c)
+ {
+     http_request_reset(c);
+     c->state       = HTTP_READ;
+     c->rx_pending  = true;      // the request may have come with the SYN's ACK
+     c->peer_closed = (w5500_socket_get_status(c->sock_num) == SOCK_CLOSE_WAIT);
+     c->served      = 0;
+     c->deadline    = osKernelGetTickCount() + http_ms_to_ticks(W5500_HTTP_IDLE_MS);
+     http_stats.connections++;
+ }
+
+ /*============================================================================*/
+ /*                         REQUEST PARSING                                    */
+ /*============================================================================*/
+
+ static uint8_t http_method(const char* s, uint16_t n)
+ {
+     for (uint8_t i = 0; i < W5500_HTTP_OTHER; i++) {
+         if ((strlen(http_methods[i]) == n) && (memcmp(s, http_methods[i], n) == 0)) {
+             return i;
+         }
+     }
+     return W5500_HTTP_OTHER;
+ }
+
+ // "METHOD SP /path[?query] SP HTTP/1.x", split in place
+ static void http_request_line(http_conn_t* c)
+ {
+     char* line = c->line;
+     char* sp1;
+     char* sp2;
+
+     if (c->line_over) {
+         c->status = 414;
+         c->keep_alive = false;
+         return;
+     }
+     line[c->line_len] = '\0';
+     sp1 = strchr(line, ' ');
+     sp2 = (sp1 != NULL) ? strchr(sp1 + 1, ' ') : NULL;
+     if ((sp2 == NULL) || (sp1[1] != '/')) {
+         c->status = 400;
+         c->keep_alive = false;
+         return;
+     }
+     if (strcmp(sp2 + 1, "HTTP/1.1") == 0) {
+         c->http10 = false;
+         c->keep_alive = true;
+     } else if (strcmp(sp2 + 1, "HTTP/1.0") == 0) {
+         c->http10 = true;
+         c->keep_alive = false;
+     } else {
+         c->status = (strncmp(sp2 + 1, "HTTP/", 5) == 0) ? 505 : 400;
+         c->keep_alive = false;
+         return;
+     }
+
+     *sp2 = '\0';
+     c->req.sock_num = c->sock_num;
+     c->req.method   = http_method(line, (uint16_t)(sp1 - line));
+     c->req.path     = sp1 + 1;
+     char* q = strchr(sp1 + 1, '?');
+     if (q != NULL) {
+         *q = '\0';
+         c->req.query = q + 1;
+     } else {
+         c->req.query = sp2;     // ""
+     }
+     c->req.path_len  = (uint16_t)strlen(c->req.path);
+     c->req.query_len = (uint16_t)strlen(c->req.query);
+ }
+
+ // One header line without its CRLF; only the headers acted on are looked at
+ static void http_header(http_conn_t* c)
+ {
+     const char* h = c->hdr;
+     const char* colon = memchr(h, ':', c->hdr_len);
+
+     if (colon == NULL) {
+         return;
+     }
+     uint16_t name_len = (uint16_t)(colon - h);
+     uint16_t v = (uint16_t)(name_len + 1U);
+     while ((v < c->hdr_len) && ((h[v] == ' ') || (h[v] == '\t'))) {
+         v++;
+     }
+     uint16_t vlen = (uint16_t)(c->hdr_len - v);
+     while ((vlen > 0U) && ((h[v + vlen - 1U] == ' ') || (h[v + vlen - 1U] == '\t'))) {
+         vlen--;
+     }
+
+     if (http_ieq(h, "connection", name_len)) {
+         if (c->line_over) {
+             return;
+         }
+         if (http_has_token(&h[v], vlen, "close")) {
+             c->keep_alive = false;
+         } else if (http_has_token(&h[v], vlen, "keep-alive")) {
+             c->keep_alive = true;
+         }
+     } else if (http_ieq(h, "if-none-match", name_len)) {
+         // A value cut short cannot be matched: answer 200
+         c->inm_valid = !c->line_over && (vlen <= sizeof(c->inm));
+         if (c->inm_valid) {
+             memcpy(c->inm, &h[v], vlen);
+             c->inm_len = vlen;
+         }
+     } else if (http_ieq(h, "content-length", name_len)) {
+         uint32_t n = 0;
+         if (c->line_over) {
+             c->status = 400;
+             c->keep_alive = false;
+             return;
+         }
+         for (uint16_t i = 0; i < vlen; i++) {
+             if ((h[v + i] < '0') || (h[v + i] > '9') || (n > 0x0FFFFFFFU)) {
+                 c->status = 400;
+                 c->keep_alive = false;
+                 return;
+             }
+             n = (n * 10U) + (uint32_t)(h[v + i] - '0');
+         }
+         c->body_left = n;
+     } else if (http_ieq(h, "transfer-encoding", name_len)) {
+         // A chunked request body cannot be skipped without decoding it
+         c->status = 501;
+         c->keep_alive = false;
+     }
+ }
+
+ /**
+  * @brief Feed received bytes to the parser
+  * @return Bytes used; fewer than len once a request is complete
+  */
+ static uint16_t http_parse(http_conn_t* c, const char* buf, uint16_t len)
+ {
+     uint16_t i = 0;
+
+     while ((i < len) && (c->parse != HTTP_P_DONE)) {
+         if (c->parse == HTTP_P_BODY) {
+             uint32_t n = len - i;
+             if (n > c->body_left) {
+                 n = c->body_left;
+             }
+             c->body_left -= n;
+             i = (uint16_t)(i + n);
+             if (c->body_left == 0U) {
+                 c->parse = HTTP_P_DONE;
+             }
+             continue;
+         }
+
+         char ch = buf[i++];
+         bool request_line = (c->parse == HTTP_P_LINE);
+         char* dst = request_line ? c->line : c->hdr;
+         uint16_t* dst_len = request_line ? &c->line_len : &c->hdr_len;
+         uint16_t dst_max = (uint16_t)(request_line ? (sizeof(c->line) - 1U) : sizeof(c->hdr));
+
+         if (ch != '\n') {
+             if (*dst_len < dst_max) {
+                 dst[(*dst_len)++] = ch;
+             } else {
+                 c->line_over = true;
+             }
+             continue;
+         }
+
+         // End of line
+         if ((*dst_len > 0U) && (dst[*dst_len - 1U] == '\r')) {
+             (*dst_len)--;
+         }
+         if (request_line) {
+             if ((c->line_len == 0U) && !c->line_over) {
+                 continue;   // empty lines before a request are allowed
+             }
+             http_request_line(c);
+             c->parse = HTTP_P_HEADER;
+         } else if ((c->hdr_len == 0U) && !c->line_over) {
+             c->parse = (c->body_left != 0U) ? HTTP_P_BODY : HTTP_P_DONE;
+         } else {
+             http_header(c);
+         }
+         c->hdr_len = 0;
+         c->line_over = false;
+     }
+     return i;
+ }
+
+ /*============================================================================*/
+ /*                         RESPONSES                                          */
+ /*============================================================================*/
+
+ // Route table first, then the static files; sets a file or a built response
+ static void http_dispatch(http_conn_t* c)
+ {
+     w5500_http_resp_t resp = {
+         .status = 200U, .type = "text/plain", .buf = c->body, .buf_size = (uint16_t)sizeof(c->body)
+     };
+     w5500_http_route_fn_t fn = w5500_router_find(c->req.method, c->req.path, c->req.path_len, &c->allow);
+
+     if (fn != NULL) {
+         fn(&c->req, &resp);
+     } else if (c->allow != 0U) {
+         c->status = 405;    // routed, not for this method
+         return;
+     } else if ((c->req.method == W5500_HTTP_GET) || (c->req.method == W5500_HTTP_HEAD)) {
+         resp.file = (http_handler != NULL) ? http_handler(&c->req)
+                                            : w5500_webfs_find(c->req.path, c->req.path_len);
+         if (resp.file == NULL) {
+             c->status = 404;
+             return;
+         }
+     } else {
+         c->allow  = W5500_ROUTE_BIT(W5500_HTTP_GET) | W5500_ROUTE_BIT(W5500_HTTP_HEAD);
+         c->status = 405;
+         return;
+     }
+
+     if (resp.file != NULL) {
+         c->file = resp.file;
+         return;
+     }
+     if ((resp.status < 200U) || (resp.status > 599U) || (resp.type == NULL) ||
+         (strlen(resp.type) > HTTP_TYPE_MAX) || ((resp.body == NULL) && (resp.len != 0U))) {
+         c->status = 500;    // handler bug
+         return;
+     }
+     c->status  = resp.status;
+     c->type    = resp.type;
+     c->tx_data = resp.body;
+     c->tx_len  = (resp.status == 204U) ? 0U : resp.len;
+ }
+
+ static void http_respond(http_conn_t* c)
+ {
+     c->t_req = SPI_BUS_CYCLES();
+     http_stats.requests++;
+     if (c->served != 0U) {
+         http_stats.reused++;
+     }
+
+     if (c->status == 0U) {
+         http_dispatch(c);
+     }
+
+     if (c->status == 0U) {
+         c->not_modified = c->inm_valid && w5500_webfs_etag_match(c->file, c->inm, c->inm_len);
+         if (c->not_modified) {
+             http_stats.not_modified++;
+         } else {
+             c->tx_data = c->file->data;
+             c->tx_len  = c->file->len;
+         }
+     } else {
+         if ((c->status >= 400U) && (c->tx_data == NULL)) {
+             const char* reason = http_reason(c->status);
+             c->type    = "text/plain";
+             c->tx_data = (const uint8_t*)reason;
+             c->tx_len  = (uint32_t)strlen(reason);
+         }
+         if (c->status >= 500U) {
+             http_stats.server_errors++;
+         } else if (c->status >= 400U) {
+             http_stats.client_errors++;
+         }
+     }
+     c->state    = HTTP_SEND;
+     c->deadline = osKernelGetTickCount() + http_ms_to_ticks(W5500_HTTP_IDLE_MS);
+ }
+
+ // Response header into http_scratch; 0 if it does not fit
+ static uint16_t http_head(http_conn_t* c)
+ {
+     char* buf = http_scratch;
+     uint16_t len = 0;
+
+     if (c->status == 0U) {
+         int32_t n = w5500_webfs_header(c->file, c->not_modified, buf, W5500_WEBFS_HEAD_MAX);
+         if (n < 2) {
+             return 0;
+         }
+         len = (uint16_t)(n - 2);    // reopen the header block
+     } else {
+         http_put(buf, &len, "HTTP/1.1 ");
+         http_put_u32(buf, &len, c->status);
+         http_put(buf, &len, " ");
+         http_put(buf, &len, http_reason(c->status));
+         http_put(buf, &len, "\r\n");
+         if (c->status != 204U) {
+             http_put(buf, &len, "Content-Type: ");
+             http_put(buf, &len, c->type);
+             http_put(buf, &len, "\r\nContent-Length: ");
+             http_put_u32(buf, &len, c->tx_len);
+             http_put(buf, &len, "\r\n");
+         }
+         if (c->status == 405U) {
+             const char* sep = "Allow: ";
+             for (uint8_t m = 0; m < W5500_HTTP_OTHER; m++) {
+                 if ((c->allow & W5500_ROUTE_BIT(m)) != 0U) {
+                     http_put(buf, &len, sep);
+                     http_put(buf, &len, http_methods[m]);
+                     sep = ", ";
+                 }
+             }
+             http_put(buf, &len, "\r\n");
+         }
+         http_put(buf, &len, "Cache-Control: no-store\r\n");
+     }
+     if (!c->keep_alive || c->peer_closed) {
+         http_put(buf, &len, "Connection: close\r\n");
+     } else if (c->http10) {
+         http_put(buf, &len, "Connection: keep-alive\r\n");
+     }
+     http_put(buf, &len, "\r\n");
+     return len;
+ }
+
+ /**
+  * @brief Queue as much of the response as the TX ring takes
+  * @return True once the whole response is queued
+  */
+ static bool http_tx(http_conn_t* c)
+ {
+     uint32_t end = (c->req.method == W5500_HTTP_HEAD) ? 0U : c->tx_len;
+     int32_t n;
+
+     if (!c->head_sent) {
+         uint16_t len = http_head(c);
+         // The header goes in whole: wait for room rather than split it
+         if ((len == 0U) || (w5500_socket_send_writable(c->sock_num) < len)) {
+             return false;
+         }
+         n = w5500_socket_send_async(c->sock_num, (const uint8_t*)http_scratch, len, &c->token);
+         if (n != (int32_t)len) {
+             c->keep_alive = false;      // broken connection: give up on it
+             return true;
+         }
+         c->head_sent = true;
+         http_stats.bytes += len;
+     }
+     while (c->tx_off < end) {
+         uint32_t left = end - c->tx_off;
+         n = w5500_socket_send_async(c->sock_num, &c->tx_data[c->tx_off],
+                                     (uint16_t)((left > 0xFFFFU) ? 0xFFFFU : left), &c->token);
+         if (n < 0) {
+             c->keep_alive = false;
+             return true;
+         }
+         if (n == 0) {
+             return false;               // ring full: the rest on the next wake-up
+         }
+         c->tx_off += (uint32_t)n;
+         http_stats.bytes += (uint32_t)n;
+         c->deadline = osKernelGetTickCount() + http_ms_to_ticks(W5500_HTTP_IDLE_MS);
+     }
+     w5500_socket_latency_add(&http_stats.service, SPI_BUS_CYCLES() - c->t_req);
+     return true;
+ }
+
+ /*============================================================================*/
+ /*                         EVENT HANDLING                                     */
+ /*============================================================================*/
+
+ // Parse from the RX ring up to the end of one request
+ static void http_rx(http_conn_t* c)
+ {
+     w5500_rx_span_t span;
+     uint16_t pos = 0;
+
+     if ((w5500_socket_peek(c->sock_num, &span) != W5500_SOCK_OK) || (span.len == 0U)) {
+         c->rx_pending = false;
+         return;
+     }
+     while ((pos < span.len) && (c->parse != HTTP_P_DONE)) {
+         uint16_t want = (uint16_t)(span.len - pos);
+         if (want > HTTP_CHUNK) {
+             want = HTTP_CHUNK;
+         }
+         int32_t got = w5500_socket_peek_read(c->sock_num, &span, pos, (uint8_t*)http_scratch, want);
+         if (got <= 0) {
+             break;
+         }
+         pos = (uint16_t)(pos + http_parse(c, http_scratch, (uint16_t)got));
+     }
+     // Bytes past the request stay in the ring for the next one
+     c->rx_pending = (pos < span.len);
+     if (pos > 0U) {
+         w5500_socket_consume(c->sock_num, &span, pos);
+     }
+ }
+
+ static void http_service(http_conn_t* c, uint8_t revents)
+ {
+     uint32_t now = osKernelGetTickCount();
+     bool answered = false;
+
+     if ((revents & W5500_POLLIN) != 0U) {
+         c->rx_pending = true;
+     }
+     // In LISTEN, HUP is a late DISCON of the previous connection: not this peer
+     if (((revents & W5500_POLLHUP) != 0U) && (c->state != HTTP_LISTEN)) {
+         c->peer_closed = true;
+     }
+
+     switch (c->state) {
+     case HTTP_IDLE:
+         if ((int32_t)(now - c->deadline) >= 0) {
+             http_listen(c);
+         }
+         return;
+
+     case HTTP_LISTEN:
+         if ((revents & W5500_POLLCON) != 0U) {
+             http_accept(c);
+             break;
+         }
+         if (w5500_socket_get_status(c->sock_num) == SOCK_CLOSED) {
+             http_listen(c);     // reset by the peer before it connected
+         }
+         return;
+
+     case HTTP_CLOSING:
+         // HUP: the peer's FIN came back, or the chip closed the socket
+         // (Sn_SR SOCK_CLOSED); a peer that never answers is cut off
+         if ((revents & W5500_POLLHUP) != 0U) {
+             http_listen(c);
+         } else if ((int32_t)(now - c->deadline) >= 0) {
+             http_stats.timeouts++;
+             http_listen(c);
+         }
+         return;
+
+     default:
+         break;
+     }
+
+     for (;;) {
+         if (c->state == HTTP_READ) {
+             if (c->rx_pending) {
+                 http_rx(c);
+             }
+             if (c->parse == HTTP_P_DONE) {
+                 if (answered) {
+                     http_stats.pipelined++;
+                 }
+                 http_respond(c);
+             } else {
+                 // Nothing more to read: idle, or part of a request
+                 if (c->peer_closed && !c->rx_pending) {
+                     http_close(c);
+                 } else if ((int32_t)(osKernelGetTickCount() - c->deadline) >= 0) {
+                     http_stats.timeouts++;
+                     http_close(c);
+                 }
+                 return;
+             }
+         }
+
+         if (c->state == HTTP_SEND) {
+             if (!http_tx(c)) {
+                 if ((int32_t)(osKernelGetTickCount() - c->deadline) >= 0) {
+                     http_stats.timeouts++;      // the client stopped reading
+                     http_close(c);
+                 }
+                 return;
+             }
+             c->served++;
+             answered = true;
+             if (c->keep_alive && !c->peer_closed) {
+                 http_request_reset(c);
+                 c->state    = HTTP_READ;
+                 c->deadline = osKernelGetTickCount() + http_ms_to_ticks(W5500_HTTP_IDLE_MS);
+                 continue;
+             }
+             c->state = HTTP_FLUSH;
+         }
+
+         if (c->state == HTTP_FLUSH) {
+             // Disconnect once the last byte is acknowledged
+             int8_t st = w5500_socket_send_status(c->sock_num, c->token);
+             if ((st == W5500_SOCK_BUSY) && ((int32_t)(osKernelGetTickCount() - c->deadline) < 0)) {
+                 return;
+             }
+             http_close(c);
+         }
+         return;
+     }
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ bool w5500_http_init(void)
+ {
+     while (http_conn_count < W5500_HTTP_MAX_CONN) {
+         http_conn_t* c = &http_conns[http_conn_count];
+         if (w5500_socket_alloc("http", ETH_CONFIG_HTTP_SOCK_MASK, &c->sock_num) != W5500_SOCK_OK) {
+             break;
+         }
+         http_conn_count++;
+         http_listen(c);
+     }
+     if (http_conn_count == 0U) {
+         BINLOG_ERROR("No free socket for HTTP");
+         return false;
+     }
+     BINLOG_INFO("HTTP server on port %d, %d connections", W5500_HTTP_PORT, http_conn_count);
+     return true;
+ }
+
+ void w5500_http_stop(void)
+ {
+     while (http_conn_count > 0U) {
+         http_conn_count--;
+         w5500_socket_release(http_conns[http_conn_count].sock_num);
+         memset(&http_conns[http_conn_count], 0, sizeof(http_conns[0]));
+     }
+ }
+
+ void w5500_http_set_handler(w5500_http_handler_t handler)
+ {
+     http_handler = handler;
+ }
+
+ void w5500_http_get_stats(w5500_http_stats_t* stats)
+ {
+     if (stats != NULL) {
+         *stats = http_stats;
+     }
+ }
+
+ void w5500_http_reset_stats(void)
+ {
+     memset(&http_stats, 0, sizeof(http_stats));
+ }
+
+ void w5500_http_task(void* argument)
+ {
+     w5500_pollfd_t fds[W5500_HTTP_MAX_CONN];
+     (void)argument;
+
+     for (;;) {
+         uint32_t now = osKernelGetTickCount();
+         uint32_t wait = osWaitForever;
+
+         if (http_conn_count == 0U) {
+             osDelay(HTTP_RETRY_MS);
+             continue;
+         }
+         for (uint8_t i = 0; i < http_conn_count; i++) {
+             http_conn_t* c = &http_conns[i];
+             int32_t until = -1;     // no deadline
+
+             fds[i].sock_num = c->sock_num;
+             fds[i].revents  = 0;
+             switch (c->state) {
+             case HTTP_LISTEN:
+                 fds[i].events = W5500_POLLCON | W5500_POLLHUP;
+                 break;
+             case HTTP_READ:
+                 fds[i].events = W5500_POLLIN | W5500_POLLHUP;
+                 until = (int32_t)(c->deadline - now);
+                 break;
+             case HTTP_CLOSING:
+                 fds[i].events = W5500_POLLHUP;
+                 until = (int32_t)(c->deadline - now);
+                 break;
+             case HTTP_SEND:
+             case HTTP_FLUSH:
+                 // The dispatched SENDOK frees ring space and ends the flush
+                 fds[i].events = W5500_POLLIN | W5500_POLLHUP | W5500_POLLSENT;
+                 until = (int32_t)(c->deadline - now);
+                 break;
+             default:
+                 fds[i].events = 0;
+                 until = (int32_t)(c->deadline - now);
+                 break;
+             }
+             if (until >= 0) {
+                 if ((uint32_t)until < wait) {
+                     wait = (uint32_t)until;
+                 }
+             } else if (c->state != HTTP_LISTEN) {
+                 wait = 0;   // deadline passed
+             }
+         }
+
+         if (w5500_socket_poll(fds, http_conn_count, wait) < 0) {
+             osDelay(1);
+         }
+         for (uint8_t i = 0; i < http_conn_count; i++) {
+             http_service(&http_conns[i], fds[i].revents);
+         }
+     }
+ }
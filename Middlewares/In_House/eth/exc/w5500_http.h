@@ -0,0 +1,197 @@
+/**
+ * @file    w5500_http.h
+ * @brief   Event-driven HTTP/1.1 server on the W5500
+ *
+ * @details One task serves every connection. It sleeps in
+ *          w5500_socket_poll() on all its sockets and wakes only for a new
+ *          connection, received data, a hang-up, a keep-alive deadline or,
+ *          while a response is stalled on a full TX ring or being flushed,
+ *          the SENDOK of its socket (W5500_POLLSENT).
+ *
+ *          Each socket (up to W5500_HTTP_MAX_CONN, taken from the pool with
+ *          ETH_CONFIG_HTTP_SOCK_MASK, all listening on W5500_HTTP_PORT)
+ *          carries its own connection state machine:
+ *
+ *            LISTEN -> READ -> SEND -> READ ... -> FLUSH -> CLOSING -> LISTEN
+ *
+ *          - READ parses the request straight out of the RX ring, one
+ *            chunk at a time: only the request line and the headers the
+ *            server acts on are kept per connection, not the whole request.
+ *            Reading stops at the end of a request. Pipelined requests stay
+ *            in the ring and are parsed as soon as the response before them
+ *            is queued.
+ *          - SEND streams the response through w5500_socket_send_async():
+ *            each piece is as large as the TX ring's free space, so a
+ *            response never waits for the wire, and responses to pipelined
+ *            requests go out in the same SENDs.
+ *          - HTTP/1.1 connections persist unless the client sends
+ *            "Connection: close" (HTTP/1.0: unless it asks for keep-alive),
+ *            and are closed after W5500_HTTP_IDLE_MS without a request.
+ *          - FLUSH waits for the last response to be sent, then CLOSING
+ *            sends FIN without blocking and listens again once the socket
+ *            is closed (peer FIN or chip timeout), or W5500_HTTP_IDLE_MS
+ *            later.
+ *
+ *          A request goes to the route table first (w5500_router.h:
+ *          method and path, constant-time). A route handler fills a
+ *          w5500_http_resp_t: a status and a body from flash or from the
+ *          connection's W5500_HTTP_BODY_MAX buffer, or a w5500_webfs file.
+ *          A routed path without a handler for the method gets 405 with
+ *          Allow. Unrouted GET and HEAD requests are static files from
+ *          w5500_webfs (gzip, ETag, 304), picked by the handler set with
+ *          w5500_http_set_handler() or looked up by path; other methods get
+ *          405. Request bodies are skipped: parameters come in the query.
+ *
+ *          W5500_MEM_HTTP_CLIENTS gives socket 2 a 4 KB TX buffer.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_HTTP_H
+ #define W5500_HTTP_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <string.h>
+#include "stm32g4xx_hal.h" // For HAL (if needed)
+
+#include "w5500_spi.h"
+#include "w5500_socket.h"
+#include "w5500_webfs.h"
+#include "eth_config.h"
+
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #ifndef W5500_HTTP_PORT
+ #define W5500_HTTP_PORT        80
+ #endif
+ #ifndef W5500_HTTP_MAX_CONN
+ #define W5500_HTTP_MAX_CONN    4       /**< Sockets (connections) served at once */
+ #endif
+ #ifndef W5500_HTTP_LINE_MAX
+ #define W5500_HTTP_LINE_MAX    256     /**< Request line; longer gets 414 */
+ #endif
+ #ifndef W5500_HTTP_HDR_MAX
+ #define W5500_HTTP_HDR_MAX     80      /**< Header line kept; longer ones are skipped */
+ #endif
+ #ifndef W5500_HTTP_ETAG_MAX
+ #define W5500_HTTP_ETAG_MAX    48      /**< If-None-Match value kept */
+ #endif
+ #ifndef W5500_HTTP_BODY_MAX
+ #define W5500_HTTP_BODY_MAX    128     /**< Response body a route handler can build */
+ #endif
+ #ifndef W5500_HTTP_IDLE_MS
+ #define W5500_HTTP_IDLE_MS     5000    /**< Keep-alive (and stalled response or close) timeout */
+ #endif
+
+ /**
+  * @brief Request method
+  */
+ typedef enum {
+     W5500_HTTP_GET = 0,
+     W5500_HTTP_HEAD,
+     W5500_HTTP_POST,
+     W5500_HTTP_PUT,
+     W5500_HTTP_DELETE,
+     W5500_HTTP_OTHER
+ } w5500_http_method_t;
+
+ /**
+  * @brief A parsed request, valid during the handler call
+  */
+ typedef struct {
+     uint8_t     sock_num;       /**< Connection socket */
+     uint8_t     method;         /**< w5500_http_method_t */
+     const char* path;           /**< Terminated, without the query */
+     uint16_t    path_len;
+     const char* query;          /**< After '?', terminated; "" if none */
+     uint16_t    query_len;
+ } w5500_http_req_t;
+
+ /**
+  * @brief Response filled in by a route handler
+  * @details Preset to 200, "text/plain", no body. The body must outlive the
+  *          call: a constant, or buf. Setting file answers with that
+  *          w5500_webfs file instead (ETag, 304), ignoring the rest.
+  */
+ typedef struct {
+     uint16_t       status;     /**< 200-599; 204 has no body */
+     const char*    type;       /**< Content-Type, up to 64 characters */
+     const uint8_t* body;       /**< NULL: none (an error status gets its reason) */
+     uint32_t       len;
+     char*          buf;        /**< This connection's body buffer */
+     uint16_t       buf_size;   /**< W5500_HTTP_BODY_MAX */
+     const w5500_webfs_file_t* file;
+ } w5500_http_resp_t;
+
+ /**
+  * @brief Route handler (see w5500_router.h); HEAD requests run the GET one
+  */
+ typedef void (*w5500_http_route_fn_t)(const w5500_http_req_t* req, w5500_http_resp_t* resp);
+
+ /**
+  * @brief Static file handler, for GET and HEAD requests no route takes
+  * @return File to answer with, NULL for 404
+  */
+ typedef const w5500_webfs_file_t* (*w5500_http_handler_t)(const w5500_http_req_t* req);
+
+ /**
+  * @brief Server counters
+  */
+ typedef struct {
+     uint32_t connections;           /**< Connections accepted */
+     uint32_t requests;              /**< Requests parsed */
+     uint32_t reused;                /**< Requests on a kept-alive connection */
+     uint32_t pipelined;             /**< Requests already queued behind the previous response */
+     uint32_t not_modified;          /**< 304 answers */
+     uint32_t client_errors;         /**< 4xx answers */
+     uint32_t server_errors;         /**< 5xx answers */
+     uint32_t timeouts;              /**< Connections closed idle or stalled */
+     uint32_t bytes;                 /**< Response bytes queued */
+     w5500_latency_stats_t service;  /**< Request parsed to last byte queued, cycles */
+ } w5500_http_stats_t;
+
+ /**
+  * @brief Take the sockets from the pool and start listening
+  * @note  Call before the scheduler starts or from the server task: the
+  *        pool refuses to reopen a socket claimed by another task.
+  * @return bool True if at least one socket is listening
+  */
+ bool w5500_http_init(void);
+
+ /**
+  * @brief Close and release the sockets
+  * @note  Stop the server task first.
+  */
+ void w5500_http_stop(void);
+
+ /**
+  * @brief Set the static file handler (NULL: look the path up in w5500_webfs)
+  * @note  Called from the server task.
+  */
+ void w5500_http_set_handler(w5500_http_handler_t handler);
+
+ /**
+  * @brief Copy the counters
+  */
+ void w5500_http_get_stats(w5500_http_stats_t* stats);
+
+ /**
+  * @brief Zero the counters
+  */
+ void w5500_http_reset_stats(void);
+
+ /**
+  * @brief HTTP server thread body: sleeps until a socket event or deadline
+  */
+ void w5500_http_task(void* argument);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_HTTP_H */
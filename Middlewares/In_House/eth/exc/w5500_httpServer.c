@@ -4,121 +4,21 @@
 #include <stdio.h>
 #include "socket.h"
 #include "dhcp.h"
-#include "httpServer.h"
+#include "cmsis_os.h"
+#include "w5500_http.h"
+#include "w5500_router.h"
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN 0 */
 #define DHCP_SOCKET     0
-#define DNS_SOCKET      1
 #define HTTP_SOCKET     2
 #define SOCK_TCPS       0
 #define SOCK_UDPS       1
 #define PORT_TCPS       5000
 #define PORT_UDPS       3000
-#define MAX_HTTPSOCK    6
-#define index_page "<!DOCTYPE html>"\
-  "<html>"\
-    "<head>"\
-      "<title>W5500-STM32 Web Server</title>"\
-      "<meta http-equiv='Content-Type' content='text/html; charset=utf-8'>"\
-      "<link href=\"data:image/x-icon;base64,A\" rel=\"icon\" type=\"image/x-icon\">"\
-      "<style>"\
-        "html {display: inline-block; margin: 0px auto; text-align: center;}"\
-        "body{margin-top: 50px;}"\
-        ".button {display: block;"\
-          "width: 70px;"\
-          "background-color: #008000;"\
-          "border: none;"\
-          "color: white;"\
-          "padding: 14px 28px;"\
-          "text-decoration: none;"\
-          "font-size: 24px;"\
-          "margin: 0px auto 36px;"\
-          "border-radius: 5px;}"\
-        ".button-on {background-color: #008000;}"\
-        ".button-on:active{background-color: #008000;}"\
-        ".button-off {background-color: #808080;}"\
-        ".button-off:active {background-color: #808080;}"\
-        "p {font-size: 20px;color: #808080;margin-bottom: 20px;}"\
-      "</style>"\
-    "</head>"\
-    "<body>"\
-      "<h1>STM32 - W5500</h1>"\
-      "<p>Control the light via Ethernet</p>"\
-      "<a class=\"button button-on\" href=\"/ledon.html\">ON</a>"\
-      "<a class=\"button button-off\" href=\"/ledoff.html\">OFF</a>"\
-    "</body>"\
-  "</html>"
-
-#define ledon_page" <!DOCTYPE html>"\
-  "<html>"\
-    "<head>"\
-      "<title>W5500-STM32 Web Server</title>"\
-      "<meta http-equiv='Content-Type' content='text/html; charset=utf-8'>"\
-      "<link href=\"data:image/x-icon;base64,A\" rel=\"icon\" type=\"image/x-icon\">"\
-      "<style>"\
-        "html {display: inline-block; margin: 0px auto; text-align: center;}"\
-        "body{margin-top: 50px;}"\
-        ".button {display: block;"\
-          "width: 70px;"\
-          "background-color: #008000;"\
-          "border: none;"\
-          "color: white;"\
-          "padding: 14px 28px;"\
-          "text-decoration: none;"\
-          "font-size: 24px;"\
-          "margin: 0px auto 36px;"\
-          "border-radius: 5px;}"\
-        ".button-on {background-color: #008000;}"\
-        ".button-on:active{background-color: #008000;}"\
-        ".button-off {background-color: #808080;}"\
-        ".button-off:active {background-color: #808080;}"\
-        "p {font-size: 20px;color: #808080;margin-bottom: 20px;}"\
-      "</style>"\
-    "</head>"\
-    "<body>"\
-      "<h1>STM32 - W5500</h1>"\
-      "<p>Light is currently on</p>"\
-      "<a class=\"button button-off\" href=\"/ledoff.html\">OFF</a>"\
-    "</body>"\
-  "</html>"
-
-#define ledoff_page"<!DOCTYPE html>"\
-  "<html>"\
-    "<head>"\
-      "<title>W5500-STM32 Web Server</title>"\
-      "<meta http-equiv='Content-Type' content='text/html; charset=utf-8'>"\
-      "<link href=\"data:image/x-icon;base64,A\" rel=\"icon\" type=\"image/x-icon\">"\
-      "<style>"\
-        "html {display: inline-block; margin: 0px auto; text-align: center;}"\
-        "body{margin-top: 50px;}"\
-        ".button {display: block;"\
-          "width: 70px;"\
-          "background-color: #008000;"\
-          "border: none;"\
-          "color: white;"\
-          "padding: 14px 28px;"\
-          "text-decoration: none;"\
-          "font-size: 24px;"\
-          "margin: 0px auto 36px;"\
-          "border-radius: 5px;}"\
-        ".button-on {background-color: #008000;}"\
-        ".button-on:active{background-color: #008000;}"\
-        ".button-off {background-color: #808080;}"\
-        ".button-off:active {background-color: #808080;}"\
-        "p {font-size: 20px;color: #808080;margin-bottom: 20px;}"\
-      "</style>"\
-    "</head>"\
-    "<body>"\
-      "<h1>STM32 - W5500</h1>"\
-      "<p>Light is currently off</p>"\
-      "<a class=\"button button-on\" href=\"/ledon.html\">ON</a>"\
-    "</body>"\
-  "</html>"
-
-uint8_t socknumlist[] = {2, 3, 4, 5, 6, 7};
-uint8_t RX_BUF[1024];
-uint8_t TX_BUF[1024];
+/* Pages live in exc/web, packed into w5500_webfs_data.c by tools/w5500_webfs_pack.py */
+/* Routes live in w5500_routes.txt, compiled into w5500_routes_data.c by tools/w5500_route_gen.py */
+
 wiz_NetInfo net_info = {
     .mac  = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xED },
     .dhcp = NETINFO_DHCP
@@ -161,7 +61,6 @@ void Callback_IPConflict(void) {
 }
 
 uint8_t dhcp_buffer[1024];
-uint8_t dns_buffer[1024];
 
 void W5500Init() {
     // Register W5500 callbacks
@@ -205,25 +104,71 @@ void W5500Init() {
 
     wizchip_setnetinfo(&net_info);
 }
+
+// LED on PC13, active low
+static void led_set(bool on) {
+    HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, on ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+// GET /ledon.html, /ledoff.html: switch the light, answer with the page
+void http_led_on(const w5500_http_req_t* req, w5500_http_resp_t* resp) {
+    if (req->method == W5500_HTTP_GET) led_set(true);      /* not for HEAD */
+    resp->file = w5500_webfs_find(req->path, req->path_len);
+}
+
+void http_led_off(const w5500_http_req_t* req, w5500_http_resp_t* resp) {
+    if (req->method == W5500_HTTP_GET) led_set(false);
+    resp->file = w5500_webfs_find(req->path, req->path_len);
+}
+
+// GET /api/led: {"on":true}
+void http_led_get(const w5500_http_req_t* req, w5500_http_resp_t* resp) {
+    static const char on[]  = "{\"on\":true}";
+    static const char off[] = "{\"on\":false}";
+    bool lit = (HAL_GPIO_ReadPin(GPIOC, GPIO_PIN_13) == GPIO_PIN_RESET);
+    (void)req;
+
+    resp->type = "application/json";
+    resp->body = (const uint8_t*)(lit ? on : off);
+    resp->len  = lit ? (sizeof(on) - 1U) : (sizeof(off) - 1U);
+}
+
+// PUT /api/led?on=1
+void http_led_put(const w5500_http_req_t* req, w5500_http_resp_t* resp) {
+    uint32_t on;
+
+    if (!w5500_router_query_u32(req, "on", &on) || (on > 1U)) {
+        resp->status = 400;
+        return;
+    }
+    led_set(on != 0U);
+    resp->status = 204;
+}
+
+osThreadId_t httpTaskHandle;
+const osThreadAttr_t httpTask_attributes = {
+  .name = "httpTask",
+  .priority = (osPriority_t) osPriorityNormal,
+  .stack_size = 256 * 4
+};
 /* USER CODE END 0 */
 
   /* USER CODE BEGIN 2 */
   W5500Init();
-  httpServer_init(TX_BUF, RX_BUF, MAX_HTTPSOCK, socknumlist);
-  reg_httpServer_cbfunc(NVIC_SystemReset, NULL);
-  /* Web content registration */
-  reg_httpServer_webContent((uint8_t *)"index.html", (uint8_t *)index_page);
-  reg_httpServer_webContent((uint8_t *)"ledon.html", (uint8_t *)ledon_page);
-  reg_httpServer_webContent((uint8_t *)"ledoff.html", (uint8_t *)ledoff_page);
+  w5500_http_init();      /* W5500_HTTP_MAX_CONN sockets listening on port 80 */
 
   HAL_GPIO_WritePin(GPIOC, GPIO_PIN_13, GPIO_PIN_RESET);
   /* USER CODE END 2 */
 
+  /* USER CODE BEGIN RTOS_THREADS */
+  /* Sleeps until a connection, request or deadline: no polling loop */
+  httpTaskHandle = osThreadNew(w5500_http_task, NULL, &httpTask_attributes);
+  /* USER CODE END RTOS_THREADS */
+
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-    for(int i = 0; i < MAX_HTTPSOCK; i++) httpServer_run(i); // HTTP Server handler
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
@@ -1,54 +1,238 @@
 /**
  * @file    w5500_icmp.c
- * @brief   ICMP Ping Task for W5500 Ethernet Controller
+ * @brief   ICMP echo responder for the W5500, with latency histograms
  * @author  Narudol T.
  * @date    2025-06-10
  */
 
  #include "w5500_icmp.h"
  #include "w5500_socket.h"
+ #include "w5500_irq.h"
  #include "eth_config.h"
  #include <string.h>
- #include <stdio.h>
- 
- #ifndef ETH_CONFIG_ICMP_SOCKET
- #define ETH_CONFIG_ICMP_SOCKET 1
- #endif
- 
- #ifndef ETH_CONFIG_ICMP_BUF_LEN
- #define ETH_CONFIG_ICMP_BUF_LEN 64
+
+ #define BINLOG_MODULE        "w5500_icmp"
+ #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ #include "binlog.h"
+
+ // Sockets the responder may take from the pool; narrowed at init to those
+ // whose RX buffer holds the largest echo request (icmp_sock_mask())
+ #ifndef ETH_CONFIG_ICMP_SOCK_MASK
+ #define ETH_CONFIG_ICMP_SOCK_MASK W5500_SOCK_ANY
  #endif
- 
- static const uint8_t PC_PING_IP[4] = {192, 168, 68, 100};
- static const char *RESPONSE = "pong";
- static const char *KEYWORD  = "ping";
- 
- static uint8_t icmp_socket = ETH_CONFIG_ICMP_SOCKET;
- static uint8_t icmp_buffer[ETH_CONFIG_ICMP_BUF_LEN];
- 
- void w5500_icmp_init(void) {
-
-     // Open UDP socket on arbitrary port (0 = any)
-     w5500_socket_close(icmp_socket);
-
-     if (w5500_socket_open(icmp_socket, W5500_SOCK_UDP, 0) != icmp_socket) 
-     {
 
+ #define ICMP_HDR_LEN        8       // type, code, checksum, identifier, sequence
+ #define ICMP_ECHO_REPLY     0
+ #define ICMP_ECHO_REQUEST   8
+
+ static uint8_t icmp_socket = W5500_MAX_SOCKET;   // none until init
+ static uint8_t icmp_buffer[W5500_ICMP_MAX_LEN];
+ static w5500_icmp_stats_t icmp_stats;
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ // RFC 1071 one's complement sum, not inverted
+ static uint16_t icmp_sum(const uint8_t *p, uint16_t len)
+ {
+     uint32_t sum = 0;
+
+     while (len > 1U) {
+         sum += (uint32_t)((p[0] << 8) | p[1]);
+         p += 2;
+         len = (uint16_t)(len - 2U);
+     }
+     if (len != 0U) {
+         sum += (uint32_t)(p[0] << 8);
      }
+     while ((sum >> 16) != 0U) {
+         sum = (sum & 0xFFFFU) + (sum >> 16);
+     }
+     return (uint16_t)sum;
  }
- 
- void w5500_icmp_task100ms(void) 
+
+ /**
+  * @brief Turn the echo request in icmp_buffer into its reply and send it
+  * @param t_read  SPI_BUS_CYCLES() before the request was read
+  * @param t_edge  SPI_BUS_CYCLES() of the INT edge (or wake-up) behind it
+  */
+ static void icmp_echo(const uint8_t *src, uint16_t len, uint32_t t_read, uint32_t t_edge)
  {
-     int32_t len;
-     uint8_t src_ip[4];
-     uint16_t src_port;
- 
-     len = w5500_socket_recvfrom(icmp_socket, icmp_buffer, sizeof(icmp_buffer), src_ip, &src_port);
+     icmp_stats.requests++;
+     if (icmp_sum(icmp_buffer, len) != 0xFFFFU) {
+         icmp_stats.dropped++;
+         return;
+     }
+
+     // Type 8 -> 0: adjust the checksum instead of summing the payload
+     // again (RFC 1624: HC' = ~(~HC + ~m + m'))
+     uint32_t sum = (uint32_t)(uint16_t)~((icmp_buffer[2] << 8) | icmp_buffer[3]);
+     sum += (uint16_t)~(ICMP_ECHO_REQUEST << 8);
+     sum += (uint32_t)(ICMP_ECHO_REPLY << 8);
+     while ((sum >> 16) != 0U) {
+         sum = (sum & 0xFFFFU) + (sum >> 16);
+     }
+     sum = (uint16_t)~sum;
+     icmp_buffer[0] = ICMP_ECHO_REPLY;
+     icmp_buffer[2] = (uint8_t)(sum >> 8);
+     icmp_buffer[3] = (uint8_t)sum;
 
-     if (len > 0 && memcmp(src_ip, PC_PING_IP, 4) == 0) 
+     if (w5500_socket_sendto(icmp_socket, icmp_buffer, len, src, W5500_IPRAW_PORT) < 0) {
+         icmp_stats.dropped++;
+         return;
+     }
+     uint32_t t_done = SPI_BUS_CYCLES();
+     icmp_stats.replies++;
+     icmp_stats.bytes += len;
+     w5500_socket_latency_add(&icmp_stats.service, t_done - t_read);
+     w5500_socket_latency_add(&icmp_stats.turnaround, t_done - t_edge);
+ }
+
+ // RECV fires once per arrival burst: drain every queued packet.
+ static void w5500_icmp_process(uint32_t t_wake)
+ {
+     w5500_rx_span_t span;
+     uint8_t head[W5500_IPRAW_HDR_LEN + ICMP_HDR_LEN];
+     uint32_t t_edge = w5500_irq_get_stamp(icmp_socket);
+
+     if (t_edge == 0U) {
+         t_edge = t_wake;    // polled, or no dispatcher
+     }
+
+     while ((w5500_socket_peek(icmp_socket, &span) == W5500_SOCK_OK) && (span.len > 0))
      {
-         if (len >= strlen(KEYWORD) && memcmp(icmp_buffer, KEYWORD, strlen(KEYWORD)) == 0) {
-             w5500_socket_sendto(icmp_socket, (const uint8_t *)RESPONSE, strlen(RESPONSE), src_ip, src_port);
+         while (span.len >= W5500_IPRAW_HDR_LEN)
+         {
+             uint32_t t_read = SPI_BUS_CYCLES();
+             int32_t got = w5500_socket_peek_read(icmp_socket, &span, 0, head, sizeof(head));
+             if (got < (int32_t)W5500_IPRAW_HDR_LEN) {
+                 return;
+             }
+             uint16_t len     = (uint16_t)((head[4] << 8) | head[5]);
+             uint16_t pkt_len = (uint16_t)(W5500_IPRAW_HDR_LEN + len);
+             if (pkt_len > span.len) {
+                 break;      // desynchronised ring, dropped below
+             }
+             uint8_t src[4];
+             memcpy(src, head, 4);
+
+             // Only echo requests are copied out; everything else is
+             // released from the ring after its 8-byte header
+             bool echo = (got == (int32_t)sizeof(head)) && (len >= ICMP_HDR_LEN) &&
+                         (head[W5500_IPRAW_HDR_LEN] == ICMP_ECHO_REQUEST) &&
+                         (head[W5500_IPRAW_HDR_LEN + 1] == 0U);
+             bool copied = echo && (len <= sizeof(icmp_buffer)) &&
+                           (w5500_socket_peek_read(icmp_socket, &span, W5500_IPRAW_HDR_LEN,
+                                                   icmp_buffer, len) == (int32_t)len);
+
+             if (w5500_socket_consume(icmp_socket, &span, pkt_len) != W5500_SOCK_OK) {
+                 return;
+             }
+             if (copied) {
+                 icmp_echo(src, len, t_read, t_edge);
+             } else if (echo) {
+                 icmp_stats.requests++;
+                 icmp_stats.dropped++;
+             } else {
+                 icmp_stats.ignored++;
+             }
+         }
+         if (span.len > 0) {
+             // Partial packet: the chip writes whole packets, so this is a
+             // desynchronised ring. Drop it.
+             w5500_socket_consume(icmp_socket, &span, span.len);
+         }
+     }
+ }
+
+ // Sockets of the ETH_CONFIG_MEM_PROFILE layout with room for a whole
+ // W5500_ICMP_MAX_LEN request: the 1 KB sockets of bulk-stream would drop it
+ static uint8_t icmp_sock_mask(void)
+ {
+     const w5500_mem_layout_t *mem = w5500_socket_get_profile(ETH_CONFIG_MEM_PROFILE);
+     uint8_t mask = 0;
+
+     for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++) {
+         if ((uint32_t)mem->rx_kb[sn] * 1024U >= (W5500_IPRAW_HDR_LEN + W5500_ICMP_MAX_LEN)) {
+             mask |= (uint8_t)(1U << sn);
          }
      }
- }
\ No newline at end of file
+     return (uint8_t)(mask & ETH_CONFIG_ICMP_SOCK_MASK);
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ bool w5500_icmp_init(void)
+ {
+     if ((icmp_socket >= W5500_MAX_SOCKET) &&
+         (w5500_socket_alloc("icmp", icmp_sock_mask(), &icmp_socket) != W5500_SOCK_OK)) {
+         BINLOG_ERROR("No free socket for ICMP");
+         icmp_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+     if (w5500_socket_open_ipraw(icmp_socket, W5500_IPPROTO_ICMP) != W5500_SOCK_OK) {
+         w5500_socket_release(icmp_socket);
+         icmp_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+
+     // Otherwise the chip answers as well and every ping gets two replies
+     w5500_spi_lock();
+     setMR(getMR() | MR_PB);
+     w5500_spi_unlock();
+
+     BINLOG_INFO("ICMP echo responder on socket %d", icmp_socket);
+     return true;
+ }
+
+ void w5500_icmp_stop(void)
+ {
+     w5500_spi_lock();
+     if (icmp_socket < W5500_MAX_SOCKET) {
+         w5500_socket_close(icmp_socket);
+         w5500_socket_release(icmp_socket);
+         icmp_socket = W5500_MAX_SOCKET;
+         setMR(getMR() & (uint8_t)~MR_PB);
+     }
+     w5500_spi_unlock();
+ }
+
+ void w5500_icmp_get_stats(w5500_icmp_stats_t *stats)
+ {
+     if (stats != NULL) {
+         *stats = icmp_stats;
+     }
+ }
+
+ void w5500_icmp_reset_stats(void)
+ {
+     memset(&icmp_stats, 0, sizeof(icmp_stats));
+ }
+
+ void w5500_icmp_task100ms(void)
+ {
+     // Nothing to do unless the INT dispatcher latched RECV for this socket
+     if ((icmp_socket < W5500_MAX_SOCKET) &&
+         (w5500_irq_wait(icmp_socket, W5500_IRQ_RECV, 0) != 0)) {
+         w5500_icmp_process(SPI_BUS_CYCLES());
+     }
+ }
+
+ void w5500_icmp_task(void *argument)
+ {
+     (void)argument;
+
+     for (;;) {
+         if (icmp_socket >= W5500_MAX_SOCKET) {
+             // No socket (pool exhausted or open failed): wait for a re-init
+             osDelay(100);
+             continue;
+         }
+         if (w5500_irq_wait(icmp_socket, W5500_IRQ_RECV, osWaitForever) != 0) {
+             w5500_icmp_process(SPI_BUS_CYCLES());
+         }
+     }
+ }
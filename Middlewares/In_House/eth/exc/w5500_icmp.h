@@ -1,42 +1,96 @@
 /**
  * @file    w5500_icmp.h
- * @brief   ICMP Ping Task API Header for W5500 Ethernet Controller
+ * @brief   ICMP echo responder for the W5500, with latency histograms
+ *
+ * @details Answers echo requests (ping) from any sender with any payload up
+ *          to W5500_ICMP_MAX_LEN on an IPRAW socket taken from the pool
+ *          (ETH_CONFIG_ICMP_SOCK_MASK). The chip's own ping reply is switched
+ *          off (MR PB) while the responder runs, so each request gets one
+ *          answer and every answer goes through the stack being measured.
+ *
+ *          Each reply is timed in DWT cycles into two histograms:
+ *          - service: request read from the RX ring to reply SENDOK,
+ *          - turnaround: INT edge (w5500_irq_get_stamp()) to reply SENDOK,
+ *            including the dispatcher, the task wake-up and the requests
+ *            queued in front of this one.
+ *          Run "ping -f" (or "ping -i 0.01 -s <size>") against the board and
+ *          read w5500_icmp_get_stats(): turnaround is the on-board share of
+ *          the round trip ping reports.
+ *
  * @author  Narudol T.
  * @date    2025-06-10
  */
 
  #ifndef W5500_ICMP_H
  #define W5500_ICMP_H
- 
+
 #include <stdint.h> // For uint8_t
 #include <stdbool.h>
 #include <string.h>
-#include "stm32f1xx_hal.h" // For HAL (if needed)
+#include "stm32g4xx_hal.h" // For HAL (if needed)
 
- #include "w5500_spi.h"
+#include "w5500_spi.h"
+#include "w5500_socket.h"
 #include "eth_config.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/socket.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/wizchip_conf.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Ethernet/W5500/w5500.h"
-#include "../../../Middlewares/Third_Party/ioLibrary_Driver_v3.2.0/Internet/DHCP/dhcp.h"
 
 
  #ifdef __cplusplus
  extern "C" {
  #endif
- 
+
+ #define W5500_ICMP_MAX_LEN     1480   /**< ICMP message in one 1500-byte IP packet */
+
  /**
-  * @brief Initialize the ICMP ping task (UDP-based ping listener)
+  * @brief Responder counters and latency histograms
   */
- void w5500_icmp_init(void);
- 
+ typedef struct {
+     uint32_t requests;                  /**< Echo requests received */
+     uint32_t replies;                   /**< Echo replies sent */
+     uint32_t bytes;                     /**< ICMP bytes echoed */
+     uint32_t dropped;                   /**< Bad checksum, too long, or send failed */
+     uint32_t ignored;                   /**< Other ICMP messages */
+     w5500_latency_stats_t service;      /**< Request read to reply SENDOK, cycles */
+     w5500_latency_stats_t turnaround;   /**< INT edge to reply SENDOK, cycles */
+ } w5500_icmp_stats_t;
+
  /**
-  * @brief Periodic ICMP task function (to be called every 10ms)
+  * @brief Take an IPRAW socket from the pool and take over ping replies
+  * @return bool True on success
+  */
+ bool w5500_icmp_init(void);
+
+ /**
+  * @brief Close the socket and hand ping replies back to the chip
+  */
+ void w5500_icmp_stop(void);
+
+ /**
+  * @brief Copy the counters
+  * @note  Updated by the responder without locking; a copy taken mid-reply
+  *        may be one request behind.
+  */
+ void w5500_icmp_get_stats(w5500_icmp_stats_t *stats);
+
+ /**
+  * @brief Zero the counters, e.g. before a ping -f run
+  */
+ void w5500_icmp_reset_stats(void);
+
+ /**
+  * @brief ICMP thread body: blocks on RECV and answers as soon as a request
+  *        arrives. Do not mix with w5500_icmp_task100ms().
+  */
+ void w5500_icmp_task(void *argument);
+
+ /**
+  * @brief Polled alternative to w5500_icmp_task()
+  * @note  Touches the chip only when the INT dispatcher latched RECV; the
+  *        period adds up to 100 ms to every round trip.
   */
  void w5500_icmp_task100ms(void);
- 
+
  #ifdef __cplusplus
  }
  #endif
- 
+
  #endif /* W5500_ICMP_H */
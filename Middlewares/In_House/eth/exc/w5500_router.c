@@ -0,0 +1,206 @@
+/**
+ * @file    w5500_router.c
+ * @brief   Compile-time route table for the HTTP server
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_router.h"
+ #include <string.h>
+
+ /*============================================================================*/
+ /*                         HASH                                               */
+ /*============================================================================*/
+
+ // tools/w5500_route_gen.py computes the same: change both together
+ #define ROUTER_FNV_BASIS    0x811C9DC5U
+ #define ROUTER_FNV_PRIME    0x01000193U
+ #define ROUTER_DISP_STEP    0x9E3779B9U
+
+ static uint32_t router_fnv(const char* s, uint16_t len)
+ {
+     uint32_t h = ROUTER_FNV_BASIS;
+
+     for (uint16_t i = 0; i < len; i++) {
+         h ^= (uint8_t)s[i];
+         h *= ROUTER_FNV_PRIME;
+     }
+     return h;
+ }
+
+ // Spreads FNV's weak low bits before the modulo
+ static uint32_t router_mix(uint32_t h)
+ {
+     h ^= h >> 16;
+     h *= 0x85EBCA6BU;
+     h ^= h >> 13;
+     h *= 0xC2B2AE35U;
+     h ^= h >> 16;
+     return h;
+ }
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ static int8_t router_hex(char c)
+ {
+     if ((c >= '0') && (c <= '9')) {
+         return (int8_t)(c - '0');
+     }
+     if ((c >= 'a') && (c <= 'f')) {
+         return (int8_t)(c - 'a' + 10);
+     }
+     if ((c >= 'A') && (c <= 'F')) {
+         return (int8_t)(c - 'A' + 10);
+     }
+     return -1;
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ w5500_http_route_fn_t w5500_router_find(uint8_t method, const char* path, uint16_t len, uint8_t* allow)
+ {
+     const w5500_route_table_t* t = &w5500_route_table;
+     const w5500_route_t* r;
+     w5500_http_route_fn_t fn = NULL;
+     uint32_t h;
+
+     if (allow != NULL) {
+         *allow = 0;
+     }
+     if ((path == NULL) || (t->route_count == 0U)) {
+         return NULL;
+     }
+
+     // One pass over the path, one candidate, one compare
+     h = router_fnv(path, len);
+     r = &t->routes[router_mix(h + ((uint32_t)t->disp[router_mix(h) % t->bucket_count] * ROUTER_DISP_STEP))
+                    % t->route_count];
+     if ((r->path == NULL) || (r->path_len != len) || (memcmp(r->path, path, len) != 0)) {
+         return NULL;
+     }
+
+     if (method < W5500_HTTP_OTHER) {
+         fn = r->handler[method];
+         if ((fn == NULL) && (method == W5500_HTTP_HEAD)) {
+             fn = r->handler[W5500_HTTP_GET];
+         }
+     }
+     if (allow != NULL) {
+         *allow = r->allow;
+         if ((r->allow & W5500_ROUTE_BIT(W5500_HTTP_GET)) != 0U) {
+             *allow |= W5500_ROUTE_BIT(W5500_HTTP_HEAD);
+         }
+     }
+     return fn;
+ }
+
+ bool w5500_router_query_next(const w5500_http_req_t* req, uint16_t* pos, w5500_router_param_t* param)
+ {
+     const char* q;
+     uint16_t i;
+
+     if ((req == NULL) || (pos == NULL) || (param == NULL) || (req->query == NULL)) {
+         return false;
+     }
+     q = req->query;
+     i = *pos;
+     while (i < req->query_len) {
+         uint16_t start = i;
+         while ((i < req->query_len) && (q[i] != '&')) {
+             i++;
+         }
+         uint16_t end = i;
+         if (i < req->query_len) {
+             i++;        // '&'
+         }
+         if (end == start) {
+             continue;   // "a=1&&b=2"
+         }
+
+         const char* eq = memchr(&q[start], '=', (size_t)(end - start));
+         param->name = &q[start];
+         if (eq != NULL) {
+             param->name_len  = (uint16_t)(eq - &q[start]);
+             param->value     = eq + 1;
+             param->value_len = (uint16_t)(&q[end] - (eq + 1));
+         } else {
+             param->name_len  = (uint16_t)(end - start);
+             param->value     = "";
+             param->value_len = 0;
+         }
+         *pos = i;
+         return true;
+     }
+     *pos = i;
+     return false;
+ }
+
+ bool w5500_router_query_get(const w5500_http_req_t* req, const char* name, w5500_router_param_t* param)
+ {
+     uint16_t pos = 0;
+     size_t name_len;
+
+     if (name == NULL) {
+         return false;
+     }
+     name_len = strlen(name);
+     while (w5500_router_query_next(req, &pos, param)) {
+         if ((param->name_len == name_len) && (memcmp(param->name, name, name_len) == 0)) {
+             return true;
+         }
+     }
+     return false;
+ }
+
+ bool w5500_router_query_u32(const w5500_http_req_t* req, const char* name, uint32_t* value)
+ {
+     w5500_router_param_t param;
+     uint32_t n = 0;
+
+     if ((value == NULL) || !w5500_router_query_get(req, name, &param) || (param.value_len == 0U)) {
+         return false;
+     }
+     for (uint16_t i = 0; i < param.value_len; i++) {
+         char c = param.value[i];
+         if ((c < '0') || (c > '9') || (n > ((0xFFFFFFFFU - (uint32_t)(c - '0')) / 10U))) {
+             return false;
+         }
+         n = (n * 10U) + (uint32_t)(c - '0');
+     }
+     *value = n;
+     return true;
+ }
+
+ int32_t w5500_router_decode(const char* src, uint16_t len, char* dst, uint16_t size)
+ {
+     uint16_t out = 0;
+
+     if ((src == NULL) || (dst == NULL)) {
+         return -1;
+     }
+     for (uint16_t i = 0; i < len; i++) {
+         char c = src[i];
+
+         if (c == '%') {
+             bool whole = (((uint32_t)i + 2U) < len);
+             int8_t hi = whole ? router_hex(src[i + 1U]) : -1;
+             int8_t lo = (hi >= 0) ? router_hex(src[i + 2U]) : -1;
+             if (lo < 0) {
+                 return -1;
+             }
+             c = (char)((hi << 4) | lo);
+             i = (uint16_t)(i + 2U);
+         } else if (c == '+') {
+             c = ' ';
+         }
+         if (out >= size) {
+             return -1;
+         }
+         dst[out++] = c;
+     }
+     return (int32_t)out;
+ }
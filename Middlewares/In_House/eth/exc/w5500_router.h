@@ -0,0 +1,116 @@
+/**
+ * @file    w5500_router.h
+ * @brief   Compile-time route table for the HTTP server
+ *
+ * @details The routes are listed in w5500_routes.txt (method, path,
+ *          handler) and compiled by tools/w5500_route_gen.py into
+ *          w5500_routes_data.c: one entry per path, holding a handler per
+ *          method, placed by a minimal perfect hash of the path.
+ *
+ *          A lookup hashes the path once (FNV-1a), picks the bucket's
+ *          displacement, takes the entry it points to and compares that one
+ *          path: the same work for three routes or three hundred, and no
+ *          string compare against any other route. A path that is routed,
+ *          but not for the request's method, reports the methods it has
+ *          (405 with Allow). HEAD falls back to the GET handler.
+ *
+ *          Query parameters are read in place: w5500_router_query_next()
+ *          and w5500_router_query_get() return spans into the request line,
+ *          still percent-encoded; w5500_router_decode() decodes one into a
+ *          caller buffer when needed.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_ROUTER_H
+ #define W5500_ROUTER_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "w5500_http.h"
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #define W5500_ROUTE_BIT(method) ((uint8_t)(1U << (method)))    /**< Bit of a method in an allow mask */
+
+ /**
+  * @brief One routed path (w5500_routes_data.c)
+  */
+ typedef struct {
+     const char*           path;                        /**< NULL for a free slot */
+     uint16_t              path_len;
+     uint8_t               allow;                       /**< W5500_ROUTE_BIT() of the routed methods */
+     w5500_http_route_fn_t handler[W5500_HTTP_OTHER];   /**< By w5500_http_method_t, NULL if none */
+ } w5500_route_t;
+
+ /**
+  * @brief Perfect hash over the routed paths
+  * @details entry = routes[mix(h + disp[mix(h) % bucket_count] * K) % route_count],
+  *          h the FNV-1a hash of the path (see w5500_router.c).
+  */
+ typedef struct {
+     const w5500_route_t* routes;       /**< In hash order */
+     const uint16_t*      disp;         /**< Displacement per bucket */
+     uint16_t             route_count;
+     uint16_t             bucket_count;
+ } w5500_route_table_t;
+
+ /* Generated by tools/w5500_route_gen.py */
+ extern const w5500_route_table_t w5500_route_table;
+
+ /**
+  * @brief One query parameter, pointing into the request
+  */
+ typedef struct {
+     const char* name;           /**< Raw (percent-encoded), not terminated */
+     uint16_t    name_len;
+     const char* value;          /**< Raw, not terminated; "" if there is no '=' */
+     uint16_t    value_len;
+ } w5500_router_param_t;
+
+ /**
+  * @brief Find the handler for a request
+  * @param method  w5500_http_method_t
+  * @param path    Request path without the query; need not be terminated
+  * @param allow   Out: W5500_ROUTE_BIT() of the path's methods (HEAD with
+  *                GET), 0 if the path is not routed; may be NULL
+  * @return Handler, NULL if the path or the method is not routed
+  */
+ w5500_http_route_fn_t w5500_router_find(uint8_t method, const char* path, uint16_t len, uint8_t* allow);
+
+ /**
+  * @brief Iterate over the query parameters ("a=1&b&c=%20")
+  * @param pos    Iterator, start at 0
+  * @return bool  False once there are no more
+  */
+ bool w5500_router_query_next(const w5500_http_req_t* req, uint16_t* pos, w5500_router_param_t* param);
+
+ /**
+  * @brief First parameter called name (compared raw)
+  * @return bool  False if there is none
+  */
+ bool w5500_router_query_get(const w5500_http_req_t* req, const char* name, w5500_router_param_t* param);
+
+ /**
+  * @brief Parameter as a decimal number
+  * @return bool  False if it is missing, empty, not a number or over 32 bits
+  */
+ bool w5500_router_query_u32(const w5500_http_req_t* req, const char* name, uint32_t* value);
+
+ /**
+  * @brief Percent-decode a raw name or value ('+' is a space)
+  * @return int32_t  Decoded length (not terminated), -1 if dst is too small
+  *                  or an escape is malformed
+  */
+ int32_t w5500_router_decode(const char* src, uint16_t len, char* dst, uint16_t size);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_ROUTER_H */
@@ -0,0 +1,34 @@
+/**
+ * @file    w5500_routes_data.c
+ * @brief   HTTP route table for w5500_router (generated, do not edit)
+ *
+ * @details Generated by tools/w5500_route_gen.py from Middlewares/In_House/eth/exc/w5500_routes.txt.
+ *          3 paths, 4 routes, 3 entries, 2 buckets.
+ */
+
+ #include "w5500_router.h"
+
+ void http_led_get(const w5500_http_req_t* req, w5500_http_resp_t* resp);
+ void http_led_off(const w5500_http_req_t* req, w5500_http_resp_t* resp);
+ void http_led_on(const w5500_http_req_t* req, w5500_http_resp_t* resp);
+ void http_led_put(const w5500_http_req_t* req, w5500_http_resp_t* resp);
+
+ static const w5500_route_t route_entries[3] = {
+     { "/ledon.html", 11U, W5500_ROUTE_BIT(W5500_HTTP_GET),
+       { http_led_on, NULL, NULL, NULL, NULL } },
+     { "/ledoff.html", 12U, W5500_ROUTE_BIT(W5500_HTTP_GET),
+       { http_led_off, NULL, NULL, NULL, NULL } },
+     { "/api/led", 8U, W5500_ROUTE_BIT(W5500_HTTP_GET) | W5500_ROUTE_BIT(W5500_HTTP_PUT),
+       { http_led_get, NULL, NULL, http_led_put, NULL } },
+ };
+
+ static const uint16_t route_disp[2] = {
+     4U, 2U,
+ };
+
+ const w5500_route_table_t w5500_route_table = {
+     .routes       = route_entries,
+     .disp         = route_disp,
+     .route_count  = 3U,
+     .bucket_count = 2U,
+ };
@@ -0,0 +1,630 @@
+/**
+ * @file    w5500_sntp.c
+ * @brief   SNTP client (RFC 4330) disciplining the wallclock timestamp service
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_sntp.h"
+ #include "w5500_socket.h"
+ #include "w5500_irq.h"
+ #include "w5500_dns.h"
+ #include "eth_config.h"
+ #include "FreeRTOS.h"
+ #include <string.h>
+
+ #define BINLOG_MODULE        "w5500_sntp"
+ #define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+ #include "binlog.h"
+
+ // Sockets the client may take from the pool
+ #ifndef ETH_CONFIG_SNTP_SOCK_MASK
+ #define ETH_CONFIG_SNTP_SOCK_MASK W5500_SOCK_ANY
+ #endif
+
+ #define SNTP_SERVER_PORT    123
+ #define SNTP_MSG_LEN        48
+ #define SNTP_VERSION        4
+ #define SNTP_MODE_CLIENT    3
+ #define SNTP_MODE_SERVER    4
+ #define SNTP_LI_ALARM       3       // server not synchronised
+ #define SNTP_STRATUM_MAX    15
+ #define SNTP_EPOCH_OFFSET   2208988800ULL   // 1900-01-01 to 1970-01-01, s
+
+ #define SNTP_REPLY_MS       2000U   // reply timeout
+ #define SNTP_BURST_GAP_S    2U
+ #define SNTP_RESOLVE_MS     100U    // recheck a pending DNS lookup
+ #define SNTP_MAX_LOSSES     4       // then re-resolve and back off
+ #define SNTP_FLL_MIN_NS     16000000000LL   // shortest baseline for a frequency update
+ #define SNTP_DELAY_SLACK_NS 200000LL        // round-trip noise floor of the filter
+
+ typedef struct {
+     int64_t  delay;                  // round trip, ns
+     uint64_t mono;                   // wallclock_mono_ns() at reception, 0 = free
+ } sntp_sample_t;
+
+ static uint8_t sntp_socket = W5500_MAX_SOCKET;   // none until init
+ static uint8_t sntp_buffer[SNTP_MSG_LEN];
+ static uint8_t sntp_server[4];                   // 0.0.0.0 = resolve first
+ static uint8_t sntp_origin[8];                   // our transmit stamp, echoed back
+ static int64_t sntp_t1;                          // request sent, wallclock ns
+ static bool sntp_waiting;                        // request outstanding
+ static uint32_t sntp_deadline;                   // next request or reply timeout, tick
+ static uint8_t sntp_burst;                       // requests left in the burst
+ static uint8_t sntp_losses;                      // in a row
+ static uint32_t sntp_poll_s = W5500_SNTP_POLL_S;
+
+ static sntp_sample_t sntp_filter[W5500_SNTP_FILTER];
+ static uint8_t sntp_filter_next;
+
+ static int32_t sntp_freq;                        // ppb handed to wallclock
+ static uint64_t sntp_fll_mono;                   // start of the frequency baseline
+ static int64_t sntp_fll_residual;                // offset not explained by slews since then
+ static int64_t sntp_last_offset;
+ static uint64_t sntp_jitter2;                    // ns^2, smoothed
+ static uint32_t sntp_applied_tick;
+ static uint32_t sntp_root_ns;                    // server root delay / 2 + dispersion
+
+ static w5500_sntp_stats_t sntp_stats;
+ static volatile bool sntp_restart;
+ static bool sntp_subscribed;
+ static osMutexId_t sntp_mutex;                   // client state and stats
+ static StaticSemaphore_t sntp_mutex_cb;
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ static bool sntp_due(uint32_t now, uint32_t tick)
+ {
+     return (int32_t)(now - tick) >= 0;
+ }
+
+ static uint32_t sntp_ms_to_ticks(uint32_t ms)
+ {
+     return (uint32_t)(((uint64_t)ms * osKernelGetTickFreq()) / 1000U);
+ }
+
+ static uint32_t sntp_get32(const uint8_t *b)
+ {
+     return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | b[3];
+ }
+
+ static void sntp_put32(uint8_t *b, uint32_t v)
+ {
+     b[0] = (uint8_t)(v >> 24);
+     b[1] = (uint8_t)(v >> 16);
+     b[2] = (uint8_t)(v >> 8);
+     b[3] = (uint8_t)v;
+ }
+
+ static void sntp_put_stamp(uint8_t *b, int64_t ns)
+ {
+     uint64_t s = (uint64_t)(ns / WALLCLOCK_NS_PER_S);
+     uint64_t f = (uint64_t)(ns % WALLCLOCK_NS_PER_S);
+
+     sntp_put32(b, (uint32_t)(s + SNTP_EPOCH_OFFSET));
+     sntp_put32(b + 4, (uint32_t)((f << 32) / (uint64_t)WALLCLOCK_NS_PER_S));
+ }
+
+ static int64_t sntp_get_stamp(const uint8_t *b)
+ {
+     uint64_t s = sntp_get32(b);
+     uint64_t f = sntp_get32(b + 4);
+
+     // RFC 4330 section 3: MSB clear means era 1, from 2036-02-07
+     if ((s & 0x80000000ULL) == 0U) {
+         s += 1ULL << 32;
+     }
+     return (int64_t)(s - SNTP_EPOCH_OFFSET) * WALLCLOCK_NS_PER_S +
+            (int64_t)((f * (uint64_t)WALLCLOCK_NS_PER_S) >> 32);
+ }
+
+ // NTP short format (16.16 s) to ns
+ static uint64_t sntp_short_to_ns(uint32_t v)
+ {
+     return ((uint64_t)v * (uint64_t)WALLCLOCK_NS_PER_S) >> 16;
+ }
+
+ static uint32_t sntp_sat_u32(uint64_t v)
+ {
+     return (v > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (uint32_t)v;
+ }
+
+ static int32_t sntp_sat_i32(int64_t v)
+ {
+     return (v > INT32_MAX) ? INT32_MAX : ((v < INT32_MIN) ? INT32_MIN : (int32_t)v);
+ }
+
+ static uint32_t sntp_isqrt(uint64_t v)
+ {
+     uint64_t r = 0;
+     uint64_t bit = 1ULL << 62;
+
+     while (bit > v) {
+         bit >>= 2;
+     }
+     while (bit != 0U) {
+         if (v >= r + bit) {
+             v -= r + bit;
+             r = (r >> 1) + bit;
+         } else {
+             r >>= 1;
+         }
+         bit >>= 2;
+     }
+     return (uint32_t)r;
+ }
+
+ /*============================================================================*/
+ /*                         SCHEDULE                                           */
+ /*============================================================================*/
+
+ static void sntp_start_burst(uint32_t now)
+ {
+     sntp_burst    = W5500_SNTP_BURST;
+     sntp_waiting  = false;
+     sntp_deadline = now;
+ }
+
+ // Next request after a reply or a loss
+ static void sntp_schedule(uint32_t now)
+ {
+     uint32_t s = (sntp_burst > 0U) ? SNTP_BURST_GAP_S : sntp_poll_s;
+     sntp_deadline = now + s * osKernelGetTickFreq();
+ }
+
+ static void sntp_backoff(void)
+ {
+     sntp_poll_s = (sntp_poll_s * 2U > W5500_SNTP_POLL_MAX_S) ? W5500_SNTP_POLL_MAX_S
+                                                              : sntp_poll_s * 2U;
+ }
+
+ static void sntp_lost(uint32_t now)
+ {
+     if (++sntp_losses >= SNTP_MAX_LOSSES) {
+         // The pool may have moved on: look the name up again
+         sntp_losses = 0;
+         memset(sntp_server, 0, 4);
+         sntp_backoff();
+     }
+     sntp_schedule(now);
+ }
+
+ /*============================================================================*/
+ /*                         CLOCK DISCIPLINE                                   */
+ /*============================================================================*/
+
+ static void sntp_filter_clear(void)
+ {
+     memset(sntp_filter, 0, sizeof(sntp_filter));
+ }
+
+ /**
+  * @brief Add a sample to the filter
+  * @return True if its round trip is close enough to the shortest one held
+  */
+ static bool sntp_filter_add(int64_t delay, uint64_t mono)
+ {
+     int64_t best = delay;
+
+     for (uint8_t i = 0; i < W5500_SNTP_FILTER; i++) {
+         if ((sntp_filter[i].mono != 0U) && (sntp_filter[i].delay < best)) {
+             best = sntp_filter[i].delay;
+         }
+     }
+     sntp_filter[sntp_filter_next].delay = delay;
+     sntp_filter[sntp_filter_next].mono  = mono;
+     sntp_filter_next = (uint8_t)((sntp_filter_next + 1U) % W5500_SNTP_FILTER);
+
+     return delay <= best + (best >> 1) + SNTP_DELAY_SLACK_NS;
+ }
+
+ static void sntp_discipline(int64_t offset, int64_t delay, uint64_t mono)
+ {
+     bool step = !wallclock_is_synced() ||
+                 (offset > W5500_SNTP_STEP_NS) || (offset < -W5500_SNTP_STEP_NS);
+
+     if (step) {
+         bool first = !wallclock_is_synced();
+         wallclock_correct(offset, sntp_freq, true);
+         sntp_stats.steps++;
+         sntp_filter_clear();
+         sntp_filter_add(delay, mono);
+         sntp_fll_mono     = mono;
+         sntp_fll_residual = 0;
+         sntp_last_offset  = 0;
+         if (!first) {
+             // Something jumped: relearn quickly
+             BINLOG_WARN("Clock stepped by %d ms", (int32_t)(offset / 1000000));
+             sntp_start_burst(osKernelGetTickCount());
+         }
+     } else {
+         // What the pending slew was about to fix is not a frequency error
+         sntp_fll_residual += offset - wallclock_get_slew_left_ns();
+         int64_t span = (int64_t)(mono - sntp_fll_mono);
+         if (span >= SNTP_FLL_MIN_NS) {
+             // FLL, gain 1/2: halves the frequency error every update
+             int64_t freq = sntp_freq + (sntp_fll_residual * WALLCLOCK_NS_PER_S) / span / 2;
+             if (freq > WALLCLOCK_RATE_MAX_PPB) {
+                 freq = WALLCLOCK_RATE_MAX_PPB;
+             } else if (freq < -WALLCLOCK_RATE_MAX_PPB) {
+                 freq = -WALLCLOCK_RATE_MAX_PPB;
+             }
+             sntp_freq = (int32_t)freq;
+             sntp_fll_mono     = mono;
+             sntp_fll_residual = 0;
+         }
+         wallclock_correct(offset, sntp_freq, false);
+
+         int64_t d = offset - sntp_last_offset;
+         if (d < 0) {
+             d = -d;
+         }
+         if (d > WALLCLOCK_NS_PER_S) {
+             d = WALLCLOCK_NS_PER_S;
+         }
+         uint64_t d2 = (uint64_t)d * (uint64_t)d;
+         sntp_jitter2 = (d2 > sntp_jitter2) ? sntp_jitter2 + (d2 - sntp_jitter2) / 4U
+                                            : sntp_jitter2 - (sntp_jitter2 - d2) / 4U;
+         sntp_last_offset = offset;
+     }
+
+     sntp_applied_tick = osKernelGetTickCount();
+     sntp_stats.applied++;
+     sntp_stats.offset_ns = sntp_sat_i32(offset);
+     sntp_stats.delay_ns  = sntp_sat_u32((uint64_t)delay);
+     sntp_stats.jitter_ns = sntp_isqrt(sntp_jitter2);
+     sntp_stats.freq_ppb  = sntp_freq;
+     sntp_stats.distance_ns = sntp_sat_u32((uint64_t)delay / 2U + sntp_stats.jitter_ns + sntp_root_ns);
+
+     // The record's cycle stamp and the UTC in it map binlog time to UTC
+     int64_t utc = wallclock_now_ns();
+     BINLOG_INFO("UTC %u.%09u: offset %d ns, delay %u ns, freq %d ppb, jitter %u ns",
+                 (uint32_t)(utc / WALLCLOCK_NS_PER_S), (uint32_t)(utc % WALLCLOCK_NS_PER_S),
+                 sntp_stats.offset_ns, sntp_stats.delay_ns, sntp_stats.freq_ppb,
+                 sntp_stats.jitter_ns);
+ }
+
+ /*============================================================================*/
+ /*                         PROTOCOL                                           */
+ /*============================================================================*/
+
+ /**
+  * @brief Look the server up if needed and send a request
+  * @details Called without sntp_mutex: the lookup and sendto() can both
+  *          wait out an ARP resolution. The mutex is taken only around the
+  *          client state.
+  */
+ static void sntp_request(uint32_t now)
+ {
+     static const uint8_t zero_ip[4] = {0, 0, 0, 0};
+     uint8_t msg[SNTP_MSG_LEN];
+     uint8_t server[4];
+     uint8_t sock;
+
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     memcpy(server, sntp_server, 4);
+     osMutexRelease(sntp_mutex);
+
+     if (memcmp(server, zero_ip, 4) == 0) {
+         w5500_dns_status_t status = w5500_dns_resolve(W5500_SNTP_SERVER, server);
+         osMutexAcquire(sntp_mutex, osWaitForever);
+         if (status == W5500_DNS_PENDING) {
+             sntp_deadline = now + sntp_ms_to_ticks(SNTP_RESOLVE_MS);
+         } else if (status != W5500_DNS_OK) {
+             BINLOG_WARN("Server lookup failed (%d)", status);
+             memset(sntp_server, 0, 4);
+             sntp_lost(now);
+         } else {
+             memcpy(sntp_server, server, 4);
+             memcpy(sntp_stats.server, server, 4);
+             BINLOG_INFO("Server %d.%d.%d.%d", server[0], server[1], server[2], server[3]);
+         }
+         osMutexRelease(sntp_mutex);
+         if (status != W5500_DNS_OK) {
+             return;
+         }
+     }
+
+     memset(msg, 0, SNTP_MSG_LEN);
+     msg[0] = (uint8_t)((SNTP_VERSION << 3) | SNTP_MODE_CLIENT);
+
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     sock = sntp_socket;
+     // Stamp as late as possible; the server echoes it as originate time
+     sntp_t1 = wallclock_now_ns();
+     sntp_put_stamp(&msg[40], sntp_t1);
+     memcpy(sntp_origin, &msg[40], 8);
+     sntp_stats.sent++;
+     if (sntp_burst > 0U) {
+         sntp_burst--;
+     }
+     sntp_waiting  = true;
+     sntp_deadline = now + sntp_ms_to_ticks(SNTP_REPLY_MS);
+     osMutexRelease(sntp_mutex);
+
+     if ((sock < W5500_MAX_SOCKET) &&
+         (w5500_socket_sendto(sock, msg, SNTP_MSG_LEN, server, SNTP_SERVER_PORT) < 0)) {
+         BINLOG_WARN("Request send failed");
+     }
+ }
+
+ /**
+  * @brief Check a reply in sntp_buffer and turn it into a sample
+  * @param t4  Reply arrival, from sntp_rx_time()
+  */
+ static void sntp_handle(const uint8_t *src, int64_t t4)
+ {
+     uint8_t li      = (uint8_t)(sntp_buffer[0] >> 6);
+     uint8_t mode    = (uint8_t)(sntp_buffer[0] & 0x07U);
+     uint8_t stratum = sntp_buffer[1];
+     uint32_t now    = osKernelGetTickCount();
+
+     // Only the answer to the request in flight: a late or forged reply
+     // does not echo our transmit stamp
+     if (!sntp_waiting || (memcmp(src, sntp_server, 4) != 0) ||
+         (memcmp(&sntp_buffer[24], sntp_origin, 8) != 0) || (mode != SNTP_MODE_SERVER)) {
+         sntp_stats.rejected++;
+         return;
+     }
+     sntp_waiting = false;
+
+     if (stratum == 0U) {
+         // Kiss-o'-Death: the code is in the reference id
+         BINLOG_WARN("Kiss-o'-Death %c%c%c%c", sntp_buffer[12], sntp_buffer[13],
+                     sntp_buffer[14], sntp_buffer[15]);
+         if (memcmp(&sntp_buffer[12], "RATE", 4) == 0) {
+             sntp_backoff();
+         } else {
+             // DENY, RSTR and the rest: leave this server alone
+             memset(sntp_server, 0, 4);
+             sntp_poll_s = W5500_SNTP_POLL_MAX_S;
+         }
+         sntp_stats.rejected++;
+         sntp_schedule(now);
+         return;
+     }
+     sntp_schedule(now);
+     if ((li == SNTP_LI_ALARM) || (stratum > SNTP_STRATUM_MAX) ||
+         ((sntp_get32(&sntp_buffer[40]) | sntp_get32(&sntp_buffer[44])) == 0U)) {
+         sntp_stats.rejected++;
+         return;
+     }
+
+     int64_t t1 = sntp_t1;
+     int64_t t2 = sntp_get_stamp(&sntp_buffer[32]);
+     int64_t t3 = sntp_get_stamp(&sntp_buffer[40]);
+     int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+     int64_t delay  = (t4 - t1) - (t3 - t2);
+     if (delay < 0) {
+         delay = 0;   // server clock finer than ours
+     }
+
+     sntp_losses = 0;
+     sntp_poll_s = W5500_SNTP_POLL_S;
+     sntp_root_ns = sntp_sat_u32(sntp_short_to_ns(sntp_get32(&sntp_buffer[4])) / 2U +
+                                 sntp_short_to_ns(sntp_get32(&sntp_buffer[8])));
+     sntp_stats.stratum = stratum;
+     sntp_stats.received++;
+
+     uint64_t mono = wallclock_mono_ns();
+     if (!wallclock_is_synced() || sntp_filter_add(delay, mono)) {
+         sntp_discipline(offset, delay, mono);
+     } else {
+         BINLOG_DEBUG("Sample skipped, delay %u ns", sntp_sat_u32((uint64_t)delay));
+         sntp_stats.filtered++;
+     }
+ }
+
+ /**
+  * @brief Reply arrival time: the INT edge that latched RECV, as the ICMP
+  *        responder stamps its turnaround, instead of the task wake-up
+  * @param t_wake  wallclock_now_ns() taken as the task woke up, used when
+  *                polled or when the stamp is not from this request
+  */
+ static int64_t sntp_rx_time(int64_t t_wake)
+ {
+     uint32_t edge = w5500_irq_get_stamp(sntp_socket);
+
+     if (edge == 0U) {
+         return t_wake;
+     }
+     int64_t t4 = wallclock_to_utc_ns(wallclock_stamp_to_mono_ns(edge));
+     return ((t4 < sntp_t1) || (t4 > t_wake)) ? t_wake : t4;
+ }
+
+ // RECV fires once per arrival burst: drain every queued datagram.
+ static void sntp_receive(int64_t t4)
+ {
+     w5500_rx_span_t span;
+     uint8_t head[W5500_UDP_HDR_LEN];
+
+     while ((w5500_socket_peek(sntp_socket, &span) == W5500_SOCK_OK) && (span.len > 0))
+     {
+         while (span.len >= W5500_UDP_HDR_LEN)
+         {
+             if (w5500_socket_peek_read(sntp_socket, &span, 0, head, sizeof(head)) < (int32_t)sizeof(head)) {
+                 return;
+             }
+             uint16_t src_port  = (uint16_t)((head[4] << 8) | head[5]);
+             uint16_t len       = (uint16_t)((head[6] << 8) | head[7]);
+             uint16_t dgram_len = (uint16_t)(W5500_UDP_HDR_LEN + len);
+             // Extension fields and MACs past the 48-byte header are ignored
+             bool valid = (src_port == SNTP_SERVER_PORT) && (len >= SNTP_MSG_LEN) &&
+                          (dgram_len <= span.len) &&
+                          (w5500_socket_peek_read(sntp_socket, &span, W5500_UDP_HDR_LEN,
+                                                  sntp_buffer, SNTP_MSG_LEN) == SNTP_MSG_LEN);
+
+             if (w5500_socket_consume(sntp_socket, &span,
+                                      (dgram_len < span.len) ? dgram_len : span.len) != W5500_SOCK_OK) {
+                 return;
+             }
+             if (valid) {
+                 sntp_handle(head, t4);
+             }
+         }
+         if (span.len > 0) {
+             // Partial header: desynchronised ring, drop it
+             w5500_socket_consume(sntp_socket, &span, span.len);
+         }
+     }
+ }
+
+ /**
+  * @brief Handle replies, timeouts and requests
+  * @param t_wake  wallclock_now_ns() taken as the task woke up
+  * @return uint32_t Ticks to the next request or reply timeout
+  */
+ static uint32_t sntp_run(bool received, int64_t t_wake)
+ {
+     uint32_t wait = osWaitForever;
+     uint32_t now = 0;
+     bool request = false;
+
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     if (sntp_socket < W5500_MAX_SOCKET) {
+         if (received) {
+             sntp_receive(sntp_rx_time(t_wake));
+         }
+         now = osKernelGetTickCount();
+         if (sntp_restart) {
+             sntp_restart = false;
+             memset(sntp_server, 0, 4);
+             sntp_start_burst(now);
+         }
+         if (sntp_due(now, sntp_deadline)) {
+             if (sntp_waiting) {
+                 sntp_waiting = false;
+                 sntp_stats.timeouts++;
+                 sntp_lost(now);
+             } else {
+                 request = true;
+             }
+         }
+         wait = sntp_due(now, sntp_deadline) ? 0U : sntp_deadline - now;
+     }
+     osMutexRelease(sntp_mutex);
+
+     if (request) {
+         sntp_request(now);
+         osMutexAcquire(sntp_mutex, osWaitForever);
+         now  = osKernelGetTickCount();
+         wait = sntp_due(now, sntp_deadline) ? 0U : sntp_deadline - now;
+         osMutexRelease(sntp_mutex);
+     }
+     return wait;
+ }
+
+ static void sntp_netinfo_changed(uint32_t changed, const wiz_NetInfo *net_info, void *ctx)
+ {
+     (void)net_info;
+     (void)ctx;
+
+     // Another network: new path delay, maybe another server
+     if ((changed & (ETH_CONFIG_CHANGED_IP | ETH_CONFIG_CHANGED_GW | ETH_CONFIG_CHANGED_DNS)) != 0U) {
+         sntp_restart = true;
+         if (sntp_socket < W5500_MAX_SOCKET) {
+             w5500_irq_post(sntp_socket, W5500_IRQ_RECV);
+         }
+     }
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ bool w5500_sntp_init(void)
+ {
+     if (sntp_mutex == NULL) {
+         const osMutexAttr_t attr = {
+             .name      = "w5500_sntp",
+             .attr_bits = osMutexRecursive | osMutexPrioInherit,
+             .cb_mem    = &sntp_mutex_cb,
+             .cb_size   = sizeof(sntp_mutex_cb),
+         };
+         sntp_mutex = osMutexNew(&attr);
+         if (sntp_mutex == NULL) {
+             return false;
+         }
+     }
+     if ((sntp_socket >= W5500_MAX_SOCKET) &&
+         (w5500_socket_alloc("sntp", ETH_CONFIG_SNTP_SOCK_MASK, &sntp_socket) != W5500_SOCK_OK)) {
+         BINLOG_ERROR("No free socket for SNTP");
+         sntp_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+     // Any local port: the chip picks one
+     if (w5500_socket_open(sntp_socket, W5500_SOCK_UDP, 0) != W5500_SOCK_OK) {
+         w5500_socket_release(sntp_socket);
+         sntp_socket = W5500_MAX_SOCKET;
+         return false;
+     }
+     if (!sntp_subscribed) {
+         sntp_subscribed = eth_config_subscribe(sntp_netinfo_changed, NULL);
+     }
+
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     memset(sntp_server, 0, 4);
+     sntp_losses = 0;
+     sntp_poll_s = W5500_SNTP_POLL_S;
+     sntp_start_burst(osKernelGetTickCount());
+     osMutexRelease(sntp_mutex);
+
+     BINLOG_INFO("SNTP client on socket %d", sntp_socket);
+     return true;
+ }
+
+ void w5500_sntp_stop(void)
+ {
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     if (sntp_socket < W5500_MAX_SOCKET) {
+         w5500_socket_close(sntp_socket);
+         w5500_socket_release(sntp_socket);
+         sntp_socket = W5500_MAX_SOCKET;
+     }
+     sntp_waiting = false;
+     osMutexRelease(sntp_mutex);
+ }
+
+ void w5500_sntp_get_stats(w5500_sntp_stats_t *stats)
+ {
+     if (stats == NULL) {
+         return;
+     }
+     osMutexAcquire(sntp_mutex, osWaitForever);
+     *stats = sntp_stats;
+     stats->poll_s = sntp_poll_s;
+     if (sntp_stats.applied > 0U) {
+         uint32_t age = osKernelGetTickCount() - sntp_applied_tick;
+         stats->age_ms = (uint32_t)(((uint64_t)age * 1000U) / osKernelGetTickFreq());
+         stats->synced = (stats->age_ms / 1000U) < 4U * sntp_poll_s;
+     }
+     osMutexRelease(sntp_mutex);
+ }
+
+ void w5500_sntp_task(void *argument)
+ {
+     (void)argument;
+
+     for (;;) {
+         if (sntp_socket >= W5500_MAX_SOCKET) {
+             // No socket (pool exhausted or stopped): wait for a re-init
+             osDelay(100);
+             continue;
+         }
+         uint32_t events = w5500_irq_wait(sntp_socket, W5500_IRQ_RECV, sntp_run(false, 0));
+         // Fallback stamp first, before any SPI traffic
+         int64_t t_wake = wallclock_now_ns();
+         sntp_run(events != 0, t_wake);
+     }
+ }
+
+ void w5500_sntp_task100ms(void)
+ {
+     // Read the socket only if the INT dispatcher latched RECV
+     bool received = (sntp_socket < W5500_MAX_SOCKET) &&
+                     (w5500_irq_wait(sntp_socket, W5500_IRQ_RECV, 0) != 0);
+
+     sntp_run(received, wallclock_now_ns());
+ }
@@ -0,0 +1,122 @@
+/**
+ * @file    w5500_sntp.h
+ * @brief   SNTP client (RFC 4330) disciplining the wallclock timestamp service
+ *
+ * @details Requests go to W5500_SNTP_SERVER (a name through w5500_dns, or a
+ *          dotted quad) from a pool UDP socket (ETH_CONFIG_SNTP_SOCK_MASK).
+ *          The transmit time is taken with wallclock_now_ns(), the receive
+ *          time from the INT edge stamp (w5500_irq_get_stamp()), so the
+ *          offset and round-trip delay of each sample are resolved to the
+ *          core cycle and leave out the task's wake-up latency.
+ *
+ *          Start-up sends W5500_SNTP_BURST requests 2 s apart, then one every
+ *          W5500_SNTP_POLL_S. Of the last W5500_SNTP_FILTER samples only one
+ *          with a round trip close to the shortest is used: queueing delay
+ *          makes a path asymmetric and the offset of a slow sample wrong.
+ *          Offsets above W5500_SNTP_STEP_NS step the clock, smaller ones
+ *          are slewed in, and the frequency error is learned from what is
+ *          left between samples (FLL), so the clock holds between polls.
+ *
+ *          Timestamps from boards synced this way can be merged to within
+ *          w5500_sntp_stats_t.distance_ns of each other's UTC. Every
+ *          correction is logged with its UTC second, which ties the binlog
+ *          cycle stamps to UTC as well.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_SNTP_H
+ #define W5500_SNTP_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <string.h>
+#include "stm32g4xx_hal.h" // For HAL (if needed)
+
+#include "w5500_spi.h"
+#include "eth_config.h"
+#include "wallclock.h"
+
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #ifndef W5500_SNTP_SERVER
+ #define W5500_SNTP_SERVER      "pool.ntp.org"
+ #endif
+ #ifndef W5500_SNTP_POLL_S
+ #define W5500_SNTP_POLL_S      64        /**< Seconds between requests once synced */
+ #endif
+ #ifndef W5500_SNTP_POLL_MAX_S
+ #define W5500_SNTP_POLL_MAX_S  1024      /**< Back-off limit on losses and RATE kisses */
+ #endif
+ #ifndef W5500_SNTP_BURST
+ #define W5500_SNTP_BURST       4         /**< Requests 2 s apart at start and after a step */
+ #endif
+ #ifndef W5500_SNTP_FILTER
+ #define W5500_SNTP_FILTER      8         /**< Samples searched for the shortest round trip */
+ #endif
+ #ifndef W5500_SNTP_STEP_NS
+ #define W5500_SNTP_STEP_NS     128000000 /**< Larger offsets are stepped, not slewed */
+ #endif
+
+ /**
+  * @brief Sync quality, for telemetry
+  */
+ typedef struct {
+     bool     synced;          /**< A sample was applied within 4 polls */
+     uint8_t  server[4];       /**< Address in use */
+     uint8_t  stratum;         /**< Server stratum, 0 before the first reply */
+     int32_t  offset_ns;       /**< Last applied offset (saturated) */
+     uint32_t delay_ns;        /**< Its round trip */
+     uint32_t jitter_ns;       /**< RMS of the change between applied offsets */
+     int32_t  freq_ppb;        /**< Learned frequency correction */
+     uint32_t distance_ns;     /**< Error bound vs UTC: delay/2 + jitter + server root distance */
+     uint32_t age_ms;          /**< Since the last applied sample */
+     uint32_t poll_s;          /**< Current request interval */
+     uint32_t sent;            /**< Requests sent */
+     uint32_t received;        /**< Valid replies */
+     uint32_t applied;         /**< Replies used to steer the clock */
+     uint32_t filtered;        /**< Replies passed over for a shorter round trip */
+     uint32_t rejected;        /**< Bogus, unsynchronised or late replies */
+     uint32_t timeouts;        /**< Requests without a reply */
+     uint32_t steps;           /**< Clock steps */
+ } w5500_sntp_stats_t;
+
+ /**
+  * @brief Take a socket from the pool and start with a request burst
+  * @note  Names need w5500_dns_init(); wallclock_init() must have run.
+  * @return bool True on success
+  */
+ bool w5500_sntp_init(void);
+
+ /**
+  * @brief Close the socket. The clock keeps running on the learned rate.
+  */
+ void w5500_sntp_stop(void);
+
+ /**
+  * @brief Copy the sync statistics
+  */
+ void w5500_sntp_get_stats(w5500_sntp_stats_t *stats);
+
+ /**
+  * @brief SNTP thread body: blocks on RECV with the next request or reply
+  *        timeout as timeout. Do not mix with w5500_sntp_task100ms().
+  */
+ void w5500_sntp_task(void *argument);
+
+ /**
+  * @brief Polled alternative to w5500_sntp_task()
+  * @note  Reply timestamps then carry up to 100 ms of extra delay, which the
+  *        round-trip filter mostly rejects: prefer the task.
+  */
+ void w5500_sntp_task100ms(void);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_SNTP_H */
@@ -0,0 +1,160 @@
+/**
+ * @file    w5500_webfs.c
+ * @brief   Read-only, flash-resident web asset filesystem
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #include "w5500_webfs.h"
+ #include <string.h>
+
+ /*============================================================================*/
+ /*                         HELPERS                                            */
+ /*============================================================================*/
+
+ // Bounded appender for the response header: no printf on this path
+ typedef struct {
+     char*    buf;
+     uint16_t size;
+     uint16_t len;
+     bool     overflow;
+ } webfs_out_t;
+
+ static void webfs_put(webfs_out_t* out, const char* s, size_t n)
+ {
+     if (out->overflow || ((size_t)out->len + n > out->size)) {
+         out->overflow = true;
+         return;
+     }
+     memcpy(&out->buf[out->len], s, n);
+     out->len = (uint16_t)(out->len + n);
+ }
+
+ static void webfs_puts(webfs_out_t* out, const char* s)
+ {
+     webfs_put(out, s, strlen(s));
+ }
+
+ static void webfs_put_u32(webfs_out_t* out, uint32_t v)
+ {
+     char digits[10];
+     uint8_t n = 0;
+
+     do {
+         digits[sizeof(digits) - 1U - n] = (char)('0' + (v % 10U));
+         v /= 10U;
+         n++;
+     } while (v != 0U);
+     webfs_put(out, &digits[sizeof(digits) - n], n);
+ }
+
+ // strcmp order between a terminated index path and an unterminated key
+ static int webfs_compare(const char* path, const char* key, uint16_t len)
+ {
+     for (uint16_t i = 0; i < len; i++) {
+         uint8_t a = (uint8_t)path[i];
+         uint8_t b = (uint8_t)key[i];
+         if (a != b) {
+             return (a < b) ? -1 : 1;   // also covers path ending first ('\0')
+         }
+     }
+     return (path[len] == '\0') ? 0 : 1;
+ }
+
+ /*============================================================================*/
+ /*                         PUBLIC API                                         */
+ /*============================================================================*/
+
+ const w5500_webfs_file_t* w5500_webfs_find(const char* path, uint16_t len)
+ {
+     uint16_t lo = 0;
+     uint16_t hi = w5500_webfs_file_count;
+
+     if (path == NULL) {
+         return NULL;
+     }
+     while (lo < hi) {
+         uint16_t mid = (uint16_t)(lo + ((hi - lo) / 2U));
+         int cmp = webfs_compare(w5500_webfs_files[mid].path, path, len);
+
+         if (cmp == 0) {
+             return &w5500_webfs_files[mid];
+         }
+         if (cmp < 0) {
+             lo = (uint16_t)(mid + 1U);
+         } else {
+             hi = mid;
+         }
+     }
+     return NULL;
+ }
+
+ bool w5500_webfs_etag_match(const w5500_webfs_file_t* file, const char* value, uint16_t len)
+ {
+     size_t tag_len;
+     uint16_t i = 0;
+
+     if ((file == NULL) || (value == NULL)) {
+         return false;
+     }
+     tag_len = strlen(file->etag);
+
+     // #( [ "W/" ] quoted-string ), or "*"
+     while (i < len) {
+         while ((i < len) && ((value[i] == ' ') || (value[i] == '\t') || (value[i] == ','))) {
+             i++;
+         }
+         if (i >= len) {
+             break;
+         }
+         if (value[i] == '*') {
+             return true;
+         }
+         if (((uint16_t)(len - i) >= 2U) && (value[i] == 'W') && (value[i + 1U] == '/')) {
+             i = (uint16_t)(i + 2U);
+         }
+         uint16_t start = i;
+         if ((i < len) && (value[i] == '"')) {
+             i++;
+             while ((i < len) && (value[i] != '"')) {
+                 i++;
+             }
+             i++;    // closing quote (or one past the end if it is missing)
+         }
+         if ((i <= len) && ((size_t)(i - start) == tag_len) && (memcmp(&value[start], file->etag, tag_len) == 0)) {
+             return true;
+         }
+         while ((i < len) && (value[i] != ',')) {
+             i++;    // malformed entry: skip to the next one
+         }
+     }
+     return false;
+ }
+
+ int32_t w5500_webfs_header(const w5500_webfs_file_t* file, bool not_modified, char* buf, uint16_t size)
+ {
+     webfs_out_t out = { .buf = buf, .size = size };
+
+     if ((file == NULL) || (buf == NULL)) {
+         return -1;
+     }
+     if (not_modified) {
+         webfs_puts(&out, "HTTP/1.1 304 Not Modified\r\n");
+     } else {
+         webfs_puts(&out, "HTTP/1.1 200 OK\r\nContent-Type: ");
+         webfs_puts(&out, file->type);
+         webfs_puts(&out, "\r\nContent-Length: ");
+         webfs_put_u32(&out, file->len);
+         webfs_puts(&out, "\r\n");
+         if ((file->flags & W5500_WEBFS_GZIP) != 0U) {
+             webfs_puts(&out, "Content-Encoding: gzip\r\n");
+         }
+     }
+     // Revalidate every time: a 304 costs one short header
+     webfs_puts(&out, "ETag: ");
+     webfs_puts(&out, file->etag);
+     webfs_puts(&out, "\r\nCache-Control: no-cache\r\n");
+     webfs_puts(&out, "\r\n");
+
+     return out.overflow ? -1 : (int32_t)out.len;
+ }
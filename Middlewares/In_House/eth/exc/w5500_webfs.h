@@ -0,0 +1,83 @@
+/**
+ * @file    w5500_webfs.h
+ * @brief   Read-only, flash-resident web asset filesystem
+ *
+ * @details The assets in exc/web are packed at build time by
+ *          tools/w5500_webfs_pack.py into w5500_webfs_data.c: bodies
+ *          gzip-compressed and deduplicated, one index sorted by path, a
+ *          strong ETag per body. Nothing is decompressed or copied on the
+ *          board: a response is a short header followed by the flash bytes
+ *          as they are, with Content-Encoding: gzip. A request carrying the
+ *          current ETag in If-None-Match gets 304 Not Modified and no body.
+ *
+ *          Gzip bodies are sent whatever the request's Accept-Encoding:
+ *          every browser accepts them, and there is no plain copy to fall
+ *          back to. The response does not vary with that header, so no
+ *          Vary is sent.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+ #ifndef W5500_WEBFS_H
+ #define W5500_WEBFS_H
+
+#include <stdint.h> // For uint8_t
+#include <stdbool.h>
+#include <stddef.h>
+
+ #ifdef __cplusplus
+ extern "C" {
+ #endif
+
+ #define W5500_WEBFS_GZIP        0x01U   /**< Body is a gzip member */
+ #define W5500_WEBFS_HEAD_MAX    256U    /**< Largest response header */
+
+ /**
+  * @brief One path of the image (w5500_webfs_data.c)
+  */
+ typedef struct {
+     const char*    path;       /**< "/index.html", "/"; index sorted by strcmp */
+     const char*    type;       /**< Content-Type */
+     const char*    etag;       /**< Strong ETag, quoted */
+     const uint8_t* data;       /**< Body as sent (shared by identical files) */
+     uint32_t       len;        /**< Bytes of data */
+     uint32_t       raw_len;    /**< Uncompressed size */
+     uint8_t        flags;      /**< W5500_WEBFS_GZIP */
+ } w5500_webfs_file_t;
+
+ /* Generated by tools/w5500_webfs_pack.py */
+ extern const w5500_webfs_file_t w5500_webfs_files[];
+ extern const uint16_t w5500_webfs_file_count;
+
+ /**
+  * @brief Look a path up in the index (binary search)
+  * @param path  Request path, query already stripped; need not be terminated
+  * @param len   Length of path
+  * @return File, or NULL if there is none
+  */
+ const w5500_webfs_file_t* w5500_webfs_find(const char* path, uint16_t len);
+
+ /**
+  * @brief Check an If-None-Match header value against the file's ETag
+  * @details Handles "*", lists and W/ prefixes (the weak comparison
+  *          RFC 9110 asks for here).
+  * @param value  Header value, need not be terminated
+  * @param len    Length of value
+  * @return bool  True if the client's copy is current (answer 304)
+  */
+ bool w5500_webfs_etag_match(const w5500_webfs_file_t* file, const char* value, uint16_t len);
+
+ /**
+  * @brief Format the response header
+  * @param not_modified  304 with the validators only, instead of 200
+  * @param buf           Output, W5500_WEBFS_HEAD_MAX is always enough
+  * @return int32_t      Header length, -1 if buf is too small
+  */
+ int32_t w5500_webfs_header(const w5500_webfs_file_t* file, bool not_modified, char* buf, uint16_t size);
+
+ #ifdef __cplusplus
+ }
+ #endif
+
+ #endif /* W5500_WEBFS_H */
@@ -0,0 +1,99 @@
+/**
+ * @file    w5500_webfs_data.c
+ * @brief   Web assets for w5500_webfs (generated, do not edit)
+ *
+ * @details Generated by tools/w5500_webfs_pack.py from Middlewares/In_House/eth/exc/web.
+ *          5 paths, 4 stored bodies, 1141 bytes of flash data.
+ */
+
+ #include "w5500_webfs.h"
+
+ static const uint8_t webfs_blob[1141] = {
+     /* /, /index.html: 304 bytes gzip */
+     0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x85, 0x51, 0xC1, 0x4E, 0xC3, 0x30,
+     0x0C, 0xBD, 0xF3, 0x15, 0x26, 0x97, 0x5E, 0xC8, 0xB2, 0x01, 0x43, 0x88, 0xA5, 0x95, 0xD0, 0xD8,
+     0x6E, 0x30, 0xA4, 0x55, 0x9A, 0x38, 0xA6, 0xAD, 0xBB, 0x44, 0x64, 0x6D, 0x49, 0xBC, 0x69, 0xFB,
+     0x7B, 0xD2, 0xA5, 0x93, 0x40, 0x1C, 0x38, 0xD9, 0x8E, 0xDF, 0x7B, 0xF6, 0x73, 0xE4, 0xF5, 0xCB,
+     0x6A, 0x9E, 0x7F, 0xBC, 0x2F, 0x40, 0xD3, 0xCE, 0x66, 0x57, 0x32, 0x06, 0x00, 0xA9, 0x51, 0x55,
+     0x7D, 0x12, 0x52, 0x32, 0x64, 0x31, 0xDB, 0x4C, 0xA7, 0xE3, 0x31, 0x5F, 0xE7, 0xAF, 0x77, 0xB7,
+     0xB0, 0xC1, 0x02, 0xD6, 0xE8, 0x0E, 0xE8, 0xA4, 0x88, 0xDD, 0x88, 0xDC, 0x21, 0xA9, 0xA0, 0x44,
+     0x1D, 0xC7, 0xAF, 0xBD, 0x39, 0xA4, 0xC9, 0xBC, 0x6D, 0x08, 0x1B, 0xE2, 0xF9, 0xA9, 0xC3, 0x04,
+     0xCA, 0x58, 0xA5, 0x09, 0xE1, 0x91, 0x44, 0x3F, 0x6A, 0x06, 0xA5, 0x56, 0xCE, 0x23, 0xA5, 0x7B,
+     0xAA, 0xF9, 0x63, 0x32, 0xE8, 0x58, 0xD3, 0x7C, 0x82, 0x76, 0x58, 0xA7, 0xAC, 0x52, 0xA4, 0x9E,
+     0xCC, 0x4E, 0x6D, 0x51, 0x1C, 0xB9, 0x09, 0x0A, 0xB3, 0x42, 0x79, 0x7C, 0xB8, 0xBF, 0x79, 0x66,
+     0xE0, 0xD0, 0xA6, 0xAC, 0x7F, 0x63, 0x40, 0x61, 0x40, 0xC8, 0x7F, 0xE0, 0xD8, 0x5F, 0x2D, 0xE1,
+     0xE9, 0x64, 0x71, 0x54, 0x7A, 0x3F, 0x70, 0xCF, 0xB5, 0xD7, 0x88, 0x74, 0x46, 0x4B, 0x71, 0x71,
+     0x2D, 0x8B, 0xB6, 0x3A, 0x0D, 0x02, 0x7A, 0x92, 0x45, 0xD7, 0x1C, 0xCE, 0x37, 0x08, 0xA8, 0xC9,
+     0xD0, 0xEA, 0xB2, 0xDE, 0xA0, 0x6B, 0x2D, 0x90, 0x46, 0xB0, 0x66, 0xAB, 0x09, 0x0E, 0x46, 0xC1,
+     0x22, 0x94, 0xAE, 0x41, 0x92, 0xA2, 0x1B, 0x90, 0x0A, 0x4A, 0xAB, 0xBC, 0x4F, 0x59, 0xB1, 0x27,
+     0x6A, 0x1B, 0x88, 0x81, 0xF7, 0xAB, 0x0F, 0xBB, 0x59, 0xAC, 0xDA, 0x66, 0xD4, 0x1F, 0x85, 0x65,
+     0xAB, 0x37, 0x29, 0xD4, 0x3F, 0xCC, 0xBA, 0xFE, 0x45, 0xAD, 0xEB, 0x0B, 0x77, 0xB9, 0x1C, 0xC8,
+     0x52, 0x44, 0x17, 0x52, 0xC4, 0x5F, 0xFD, 0x06, 0xFF, 0x38, 0x84, 0xCF, 0xED, 0x01, 0x00, 0x00,
+     /* /ledoff.html: 287 bytes gzip */
+     0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x65, 0x51, 0xC1, 0x4E, 0xC3, 0x30,
+     0x0C, 0xBD, 0xF3, 0x15, 0x26, 0x97, 0x5E, 0xC8, 0xB2, 0x01, 0x43, 0x88, 0xA5, 0x95, 0xD0, 0xE0,
+     0x06, 0x0C, 0x69, 0x95, 0x26, 0x8E, 0x69, 0xEB, 0x2E, 0x11, 0x59, 0x5B, 0x12, 0x77, 0x5A, 0xFF,
+     0x9E, 0x74, 0xE9, 0x24, 0x24, 0x4E, 0x7E, 0xB6, 0x5F, 0x9E, 0x9F, 0x1D, 0x79, 0xFD, 0xB2, 0x59,
+     0xE7, 0x5F, 0x9F, 0xAF, 0xA0, 0xE9, 0x60, 0xB3, 0x2B, 0x19, 0x03, 0x80, 0xD4, 0xA8, 0xAA, 0x11,
+     0x04, 0x48, 0x86, 0x2C, 0x66, 0xBB, 0xE5, 0x72, 0x3E, 0xE7, 0xDB, 0xFC, 0xFD, 0xEE, 0x16, 0x76,
+     0x58, 0xC0, 0x16, 0xDD, 0x11, 0x9D, 0x14, 0xB1, 0x1B, 0x99, 0x07, 0x24, 0x15, 0x94, 0xA8, 0xE3,
+     0xF8, 0xD3, 0x9B, 0x63, 0x9A, 0xAC, 0xDB, 0x86, 0xB0, 0x21, 0x9E, 0x0F, 0x1D, 0x26, 0x50, 0xC6,
+     0x2C, 0x4D, 0x08, 0x4F, 0x24, 0xC6, 0x51, 0x2B, 0x28, 0xB5, 0x72, 0x1E, 0x29, 0xED, 0xA9, 0xE6,
+     0x8F, 0xC9, 0xA4, 0x63, 0x4D, 0xF3, 0x0D, 0xDA, 0x61, 0x9D, 0xB2, 0x4A, 0x91, 0x7A, 0x32, 0x07,
+     0xB5, 0x47, 0x71, 0xE2, 0x26, 0x28, 0xAC, 0x0A, 0xE5, 0xF1, 0xE1, 0xFE, 0xE6, 0x99, 0x81, 0x43,
+     0x9B, 0xB2, 0xB1, 0xC6, 0x80, 0xC2, 0x80, 0x80, 0xFF, 0xF0, 0xD8, 0x7F, 0x2D, 0xE1, 0x69, 0xB0,
+     0x38, 0x2B, 0xBD, 0x9F, 0xDE, 0x9E, 0x73, 0xAF, 0x11, 0xE9, 0xCC, 0x96, 0xE2, 0xB2, 0xB5, 0x2C,
+     0xDA, 0x6A, 0x98, 0x04, 0xF4, 0x22, 0x8B, 0x5B, 0x73, 0x38, 0xDF, 0x20, 0xB0, 0x16, 0x53, 0xAB,
+     0xCB, 0xDE, 0xCC, 0x5E, 0x13, 0x18, 0x0F, 0x65, 0xEF, 0x5C, 0xD8, 0xCD, 0x0E, 0xD0, 0xD6, 0xB5,
+     0x14, 0xDD, 0xC4, 0x50, 0x50, 0x5A, 0xE5, 0x7D, 0xCA, 0x8A, 0x9E, 0xA8, 0x6D, 0x20, 0x06, 0x3E,
+     0x5A, 0x9E, 0x3C, 0x59, 0xAC, 0xDA, 0x66, 0x36, 0x1E, 0x83, 0x65, 0x9B, 0x0F, 0x29, 0x54, 0x74,
+     0x12, 0x0D, 0x48, 0x11, 0x3F, 0xE4, 0x17, 0x45, 0xC6, 0x57, 0x99, 0xA8, 0x01, 0x00, 0x00,
+     /* /ledon.html: 289 bytes gzip */
+     0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x65, 0x51, 0xCB, 0x4E, 0xC3, 0x30,
+     0x10, 0xBC, 0xF3, 0x15, 0x8B, 0x2F, 0xB9, 0xE0, 0xBA, 0x05, 0x8A, 0x10, 0x75, 0x22, 0xA1, 0x42,
+     0x4F, 0xA0, 0x22, 0xB5, 0x52, 0xC5, 0xD1, 0x49, 0x36, 0xB5, 0x85, 0x9B, 0x04, 0x7B, 0x53, 0x35,
+     0x7F, 0x8F, 0x53, 0xA7, 0x12, 0x52, 0x4F, 0xFB, 0x1A, 0xCF, 0xCE, 0xAC, 0xE5, 0xED, 0xDB, 0x7A,
+     0xB9, 0xFD, 0xFE, 0x7A, 0x07, 0x4D, 0x07, 0x9B, 0xDD, 0xC8, 0x18, 0x00, 0xA4, 0x46, 0x55, 0x0E,
+     0x49, 0x48, 0xC9, 0x90, 0xC5, 0x6C, 0x37, 0x9F, 0x4F, 0xA7, 0x7C, 0xB3, 0xFD, 0x7C, 0xB8, 0x87,
+     0x1D, 0xE6, 0xB0, 0x41, 0x77, 0x44, 0x27, 0x45, 0x9C, 0x46, 0xE4, 0x01, 0x49, 0x05, 0x26, 0x6A,
+     0x39, 0xFE, 0x76, 0xE6, 0x98, 0x26, 0xCB, 0xA6, 0x26, 0xAC, 0x89, 0x6F, 0xFB, 0x16, 0x13, 0x28,
+     0x62, 0x95, 0x26, 0x84, 0x27, 0x12, 0xC3, 0xAA, 0x05, 0x14, 0x5A, 0x39, 0x8F, 0x94, 0x76, 0x54,
+     0xF1, 0xE7, 0x64, 0xE4, 0xB1, 0xA6, 0xFE, 0x01, 0xED, 0xB0, 0x4A, 0x59, 0xA9, 0x48, 0xBD, 0x98,
+     0x83, 0xDA, 0xA3, 0x38, 0x71, 0x13, 0x18, 0x16, 0xB9, 0xF2, 0xF8, 0xF4, 0x78, 0xF7, 0xCA, 0xC0,
+     0xA1, 0x4D, 0xD9, 0xD0, 0x63, 0x40, 0x61, 0x41, 0xC8, 0xFF, 0xE1, 0xD8, 0x35, 0x97, 0xF0, 0xD4,
+     0x5B, 0x9C, 0x14, 0xDE, 0x8F, 0x6F, 0xCF, 0xB5, 0xD7, 0x88, 0x74, 0x46, 0x4B, 0x71, 0x71, 0x2D,
+     0xF3, 0xA6, 0xEC, 0x47, 0x02, 0x3D, 0xCB, 0xA2, 0x6B, 0x0E, 0xE7, 0x1B, 0x04, 0xD4, 0x6C, 0x1C,
+     0xB5, 0xD9, 0x87, 0xD9, 0x6B, 0x02, 0xE3, 0xA1, 0xE8, 0x9C, 0x0B, 0xDE, 0x6C, 0x0F, 0x4D, 0x2D,
+     0x45, 0x3B, 0x02, 0x14, 0x14, 0x56, 0x79, 0x9F, 0xB2, 0xBC, 0x23, 0x6A, 0x6A, 0x88, 0x81, 0x37,
+     0x55, 0xC5, 0x2E, 0x9A, 0x2C, 0x96, 0xA1, 0x9C, 0x0C, 0xD7, 0x60, 0xD9, 0x7A, 0xB5, 0x92, 0x42,
+     0x45, 0x2D, 0x51, 0x82, 0x14, 0xF1, 0x4B, 0xFE, 0x00, 0x93, 0x5A, 0x50, 0x98, 0xAA, 0x01, 0x00,
+     0x00,
+     /* /style.css: 261 bytes gzip */
+     0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8D, 0x90, 0xDD, 0x4E, 0xC3, 0x30,
+     0x0C, 0x85, 0xEF, 0xFB, 0x14, 0x96, 0xB8, 0x0E, 0x0A, 0x63, 0x83, 0x2A, 0x7D, 0x9A, 0x34, 0x49,
+     0x5B, 0x6B, 0x69, 0x5C, 0xA5, 0xEE, 0x7E, 0xA8, 0xF6, 0xEE, 0x4B, 0x7F, 0x04, 0x65, 0x02, 0x84,
+     0x72, 0x65, 0xFB, 0xF3, 0xC9, 0x39, 0x6E, 0xB8, 0xF5, 0x30, 0x5A, 0xEC, 0x3B, 0xAF, 0xAF, 0x0A,
+     0x30, 0x78, 0x0C, 0x4E, 0x94, 0x9E, 0xCC, 0xB1, 0x80, 0x56, 0xC7, 0x1A, 0x83, 0x02, 0xD9, 0x5D,
+     0x40, 0x0F, 0x4C, 0x05, 0xB0, 0xBB, 0xB0, 0xD0, 0x1E, 0xEB, 0xD4, 0x35, 0x2E, 0xB0, 0x8B, 0xC5,
+     0x2D, 0x2B, 0xC9, 0x5E, 0x61, 0x5C, 0x60, 0xC1, 0xD4, 0x29, 0x38, 0xA4, 0x8D, 0x34, 0x78, 0x2E,
+     0x07, 0x66, 0x0A, 0x1B, 0xFD, 0x45, 0x38, 0x03, 0x38, 0xA3, 0xE5, 0x46, 0xC1, 0xFB, 0x04, 0xA6,
+     0xB2, 0xD4, 0xE6, 0x58, 0x47, 0x1A, 0x82, 0x15, 0x86, 0x3C, 0x45, 0x05, 0x4F, 0x52, 0xE6, 0x52,
+     0xCA, 0x79, 0x48, 0xD1, 0xBA, 0xD4, 0x0A, 0x14, 0xDC, 0x54, 0xAF, 0xC4, 0xB9, 0x41, 0x9E, 0xEB,
+     0x4E, 0x5B, 0x8B, 0xA1, 0x56, 0xF0, 0xB2, 0x4F, 0x46, 0x77, 0xF9, 0x22, 0x39, 0x5B, 0xB5, 0xCE,
+     0x50, 0xD4, 0x8C, 0x14, 0xBE, 0xD6, 0x2B, 0x0A, 0x2C, 0x7A, 0xFC, 0x70, 0x0A, 0x76, 0xFB, 0x85,
+     0x7D, 0x0C, 0x0A, 0xAF, 0x6F, 0xAB, 0xAF, 0xF9, 0x6B, 0x11, 0xB5, 0xC5, 0xA1, 0x4F, 0xB9, 0xB6,
+     0xB1, 0xC4, 0x94, 0xEC, 0x77, 0xE3, 0x5B, 0x4E, 0x69, 0xC3, 0x78, 0x72, 0xFF, 0xC4, 0xAB, 0xEA,
+     0x47, 0x30, 0x97, 0xD3, 0xFB, 0x0E, 0xFE, 0x25, 0xFC, 0xC9, 0x77, 0x30, 0x6E, 0x33, 0x4F, 0x27,
+     0x87, 0x07, 0x68, 0xBD, 0x80, 0x28, 0x29, 0x29, 0xB7, 0x2B, 0x74, 0xCB, 0xEE, 0xB3, 0x30, 0x68,
+     0x06, 0x1E, 0x02, 0x00, 0x00,
+ };
+
+ const w5500_webfs_file_t w5500_webfs_files[] = {
+     { "/", "text/html; charset=utf-8", "\"eb96dea36f205425\"", &webfs_blob[0], 304U, 493U, W5500_WEBFS_GZIP },
+     { "/index.html", "text/html; charset=utf-8", "\"eb96dea36f205425\"", &webfs_blob[0], 304U, 493U, W5500_WEBFS_GZIP },
+     { "/ledoff.html", "text/html; charset=utf-8", "\"1800ee3982de9806\"", &webfs_blob[304], 287U, 424U, W5500_WEBFS_GZIP },
+     { "/ledon.html", "text/html; charset=utf-8", "\"c65581d708e04fd0\"", &webfs_blob[591], 289U, 426U, W5500_WEBFS_GZIP },
+     { "/style.css", "text/css", "\"dee4d1e2466f1550\"", &webfs_blob[880], 261U, 542U, W5500_WEBFS_GZIP },
+ };
+
+ const uint16_t w5500_webfs_file_count = 5U;
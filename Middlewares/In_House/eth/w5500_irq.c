@@ -0,0 +1,245 @@
+/**
+ * @file    w5500_irq.c
+ * @brief   Interrupt-driven W5500 socket event dispatch (INT pin, PA8)
+ *
+ * @details The EXTI callback only notifies the dispatcher task; all SPI work
+ *          happens in task context under the w5500_spi lock. INT is level
+ *          low while anything unmasked is pending but EXTI is edge-triggered,
+ *          so after a service pass the dispatcher re-checks the pin and
+ *          services again (every W5500_IRQ_RECHECK_MS) until it is released.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#include "w5500_irq.h"
+#include "w5500_socket.h"
+
+#include "FreeRTOS.h"
+#include "event_groups.h"
+
+#define BINLOG_MODULE        "w5500_irq"
+#define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+#include "binlog.h"
+
+/*============================================================================*/
+/*                         PRIVATE DEFINES                                    */
+/*============================================================================*/
+
+/* Thread flag set by the EXTI callback */
+#define W5500_IRQ_FLAG_INT      0x00000001U
+
+/* Re-service period while INT stays asserted after a pass */
+#define W5500_IRQ_RECHECK_MS    1U
+
+#define W5500_IRQ_NVIC_PRIO     5U
+
+/*============================================================================*/
+/*                         PRIVATE VARIABLES                                  */
+/*============================================================================*/
+
+static osThreadId_t volatile w5500_irq_task_handle = NULL;
+static osEventFlagsId_t w5500_irq_events[W5500_MAX_SOCKET];
+static StaticEventGroup_t w5500_irq_events_cb[W5500_MAX_SOCKET];
+
+/* Sn_IMR shadow: W5500_IRQ_SN_EVENTS plus what w5500_irq_unmask() added */
+static uint8_t w5500_irq_imr[W5500_MAX_SOCKET];
+
+/* SPI_BUS_CYCLES() at the last INT edge, and at the edge behind the events
+ * last latched for each socket */
+static volatile uint32_t w5500_irq_edge;
+static uint32_t w5500_irq_stamp[W5500_MAX_SOCKET];
+
+/* Bit n: something was latched for socket n (w5500_irq_wait_any) */
+static osEventFlagsId_t w5500_irq_any;
+static StaticEventGroup_t w5500_irq_any_cb;
+
+/* Dispatcher task, above the application tasks so events are delivered
+ * before their owners run again */
+static StaticTask_t w5500_irq_task_cb;
+static uint32_t w5500_irq_task_stack[192];
+static const osThreadAttr_t w5500_irq_task_attributes = {
+    .name       = "w5500_irq",
+    .cb_mem     = &w5500_irq_task_cb,
+    .cb_size    = sizeof(w5500_irq_task_cb),
+    .stack_mem  = w5500_irq_task_stack,
+    .stack_size = sizeof(w5500_irq_task_stack),
+    .priority   = (osPriority_t) osPriorityAboveNormal,
+};
+
+/*============================================================================*/
+/*                         PRIVATE FUNCTIONS                                  */
+/*============================================================================*/
+
+/**
+ * @brief Read SIR, then read, clear and dispatch Sn_IR of each flagged socket
+ */
+static void w5500_irq_service(void)
+{
+    uint32_t edge = w5500_irq_edge;
+    uint8_t sir = getSIR();
+
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++) {
+        if ((sir & (1U << sn)) == 0U) {
+            continue;
+        }
+        uint8_t ir = getSn_IR(sn) & w5500_irq_imr[sn];
+        if (ir != 0U) {
+            setSn_IR(sn, ir);
+            if (ir & (W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT)) {
+                /* Completes the SEND and issues the next one before the
+                 * waiters run */
+                w5500_socket_on_send_event(sn, ir);
+            }
+            w5500_irq_stamp[sn] = edge;
+            osEventFlagsSet(w5500_irq_events[sn], ir);
+            osEventFlagsSet(w5500_irq_any, 1UL << sn);
+            BINLOG_DEBUG("socket %d events 0x%02x", sn, ir);
+        }
+    }
+}
+
+static bool w5500_irq_pin_asserted(void)
+{
+    return HAL_GPIO_ReadPin(W5500_INT_GPIO_Port, W5500_INT_Pin) == GPIO_PIN_RESET;
+}
+
+static void w5500_irq_task(void *argument)
+{
+    uint32_t timeout = osWaitForever;
+    (void)argument;
+
+    for (;;) {
+        osThreadFlagsWait(W5500_IRQ_FLAG_INT, osFlagsWaitAny, timeout);
+        w5500_irq_service();
+        timeout = w5500_irq_pin_asserted() ? W5500_IRQ_RECHECK_MS : osWaitForever;
+    }
+}
+
+/*============================================================================*/
+/*                         PUBLIC API IMPLEMENTATION                          */
+/*============================================================================*/
+
+void w5500_irq_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    if (w5500_irq_task_handle != NULL) {
+        return;
+    }
+
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++) {
+        const osEventFlagsAttr_t attr = {
+            .name    = "w5500_sock",
+            .cb_mem  = &w5500_irq_events_cb[sn],
+            .cb_size = sizeof(w5500_irq_events_cb[sn]),
+        };
+        w5500_irq_events[sn] = osEventFlagsNew(&attr);
+
+        setSn_IR(sn, 0xFF);
+        w5500_irq_imr[sn] = W5500_IRQ_SN_EVENTS;
+        setSn_IMR(sn, w5500_irq_imr[sn]);
+    }
+    setSIMR(0xFF);
+
+    const osEventFlagsAttr_t any_attr = {
+        .name    = "w5500_any",
+        .cb_mem  = &w5500_irq_any_cb,
+        .cb_size = sizeof(w5500_irq_any_cb),
+    };
+    w5500_irq_any = osEventFlagsNew(&any_attr);
+
+    w5500_irq_task_handle = osThreadNew(w5500_irq_task, NULL, &w5500_irq_task_attributes);
+
+    /* INT is open-drain active low */
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    gpio.Pin  = W5500_INT_Pin;
+    gpio.Mode = GPIO_MODE_IT_FALLING;
+    gpio.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(W5500_INT_GPIO_Port, &gpio);
+
+    HAL_NVIC_SetPriority(EXTI9_5_IRQn, W5500_IRQ_NVIC_PRIO, 0);
+    HAL_NVIC_EnableIRQ(EXTI9_5_IRQn);
+
+    /* Anything already pending will not produce an edge */
+    if (w5500_irq_pin_asserted()) {
+        osThreadFlagsSet(w5500_irq_task_handle, W5500_IRQ_FLAG_INT);
+    }
+    BINLOG_INFO("INT dispatch enabled, Sn_IMR 0x%02x", W5500_IRQ_SN_EVENTS);
+}
+
+uint32_t w5500_irq_wait(uint8_t sock_num, uint32_t events, uint32_t timeout)
+{
+    uint32_t flags;
+
+    if ((sock_num >= W5500_MAX_SOCKET) || (w5500_irq_events[sock_num] == NULL)) {
+        return 0;
+    }
+    flags = osEventFlagsWait(w5500_irq_events[sock_num], events, osFlagsWaitAny, timeout);
+    return ((flags & osFlagsError) != 0U) ? 0U : (flags & events);
+}
+
+void w5500_irq_post(uint8_t sock_num, uint32_t events)
+{
+    if ((sock_num < W5500_MAX_SOCKET) && (w5500_irq_events[sock_num] != NULL)) {
+        osEventFlagsSet(w5500_irq_events[sock_num], events);
+        osEventFlagsSet(w5500_irq_any, 1UL << sock_num);
+    }
+}
+
+bool w5500_irq_unmask(uint8_t sock_num, uint8_t events)
+{
+    if ((sock_num >= W5500_MAX_SOCKET) || (w5500_irq_task_handle == NULL)) {
+        return false;
+    }
+    w5500_spi_lock();
+    w5500_irq_imr[sock_num] |= events;
+    setSn_IMR(sock_num, w5500_irq_imr[sock_num]);
+    w5500_spi_unlock();
+    return true;
+}
+
+void w5500_irq_mask(uint8_t sock_num, uint8_t events)
+{
+    if ((sock_num >= W5500_MAX_SOCKET) || (w5500_irq_task_handle == NULL)) {
+        return;
+    }
+    events &= (uint8_t)~W5500_IRQ_SN_EVENTS;
+    w5500_spi_lock();
+    w5500_irq_imr[sock_num] &= (uint8_t)~events;
+    setSn_IMR(sock_num, w5500_irq_imr[sock_num]);
+    w5500_spi_unlock();
+    osEventFlagsClear(w5500_irq_events[sock_num], events);
+}
+
+uint32_t w5500_irq_wait_any(uint8_t sock_mask, uint32_t timeout)
+{
+    uint32_t flags;
+
+    if (w5500_irq_any == NULL) {
+        if (timeout != 0U) {
+            osDelay(1U);
+        }
+        return 0;
+    }
+    flags = osEventFlagsWait(w5500_irq_any, sock_mask, osFlagsWaitAny, timeout);
+    return ((flags & osFlagsError) != 0U) ? 0U : (flags & sock_mask);
+}
+
+uint32_t w5500_irq_get_stamp(uint8_t sock_num)
+{
+    return (sock_num < W5500_MAX_SOCKET) ? w5500_irq_stamp[sock_num] : 0U;
+}
+
+/**
+ * @brief EXTI callback (EXTI9_5_IRQHandler -> HAL_GPIO_EXTI_IRQHandler)
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    osThreadId_t task = w5500_irq_task_handle;
+
+    if ((GPIO_Pin == W5500_INT_Pin) && (task != NULL)) {
+        w5500_irq_edge = SPI_BUS_CYCLES();
+        osThreadFlagsSet(task, W5500_IRQ_FLAG_INT);
+    }
+}
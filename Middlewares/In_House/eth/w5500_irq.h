@@ -0,0 +1,125 @@
+/**
+ * @file    w5500_irq.h
+ * @brief   Interrupt-driven W5500 socket event dispatch (INT pin, PA8)
+ *
+ * @details The W5500 pulls INT low while any unmasked socket interrupt is
+ *          pending. A falling edge on PA8 (EXTI9_5) wakes the dispatcher
+ *          task, which reads SIR and the flagged Sn_IR registers once,
+ *          clears them on the chip and latches the bits into one event-flags
+ *          object per socket. Socket owners block in w5500_irq_wait() instead
+ *          of polling the chip on a timer.
+ *
+ *          By default only CON, DISCON and RECV are unmasked (Sn_IMR) and
+ *          consumed by the dispatcher: the ioLibrary send()/sendto() still
+ *          poll and clear Sn_IR SENDOK/TIMEOUT themselves. A socket using
+ *          w5500_socket_send_async() unmasks SENDOK/TIMEOUT for itself
+ *          (w5500_irq_unmask()); the dispatcher then completes its sends.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _W5500_IRQ_H_
+#define _W5500_IRQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <cmsis_os2.h>
+
+#include "w5500_spi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*/
+/*                         EVENTS                                             */
+/*============================================================================*/
+
+/* Socket events, same bit positions as Sn_IR */
+#define W5500_IRQ_CON           Sn_IR_CON
+#define W5500_IRQ_DISCON        Sn_IR_DISCON
+#define W5500_IRQ_RECV          Sn_IR_RECV
+#define W5500_IRQ_TIMEOUT       Sn_IR_TIMEOUT
+#define W5500_IRQ_SENDOK        Sn_IR_SENDOK
+
+/* Events unmasked on the chip and dispatched to socket owners */
+#define W5500_IRQ_SN_EVENTS     (W5500_IRQ_CON | W5500_IRQ_DISCON | W5500_IRQ_RECV)
+
+/*============================================================================*/
+/*                         API                                                */
+/*============================================================================*/
+
+/**
+ * @brief Configure the INT pin and chip interrupt masks, create the per-socket
+ *        event flags and the dispatcher task
+ * @note  Called by w5500_spi_init() once the wizchip callbacks are registered.
+ */
+void w5500_irq_init(void);
+
+/**
+ * @brief Block until one of the requested events is latched for a socket
+ *
+ * @param sock_num  Socket number (0-7)
+ * @param events    W5500_IRQ_* mask to wait for
+ * @param timeout   Timeout in kernel ticks (0 = poll, osWaitForever)
+ * @return uint32_t The latched events that matched (cleared on return),
+ *                  0 on timeout or invalid socket
+ */
+uint32_t w5500_irq_wait(uint8_t sock_num, uint32_t events, uint32_t timeout);
+
+/**
+ * @brief Latch an event for a socket without touching the chip
+ * @note  Used by owners that consume only part of the pending data, so that
+ *        the next w5500_irq_wait() returns immediately.
+ */
+void w5500_irq_post(uint8_t sock_num, uint32_t events);
+
+/**
+ * @brief Dispatch more events for one socket than W5500_IRQ_SN_EVENTS
+ *
+ * @param sock_num  Socket number
+ * @param events    W5500_IRQ_* events to add to its Sn_IMR
+ * @return bool     true if the dispatcher runs and will deliver them, false
+ *                  before w5500_irq_init() (the caller must poll Sn_IR)
+ */
+bool w5500_irq_unmask(uint8_t sock_num, uint8_t events);
+
+/**
+ * @brief Undo w5500_irq_unmask(): hand the events back to Sn_IR polling
+ * @note  W5500_IRQ_SN_EVENTS always stay unmasked.
+ */
+void w5500_irq_mask(uint8_t sock_num, uint8_t events);
+
+/**
+ * @brief Block until events are latched on any socket of a set
+ *
+ * @details Every latch (dispatcher or w5500_irq_post()) also marks its socket
+ *          in a shared flags object, so one task can sleep on several
+ *          sockets. The per-socket events stay latched for w5500_irq_wait().
+ *          Wake-ups may be spurious: re-check the sockets on return.
+ *
+ * @param sock_mask Bit n selects socket n
+ * @param timeout   Timeout in kernel ticks (0 = poll, osWaitForever)
+ * @return uint32_t Sockets with activity (cleared on return), 0 on timeout.
+ *                  Before w5500_irq_init() it sleeps one tick and returns 0.
+ */
+uint32_t w5500_irq_wait_any(uint8_t sock_mask, uint32_t timeout);
+
+/**
+ * @brief When the events last latched for a socket were signalled
+ *
+ * @details SPI_BUS_CYCLES() taken in the EXTI callback of the INT edge that
+ *          led to the latch: the start of a request's on-board latency.
+ *          Events added by w5500_irq_post() keep the previous stamp.
+ *
+ * @param sock_num  Socket number
+ * @return uint32_t DWT cycle count, 0 if nothing was dispatched yet
+ */
+uint32_t w5500_irq_get_stamp(uint8_t sock_num);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _W5500_IRQ_H_ */
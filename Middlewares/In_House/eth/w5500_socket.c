@@ -23,29 +23,173 @@
  * ==========================================================================*/
 
 #include "w5500_socket.h"
+#include "w5500_spi.h"
+#include "w5500_irq.h"
+
+#define BINLOG_MODULE        "w5500_socket"
+#define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_WARN
+#include "binlog.h"
+
+/* Bit n set: w5500_socket_sendv() issued SEND on socket n and has not seen its
+ * SENDOK yet (the ioLibrary keeps the same flag privately for send()) */
+static uint8_t w5500_sock_sending;
+
+static int8_t w5500_socket_wait_sendok(uint8_t sock_num);
+static int32_t w5500_socket_gather(uint8_t sock_num, const w5500_iovec_t *iov,
+                                   uint8_t iovcnt, uint16_t total, uint8_t expect_sr);
+
+/* Socket pool: bit n of w5500_sock_claimed set while socket n has an owner,
+ * of w5500_sock_implicit while that claim was taken by w5500_socket_open()
+ * rather than w5500_socket_alloc() (it ends at close) */
+static uint8_t w5500_sock_claimed;
+static uint8_t w5500_sock_implicit;
+static w5500_sock_owner_t w5500_sock_owners[W5500_MAX_SOCKET];
+static w5500_sock_pool_stats_t w5500_sock_pool_stats;
+
+static void w5500_socket_claim(uint8_t sock_num, const char *owner);
+static void w5500_socket_unclaim(uint8_t sock_num);
+static bool w5500_socket_foreign(uint8_t sock_num);
+
+/* Multicast: bit n set while socket n is open on a group (Sn_MR MULTI) */
+static uint8_t w5500_sock_multicast;
+static struct {
+    uint8_t  ip[4];
+    uint16_t port;
+} w5500_sock_group[W5500_MAX_SOCKET];
+
+/* MACRAW streaming on socket 0 */
+static struct {
+    bool                  open;
+    uint16_t              ethertype;    /* 0: any */
+    uint8_t               mac[6];       /* SHAR, source of every frame sent */
+    w5500_macraw_filter_t filter;
+    void                 *ctx;
+} w5500_macraw;
+
+/* w5500_socket_send_async() state; stream offsets wrap at 2^32 */
+typedef struct {
+    uint32_t queued;        /* Bytes written to the TX ring */
+    uint32_t issued;        /* Bytes covered by SEND commands */
+    uint32_t done;          /* Bytes confirmed by SENDOK */
+    uint16_t wr;            /* Sn_TX_WR shadow, written right before SEND */
+    bool     active;        /* wr is valid and SENDOK/TIMEOUT are ours */
+    bool     irq;           /* Completions delivered by the INT dispatcher */
+    bool     in_flight;     /* A SEND awaits its SENDOK */
+    int8_t   error;         /* W5500_SOCK_TIMEOUT/ERROR once the SEND cannot complete */
+} w5500_tx_async_t;
+
+static w5500_tx_async_t w5500_tx_async[W5500_MAX_SOCKET];
+
+static void w5500_socket_async_reset(uint8_t sock_num);
+
+/* Per-socket traffic counters, kept by the data transfer wrappers */
+static w5500_sock_stats_t w5500_sock_stats[W5500_MAX_SOCKET];
+
+/* Start of a counted call: cycle stamp and the SPI client's running totals */
+typedef struct {
+    uint32_t cycles;
+    uint32_t spi_bytes;
+    uint64_t spi_cycles;
+} w5500_stats_mark_t;
+
+static void w5500_stats_begin(w5500_stats_mark_t *mark);
+static void w5500_stats_spi(uint8_t sock_num, const w5500_stats_mark_t *mark);
+static void w5500_stats_send(uint8_t sock_num, const w5500_stats_mark_t *mark, int32_t ret);
+static void w5500_stats_recv(uint8_t sock_num, const w5500_stats_mark_t *mark, int32_t ret);
+static int32_t w5500_stats_iolib_err(int32_t ret);
 
 /*============================================================================*/
-/* SOCKET INITIALIZATION/DEINITIALIZATION             */
+/* SOCKET REGISTER BLOCK ACCESS                       */
 /*============================================================================*/
 
+/* Offsets inside the socket register block, relative to Sn_IR (0x0002) */
+#define W5500_SREG_IR           0x00U
+#define W5500_SREG_SR           0x01U
+#define W5500_SREG_PORT         0x02U
+#define W5500_SREG_DHAR         0x04U
+#define W5500_SREG_DIPR         0x0AU
+#define W5500_SREG_DPORT        0x0EU
+#define W5500_SREG_MSSR         0x10U
+#define W5500_SREG_TOS          0x13U
+#define W5500_SREG_TTL          0x14U
+#define W5500_SREG_RXBUF_SIZE   0x1CU
+#define W5500_SREG_TXBUF_SIZE   0x1DU
+#define W5500_SREG_TX_FSR       0x1EU
+#define W5500_SREG_TX_RD        0x20U
+#define W5500_SREG_TX_WR        0x22U
+#define W5500_SREG_RX_RSR       0x24U
+#define W5500_SREG_RX_RD        0x26U
+#define W5500_SREG_RX_WR        0x28U
+#define W5500_SREG_BLOCK_LEN    0x2AU   /* Sn_IR .. Sn_RX_WR inclusive */
+
+static inline uint16_t w5500_sreg_u16(const uint8_t *raw, uint8_t off)
+{
+    return (uint16_t)(((uint16_t)raw[off] << 8) | raw[off + 1U]);
+}
+
 /**
- * @brief Open a socket and initialize it
+ * @brief Read [first, first + len) of the socket register block in one CS
+ *        frame and decode the whole block; registers outside the window
+ *        decode as zero
+ */
+static void w5500_socket_read_window(uint8_t sock_num, uint8_t first, uint8_t len,
+                                     w5500_sock_regs_t *regs)
+{
+    uint8_t raw[W5500_SREG_BLOCK_LEN] = {0};
+
+    WIZCHIP_READ_BUF(WIZCHIP_OFFSET_INC(Sn_IR(sock_num), first), &raw[first], len);
+
+    regs->ir         = raw[W5500_SREG_IR];
+    regs->sr         = raw[W5500_SREG_SR];
+    regs->port       = w5500_sreg_u16(raw, W5500_SREG_PORT);
+    memcpy(regs->dhar, &raw[W5500_SREG_DHAR], sizeof(regs->dhar));
+    memcpy(regs->dipr, &raw[W5500_SREG_DIPR], sizeof(regs->dipr));
+    regs->dport      = w5500_sreg_u16(raw, W5500_SREG_DPORT);
+    regs->mssr       = w5500_sreg_u16(raw, W5500_SREG_MSSR);
+    regs->tos        = raw[W5500_SREG_TOS];
+    regs->ttl        = raw[W5500_SREG_TTL];
+    regs->rxbuf_size = raw[W5500_SREG_RXBUF_SIZE];
+    regs->txbuf_size = raw[W5500_SREG_TXBUF_SIZE];
+    regs->tx_fsr     = w5500_sreg_u16(raw, W5500_SREG_TX_FSR);
+    regs->tx_rd      = w5500_sreg_u16(raw, W5500_SREG_TX_RD);
+    regs->tx_wr      = w5500_sreg_u16(raw, W5500_SREG_TX_WR);
+    regs->rx_rsr     = w5500_sreg_u16(raw, W5500_SREG_RX_RSR);
+    regs->rx_rd      = w5500_sreg_u16(raw, W5500_SREG_RX_RD);
+    regs->rx_wr      = w5500_sreg_u16(raw, W5500_SREG_RX_WR);
+}
+
+/**
+ * @brief Read a socket's register block (Sn_IR .. Sn_RX_WR) in one SPI burst
  *
- * @param sock_num  Socket number (0-7)
- * @param type      Socket type (TCP or UDP)
- * @param port      Port number to bind to
+ * @param sock_num  Socket number
+ * @param regs      Decoded register snapshot
  * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
  */
-int8_t w5500_socket_open(uint8_t sock_num, w5500_sock_type_t type, uint16_t port)
+int8_t w5500_socket_read_regs(uint8_t sock_num, w5500_sock_regs_t *regs)
 {
-    uint8_t protocol;
-    uint8_t flag = 0; // Default flags
-
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_open: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_read_regs: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if (regs == NULL)
+    {
+        BINLOG_WARN("w5500_socket_read_regs: regs is NULL");
         return W5500_SOCK_ERROR;
     }
+    w5500_socket_read_window(sock_num, 0U, W5500_SREG_BLOCK_LEN, regs);
+    return W5500_SOCK_OK;
+}
+
+/*============================================================================*/
+/* SOCKET INITIALIZATION/DEINITIALIZATION             */
+/*============================================================================*/
+
+/* w5500_socket_open() with Sn_MR option flags (ioLibrary SF_*) */
+static int8_t w5500_socket_open_flags(uint8_t sock_num, w5500_sock_type_t type, uint16_t port,
+                                      uint8_t flag)
+{
+    uint8_t protocol;
 
     switch (type)
     {
@@ -55,26 +199,84 @@ int8_t w5500_socket_open(uint8_t sock_num, w5500_sock_type_t type, uint16_t port
     case W5500_SOCK_UDP:
         protocol = Sn_MR_UDP;
         break;
+    case W5500_SOCK_MACRAW:
+        if (sock_num != W5500_MACRAW_SOCKET)
+        {
+            BINLOG_WARN("w5500_socket_open: MACRAW is only available on socket %d",
+                        W5500_MACRAW_SOCKET);
+            return W5500_SOCK_ERROR;
+        }
+        protocol = Sn_MR_MACRAW;
+        break;
+    case W5500_SOCK_IPRAW:
+        protocol = Sn_MR_IPRAW;
+        break;
     default:
-        DEBUG_PRINT("w5500_socket_open: Unsupported socket type %d\r\n", type);
+        BINLOG_WARN("w5500_socket_open: Unsupported socket type %d", type);
         return W5500_SOCK_ERROR;
     }
 
-    DEBUG_PRINT("w5500_socket_open: Opening socket %d, type %d, port %d\r\n", sock_num, type, port);
+    // Fixed socket numbers count against the pool until they are closed.
+    // A socket another task took with w5500_socket_alloc() is not ours to
+    // reopen; a fixed one can be reopened by anyone, as before the pool
+    w5500_spi_lock();
+    bool implicit = (w5500_sock_claimed & (1U << sock_num)) == 0U;
+    if (w5500_socket_foreign(sock_num))
+    {
+        w5500_spi_unlock();
+        BINLOG_WARN("w5500_socket_open: Socket %d is claimed by another task", sock_num);
+        return W5500_SOCK_BUSY;
+    }
+    if (implicit)
+    {
+        w5500_socket_claim(sock_num, NULL);
+        w5500_sock_implicit |= (uint8_t)(1U << sock_num);
+    }
+
+    BINLOG_DEBUG("w5500_socket_open: Opening socket %d, type %d, port %d", sock_num, type, port);
+    w5500_sock_sending &= (uint8_t)~(1U << sock_num);
+    w5500_sock_multicast &= (uint8_t)~(1U << sock_num);
+    w5500_socket_async_reset(sock_num);
     // The 'socket' function is from the WIZnet ioLibrary_Driver
     int8_t ret = socket(sock_num, protocol, port, flag);
 
     if (ret != sock_num) // On success, socket() returns the socket number
     {
-        DEBUG_PRINT("w5500_socket_open: Failed to open socket %d, error %d\r\n", sock_num, ret);
+        if (implicit)
+        {
+            w5500_socket_unclaim(sock_num);
+        }
+        w5500_spi_unlock();
+        BINLOG_WARN("w5500_socket_open: Failed to open socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
+    w5500_spi_unlock();
 
     return W5500_SOCK_OK;
 }
 
 /**
- * @brief Close a socket
+ * @brief Open a socket and initialize it
+ *
+ * @param sock_num  Socket number (0-7)
+ * @param type      Socket type (TCP or UDP)
+ * @param port      Port number to bind to
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUSY if another task
+ *                  holds the claim, negative error code on failure
+ */
+int8_t w5500_socket_open(uint8_t sock_num, w5500_sock_type_t type, uint16_t port)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_open: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    return w5500_socket_open_flags(sock_num, type, port, 0U);
+}
+
+/**
+ * @brief Close a socket; an implicit claim from w5500_socket_open() ends here,
+ *        one from w5500_socket_alloc() stays until w5500_socket_release()
  *
  * @param sock_num  Socket number
  * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
@@ -83,19 +285,26 @@ int8_t w5500_socket_close(uint8_t sock_num)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_close: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_close: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
 
-    DEBUG_PRINT("w5500_socket_close: Closing socket %d\r\n", sock_num);
+    BINLOG_DEBUG("w5500_socket_close: Closing socket %d", sock_num);
+    w5500_sock_sending &= (uint8_t)~(1U << sock_num);
+    w5500_sock_multicast &= (uint8_t)~(1U << sock_num);
+    w5500_socket_async_reset(sock_num);
     // The 'close' function is from the WIZnet ioLibrary_Driver
     int8_t ret = close(sock_num);
 
     if (ret != SOCK_OK) // SOCK_OK is usually 0
     {
-        DEBUG_PRINT("w5500_socket_close: Failed to close socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_close: Failed to close socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
+    if (w5500_sock_implicit & (1U << sock_num))
+    {
+        w5500_socket_unclaim(sock_num);
+    }
 
     return W5500_SOCK_OK;
 }
@@ -112,15 +321,15 @@ int8_t w5500_socket_setsockopt(uint8_t sock_num, uint8_t option_type, void *opti
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_setsockopt: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_setsockopt: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_setsockopt: Setting option %d on socket %d\r\n", option_type, sock_num);
+    BINLOG_DEBUG("w5500_socket_setsockopt: Setting option %d on socket %d", option_type, sock_num);
     // The 'setsockopt' function is from the WIZnet ioLibrary_Driver
     int8_t ret = setsockopt(sock_num, option_type, option_value);
     if (ret != SOCK_OK)
     {
-        DEBUG_PRINT("w5500_socket_setsockopt: Failed to set option %d on socket %d, error %d\r\n", option_type, sock_num, ret);
+        BINLOG_WARN("w5500_socket_setsockopt: Failed to set option %d on socket %d, error %d", option_type, sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return W5500_SOCK_OK;
@@ -138,20 +347,197 @@ int8_t w5500_socket_getsockopt(uint8_t sock_num, uint8_t option_type, void *opti
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_getsockopt: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_getsockopt: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
     int8_t ret = getsockopt(sock_num, option_type, option_value);
-    DEBUG_PRINT("w5500_socket_getsockopt: Getting option %d from socket %d, result %d\r\n",
-                option_type, sock_num, ret);
+    BINLOG_DEBUG("w5500_socket_getsockopt: Getting option %d from socket %d, result %d",
+                 option_type, sock_num, ret);
     if (ret != SOCK_OK)
     {
-        DEBUG_PRINT("w5500_socket_getsockopt: Failed to get option %d from socket %d, error %d\r\n", option_type, sock_num, ret);
+        BINLOG_WARN("w5500_socket_getsockopt: Failed to get option %d from socket %d, error %d", option_type, sock_num, ret);
+        return W5500_SOCK_ERROR;
+    }
+    return W5500_SOCK_OK;
+}
+
+/*============================================================================*/
+/* SOCKET POOL                                        */
+/*============================================================================*/
+
+/* Callers hold w5500_spi_lock(): it also serialises the pool bookkeeping */
+static void w5500_socket_claim(uint8_t sock_num, const char *owner)
+{
+    w5500_sock_claimed |= (uint8_t)(1U << sock_num);
+    w5500_sock_owners[sock_num].owner = owner;
+    w5500_sock_owners[sock_num].task  = osThreadGetId();
+    w5500_sock_owners[sock_num].since = osKernelGetTickCount();
+
+    uint8_t in_use = 0;
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        in_use += (uint8_t)((w5500_sock_claimed >> sn) & 1U);
+    }
+    w5500_sock_pool_stats.in_use = in_use;
+    if (in_use > w5500_sock_pool_stats.high_water)
+    {
+        w5500_sock_pool_stats.high_water = in_use;
+    }
+}
+
+/* Allocated by another task (claims taken before the scheduler have none);
+ * implicit claims of fixed socket numbers are nobody's in particular */
+static bool w5500_socket_foreign(uint8_t sock_num)
+{
+    return ((w5500_sock_claimed & (uint8_t)~w5500_sock_implicit & (1U << sock_num)) != 0U) &&
+           (w5500_sock_owners[sock_num].task != NULL) &&
+           (osThreadGetId() != NULL) &&
+           (w5500_sock_owners[sock_num].task != osThreadGetId());
+}
+
+static void w5500_socket_unclaim(uint8_t sock_num)
+{
+    w5500_spi_lock();
+    if (w5500_sock_claimed & (1U << sock_num))
+    {
+        w5500_sock_claimed &= (uint8_t)~(1U << sock_num);
+        w5500_sock_implicit &= (uint8_t)~(1U << sock_num);
+        memset(&w5500_sock_owners[sock_num], 0, sizeof(w5500_sock_owners[sock_num]));
+        w5500_sock_pool_stats.in_use--;
+        BINLOG_DEBUG("w5500_socket_unclaim: Socket %d back in the pool", sock_num);
+    }
+    w5500_spi_unlock();
+}
+
+/**
+ * @brief Claim a free hardware socket for a module
+ *
+ * @param owner     Module name (static string)
+ * @param sock_mask Acceptable sockets, bit n = socket n (W5500_SOCK_ANY)
+ * @param sock_num  Claimed socket number
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUSY if no socket is free
+ */
+int8_t w5500_socket_alloc(const char *owner, uint8_t sock_mask, uint8_t *sock_num)
+{
+    if (sock_num == NULL)
+    {
+        BINLOG_WARN("w5500_socket_alloc: sock_num is NULL");
+        return W5500_SOCK_ERROR;
+    }
+
+    w5500_spi_lock();
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        if (((sock_mask & (1U << sn)) == 0U) || (w5500_sock_claimed & (1U << sn)))
+        {
+            continue;
+        }
+        // Skip sockets opened behind the pool's back (raw ioLibrary calls)
+        w5500_sock_regs_t regs;
+        w5500_socket_read_window(sn, W5500_SREG_SR, 1U, &regs);
+        if (regs.sr != SOCK_CLOSED)
+        {
+            continue;
+        }
+        w5500_socket_claim(sn, owner);
+        w5500_sock_pool_stats.allocs++;
+        w5500_spi_unlock();
+
+        *sock_num = sn;
+        BINLOG_DEBUG("w5500_socket_alloc: Socket %d claimed, %d in use",
+                     sn, w5500_sock_pool_stats.in_use);
+        return W5500_SOCK_OK;
+    }
+    w5500_sock_pool_stats.failures++;
+    w5500_spi_unlock();
+
+    BINLOG_WARN("w5500_socket_alloc: No free socket in mask 0x%02X", sock_mask);
+    return W5500_SOCK_BUSY;
+}
+
+/**
+ * @brief Close a socket if open and return it to the pool
+ *
+ * @param sock_num  Socket number
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_release(uint8_t sock_num)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_release: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
+    w5500_sock_regs_t regs;
+    w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+    if (regs.sr != SOCK_CLOSED)
+    {
+        int8_t ret = w5500_socket_close(sock_num);
+        if (ret != W5500_SOCK_OK)
+        {
+            return ret;
+        }
+    }
+    w5500_socket_unclaim(sock_num);
     return W5500_SOCK_OK;
 }
 
+/**
+ * @brief Get the owner of a claimed socket
+ *
+ * @param sock_num  Socket number
+ * @param info      Owner record
+ * @return bool     true if the socket is claimed
+ */
+bool w5500_socket_get_owner(uint8_t sock_num, w5500_sock_owner_t *info)
+{
+    bool claimed;
+
+    if ((sock_num >= W5500_MAX_SOCKET) || (info == NULL))
+    {
+        return false;
+    }
+    w5500_spi_lock();
+    claimed = (w5500_sock_claimed & (1U << sock_num)) != 0U;
+    *info = w5500_sock_owners[sock_num];
+    w5500_spi_unlock();
+    return claimed;
+}
+
+/**
+ * @brief Get the pool usage counters and high-water mark, and count the
+ *        claimed sockets that are SOCK_CLOSED as leaked
+ *
+ * @param stats     Counters
+ */
+void w5500_socket_get_pool_stats(w5500_sock_pool_stats_t *stats)
+{
+    if (stats == NULL)
+    {
+        return;
+    }
+    w5500_spi_lock();
+    *stats = w5500_sock_pool_stats;
+    stats->leaked      = 0;
+    stats->leaked_mask = 0;
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        if ((w5500_sock_claimed & (1U << sn)) == 0U)
+        {
+            continue;
+        }
+        // Claimed but closed by the chip and never given back
+        w5500_sock_regs_t regs;
+        w5500_socket_read_window(sn, W5500_SREG_SR, 1U, &regs);
+        if (regs.sr == SOCK_CLOSED)
+        {
+            stats->leaked++;
+            stats->leaked_mask |= (uint8_t)(1U << sn);
+        }
+    }
+    w5500_spi_unlock();
+}
+
 /*============================================================================*/
 /* TCP SPECIFIC OPERATIONS                            */
 /*============================================================================*/
@@ -168,16 +554,16 @@ int8_t w5500_socket_connect(uint8_t sock_num, const uint8_t *dest_ip, uint16_t d
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_connect: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_connect: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_connect: Connecting socket %d to %d.%d.%d.%d:%d\r\n",
-                sock_num, dest_ip[0], dest_ip[1], dest_ip[2], dest_ip[3], dest_port);
+    BINLOG_DEBUG("w5500_socket_connect: Connecting socket %d to %d.%d.%d.%d:%d",
+                 sock_num, dest_ip[0], dest_ip[1], dest_ip[2], dest_ip[3], dest_port);
     // The 'connect' function is from the WIZnet ioLibrary_Driver
     int8_t ret = connect(sock_num, (uint8_t *)dest_ip, dest_port);
     if (ret != SOCK_OK)
     {
-        DEBUG_PRINT("w5500_socket_connect: Failed to connect socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_connect: Failed to connect socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return W5500_SOCK_OK;
@@ -193,15 +579,48 @@ int8_t w5500_disconnect(uint8_t sock_num)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_disconnect: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_disconnect: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_disconnect: Disconnecting socket %d\r\n", sock_num);
+    BINLOG_DEBUG("w5500_disconnect: Disconnecting socket %d", sock_num);
     // The 'disconnect' function is from the WIZnet ioLibrary_Driver, specifically for TCP
     int8_t ret = disconnect(sock_num);
     if (ret != SOCK_OK)
     {
-        DEBUG_PRINT("w5500_disconnect: Failed to disconnect socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_disconnect: Failed to disconnect socket %d, error %d", sock_num, ret);
+        return W5500_SOCK_ERROR;
+    }
+    return W5500_SOCK_OK;
+}
+
+/**
+ * @brief Start a graceful TCP close without waiting for it
+ *
+ * @param sock_num Socket number
+ * @return int8_t W5500_SOCK_OK once DISCON is issued, negative error code on failure
+ */
+int8_t w5500_disconnect_async(uint8_t sock_num)
+{
+    uint8_t mode;
+    uint8_t nonblock = SOCK_IO_NONBLOCK;
+
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_disconnect_async: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    BINLOG_DEBUG("w5500_disconnect_async: Disconnecting socket %d", sock_num);
+    // The ioLibrary I/O mode bits are shared by every socket: switch ours for
+    // this call only, under the lock
+    w5500_spi_lock();
+    ctlsocket(sock_num, CS_GET_IOMODE, &mode);
+    ctlsocket(sock_num, CS_SET_IOMODE, &nonblock);
+    int8_t ret = disconnect(sock_num);   // SOCK_BUSY: DISCON issued, not done
+    ctlsocket(sock_num, CS_SET_IOMODE, &mode);
+    w5500_spi_unlock();
+    if ((ret != SOCK_BUSY) && (ret != SOCK_OK))
+    {
+        BINLOG_WARN("w5500_disconnect_async: Failed to disconnect socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return W5500_SOCK_OK;
@@ -217,15 +636,15 @@ int8_t w5500_socket_listen(uint8_t sock_num)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_listen: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_listen: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_listen: Listening on socket %d\r\n", sock_num);
+    BINLOG_DEBUG("w5500_socket_listen: Listening on socket %d", sock_num);
     // The 'listen' function is from the WIZnet ioLibrary_Driver
     int8_t ret = listen(sock_num);
     if (ret != SOCK_OK)
     {
-        DEBUG_PRINT("w5500_socket_listen: Failed to listen on socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_listen: Failed to listen on socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return W5500_SOCK_OK;
@@ -241,15 +660,14 @@ bool w5500_socket_is_connected(uint8_t sock_num)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_is_connected: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_is_connected: Invalid socket number %d", sock_num);
         return false;
     }
-    // This typically checks the socket status register (Sn_SR)
-    // Sn_SR_ESTABLISHED indicates a connected state for TCP.
-    // getSn_SR is from wizchip_conf.h or socket.h in WIZnet library.
-    uint8_t status = getSn_SR(sock_num);
-    DEBUG_PRINT("w5500_socket_is_connected: Socket %d status: 0x%02X\r\n", sock_num, status);
-    return (status == SOCK_ESTABLISHED);
+    // Sn_SR == SOCK_ESTABLISHED indicates a connected state for TCP.
+    w5500_sock_regs_t regs;
+    w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+    BINLOG_DEBUG("w5500_socket_is_connected: Socket %d status: 0x%02X", sock_num, regs.sr);
+    return (regs.sr == SOCK_ESTABLISHED);
 }
 
 /*============================================================================*/
@@ -268,20 +686,23 @@ int32_t w5500_socket_send(uint8_t sock_num, const uint8_t *buffer, uint16_t len)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_send: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_send: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
     if (buffer == NULL)
     {
-        DEBUG_PRINT("w5500_socket_send: Buffer is NULL\r\n");
+        BINLOG_WARN("w5500_socket_send: Buffer is NULL");
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_send: Sending %d bytes on socket %d\r\n", len, sock_num);
+    BINLOG_DEBUG("w5500_socket_send: Sending %d bytes on socket %d", len, sock_num);
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
     // The 'send' function is from the WIZnet ioLibrary_Driver
     int32_t ret = send(sock_num, (uint8_t *)buffer, len);
+    w5500_stats_send(sock_num, &mark, w5500_stats_iolib_err(ret));
     if (ret < 0)
     {
-        DEBUG_PRINT("w5500_socket_send: Failed to send data on socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_send: Failed to send data on socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return ret;
@@ -299,22 +720,25 @@ int32_t w5500_socket_recv(uint8_t sock_num, uint8_t *buffer, uint16_t maxlen)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_recv: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_recv: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
     if (buffer == NULL)
     {
-        DEBUG_PRINT("w5500_socket_recv: Buffer is NULL\r\n");
+        BINLOG_WARN("w5500_socket_recv: Buffer is NULL");
         return W5500_SOCK_ERROR;
     }
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
     // The 'recv' function is from the WIZnet ioLibrary_Driver
     int32_t ret = recv(sock_num, buffer, maxlen);
+    w5500_stats_recv(sock_num, &mark, w5500_stats_iolib_err(ret));
     if (ret < 0)
     {
-        DEBUG_PRINT("w5500_socket_recv: Failed to receive data on socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_recv: Failed to receive data on socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_recv: Received %d bytes on socket %d\r\n", ret, sock_num);
+    BINLOG_DEBUG("w5500_socket_recv: Received %d bytes on socket %d", ret, sock_num);
     return ret;
 }
 
@@ -333,21 +757,24 @@ int32_t w5500_socket_sendto(uint8_t sock_num, const uint8_t *buffer, uint16_t le
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_sendto: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_sendto: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
     if (buffer == NULL)
     {
-        DEBUG_PRINT("w5500_socket_sendto: Buffer is NULL\r\n");
+        BINLOG_WARN("w5500_socket_sendto: Buffer is NULL");
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_sendto: Sending %d bytes to %d.%d.%d.%d:%d on socket %d\r\n",
-                len, dest_ip[0], dest_ip[1], dest_ip[2], dest_ip[3], dest_port, sock_num);
+    BINLOG_DEBUG("w5500_socket_sendto: Sending %d bytes to %d.%d.%d.%d:%d on socket %d",
+                 len, dest_ip[0], dest_ip[1], dest_ip[2], dest_ip[3], dest_port, sock_num);
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
     // The 'sendto' function is from the WIZnet ioLibrary_Driver
     int32_t ret = sendto(sock_num, (uint8_t *)buffer, len, (uint8_t *)dest_ip, dest_port);
+    w5500_stats_send(sock_num, &mark, w5500_stats_iolib_err(ret));
     if (ret < 0)
     {
-        DEBUG_PRINT("w5500_socket_sendto: Failed to sendto data on socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_sendto: Failed to sendto data on socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
     return ret;
@@ -368,83 +795,2080 @@ int32_t w5500_socket_recvfrom(uint8_t sock_num, uint8_t *buffer, uint16_t maxlen
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_recvfrom: Invalid socket number %d\r\n", sock_num);
+        BINLOG_WARN("w5500_socket_recvfrom: Invalid socket number %d", sock_num);
         return W5500_SOCK_ERROR;
     }
     if (buffer == NULL)
     {
-        DEBUG_PRINT("w5500_socket_recvfrom: Buffer is NULL\r\n");
+        BINLOG_WARN("w5500_socket_recvfrom: Buffer is NULL");
         return W5500_SOCK_ERROR;
     }
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
     // The 'recvfrom' function is from the WIZnet ioLibrary_Driver
     int32_t ret = recvfrom(sock_num, buffer, maxlen, src_ip, src_port);
+    w5500_stats_recv(sock_num, &mark, w5500_stats_iolib_err(ret));
     if (ret < 0)
     {
-        DEBUG_PRINT("w5500_socket_recvfrom: Failed to recvfrom data on socket %d, error %d\r\n", sock_num, ret);
+        BINLOG_WARN("w5500_socket_recvfrom: Failed to recvfrom data on socket %d, error %d", sock_num, ret);
         return W5500_SOCK_ERROR;
     }
-    DEBUG_PRINT("w5500_socket_recvfrom: Received %d bytes from %d.%d.%d.%d:%d on socket %d\r\n",
-                ret, src_ip[0], src_ip[1], src_ip[2], src_ip[3], *src_port, sock_num);
+    BINLOG_DEBUG("w5500_socket_recvfrom: Received %d bytes from %d.%d.%d.%d:%d on socket %d",
+                 ret, src_ip[0], src_ip[1], src_ip[2], src_ip[3], *src_port, sock_num);
     return ret;
 }
 
+/**
+ * @brief Ask whether a host answers ARP for @p ip
+ *
+ * @param sock_num  Open UDP socket
+ * @param ip        Address to probe (4 bytes)
+ * @param retries   ARP retries (RCR) for the probe
+ * @return int8_t   W5500_SOCK_OK if nobody answered, W5500_SOCK_BUSY if a
+ *                  host did, W5500_SOCK_ERROR if @p ip cannot be probed
+ */
+int8_t w5500_socket_arp_probe(uint8_t sock_num, const uint8_t *ip, uint8_t retries)
+{
+    // Same check as the ioLibrary DHCP client; port 5000 is never answered
+    static const uint8_t probe[] = "CHECK_IP_CONFLICT";
+    const w5500_iovec_t iov = { .data = probe, .len = (uint16_t)(sizeof(probe) - 1U) };
+    uint8_t sipr[4];
+    uint8_t subr[4];
+    bool on_link = true;
+
+    if ((sock_num >= W5500_MAX_SOCKET) || (ip == NULL))
+    {
+        BINLOG_WARN("w5500_socket_arp_probe: Bad arguments on socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    // SIPR and SUBR stay as they are: live sockets keep building segments
+    // from them. An off-link target would make the chip ARP the gateway,
+    // which then answers for it, so such a target cannot be probed.
+    // RCR is only changed and restored in short bus transactions; the wait
+    // sleeps on SENDOK/TIMEOUT without the lock
+    w5500_spi_lock();
+    getSIPR(sipr);
+    getSUBR(subr);
+    for (uint8_t i = 0; i < 4U; i++)
+    {
+        if (((ip[i] ^ sipr[i]) & subr[i]) != 0U)
+        {
+            on_link = false;
+        }
+    }
+    uint8_t rcr = getRCR();
+    if (on_link)
+    {
+        setRCR(retries);
+        setSn_DIPR(sock_num, (uint8_t *)ip);
+        setSn_DPORT(sock_num, 5000U);
+    }
+    w5500_spi_unlock();
+    if (!on_link)
+    {
+        BINLOG_WARN("w5500_socket_arp_probe: %d.%d.%d.%d is off-link, not probed",
+                    ip[0], ip[1], ip[2], ip[3]);
+        return W5500_SOCK_ERROR;
+    }
+
+    int32_t ret = w5500_socket_gather(sock_num, &iov, 1U, iov.len, SOCK_UDP);
+    if (ret >= 0)
+    {
+        ret = w5500_socket_wait_sendok(sock_num);
+    }
+
+    w5500_spi_lock();
+    setRCR(rcr);
+    w5500_spi_unlock();
+
+    BINLOG_DEBUG("w5500_socket_arp_probe: %d.%d.%d.%d result %d", ip[0], ip[1], ip[2], ip[3], ret);
+    if (ret == W5500_SOCK_OK)
+    {
+        return W5500_SOCK_BUSY;     // the datagram got out: someone answered
+    }
+    return (ret == W5500_SOCK_TIMEOUT) ? W5500_SOCK_OK : W5500_SOCK_ERROR;
+}
+
 /*============================================================================*/
-/* SOCKET STATUS                                      */
+/* UDP MULTICAST                                      */
 /*============================================================================*/
 
 /**
- * @brief Get socket status
+ * @brief Open a UDP socket on a multicast group
  *
  * @param sock_num  Socket number
- * @return uint8_t  Socket status code (see socket.h for Sn_SR_* defines)
+ * @param group_ip  Group address, 224.0.0.0 .. 239.255.255.255
+ * @param port      Group port, also the local port
+ * @param options   W5500_MCAST_* options
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
  */
-uint8_t w5500_socket_get_status(uint8_t sock_num)
+int8_t w5500_socket_open_multicast(uint8_t sock_num, const uint8_t *group_ip, uint16_t port,
+                                   uint8_t options)
 {
+    uint8_t mac[6];
+    uint8_t flag = SF_MULTI_ENABLE;
+
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_get_status: Invalid socket number %d\r\n", sock_num);
-        return 0xFF; // Indicate error with an invalid status code
+        BINLOG_WARN("w5500_socket_open_multicast: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((group_ip == NULL) || ((group_ip[0] & 0xF0U) != 0xE0U) || (port == 0U))
+    {
+        BINLOG_WARN("w5500_socket_open_multicast: Bad group for socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if (options & W5500_MCAST_BLOCK_UNICAST)
+    {
+        flag |= SF_UNI_BLOCK;
+    }
+    if (options & W5500_MCAST_BLOCK_BROADCAST)
+    {
+        flag |= SF_BROAD_BLOCK;
+    }
+    if (options & W5500_MCAST_IGMP_V1)
+    {
+        flag |= SF_IGMP_VER2;   // Sn_MR MC: set selects IGMPv1 on the W5500
+    }
+
+    // RFC 1112 group MAC: 01:00:5E + low 23 bits of the group address
+    mac[0] = 0x01U;
+    mac[1] = 0x00U;
+    mac[2] = 0x5EU;
+    mac[3] = (uint8_t)(group_ip[1] & 0x7FU);
+    mac[4] = group_ip[2];
+    mac[5] = group_ip[3];
+
+    BINLOG_DEBUG("w5500_socket_open_multicast: Socket %d joins %d.%d.%d.%d:%d",
+                 sock_num, group_ip[0], group_ip[1], group_ip[2], group_ip[3], port);
+    // The chip sends the IGMP join on OPEN from Sn_DHAR/Sn_DIPR/Sn_DPORT
+    // (and the leave on CLOSE); the registers must be in place first
+    w5500_spi_lock();
+    if (w5500_socket_foreign(sock_num))
+    {
+        w5500_spi_unlock();
+        BINLOG_WARN("w5500_socket_open_multicast: Socket %d is claimed by another task", sock_num);
+        return W5500_SOCK_BUSY;
+    }
+    setSn_DHAR(sock_num, mac);
+    setSn_DIPR(sock_num, (uint8_t *)group_ip);
+    setSn_DPORT(sock_num, port);
+    int8_t ret = w5500_socket_open_flags(sock_num, W5500_SOCK_UDP, port, flag);
+    if (ret == W5500_SOCK_OK)
+    {
+        memcpy(w5500_sock_group[sock_num].ip, group_ip, 4);
+        w5500_sock_group[sock_num].port = port;
+        w5500_sock_multicast |= (uint8_t)(1U << sock_num);
     }
-    // getSn_SR is from wizchip_conf.h or socket.h in WIZnet library.
-    uint8_t status = getSn_SR(sock_num);
-    DEBUG_PRINT("w5500_socket_get_status: Socket %d current status: 0x%02X\r\n", sock_num, status);
-    return status;
+    w5500_spi_unlock();
+    return ret;
 }
 
 /**
- * @brief Get the amount of free transmit buffer size on a socket
+ * @brief Send one datagram to the group a socket joined
  *
- * @param sock_num  Socket number
- * @return uint16_t Free TX buffer size in bytes
+ * @param sock_num  Socket number opened with w5500_socket_open_multicast()
+ * @param buffer    Pointer to data to send
+ * @param len       Length of data to send
+ * @return int32_t  Number of bytes sent, negative error code on failure
  */
-uint16_t w5500_socket_get_tx_buf_free_size(uint8_t sock_num)
+int32_t w5500_socket_publish(uint8_t sock_num, const uint8_t *buffer, uint16_t len)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_get_tx_buf_free_size: Invalid socket number %d\r\n", sock_num);
-        return 0;
+        BINLOG_WARN("w5500_socket_publish: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((w5500_sock_multicast & (1U << sock_num)) == 0U)
+    {
+        BINLOG_WARN("w5500_socket_publish: Socket %d is not on a multicast group", sock_num);
+        return W5500_SOCK_ERROR;
     }
-    // getSn_TX_FSR is from wizchip_conf.h or socket.h in WIZnet library.
-    uint16_t size = getSn_TX_FSR(sock_num);
-    DEBUG_PRINT("w5500_socket_get_tx_buf_free_size: Socket %d TX free size: %d\r\n", sock_num, size);
-    return size;
+    return w5500_socket_sendto(sock_num, buffer, len, w5500_sock_group[sock_num].ip,
+                               w5500_sock_group[sock_num].port);
 }
 
+/*============================================================================*/
+/* IP RAW                                             */
+/*============================================================================*/
+
 /**
- * @brief Get the amount of received data in the RX buffer of a socket
+ * @brief Open a socket on the IP payloads of one protocol
  *
  * @param sock_num  Socket number
- * @return uint16_t RX buffer size in bytes
+ * @param protocol  IP protocol number, e.g. W5500_IPPROTO_ICMP
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
  */
-uint16_t w5500_socket_get_rx_buf_size(uint8_t sock_num)
+int8_t w5500_socket_open_ipraw(uint8_t sock_num, uint8_t protocol)
 {
     if (sock_num >= W5500_MAX_SOCKET)
     {
-        DEBUG_PRINT("w5500_socket_get_rx_buf_size: Invalid socket number %d\r\n", sock_num);
-        return 0;
+        BINLOG_WARN("w5500_socket_open_ipraw: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+
+    // Sn_PROTO is latched on OPEN
+    w5500_spi_lock();
+    if (w5500_socket_foreign(sock_num))
+    {
+        w5500_spi_unlock();
+        BINLOG_WARN("w5500_socket_open_ipraw: Socket %d is claimed by another task", sock_num);
+        return W5500_SOCK_BUSY;
+    }
+    setSn_PROTO(sock_num, protocol);
+    int8_t ret = w5500_socket_open_flags(sock_num, W5500_SOCK_IPRAW, 0U, 0U);
+    w5500_spi_unlock();
+    return ret;
+}
+
+/*============================================================================*/
+/* MACRAW STREAMING                                   */
+/*============================================================================*/
+
+/* Minimum Ethernet payload; the frame is 60 bytes before the FCS */
+#define W5500_ETH_MIN_PAYLOAD   46U
+
+/* Sn_RX ring: each frame is preceded by its length, length bytes included */
+#define W5500_MACRAW_RX_HDR_LEN 2U
+
+// All memory to socket 0: MACRAW frames queue back to back in one ring
+static const w5500_mem_layout_t w5500_macraw_layout = {
+    .name  = "macraw",
+    .tx_kb = {16, 0, 0, 0, 0, 0, 0, 0},
+    .rx_kb = {16, 0, 0, 0, 0, 0, 0, 0},
+};
+
+static const uint8_t w5500_macraw_pad[W5500_ETH_MIN_PAYLOAD];
+
+static uint16_t w5500_macraw_wire_len(const w5500_macraw_frame_t *frame)
+{
+    uint16_t len = (frame->len < W5500_ETH_MIN_PAYLOAD) ? W5500_ETH_MIN_PAYLOAD : frame->len;
+    return (uint16_t)(W5500_ETH_HDR_LEN + len);
+}
+
+/* Header, payload and padding at ptr, past Sn_TX_WR; w5500_spi_lock() held */
+static uint16_t w5500_macraw_write(uint16_t ptr, const w5500_macraw_frame_t *frame)
+{
+    const uint8_t sn = W5500_MACRAW_SOCKET;
+    uint8_t hdr[W5500_ETH_HDR_LEN];
+
+    if (frame->dst != NULL)
+    {
+        memcpy(&hdr[0], frame->dst, 6);
+    }
+    else
+    {
+        memset(&hdr[0], 0xFF, 6);
+    }
+    memcpy(&hdr[6], w5500_macraw.mac, 6);
+    hdr[12] = (uint8_t)(w5500_macraw.ethertype >> 8);
+    hdr[13] = (uint8_t)w5500_macraw.ethertype;
+
+    WIZCHIP_WRITE_BUF(((uint32_t)ptr << 8) + (WIZCHIP_TXBUF_BLOCK(sn) << 3), hdr, sizeof(hdr));
+    ptr = (uint16_t)(ptr + sizeof(hdr));
+    if (frame->len > 0U)
+    {
+        WIZCHIP_WRITE_BUF(((uint32_t)ptr << 8) + (WIZCHIP_TXBUF_BLOCK(sn) << 3),
+                          (uint8_t *)frame->data, frame->len);
+        ptr = (uint16_t)(ptr + frame->len);
+    }
+    if (frame->len < W5500_ETH_MIN_PAYLOAD)
+    {
+        uint16_t pad = (uint16_t)(W5500_ETH_MIN_PAYLOAD - frame->len);
+        WIZCHIP_WRITE_BUF(((uint32_t)ptr << 8) + (WIZCHIP_TXBUF_BLOCK(sn) << 3),
+                          (uint8_t *)w5500_macraw_pad, pad);
+        ptr = (uint16_t)(ptr + pad);
+    }
+    return ptr;
+}
+
+/**
+ * @brief Switch socket 0 to raw Ethernet frames of one EtherType
+ *
+ * @param ethertype EtherType of the frames sent and received (0: any)
+ * @param options   W5500_MACRAW_* chip-side filters
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_macraw_open(uint16_t ethertype, uint8_t options)
+{
+    uint8_t flag = 0U;
+    uint8_t sn;
+
+    if (w5500_macraw.open)
+    {
+        BINLOG_WARN("w5500_socket_macraw_open: Already open");
+        return W5500_SOCK_BUSY;
+    }
+    if (options & W5500_MACRAW_MAC_FILTER)
+    {
+        flag |= SF_ETHER_OWN;
+    }
+    if (options & W5500_MACRAW_BLOCK_MULTICAST)
+    {
+        flag |= SF_MULTI_BLOCK;
+    }
+    if (options & W5500_MACRAW_BLOCK_IPV6)
+    {
+        flag |= SF_IPv6_BLOCK;
+    }
+
+    // Claim, re-partition and open as one bus transaction: no socket can be
+    // opened on the old layout in between
+    w5500_spi_lock();
+    int8_t ret = w5500_socket_alloc("macraw", 1U << W5500_MACRAW_SOCKET, &sn);
+    if (ret == W5500_SOCK_OK)
+    {
+        ret = w5500_socket_apply_layout(&w5500_macraw_layout);
+        if (ret == W5500_SOCK_OK)
+        {
+            ret = w5500_socket_open_flags(sn, W5500_SOCK_MACRAW, 0U, flag);
+            if (ret != W5500_SOCK_OK)
+            {
+                (void)w5500_socket_apply_layout(w5500_socket_get_profile(ETH_CONFIG_MEM_PROFILE));
+            }
+        }
+        if (ret != W5500_SOCK_OK)
+        {
+            (void)w5500_socket_release(sn);
+        }
+    }
+    if (ret == W5500_SOCK_OK)
+    {
+        getSHAR(w5500_macraw.mac);
+        w5500_macraw.ethertype = ethertype;
+        w5500_macraw.open      = true;
+    }
+    w5500_spi_unlock();
+
+    if (ret != W5500_SOCK_OK)
+    {
+        BINLOG_WARN("w5500_socket_macraw_open: Cannot take socket 0 and the buffer memory, error %d", ret);
+    }
+    return ret;
+}
+
+/**
+ * @brief Close socket 0 and restore the ETH_CONFIG_MEM_PROFILE layout
+ *
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_macraw_close(void)
+{
+    if (!w5500_macraw.open)
+    {
+        return W5500_SOCK_OK;
+    }
+    w5500_spi_lock();
+    int8_t ret = w5500_socket_release(W5500_MACRAW_SOCKET);
+    if (ret == W5500_SOCK_OK)
+    {
+        w5500_macraw.open = false;
+        ret = w5500_socket_apply_layout(w5500_socket_get_profile(ETH_CONFIG_MEM_PROFILE));
+    }
+    w5500_spi_unlock();
+    return ret;
+}
+
+/**
+ * @brief Replace the software filter of incoming frames
+ *
+ * @param filter    Filter, NULL to accept every frame of the EtherType
+ * @param ctx       Passed to @p filter
+ */
+void w5500_socket_macraw_set_filter(w5500_macraw_filter_t filter, void *ctx)
+{
+    w5500_spi_lock();
+    w5500_macraw.filter = filter;
+    w5500_macraw.ctx    = ctx;
+    w5500_spi_unlock();
+}
+
+/**
+ * @brief Send a batch of frames
+ *
+ * @param frames    Frames, sent in order
+ * @param count     Number of frames
+ * @return int32_t  Frames sent, negative error code on failure
+ */
+int32_t w5500_socket_macraw_send_batch(const w5500_macraw_frame_t *frames, uint8_t count)
+{
+    const uint8_t sn = W5500_MACRAW_SOCKET;
+    w5500_sock_regs_t regs;
+    w5500_stats_mark_t mark;
+    uint32_t bytes = 0U;
+    uint8_t sent = 0U;
+
+    if (!w5500_macraw.open)
+    {
+        BINLOG_WARN("w5500_socket_macraw_send_batch: MACRAW is not open");
+        return W5500_SOCK_ERROR;
+    }
+    if ((frames == NULL) || (count == 0U))
+    {
+        BINLOG_WARN("w5500_socket_macraw_send_batch: No frames");
+        return W5500_SOCK_ERROR;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if ((frames[i].len > W5500_MACRAW_MTU) || ((frames[i].len > 0U) && (frames[i].data == NULL)))
+        {
+            BINLOG_WARN("w5500_socket_macraw_send_batch: Frame %d is malformed (%d bytes)",
+                        i, frames[i].len);
+            return W5500_SOCK_BUFFER_ERROR;
+        }
+    }
+
+    w5500_stats_begin(&mark);
+    while (sent < count)
+    {
+        // Free space and Sn_TX_WR in one frame; a torn Sn_TX_FSR is low
+        w5500_socket_read_window(sn, W5500_SREG_TX_FSR,
+                                 W5500_SREG_RX_RSR - W5500_SREG_TX_FSR, &regs);
+        uint16_t room = regs.tx_fsr;
+        uint16_t ptr  = regs.tx_wr;
+        uint8_t  n    = 0U;
+
+        // Write every frame that fits while the previous SEND is on the wire
+        w5500_spi_lock();
+        while (((sent + n) < count) && (w5500_macraw_wire_len(&frames[sent + n]) <= room))
+        {
+            room = (uint16_t)(room - w5500_macraw_wire_len(&frames[sent + n]));
+            ptr  = w5500_macraw_write(ptr, &frames[sent + n]);
+            n++;
+        }
+        w5500_spi_unlock();
+
+        // One SEND per frame: the chip sends Sn_TX_RD .. Sn_TX_WR as a frame
+        ptr = regs.tx_wr;
+        for (uint8_t i = 0; i < n; i++)
+        {
+            if (w5500_sock_sending & (1U << sn))
+            {
+                int8_t done = w5500_socket_wait_sendok(sn);
+                w5500_sock_sending &= (uint8_t)~(1U << sn);
+                if (done != W5500_SOCK_OK)
+                {
+                    BINLOG_WARN("w5500_socket_macraw_send_batch: SEND failed, error %d", done);
+                    w5500_stats_send(sn, &mark, done);
+                    return done;
+                }
+            }
+            ptr = (uint16_t)(ptr + w5500_macraw_wire_len(&frames[sent + i]));
+            w5500_spi_lock();
+            setSn_TX_WR(sn, ptr);
+            setSn_CR(sn, Sn_CR_SEND);
+            while (getSn_CR(sn))
+            {
+            }
+            w5500_spi_unlock();
+            w5500_sock_sending |= (uint8_t)(1U << sn);
+            bytes += frames[sent + i].len;
+        }
+        sent = (uint8_t)(sent + n);
+
+        if ((n == 0U) && (w5500_sock_sending & (1U << sn)))
+        {
+            // Ring full: free the frame in flight before looking again
+            int8_t done = w5500_socket_wait_sendok(sn);
+            w5500_sock_sending &= (uint8_t)~(1U << sn);
+            if (done != W5500_SOCK_OK)
+            {
+                w5500_stats_send(sn, &mark, done);
+                return done;
+            }
+        }
+    }
+    w5500_stats_send(sn, &mark, (int32_t)bytes);
+
+    BINLOG_DEBUG("w5500_socket_macraw_send_batch: Sent %d frames, %d bytes", sent, bytes);
+    return sent;
+}
+
+/**
+ * @brief Send one frame
+ *
+ * @param dst       Destination MAC, NULL for broadcast
+ * @param data      Payload
+ * @param len       Payload length
+ * @return int32_t  Payload bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_macraw_send(const uint8_t *dst, const uint8_t *data, uint16_t len)
+{
+    w5500_macraw_frame_t frame = { .dst = dst, .data = data, .len = len };
+    int32_t ret = w5500_socket_macraw_send_batch(&frame, 1U);
+
+    return (ret < 0) ? ret : len;
+}
+
+/**
+ * @brief Receive the pending frames that pass the filters
+ *
+ * @param frames    Receive slots, filled in order
+ * @param count     Number of slots
+ * @return int32_t  Frames delivered, negative error code on failure
+ */
+int32_t w5500_socket_macraw_recv_batch(w5500_macraw_rx_t *frames, uint8_t count)
+{
+    const uint8_t sn = W5500_MACRAW_SOCKET;
+    w5500_sock_regs_t regs;
+    w5500_stats_mark_t mark;
+    int32_t ret = W5500_SOCK_OK;
+    uint32_t bytes = 0U;
+    uint8_t got = 0U;
+
+    if (!w5500_macraw.open)
+    {
+        BINLOG_WARN("w5500_socket_macraw_recv_batch: MACRAW is not open");
+        return W5500_SOCK_ERROR;
+    }
+    if ((frames == NULL) || (count == 0U))
+    {
+        BINLOG_WARN("w5500_socket_macraw_recv_batch: No receive slots");
+        return W5500_SOCK_ERROR;
+    }
+
+    w5500_stats_begin(&mark);
+    // Pending bytes and Sn_RX_RD in one frame; the chip only counts whole frames
+    w5500_socket_read_window(sn, W5500_SREG_RX_RSR, W5500_SREG_RX_WR - W5500_SREG_RX_RSR, &regs);
+    uint16_t rsr = regs.rx_rsr;
+    uint16_t rd  = regs.rx_rd;
+    uint16_t start = rd;
+
+    while ((got < count) && (rsr >= (W5500_MACRAW_RX_HDR_LEN + W5500_ETH_HDR_LEN)))
+    {
+        uint8_t raw[W5500_MACRAW_RX_HDR_LEN + W5500_ETH_HDR_LEN];
+        w5500_eth_hdr_t hdr;
+
+        WIZCHIP_READ_BUF(((uint32_t)rd << 8) + (WIZCHIP_RXBUF_BLOCK(sn) << 3), raw, sizeof(raw));
+        uint16_t flen = (uint16_t)(((uint16_t)raw[0] << 8) | raw[1]);
+        if ((flen < sizeof(raw)) || (flen > rsr))
+        {
+            // Lost framing (RX overrun): drop everything pending
+            BINLOG_WARN("w5500_socket_macraw_recv_batch: Bad frame length %d with %d pending",
+                        flen, rsr);
+            rd  = (uint16_t)(rd + rsr);
+            ret = W5500_SOCK_BUFFER_ERROR;
+            break;
+        }
+        uint16_t plen = (uint16_t)(flen - sizeof(raw));
+        memcpy(hdr.dst, &raw[2], 6);
+        memcpy(hdr.src, &raw[8], 6);
+        hdr.ethertype = (uint16_t)(((uint16_t)raw[14] << 8) | raw[15]);
+
+        if (((w5500_macraw.ethertype == 0U) || (hdr.ethertype == w5500_macraw.ethertype)) &&
+            ((w5500_macraw.filter == NULL) || w5500_macraw.filter(&hdr, plen, w5500_macraw.ctx)))
+        {
+            w5500_macraw_rx_t *f = &frames[got++];
+            uint16_t n = (plen < f->size) ? plen : f->size;
+
+            if ((n > 0U) && (f->buf != NULL))
+            {
+                uint16_t ptr = (uint16_t)(rd + sizeof(raw));
+                WIZCHIP_READ_BUF(((uint32_t)ptr << 8) + (WIZCHIP_RXBUF_BLOCK(sn) << 3), f->buf, n);
+            }
+            else
+            {
+                n = 0U;
+            }
+            f->hdr       = hdr;
+            f->len       = n;
+            f->truncated = (n < plen);
+            bytes += n;
+        }
+        rd  = (uint16_t)(rd + flen);
+        rsr = (uint16_t)(rsr - flen);
+    }
+
+    if (rd != start)
+    {
+        // One RECV returns the space of every frame walked
+        w5500_spi_lock();
+        setSn_RX_RD(sn, rd);
+        setSn_CR(sn, Sn_CR_RECV);
+        while (getSn_CR(sn))
+        {
+        }
+        w5500_spi_unlock();
+    }
+    w5500_stats_recv(sn, &mark, (ret < 0) ? ret : (int32_t)bytes);
+    return (ret < 0) ? ret : got;
+}
+
+/**
+ * @brief Receive one frame
+ *
+ * @param hdr       Frame header (may be NULL)
+ * @param buf       Payload destination
+ * @param size      Size of @p buf
+ * @return int32_t  Payload bytes stored, 0 if no frame is pending, negative
+ *                  error code on failure
+ */
+int32_t w5500_socket_macraw_recv(w5500_eth_hdr_t *hdr, uint8_t *buf, uint16_t size)
+{
+    w5500_macraw_rx_t frame = { .buf = buf, .size = size };
+    int32_t ret = w5500_socket_macraw_recv_batch(&frame, 1U);
+
+    if (ret <= 0)
+    {
+        return ret;
+    }
+    if (hdr != NULL)
+    {
+        *hdr = frame.hdr;
+    }
+    return frame.len;
+}
+
+/*============================================================================*/
+/* GATHERED SEND                                      */
+/*============================================================================*/
+
+/* Upper bound on one sleep for SENDOK: the INT edge may be missed */
+#define W5500_SENDOK_RECHECK    10U
+
+/**
+ * @brief Wait until the last SEND completes, then clear SENDOK
+ *
+ * @details A SEND that is already done costs one Sn_IR/Sn_SR frame. Otherwise
+ *          SENDOK/TIMEOUT are unmasked for the wait and the task sleeps on
+ *          its event flags (the dispatcher clears and latches them), or on
+ *          osDelay(1) before the dispatcher runs.
+ */
+static int8_t w5500_socket_wait_sendok(uint8_t sock_num)
+{
+    const uint8_t done = Sn_IR_SENDOK | Sn_IR_TIMEOUT;
+    bool unmasked = false;
+    bool irq = false;
+    uint8_t ir = 0U;
+    int8_t ret;
+
+    for (;;)
+    {
+        if ((ir & done) == 0U)
+        {
+            // Sn_IR and Sn_SR in one frame
+            w5500_sock_regs_t regs;
+            w5500_socket_read_window(sock_num, W5500_SREG_IR, 2U, &regs);
+            ir = regs.ir & done;
+            if (ir != 0U)
+            {
+                setSn_IR(sock_num, ir);
+            }
+            else if (regs.sr == SOCK_CLOSED)
+            {
+                ret = W5500_SOCK_ERROR;
+                break;
+            }
+        }
+        if (ir & Sn_IR_SENDOK)
+        {
+            ret = W5500_SOCK_OK;
+            break;
+        }
+        if (ir & Sn_IR_TIMEOUT)
+        {
+            ret = W5500_SOCK_TIMEOUT;
+            break;
+        }
+        if (!unmasked)
+        {
+            // Look at Sn_IR once more: the SEND may complete before the unmask
+            unmasked = true;
+            irq = w5500_irq_unmask(sock_num, W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT);
+        }
+        else if (irq)
+        {
+            ir = (uint8_t)w5500_irq_wait(sock_num, done, W5500_SENDOK_RECHECK);
+        }
+        else
+        {
+            osDelay(1U);
+        }
+    }
+    if (irq)
+    {
+        // Back to Sn_IR polling; also drops anything latched meanwhile
+        w5500_irq_mask(sock_num, W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT);
+    }
+    return ret;
+}
+
+/**
+ * @brief Sum the segment lengths, 0 if the vector is malformed or too long
+ */
+static uint16_t w5500_socket_iov_total(const w5500_iovec_t *iov, uint8_t iovcnt)
+{
+    uint32_t total = 0;
+
+    for (uint8_t i = 0; i < iovcnt; i++)
+    {
+        if ((iov[i].len > 0U) && (iov[i].data == NULL))
+        {
+            return 0;
+        }
+        total += iov[i].len;
+    }
+    return (total > 0xFFFFU) ? 0U : (uint16_t)total;
+}
+
+/**
+ * @brief Wait for TX room, write every segment at Sn_TX_WR and issue one SEND
+ *
+ * @param expect_sr Socket state the send is valid in (besides CLOSE_WAIT for TCP)
+ */
+static int32_t w5500_socket_gather(uint8_t sock_num, const w5500_iovec_t *iov,
+                                   uint8_t iovcnt, uint16_t total, uint8_t expect_sr)
+{
+    w5500_sock_regs_t regs;
+    uint16_t fsr;
+    uint16_t ptr;
+
+    // Free size, pointers and buffer size in one frame; a torn Sn_TX_FSR is
+    // low (see w5500_sock_regs_t), so one read is enough
+    for (;;)
+    {
+        w5500_socket_read_window(sock_num, W5500_SREG_TXBUF_SIZE,
+                                 W5500_SREG_RX_RSR - W5500_SREG_TXBUF_SIZE, &regs);
+        fsr = regs.tx_fsr;
+        ptr = regs.tx_wr;
+        if (total > (uint16_t)(regs.txbuf_size * 1024U))
+        {
+            return W5500_SOCK_BUFFER_ERROR;
+        }
+        if (fsr >= total)
+        {
+            break;
+        }
+        w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+        if ((regs.sr != expect_sr) && (regs.sr != SOCK_CLOSE_WAIT))
+        {
+            return W5500_SOCK_ERROR;
+        }
+        // No room until the peer ACKs: give the bus and the CPU away
+        // rather than spinning on Sn_TX_FSR (SENDOK is not unmasked here)
+        osDelay(1U);
+    }
+
+    // Only this socket's owner advances Sn_TX_WR, so the value read above is
+    // still current; the lock keeps the writes and SEND in one bus transaction
+    w5500_spi_lock();
+    for (uint8_t i = 0; i < iovcnt; i++)
+    {
+        if (iov[i].len == 0U)
+        {
+            continue;
+        }
+        WIZCHIP_WRITE_BUF(((uint32_t)ptr << 8) + (WIZCHIP_TXBUF_BLOCK(sock_num) << 3),
+                          (uint8_t *)iov[i].data, iov[i].len);
+        ptr = (uint16_t)(ptr + iov[i].len);
+    }
+    setSn_TX_WR(sock_num, ptr);
+    setSn_CR(sock_num, Sn_CR_SEND);
+    while (getSn_CR(sock_num))
+    {
+    }
+    w5500_spi_unlock();
+    return total;
+}
+
+/**
+ * @brief Send a message gathered from several segments (TCP)
+ *
+ * @param sock_num  Socket number
+ * @param iov       Segments, sent in order
+ * @param iovcnt    Number of segments
+ * @return int32_t  Number of bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_sendv(uint8_t sock_num, const w5500_iovec_t *iov, uint8_t iovcnt)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_sendv: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((iov == NULL) || (iovcnt == 0U))
+    {
+        BINLOG_WARN("w5500_socket_sendv: No segments");
+        return W5500_SOCK_ERROR;
+    }
+    uint16_t total = w5500_socket_iov_total(iov, iovcnt);
+    if (total == 0U)
+    {
+        BINLOG_WARN("w5500_socket_sendv: Empty or malformed vector on socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
+    if (w5500_sock_sending & (1U << sock_num))
+    {
+        int8_t done = w5500_socket_wait_sendok(sock_num);
+        w5500_sock_sending &= (uint8_t)~(1U << sock_num);
+        if (done != W5500_SOCK_OK)
+        {
+            BINLOG_WARN("w5500_socket_sendv: Previous SEND on socket %d failed, error %d",
+                        sock_num, done);
+            w5500_stats_send(sock_num, &mark, done);
+            return done;
+        }
+    }
+
+    BINLOG_DEBUG("w5500_socket_sendv: Sending %d bytes in %d segments on socket %d",
+                 total, iovcnt, sock_num);
+    int32_t ret = w5500_socket_gather(sock_num, iov, iovcnt, total, SOCK_ESTABLISHED);
+    w5500_stats_send(sock_num, &mark, ret);
+    if (ret < 0)
+    {
+        BINLOG_WARN("w5500_socket_sendv: Failed to send on socket %d, error %d", sock_num, ret);
+        return ret;
+    }
+    w5500_sock_sending |= (uint8_t)(1U << sock_num);
+    return ret;
+}
+
+/**
+ * @brief Send one UDP datagram gathered from several segments
+ *
+ * @param sock_num  Socket number
+ * @param iov       Segments, sent in order
+ * @param iovcnt    Number of segments
+ * @param dest_ip   Destination IP address (4 bytes)
+ * @param dest_port Destination port
+ * @return int32_t  Number of bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_sendtov(uint8_t sock_num, const w5500_iovec_t *iov, uint8_t iovcnt,
+                             const uint8_t *dest_ip, uint16_t dest_port)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_sendtov: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((iov == NULL) || (iovcnt == 0U) || (dest_ip == NULL) || (dest_port == 0U))
+    {
+        BINLOG_WARN("w5500_socket_sendtov: Bad arguments on socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    uint16_t total = w5500_socket_iov_total(iov, iovcnt);
+    if (total == 0U)
+    {
+        BINLOG_WARN("w5500_socket_sendtov: Empty or malformed vector on socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+
+    BINLOG_DEBUG("w5500_socket_sendtov: Sending %d bytes in %d segments to %d.%d.%d.%d:%d on socket %d",
+                 total, iovcnt, dest_ip[0], dest_ip[1], dest_ip[2], dest_ip[3], dest_port, sock_num);
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
+    setSn_DIPR(sock_num, (uint8_t *)dest_ip);
+    setSn_DPORT(sock_num, dest_port);
+    int32_t ret = w5500_socket_gather(sock_num, iov, iovcnt, total, SOCK_UDP);
+    if (ret >= 0)
+    {
+        int8_t done = w5500_socket_wait_sendok(sock_num);
+        if (done != W5500_SOCK_OK)
+        {
+            ret = done;
+        }
+    }
+    w5500_stats_send(sock_num, &mark, ret);
+    if (ret < 0)
+    {
+        BINLOG_WARN("w5500_socket_sendtov: Failed to send on socket %d, error %d", sock_num, ret);
+    }
+    return ret;
+}
+
+/*============================================================================*/
+/* ASYNCHRONOUS TCP SEND                              */
+/*============================================================================*/
+
+/* Re-check period of w5500_socket_send_wait(): a latched SENDOK can be taken
+ * by another waiter on the same socket (w5500_socket_poll) */
+#define W5500_SEND_RECHECK      10U
+
+/* Forget the async state and give SENDOK/TIMEOUT back to the ioLibrary */
+static void w5500_socket_async_reset(uint8_t sock_num)
+{
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+
+    w5500_spi_lock();
+    if (tx->irq)
+    {
+        w5500_irq_mask(sock_num, W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT);
+    }
+    memset(tx, 0, sizeof(*tx));
+    w5500_spi_unlock();
+}
+
+/* Cover everything queued with one SEND; w5500_spi_lock() held */
+static void w5500_socket_async_issue(uint8_t sock_num)
+{
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+
+    setSn_TX_WR(sock_num, tx->wr);
+    setSn_CR(sock_num, Sn_CR_SEND);
+    while (getSn_CR(sock_num))
+    {
+    }
+    tx->issued    = tx->queued;
+    tx->in_flight = true;
+}
+
+/**
+ * @brief SENDOK/TIMEOUT hook of the INT dispatcher (w5500_irq)
+ *
+ * @param sock_num  Socket number
+ * @param ir        Sn_IR bits read and cleared by the dispatcher
+ */
+void w5500_socket_on_send_event(uint8_t sock_num, uint8_t ir)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        return;
+    }
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+
+    w5500_spi_lock();
+    if (tx->active && tx->in_flight)
+    {
+        if (ir & Sn_IR_TIMEOUT)
+        {
+            // The chip closed the socket: nothing queued will go out
+            tx->in_flight = false;
+            tx->active    = false;
+            tx->error     = W5500_SOCK_TIMEOUT;
+            BINLOG_WARN("w5500_socket_on_send_event: Socket %d retransmission timeout", sock_num);
+        }
+        else if (ir & Sn_IR_SENDOK)
+        {
+            tx->done      = tx->issued;
+            tx->in_flight = false;
+            if (tx->queued != tx->issued)
+            {
+                w5500_socket_async_issue(sock_num);
+            }
+        }
+    }
+    w5500_spi_unlock();
+}
+
+/* A SEND in flight on a socket that closed without TIMEOUT (RST, or
+ * closed under us) never gets its SENDOK: fail it; w5500_spi_lock() held */
+static void w5500_socket_async_check_closed(uint8_t sock_num)
+{
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+    w5500_sock_regs_t regs;
+
+    if (!tx->active || !tx->in_flight)
+    {
+        return;
+    }
+    w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+    if (regs.sr == SOCK_CLOSED)
+    {
+        // Read, not cleared: TIMEOUT may still be on its way to the dispatcher
+        tx->in_flight = false;
+        tx->active    = false;
+        tx->error     = (getSn_IR(sock_num) & Sn_IR_TIMEOUT) ? W5500_SOCK_TIMEOUT : W5500_SOCK_ERROR;
+        BINLOG_WARN("w5500_socket_send_status: Socket %d closed with a SEND in flight", sock_num);
+    }
+}
+
+/**
+ * @brief Low-rate poller for sockets whose SENDOK is not dispatched on INT
+ *
+ * @param sock_num  Socket number
+ */
+void w5500_socket_send_poll(uint8_t sock_num)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        return;
+    }
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+
+    w5500_spi_lock();
+    if (tx->active && tx->in_flight && !tx->irq)
+    {
+        uint8_t ir = getSn_IR(sock_num) & (Sn_IR_SENDOK | Sn_IR_TIMEOUT);
+        if (ir != 0U)
+        {
+            setSn_IR(sock_num, ir);
+            w5500_socket_on_send_event(sock_num, ir);
+        }
+        w5500_socket_async_check_closed(sock_num);
+    }
+    w5500_spi_unlock();
+}
+
+/* Writable bytes; w5500_spi_lock() held */
+static uint16_t w5500_socket_async_room(uint8_t sock_num)
+{
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+    w5500_sock_regs_t regs;
+
+    // Sn_TX_FSR counts issued data only; queued bytes past Sn_TX_WR are ours
+    w5500_socket_read_window(sock_num, W5500_SREG_TX_FSR, 2U, &regs);
+    uint32_t pending = tx->queued - tx->issued;
+    return (regs.tx_fsr > pending) ? (uint16_t)(regs.tx_fsr - pending) : 0U;
+}
+
+/**
+ * @brief Queue data into a TCP socket's TX ring without waiting for the wire
+ *
+ * @param sock_num  Socket number
+ * @param buffer    Data to queue
+ * @param len       Length of data
+ * @param token     Completion token of the last queued byte (may be NULL)
+ * @return int32_t  Bytes queued (0 if the ring is full), negative error code
+ *                  on failure
+ */
+int32_t w5500_socket_send_async(uint8_t sock_num, const uint8_t *buffer, uint16_t len,
+                                w5500_send_token_t *token)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_send_async: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if (buffer == NULL)
+    {
+        BINLOG_WARN("w5500_socket_send_async: Buffer is NULL");
+        return W5500_SOCK_ERROR;
+    }
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+    w5500_sock_regs_t regs;
+    w5500_stats_mark_t mark;
+    int32_t ret;
+
+    w5500_stats_begin(&mark);
+    w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+    if ((regs.sr != SOCK_ESTABLISHED) && (regs.sr != SOCK_CLOSE_WAIT))
+    {
+        BINLOG_WARN("w5500_socket_send_async: Socket %d not connected (0x%02X)", sock_num, regs.sr);
+        ret = (tx->error != W5500_SOCK_OK) ? tx->error : W5500_SOCK_ERROR;
+        w5500_stats_send(sock_num, &mark, ret);
+        return ret;
+    }
+
+    w5500_spi_lock();
+    if (!tx->active)
+    {
+        // First async send since open: take over SENDOK/TIMEOUT
+        w5500_socket_read_window(sock_num, W5500_SREG_TX_WR, 2U, &regs);
+        tx->wr     = regs.tx_wr;
+        tx->irq    = w5500_irq_unmask(sock_num, W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT);
+        tx->active = true;
+    }
+    if (!tx->irq)
+    {
+        w5500_socket_send_poll(sock_num);
+    }
+    if (tx->error != W5500_SOCK_OK)
+    {
+        ret = tx->error;
+        w5500_spi_unlock();
+        w5500_stats_send(sock_num, &mark, ret);
+        return ret;
+    }
+
+    uint16_t room = w5500_socket_async_room(sock_num);
+    uint16_t n = (len < room) ? len : room;
+    if (n > 0U)
+    {
+        // Past Sn_TX_WR the chip does not look at the ring until the next SEND
+        WIZCHIP_WRITE_BUF(((uint32_t)tx->wr << 8) + (WIZCHIP_TXBUF_BLOCK(sock_num) << 3),
+                          (uint8_t *)buffer, n);
+        tx->wr      = (uint16_t)(tx->wr + n);
+        tx->queued += n;
+        if (!tx->in_flight)
+        {
+            w5500_socket_async_issue(sock_num);
+        }
+    }
+    if (token != NULL)
+    {
+        *token = tx->queued;
+    }
+    w5500_spi_unlock();
+    w5500_stats_send(sock_num, &mark, n);
+
+    BINLOG_DEBUG("w5500_socket_send_async: Socket %d queued %d of %d bytes", sock_num, n, len);
+    return n;
+}
+
+/**
+ * @brief Bytes w5500_socket_send_async() would accept now
+ *
+ * @param sock_num  Socket number
+ * @return uint16_t Writable bytes
+ */
+uint16_t w5500_socket_send_writable(uint8_t sock_num)
+{
+    uint16_t room;
+
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_send_writable: Invalid socket number %d", sock_num);
+        return 0;
+    }
+    w5500_spi_lock();
+    if (!w5500_tx_async[sock_num].irq)
+    {
+        w5500_socket_send_poll(sock_num);
+    }
+    room = w5500_socket_async_room(sock_num);
+    w5500_spi_unlock();
+    return room;
+}
+
+/**
+ * @brief Check whether the data up to a token has been sent
+ *
+ * @param sock_num  Socket number
+ * @param token     Token from w5500_socket_send_async()
+ * @return int8_t   W5500_SOCK_OK when sent, W5500_SOCK_BUSY while pending,
+ *                  W5500_SOCK_TIMEOUT after a retransmission timeout,
+ *                  W5500_SOCK_ERROR if the socket closed otherwise (RST)
+ */
+int8_t w5500_socket_send_status(uint8_t sock_num, w5500_send_token_t token)
+{
+    int8_t ret;
+
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_send_status: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    w5500_tx_async_t *tx = &w5500_tx_async[sock_num];
+
+    w5500_spi_lock();
+    if (!tx->irq)
+    {
+        w5500_socket_send_poll(sock_num);
+    }
+    else
+    {
+        w5500_socket_async_check_closed(sock_num);
+    }
+    if ((int32_t)(tx->done - token) >= 0)
+    {
+        ret = W5500_SOCK_OK;
+    }
+    else if (tx->error != W5500_SOCK_OK)
+    {
+        ret = tx->error;
+    }
+    else
+    {
+        ret = W5500_SOCK_BUSY;
+    }
+    w5500_spi_unlock();
+    return ret;
+}
+
+/**
+ * @brief Block until the data up to a token has been sent
+ *
+ * @param sock_num  Socket number
+ * @param token     Token from w5500_socket_send_async()
+ * @param timeout   Timeout in kernel ticks (0 = check once, osWaitForever)
+ * @return int8_t   As w5500_socket_send_status(), W5500_SOCK_BUSY on timeout;
+ *                  a socket that closes ends the wait within
+ *                  W5500_SEND_RECHECK ticks whatever the timeout
+ */
+int8_t w5500_socket_send_wait(uint8_t sock_num, w5500_send_token_t token, uint32_t timeout)
+{
+    uint32_t start = osKernelGetTickCount();
+
+    for (;;)
+    {
+        int8_t ret = w5500_socket_send_status(sock_num, token);
+        if ((ret != W5500_SOCK_BUSY) || (timeout == 0U))
+        {
+            return ret;
+        }
+
+        uint32_t wait = W5500_SEND_RECHECK;
+        if (timeout != osWaitForever)
+        {
+            uint32_t elapsed = osKernelGetTickCount() - start;
+            if (elapsed >= timeout)
+            {
+                return W5500_SOCK_BUSY;
+            }
+            if ((timeout - elapsed) < wait)
+            {
+                wait = timeout - elapsed;
+            }
+        }
+        if (w5500_tx_async[sock_num].irq)
+        {
+            (void)w5500_irq_wait(sock_num, W5500_IRQ_SENDOK | W5500_IRQ_TIMEOUT, wait);
+        }
+        else
+        {
+            osDelay(1U);
+        }
+    }
+}
+
+/*============================================================================*/
+/* ZERO-COPY RECEIVE                                  */
+/*============================================================================*/
+
+/* Sn_RX_RD is a free-running 16-bit pointer; the buffer size is a power of
+ * two, so the offset in the buffer is its low bits */
+static void w5500_socket_span_split(w5500_rx_span_t *span)
+{
+    uint16_t offset = span->rd & (uint16_t)(span->size - 1U);
+    uint16_t to_end = (uint16_t)(span->size - offset);
+
+    span->nseg = 0;
+    if (span->len == 0U)
+    {
+        return;
+    }
+    span->seg[0].offset = offset;
+    span->seg[0].len    = (span->len < to_end) ? span->len : to_end;
+    span->nseg = 1;
+    if (span->len > to_end)
+    {
+        span->seg[1].offset = 0;
+        span->seg[1].len    = (uint16_t)(span->len - to_end);
+        span->nseg = 2;
+    }
+}
+
+/**
+ * @brief Snapshot the readable span of a socket's RX ring without copying
+ *
+ * @param sock_num  Socket number
+ * @param span      Readable span, len == 0 if nothing is pending
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_peek(uint8_t sock_num, w5500_rx_span_t *span)
+{
+    w5500_sock_regs_t regs;
+
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_peek: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if (span == NULL)
+    {
+        BINLOG_WARN("w5500_socket_peek: span is NULL");
+        return W5500_SOCK_ERROR;
+    }
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
+    // Buffer size and both pointers from one frame: the span is consistent
+    w5500_socket_read_window(sock_num, W5500_SREG_RXBUF_SIZE,
+                             W5500_SREG_BLOCK_LEN - W5500_SREG_RXBUF_SIZE, &regs);
+    w5500_stats_spi(sock_num, &mark);
+    if (regs.rxbuf_size == 0U)
+    {
+        BINLOG_WARN("w5500_socket_peek: Socket %d has no RX buffer", sock_num);
+        return W5500_SOCK_BUFFER_ERROR;
+    }
+    span->rd   = regs.rx_rd;
+    span->len  = (uint16_t)(regs.rx_wr - regs.rx_rd);
+    span->size = (uint16_t)(regs.rxbuf_size * 1024U);
+    w5500_socket_span_split(span);
+    BINLOG_DEBUG("w5500_socket_peek: Socket %d has %d bytes in %d segments",
+                 sock_num, span->len, span->nseg);
+    return W5500_SOCK_OK;
+}
+
+/**
+ * @brief Read bytes of a peeked span straight from the chip
+ *
+ * @param sock_num  Socket number
+ * @param span      Span from w5500_socket_peek()
+ * @param pos       Position in the span (0 = first unconsumed byte)
+ * @param dst       Destination for the bytes
+ * @param len       Bytes wanted, clamped to the end of the span
+ * @return int32_t  Number of bytes read, negative error code on failure
+ */
+int32_t w5500_socket_peek_read(uint8_t sock_num, const w5500_rx_span_t *span,
+                               uint16_t pos, uint8_t *dst, uint16_t len)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_peek_read: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((span == NULL) || (dst == NULL))
+    {
+        BINLOG_WARN("w5500_socket_peek_read: span or dst is NULL");
+        return W5500_SOCK_ERROR;
+    }
+    if (pos >= span->len)
+    {
+        return 0;
+    }
+    if (len > (uint16_t)(span->len - pos))
+    {
+        len = (uint16_t)(span->len - pos);
+    }
+    if (len > 0U)
+    {
+        uint16_t ptr = (uint16_t)(span->rd + pos);
+        w5500_stats_mark_t mark;
+        w5500_stats_begin(&mark);
+        WIZCHIP_READ_BUF(((uint32_t)ptr << 8) + (WIZCHIP_RXBUF_BLOCK(sock_num) << 3), dst, len);
+        w5500_stats_spi(sock_num, &mark);
+    }
+    return len;
+}
+
+/**
+ * @brief Release the first bytes of a span back to the chip (RECV command)
+ *
+ * @param sock_num  Socket number
+ * @param span      Span from w5500_socket_peek(), advanced past the bytes
+ * @param len       Bytes consumed, at most span->len
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_consume(uint8_t sock_num, w5500_rx_span_t *span, uint16_t len)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_consume: Invalid socket number %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    if ((span == NULL) || (len > span->len))
+    {
+        BINLOG_WARN("w5500_socket_consume: Socket %d cannot consume %d bytes", sock_num, len);
+        return W5500_SOCK_ERROR;
+    }
+    if (len == 0U)
+    {
+        return W5500_SOCK_OK;
+    }
+    w5500_stats_mark_t mark;
+    w5500_stats_begin(&mark);
+    // Pointer update and RECV must not interleave with another task's frames
+    w5500_spi_lock();
+    span->rd  = (uint16_t)(span->rd + len);
+    span->len = (uint16_t)(span->len - len);
+    setSn_RX_RD(sock_num, span->rd);
+    setSn_CR(sock_num, Sn_CR_RECV);
+    while (getSn_CR(sock_num))
+    {
+    }
+    w5500_spi_unlock();
+    w5500_stats_spi(sock_num, &mark);
+    w5500_sock_stats[sock_num].rx_bytes += len;
+    w5500_sock_stats[sock_num].rx_packets++;
+
+    w5500_socket_span_split(span);
+    return W5500_SOCK_OK;
+}
+
+/*============================================================================*/
+/* SOCKET MULTIPLEXING                                */
+/*============================================================================*/
+
+/* Upper bound on one sleep while POLLOUT/POLLSENT is pending on a socket
+ * whose SENDOK is not dispatched on INT: nothing wakes the poller for it */
+#define W5500_POLL_TX_RECHECK   1U
+
+/* Sn_IR bits behind each edge event. TIMEOUT is not one of them: taking
+ * and clearing it here would steal it from a sender waiting for its SEND
+ * (ioLibrary send/sendto, sendv, send_async); a timed-out socket is
+ * reported through Sn_SR instead */
+static uint8_t w5500_poll_ir_mask(uint8_t events)
+{
+    uint8_t mask = 0;
+
+    if (events & W5500_POLLIN)
+    {
+        mask |= Sn_IR_RECV;
+    }
+    if (events & W5500_POLLCON)
+    {
+        mask |= Sn_IR_CON;
+    }
+    if (events & W5500_POLLHUP)
+    {
+        mask |= Sn_IR_DISCON;
+    }
+    return mask;
+}
+
+static uint8_t w5500_poll_from_ir(uint8_t ir)
+{
+    uint8_t revents = 0;
+
+    if (ir & Sn_IR_RECV)
+    {
+        revents |= W5500_POLLIN;
+    }
+    if (ir & Sn_IR_CON)
+    {
+        revents |= W5500_POLLCON;
+    }
+    if (ir & Sn_IR_DISCON)
+    {
+        revents |= W5500_POLLHUP;
+    }
+    return revents;
+}
+
+/**
+ * @brief Wait until any socket of a set is ready
+ *
+ * @param fds       Sockets and events of interest, revents filled in
+ * @param nfds      Number of entries in @p fds
+ * @param timeout   Timeout in kernel ticks (0 = check once, osWaitForever)
+ * @return int32_t  Number of entries with revents set, 0 on timeout,
+ *                  negative error code on failure
+ */
+int32_t w5500_socket_poll(w5500_pollfd_t *fds, uint8_t nfds, uint32_t timeout)
+{
+    uint8_t sock_mask = 0;
+    uint8_t flagged = 0xFFU;    // First pass: look at every socket once
+    bool want_tx = false;
+
+    if ((fds == NULL) || (nfds == 0U))
+    {
+        BINLOG_WARN("w5500_socket_poll: Empty socket set");
+        return W5500_SOCK_ERROR;
+    }
+    for (uint8_t i = 0; i < nfds; i++)
+    {
+        if (fds[i].sock_num >= W5500_MAX_SOCKET)
+        {
+            BINLOG_WARN("w5500_socket_poll: Invalid socket number %d", fds[i].sock_num);
+            return W5500_SOCK_ERROR;
+        }
+        sock_mask |= (uint8_t)(1U << fds[i].sock_num);
+        want_tx = want_tx || (((fds[i].events & (W5500_POLLOUT | W5500_POLLSENT)) != 0U) &&
+                              !w5500_tx_async[fds[i].sock_num].irq);
+    }
+
+    uint32_t start = osKernelGetTickCount();
+    for (;;)
+    {
+        int32_t ready = 0;
+        uint8_t sir = getSIR();
+
+        // Level checks only for sockets with something on the chip or
+        // latched since the last pass
+        flagged |= sir;
+
+        for (uint8_t i = 0; i < nfds; i++)
+        {
+            uint8_t sn = fds[i].sock_num;
+            uint8_t want = w5500_poll_ir_mask(fds[i].events);
+            uint8_t ir = 0;
+
+            if (want != 0U)
+            {
+                // Latched by the dispatcher: no SPI
+                ir = (uint8_t)w5500_irq_wait(sn, want, 0);
+                // Still on the chip: not dispatched yet, or masked from INT
+                if (sir & (1U << sn))
+                {
+                    uint8_t chip = getSn_IR(sn) & want;
+                    if (chip != 0U)
+                    {
+                        setSn_IR(sn, chip);
+                        ir |= chip;
+                    }
+                }
+            }
+            fds[i].revents = w5500_poll_from_ir(ir);
+            bool look = (flagged & (1U << sn)) != 0U;
+            if ((fds[i].events & W5500_POLLHUP) && !(fds[i].revents & W5500_POLLHUP) && look)
+            {
+                // Closed by the chip (RST, ARP/TCP timeout): Sn_SR, not Sn_IR
+                w5500_sock_regs_t regs;
+                w5500_socket_read_window(sn, W5500_SREG_SR, 1U, &regs);
+                if (regs.sr == SOCK_CLOSED)
+                {
+                    fds[i].revents |= W5500_POLLHUP;
+                }
+            }
+            // Without SENDOK on INT, free space shows up only on the recheck
+            if ((fds[i].events & W5500_POLLOUT) && (look || !w5500_tx_async[sn].irq))
+            {
+                w5500_sock_regs_t regs;
+                w5500_socket_read_window(sn, W5500_SREG_TX_FSR, 2U, &regs);
+                if (regs.tx_fsr != 0U)
+                {
+                    fds[i].revents |= W5500_POLLOUT;
+                }
+            }
+            if (fds[i].events & W5500_POLLSENT)
+            {
+                w5500_tx_async_t *tx = &w5500_tx_async[sn];
+                if (tx->irq)
+                {
+                    // Latched only: Sn_IR SENDOK belongs to the dispatcher,
+                    // which completes the SEND before it latches the event
+                    if (w5500_irq_wait(sn, W5500_IRQ_SENDOK, 0) != 0U)
+                    {
+                        fds[i].revents |= W5500_POLLSENT;
+                    }
+                }
+                else
+                {
+                    uint32_t done = tx->done;
+                    w5500_socket_send_poll(sn);
+                    if ((tx->done != done) || (tx->error != W5500_SOCK_OK))
+                    {
+                        fds[i].revents |= W5500_POLLSENT;
+                    }
+                }
+            }
+            if (fds[i].revents != 0U)
+            {
+                ready++;
+            }
+        }
+        if ((ready > 0) || (timeout == 0U))
+        {
+            return ready;
+        }
+
+        uint32_t wait = osWaitForever;
+        if (timeout != osWaitForever)
+        {
+            uint32_t elapsed = osKernelGetTickCount() - start;
+            if (elapsed >= timeout)
+            {
+                return 0;
+            }
+            wait = timeout - elapsed;
+        }
+        if (want_tx && (wait > W5500_POLL_TX_RECHECK))
+        {
+            wait = W5500_POLL_TX_RECHECK;
+        }
+        flagged = (uint8_t)w5500_irq_wait_any(sock_mask, wait);
+    }
+}
+
+/*============================================================================*/
+/* SOCKET STATUS                                      */
+/*============================================================================*/
+
+/**
+ * @brief Get socket status
+ *
+ * @param sock_num  Socket number
+ * @return uint8_t  Socket status code (see socket.h for Sn_SR_* defines)
+ */
+uint8_t w5500_socket_get_status(uint8_t sock_num)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_get_status: Invalid socket number %d", sock_num);
+        return 0xFF; // Indicate error with an invalid status code
+    }
+    w5500_sock_regs_t regs;
+    w5500_socket_read_window(sock_num, W5500_SREG_SR, 1U, &regs);
+    BINLOG_DEBUG("w5500_socket_get_status: Socket %d current status: 0x%02X", sock_num, regs.sr);
+    return regs.sr;
+}
+
+/**
+ * @brief Get the amount of free transmit buffer size on a socket
+ *
+ * @param sock_num  Socket number
+ * @return uint16_t Free TX buffer size in bytes
+ */
+uint16_t w5500_socket_get_tx_buf_free_size(uint8_t sock_num)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_get_tx_buf_free_size: Invalid socket number %d", sock_num);
+        return 0;
+    }
+    // One 2-byte burst instead of getSn_TX_FSR's read-until-stable loop;
+    // a torn read can only under-report (see w5500_sock_regs_t).
+    w5500_sock_regs_t regs;
+    w5500_socket_read_window(sock_num, W5500_SREG_TX_FSR, 2U, &regs);
+    BINLOG_DEBUG("w5500_socket_get_tx_buf_free_size: Socket %d TX free size: %d", sock_num, regs.tx_fsr);
+    return regs.tx_fsr;
+}
+
+/**
+ * @brief Get the amount of received data in the RX buffer of a socket
+ *
+ * @param sock_num  Socket number
+ * @return uint16_t RX buffer size in bytes
+ */
+uint16_t w5500_socket_get_rx_buf_size(uint8_t sock_num)
+{
+    if (sock_num >= W5500_MAX_SOCKET)
+    {
+        BINLOG_WARN("w5500_socket_get_rx_buf_size: Invalid socket number %d", sock_num);
+        return 0;
+    }
+    // One 2-byte burst instead of getSn_RX_RSR's read-until-stable loop;
+    // a torn read can only under-report (see w5500_sock_regs_t).
+    w5500_sock_regs_t regs;
+    w5500_socket_read_window(sock_num, W5500_SREG_RX_RSR, 2U, &regs);
+    BINLOG_DEBUG("w5500_socket_get_rx_buf_size: Socket %d RX size: %d", sock_num, regs.rx_rsr);
+    return regs.rx_rsr;
+}
+
+/*============================================================================*/
+/* SOCKET MEMORY PROFILES                             */
+/*============================================================================*/
+
+static const w5500_mem_layout_t w5500_mem_profiles[W5500_MEM_PROFILE_COUNT] = {
+    [W5500_MEM_BALANCED] = {
+        .name  = "balanced",
+        .tx_kb = {2, 2, 2, 2, 2, 2, 2, 2},
+        .rx_kb = {2, 2, 2, 2, 2, 2, 2, 2},
+    },
+    // One stream socket (2) with 8 KB in flight each way; the 1 KB sockets
+    // are for DHCP/DNS/SNTP datagrams, ICMP goes to socket 3 (see the header)
+    [W5500_MEM_BULK_STREAM] = {
+        .name  = "bulk-stream",
+        .tx_kb = {1, 1, 8, 2, 1, 1, 1, 1},
+        .rx_kb = {1, 1, 8, 2, 1, 1, 1, 1},
+    },
+    // 2 KB sockets 2..7 for HTTP (W5500_HTTP_MAX_CONN) and ICMP; responses
+    // are larger than requests, so the first one (2) gets 4 KB TX
+    [W5500_MEM_HTTP_CLIENTS] = {
+        .name  = "http-clients",
+        .tx_kb = {1, 1, 4, 2, 2, 2, 2, 2},
+        .rx_kb = {1, 1, 2, 2, 2, 2, 2, 2},
+    },
+};
+
+static bool w5500_mem_size_valid(uint8_t kb)
+{
+    return (kb == 0U) || (kb == 1U) || (kb == 2U) || (kb == 4U) || (kb == 8U) || (kb == 16U);
+}
+
+/**
+ * @brief Get the layout of a named profile
+ *
+ * @param profile   Profile
+ * @return const w5500_mem_layout_t*  Layout, NULL for an unknown profile
+ */
+const w5500_mem_layout_t *w5500_socket_get_profile(w5500_mem_profile_t profile)
+{
+    if ((unsigned)profile >= W5500_MEM_PROFILE_COUNT)
+    {
+        return NULL;
+    }
+    return &w5500_mem_profiles[profile];
+}
+
+/**
+ * @brief Re-partition the socket buffer memory at runtime
+ *
+ * @param layout    New layout
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_apply_layout(const w5500_mem_layout_t *layout)
+{
+    uint16_t tx_total = 0;
+    uint16_t rx_total = 0;
+
+    if (layout == NULL)
+    {
+        BINLOG_WARN("w5500_socket_apply_layout: layout is NULL");
+        return W5500_SOCK_ERROR;
+    }
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        if (!w5500_mem_size_valid(layout->tx_kb[sn]) || !w5500_mem_size_valid(layout->rx_kb[sn]))
+        {
+            BINLOG_WARN("w5500_socket_apply_layout: Socket %d size %d/%d KB not supported",
+                        sn, layout->tx_kb[sn], layout->rx_kb[sn]);
+            return W5500_SOCK_BUFFER_ERROR;
+        }
+        tx_total += layout->tx_kb[sn];
+        rx_total += layout->rx_kb[sn];
+    }
+    if ((tx_total > 16U) || (rx_total > 16U))
+    {
+        BINLOG_WARN("w5500_socket_apply_layout: %d/%d KB exceeds 16 KB", tx_total, rx_total);
+        return W5500_SOCK_BUFFER_ERROR;
+    }
+
+    w5500_spi_lock();
+    // Buffers are allocated in socket order: compare bases as well as sizes
+    uint16_t cur_tx_base = 0, cur_rx_base = 0;
+    uint16_t new_tx_base = 0, new_rx_base = 0;
+    uint8_t changed = 0;
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        w5500_sock_regs_t regs;
+        // Sn_SR .. Sn_TXBUF_SIZE in one frame
+        w5500_socket_read_window(sn, W5500_SREG_SR,
+                                 W5500_SREG_TX_FSR - W5500_SREG_SR, &regs);
+        bool moved = (cur_tx_base != new_tx_base) || (regs.txbuf_size != layout->tx_kb[sn]) ||
+                     (cur_rx_base != new_rx_base) || (regs.rxbuf_size != layout->rx_kb[sn]);
+        if (moved && (regs.sr != SOCK_CLOSED))
+        {
+            w5500_spi_unlock();
+            BINLOG_WARN("w5500_socket_apply_layout: Socket %d is open (0x%02X), buffers would move",
+                        sn, regs.sr);
+            return W5500_SOCK_BUSY;
+        }
+        if (moved)
+        {
+            changed |= (uint8_t)(1U << sn);
+        }
+        cur_tx_base += regs.txbuf_size;
+        cur_rx_base += regs.rxbuf_size;
+        new_tx_base += layout->tx_kb[sn];
+        new_rx_base += layout->rx_kb[sn];
+    }
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        if (changed & (1U << sn))
+        {
+            setSn_TXBUF_SIZE(sn, layout->tx_kb[sn]);
+            setSn_RXBUF_SIZE(sn, layout->rx_kb[sn]);
+        }
+    }
+    w5500_spi_unlock();
+
+    BINLOG_INFO("w5500_socket_apply_layout: %d/%d KB TX/RX, sockets 0x%02X resized",
+                tx_total, rx_total, changed);
+    return W5500_SOCK_OK;
+}
+
+/**
+ * @brief Apply a named profile
+ *
+ * @param profile   Profile
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_apply_profile(w5500_mem_profile_t profile)
+{
+    const w5500_mem_layout_t *layout = w5500_socket_get_profile(profile);
+
+    if (layout == NULL)
+    {
+        BINLOG_WARN("w5500_socket_apply_profile: Unknown profile %d", profile);
+        return W5500_SOCK_ERROR;
+    }
+    return w5500_socket_apply_layout(layout);
+}
+
+/*============================================================================*/
+/* SOCKET STATISTICS                                  */
+/*============================================================================*/
+
+/* A handful of adds and two DWT reads per call: cheap enough to stay in.
+ * SPI cost is the W5500 bus client's counters accrued between begin and end,
+ * so frames another task squeezes in between are charged to this socket too;
+ * sockets driven from one task are exact. */
+
+static void w5500_stats_begin(w5500_stats_mark_t *mark)
+{
+    const spi_client_t *client = w5500_spi_get_client();
+
+    mark->spi_bytes  = client->bytes;
+    mark->spi_cycles = client->hold_cycles;
+    mark->cycles     = SPI_BUS_CYCLES();
+}
+
+static void w5500_stats_spi(uint8_t sock_num, const w5500_stats_mark_t *mark)
+{
+    const spi_client_t *client = w5500_spi_get_client();
+    w5500_sock_stats_t *st = &w5500_sock_stats[sock_num];
+
+    st->spi_bytes  += client->bytes - mark->spi_bytes;
+    st->spi_cycles += client->hold_cycles - mark->spi_cycles;
+}
+
+/* Latency sample of a call that moved data, error count of one that failed */
+static void w5500_stats_call(uint8_t sock_num, const w5500_stats_mark_t *mark,
+                             w5500_latency_stats_t *lat, int32_t ret)
+{
+    uint32_t cycles = SPI_BUS_CYCLES() - mark->cycles;
+
+    w5500_stats_spi(sock_num, mark);
+    if (ret < 0)
+    {
+        uint32_t idx = (uint32_t)(-ret) - 1U;
+        if (idx < W5500_STATS_ERR_COUNT)
+        {
+            w5500_sock_stats[sock_num].errors[idx]++;
+        }
+        return;
+    }
+    if (ret == 0)
+    {
+        return;
+    }
+
+    w5500_socket_latency_add(lat, cycles);
+}
+
+/**
+ * @brief Add one sample to latency counters
+ *
+ * @param lat       Latency counters
+ * @param cycles    Sample in DWT cycles
+ */
+void w5500_socket_latency_add(w5500_latency_stats_t *lat, uint32_t cycles)
+{
+    if ((lat->count == 0U) || (cycles < lat->min_cycles))
+    {
+        lat->min_cycles = cycles;
+    }
+    if (cycles > lat->max_cycles)
+    {
+        lat->max_cycles = cycles;
+    }
+    lat->count++;
+    lat->sum_cycles += cycles;
+
+    uint32_t bucket = 0U;
+    uint32_t scaled = cycles >> W5500_STATS_HIST_SHIFT;
+    while ((scaled != 0U) && (bucket < (W5500_STATS_HIST_BUCKETS - 1U)))
+    {
+        scaled >>= 1;
+        bucket++;
+    }
+    if (lat->hist[bucket] == UINT16_MAX)
+    {
+        for (uint32_t i = 0; i < W5500_STATS_HIST_BUCKETS; i++)
+        {
+            lat->hist[i] >>= 1;
+        }
+    }
+    lat->hist[bucket]++;
+}
+
+static void w5500_stats_send(uint8_t sock_num, const w5500_stats_mark_t *mark, int32_t ret)
+{
+    w5500_sock_stats_t *st = &w5500_sock_stats[sock_num];
+
+    w5500_stats_call(sock_num, mark, &st->send, ret);
+    if (ret > 0)
+    {
+        st->tx_bytes += (uint32_t)ret;
+        st->tx_packets++;
+    }
+}
+
+static void w5500_stats_recv(uint8_t sock_num, const w5500_stats_mark_t *mark, int32_t ret)
+{
+    w5500_sock_stats_t *st = &w5500_sock_stats[sock_num];
+
+    w5500_stats_call(sock_num, mark, &st->recv, ret);
+    if (ret > 0)
+    {
+        st->rx_bytes += (uint32_t)ret;
+        st->rx_packets++;
+    }
+}
+
+/* ioLibrary SOCKERR_* codes overlap w5500_sock_error_t: count timeouts and
+ * oversized requests under their own codes, everything else as an error */
+static int32_t w5500_stats_iolib_err(int32_t ret)
+{
+    if (ret >= 0)
+    {
+        return ret;
+    }
+    if (ret == SOCKERR_TIMEOUT)
+    {
+        return W5500_SOCK_TIMEOUT;
+    }
+    if (ret == SOCKERR_DATALEN)
+    {
+        return W5500_SOCK_BUFFER_ERROR;
+    }
+    return W5500_SOCK_ERROR;
+}
+
+/**
+ * @brief Copy a socket's traffic and latency counters
+ *
+ * @param sock_num  Socket number
+ * @param stats     Counters
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_get_stats(uint8_t sock_num, w5500_sock_stats_t *stats)
+{
+    if ((sock_num >= W5500_MAX_SOCKET) || (stats == NULL))
+    {
+        BINLOG_WARN("w5500_socket_get_stats: Bad arguments for socket %d", sock_num);
+        return W5500_SOCK_ERROR;
+    }
+    *stats = w5500_sock_stats[sock_num];
+    return W5500_SOCK_OK;
+}
+
+/**
+ * @brief Zero a socket's counters
+ *
+ * @param sock_num  Socket number, W5500_SOCK_ANY for every socket
+ */
+void w5500_socket_reset_stats(uint8_t sock_num)
+{
+    if (sock_num == W5500_SOCK_ANY)
+    {
+        memset(w5500_sock_stats, 0, sizeof(w5500_sock_stats));
+    }
+    else if (sock_num < W5500_MAX_SOCKET)
+    {
+        memset(&w5500_sock_stats[sock_num], 0, sizeof(w5500_sock_stats[sock_num]));
+    }
+}
+
+/**
+ * @brief Latency percentile from the histogram
+ *
+ * @param lat       Latency counters
+ * @param pct       Percentile, 1..100
+ * @return uint32_t Upper bound in cycles of the percentile's bucket
+ */
+uint32_t w5500_socket_latency_percentile(const w5500_latency_stats_t *lat, uint8_t pct)
+{
+    uint32_t total = 0U;
+
+    if ((lat == NULL) || (pct == 0U) || (pct > 100U))
+    {
+        return 0U;
+    }
+    for (uint32_t i = 0; i < W5500_STATS_HIST_BUCKETS; i++)
+    {
+        total += lat->hist[i];
+    }
+    if (total == 0U)
+    {
+        return 0U;
+    }
+
+    uint32_t rank = (total * pct + 99U) / 100U;
+    uint32_t seen = 0U;
+    for (uint32_t i = 0; i < (W5500_STATS_HIST_BUCKETS - 1U); i++)
+    {
+        seen += lat->hist[i];
+        if (seen >= rank)
+        {
+            uint32_t bound = 1UL << (W5500_STATS_HIST_SHIFT + i);
+            return (bound < lat->max_cycles) ? bound : lat->max_cycles;
+        }
+    }
+    return lat->max_cycles;
+}
+
+/**
+ * @brief SPI bytes clocked per 1000 payload bytes
+ *
+ * @param stats     Counters from w5500_socket_get_stats()
+ * @return uint32_t Overhead in per-mille, 0 without payload
+ */
+uint32_t w5500_socket_spi_overhead(const w5500_sock_stats_t *stats)
+{
+    uint64_t payload;
+
+    if (stats == NULL)
+    {
+        return 0U;
+    }
+    payload = (uint64_t)stats->tx_bytes + stats->rx_bytes;
+    if (payload == 0U)
+    {
+        return 0U;
+    }
+    return (uint32_t)(((uint64_t)stats->spi_bytes * 1000U) / payload);
+}
+
+static uint8_t *w5500_stats_put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+static uint8_t *w5500_stats_put_u64(uint8_t *p, uint64_t v)
+{
+    p = w5500_stats_put_u32(p, (uint32_t)v);
+    return w5500_stats_put_u32(p, (uint32_t)(v >> 32));
+}
+
+static uint8_t *w5500_stats_put_latency(uint8_t *p, const w5500_latency_stats_t *lat)
+{
+    uint32_t avg = (lat->count != 0U) ? (uint32_t)(lat->sum_cycles / lat->count) : 0U;
+
+    p = w5500_stats_put_u32(p, lat->count);
+    p = w5500_stats_put_u32(p, lat->min_cycles);
+    p = w5500_stats_put_u32(p, avg);
+    p = w5500_stats_put_u32(p, lat->max_cycles);
+    p = w5500_stats_put_u32(p, w5500_socket_latency_percentile(lat, 50U));
+    return w5500_stats_put_u32(p, w5500_socket_latency_percentile(lat, 99U));
+}
+
+/**
+ * @brief Serialise every socket's counters into a compact binary record
+ *
+ * @param buf       Destination
+ * @param size      Size of @p buf
+ * @return size_t   Bytes written, 0 if @p buf cannot hold the header
+ */
+size_t w5500_socket_stats_dump(uint8_t *buf, size_t size)
+{
+    const spi_client_t *client = w5500_spi_get_client();
+
+    if ((buf == NULL) || (size < W5500_STATS_DUMP_HDR_LEN))
+    {
+        return 0U;
+    }
+
+    uint8_t *p = buf;
+    *p++ = 'W';
+    *p++ = 'S';
+    *p++ = W5500_STATS_DUMP_VERSION;
+    *p++ = 0U;      // Record count, filled in below
+    p = w5500_stats_put_u32(p, client->transactions);
+    p = w5500_stats_put_u32(p, client->bytes);
+    p = w5500_stats_put_u64(p, client->hold_cycles);
+
+    uint8_t records = 0U;
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++)
+    {
+        const w5500_sock_stats_t *st = &w5500_sock_stats[sn];
+        uint32_t errors = 0U;
+
+        for (uint32_t i = 0; i < W5500_STATS_ERR_COUNT; i++)
+        {
+            errors |= st->errors[i];
+        }
+        if ((st->spi_bytes == 0U) && (errors == 0U))
+        {
+            continue;
+        }
+        if ((size_t)(p - buf) + W5500_STATS_DUMP_REC_LEN > size)
+        {
+            break;
+        }
+        *p++ = sn;
+        p = w5500_stats_put_u32(p, st->tx_bytes);
+        p = w5500_stats_put_u32(p, st->rx_bytes);
+        p = w5500_stats_put_u32(p, st->tx_packets);
+        p = w5500_stats_put_u32(p, st->rx_packets);
+        p = w5500_stats_put_u32(p, st->spi_bytes);
+        p = w5500_stats_put_u64(p, st->spi_cycles);
+        for (uint32_t i = 0; i < W5500_STATS_ERR_COUNT; i++)
+        {
+            p = w5500_stats_put_u32(p, st->errors[i]);
+        }
+        p = w5500_stats_put_latency(p, &st->send);
+        p = w5500_stats_put_latency(p, &st->recv);
+        records++;
     }
-    // getSn_RX_RSR is from wizchip_conf.h or socket.h in WIZnet library.
-    uint16_t size = getSn_RX_RSR(sock_num);
-    DEBUG_PRINT("w5500_socket_get_rx_buf_size: Socket %d RX size: %d\r\n", sock_num, size);
-    return size;
+    buf[3] = records;
+    return (size_t)(p - buf);
 }
@@ -40,7 +40,9 @@
  */
 typedef enum {
     W5500_SOCK_TCP = 0,  /**< TCP socket type */
-    W5500_SOCK_UDP = 1   /**< UDP socket type */
+    W5500_SOCK_UDP = 1,  /**< UDP socket type */
+    W5500_SOCK_MACRAW = 2, /**< Raw Ethernet frames, socket 0 only */
+    W5500_SOCK_IPRAW = 3  /**< IP payloads of one protocol, see w5500_socket_open_ipraw() */
 } w5500_sock_type_t;
 
 /**
@@ -54,6 +56,313 @@ typedef enum {
     W5500_SOCK_BUFFER_ERROR = -4 /**< Buffer error */
 } w5500_sock_error_t;
 
+/**
+ * @brief Decoded snapshot of one socket's register block (Sn_IR .. Sn_RX_WR)
+ *
+ * @note  The block is read in a single CS-held burst. The 16-bit counters
+ *        Sn_TX_FSR and Sn_RX_RSR only grow while the chip owns them, and the
+ *        high byte is clocked out first, so a value torn by a concurrent
+ *        update can only be lower than the true one: it is a safe lower
+ *        bound for the free space / pending data, never an overstatement.
+ */
+typedef struct {
+    uint8_t  ir;            /**< Sn_IR: interrupt flags (CON/DISCON/RECV/TIMEOUT/SENDOK) */
+    uint8_t  sr;            /**< Sn_SR: socket status (SOCK_*) */
+    uint16_t port;          /**< Sn_PORT: local port */
+    uint8_t  dhar[6];       /**< Sn_DHAR: destination MAC */
+    uint8_t  dipr[4];       /**< Sn_DIPR: destination IP */
+    uint16_t dport;         /**< Sn_DPORT: destination port */
+    uint16_t mssr;          /**< Sn_MSSR: maximum segment size */
+    uint8_t  tos;           /**< Sn_TOS */
+    uint8_t  ttl;           /**< Sn_TTL */
+    uint8_t  rxbuf_size;    /**< Sn_RXBUF_SIZE in KB */
+    uint8_t  txbuf_size;    /**< Sn_TXBUF_SIZE in KB */
+    uint16_t tx_fsr;        /**< Sn_TX_FSR: free TX space in bytes */
+    uint16_t tx_rd;         /**< Sn_TX_RD */
+    uint16_t tx_wr;         /**< Sn_TX_WR */
+    uint16_t rx_rsr;        /**< Sn_RX_RSR: received bytes pending */
+    uint16_t rx_rd;         /**< Sn_RX_RD */
+    uint16_t rx_wr;         /**< Sn_RX_WR */
+} w5500_sock_regs_t;
+
+/**
+ * @brief Bytes the chip puts in front of each datagram in a UDP RX ring:
+ *        source IP (4), source port (2), payload length (2), big-endian
+ */
+#define W5500_UDP_HDR_LEN 8U
+
+/**
+ * @brief Bytes the chip puts in front of each packet in an IPRAW RX ring:
+ *        source IP (4), payload length (2), big-endian
+ */
+#define W5500_IPRAW_HDR_LEN 6U
+
+/**
+ * @brief Readable span of a socket's RX ring (Sn_RX_RD .. Sn_RX_WR)
+ *
+ * @details The span lives in chip memory. Segments are offsets into the
+ *          socket's RX buffer: one segment, or two when the span wraps past
+ *          the end of the buffer. Read bytes in place with
+ *          w5500_socket_peek_read() at any position of the span and release
+ *          them with w5500_socket_consume(), which also advances the span.
+ *
+ * @note  UDP rings hold W5500_UDP_HDR_LEN header bytes before each payload.
+ *        Do not mix with w5500_socket_recvfrom() while that call is in the
+ *        middle of a datagram: the ioLibrary keeps its own position.
+ */
+typedef struct {
+    uint16_t rd;            /**< Sn_RX_RD of the first readable byte */
+    uint16_t len;           /**< Readable bytes */
+    uint16_t size;          /**< Socket RX buffer size in bytes */
+    uint8_t  nseg;          /**< 0 (empty), 1, or 2 when the span wraps */
+    struct {
+        uint16_t offset;    /**< Offset in the socket RX buffer */
+        uint16_t len;
+    } seg[2];
+} w5500_rx_span_t;
+
+/**
+ * @brief Options of w5500_socket_open_multicast()
+ */
+#define W5500_MCAST_BLOCK_UNICAST   0x01U   /**< Drop unicast datagrams (Sn_MR UCASTB) */
+#define W5500_MCAST_BLOCK_BROADCAST 0x02U   /**< Drop broadcast datagrams (Sn_MR BCASTB) */
+#define W5500_MCAST_IGMP_V1         0x04U   /**< IGMPv1 reports instead of IGMPv2 (Sn_MR MC) */
+
+/**
+ * @brief IPRAW sockets (see w5500_socket_open_ipraw())
+ */
+#define W5500_IPPROTO_ICMP          1U
+#define W5500_IPRAW_PORT            1U      /**< dest_port for w5500_socket_sendto(): unused by the chip, but the ioLibrary refuses 0 */
+
+/**
+ * @brief MACRAW streaming (see w5500_socket_macraw_open())
+ */
+#define W5500_MACRAW_SOCKET         0U      /**< The only socket the chip runs MACRAW on */
+#define W5500_ETH_HDR_LEN           14U     /**< Destination, source, EtherType */
+#define W5500_MACRAW_MTU            1500U   /**< Largest payload of one frame */
+
+#define W5500_MACRAW_MAC_FILTER     0x01U   /**< Chip drops frames not for our MAC or broadcast (Sn_MR MFEN) */
+#define W5500_MACRAW_BLOCK_MULTICAST 0x02U  /**< Chip drops multicast frames (Sn_MR MMB) */
+#define W5500_MACRAW_BLOCK_IPV6     0x04U   /**< Chip drops IPv6 frames (Sn_MR MIP6B) */
+
+/**
+ * @brief Ethernet header of a MACRAW frame
+ */
+typedef struct {
+    uint8_t  dst[6];
+    uint8_t  src[6];
+    uint16_t ethertype;
+} w5500_eth_hdr_t;
+
+/**
+ * @brief One outgoing frame of w5500_socket_macraw_send_batch()
+ */
+typedef struct {
+    const uint8_t* dst;     /**< Destination MAC, NULL for broadcast */
+    const uint8_t* data;    /**< Payload */
+    uint16_t       len;     /**< Payload length, at most W5500_MACRAW_MTU */
+} w5500_macraw_frame_t;
+
+/**
+ * @brief One incoming frame of w5500_socket_macraw_recv_batch()
+ */
+typedef struct {
+    w5500_eth_hdr_t hdr;    /**< Header (output) */
+    uint8_t*        buf;    /**< Payload destination */
+    uint16_t        size;   /**< Size of @p buf */
+    uint16_t        len;    /**< Payload bytes stored (output) */
+    bool            truncated; /**< Payload was longer than @p size (output) */
+} w5500_macraw_rx_t;
+
+/**
+ * @brief Software filter of incoming MACRAW frames
+ *
+ * @param hdr       Frame header
+ * @param len       Payload length
+ * @param ctx       Context given to w5500_socket_macraw_set_filter()
+ * @return bool     true to deliver the frame, false to drop it unread
+ */
+typedef bool (*w5500_macraw_filter_t)(const w5500_eth_hdr_t* hdr, uint16_t len, void* ctx);
+
+/**
+ * @brief One segment of a gathered send
+ */
+typedef struct {
+    const uint8_t* data;    /**< Segment bytes */
+    uint16_t       len;     /**< Segment length, 0 is skipped */
+} w5500_iovec_t;
+
+/**
+ * @brief Socket readiness events for w5500_socket_poll()
+ */
+#define W5500_POLLIN    0x01U   /**< Data received (Sn_IR RECV) */
+#define W5500_POLLOUT   0x02U   /**< TX buffer has free space (Sn_TX_FSR) */
+#define W5500_POLLCON   0x04U   /**< TCP connection established (Sn_IR CON) */
+#define W5500_POLLHUP   0x08U   /**< Peer closed (Sn_IR DISCON) or socket closed (Sn_SR) */
+#define W5500_POLLSENT  0x10U   /**< w5500_socket_send_async() SEND completed (Sn_IR SENDOK) */
+
+/**
+ * @brief One socket of a w5500_socket_poll() set
+ */
+typedef struct {
+    uint8_t sock_num;       /**< Socket number */
+    uint8_t events;         /**< W5500_POLL* events of interest */
+    uint8_t revents;        /**< W5500_POLL* events that occurred (output) */
+} w5500_pollfd_t;
+
+/**
+ * @brief Named socket buffer layouts (see w5500_socket_apply_profile())
+ *
+ * @details The pool does not say which socket a service gets: it hands out
+ *          the lowest free socket of the service's ETH_CONFIG_*_SOCK_MASK
+ *          (W5500_SOCK_ANY by default), so a profile only fits if the masks
+ *          keep each service on a socket big enough for it:
+ *
+ *          - bulk-stream: the stream must be pinned to socket 2 (as
+ *            ETH_CONFIG_BENCH_SOCK_MASK is) and claimed before the other
+ *            services allocate. Sockets 0, 1 and 4..7 have
+ *            1 KB and only take small datagrams (DHCP, DNS, SNTP). ICMP
+ *            echo requests of up to W5500_ICMP_MAX_LEN do not fit there:
+ *            w5500_icmp_init() only takes a socket whose RX buffer holds
+ *            one, socket 3 here.
+ *          - http-clients: W5500_HTTP_MAX_CONN (4 by default) HTTP sockets
+ *            and ICMP belong on 2..7, which leaves one for SNTP; give DHCP
+ *            and DNS a mask of 0x03 so they do not use up the 2 KB
+ *            sockets, and start HTTP first so it gets socket 2 and its
+ *            4 KB TX.
+ *
+ *          TCP throughput of the stream socket is bounded by its window
+ *          (buffer / RTT) and by the SPI link (SCK / SPI bytes per payload
+ *          byte, 1.004-1.015 in the host bench at 20 MHz). Upper bounds at
+ *          a 1 ms RTT and 20 MHz SCK, computed from these, not measured on
+ *          the board:
+ *
+ *            profile        socket 2 TX/RX   RX Mb/s   TX Mb/s
+ *            balanced         2 / 2 KB         16.4      16.4
+ *            bulk-stream      8 / 8 KB         19.9      19.9
+ *            http-clients     4 / 2 KB         16.4      19.9
+ */
+typedef enum {
+    W5500_MEM_BALANCED = 0,     /**< 2 KB TX/RX on every socket (reset layout) */
+    W5500_MEM_BULK_STREAM,      /**< 8 KB TX/RX on socket 2 for bulk transfers */
+    W5500_MEM_HTTP_CLIENTS,     /**< 2 KB on sockets 2..7, 4 KB TX on socket 2 */
+    W5500_MEM_PROFILE_COUNT
+} w5500_mem_profile_t;
+
+/**
+ * @brief Socket buffer layout in KB per socket
+ * @note  Sizes are 0, 1, 2, 4, 8 or 16; each direction totals at most 16 KB.
+ */
+typedef struct {
+    const char* name;                       /**< Profile name for logs */
+    uint8_t     tx_kb[W5500_MAX_SOCKET];    /**< Sn_TXBUF_SIZE per socket */
+    uint8_t     rx_kb[W5500_MAX_SOCKET];    /**< Sn_RXBUF_SIZE per socket */
+} w5500_mem_layout_t;
+
+/**
+ * @brief Buffer layout programmed by w5500_spi_init()
+ */
+#ifndef ETH_CONFIG_MEM_PROFILE
+#define ETH_CONFIG_MEM_PROFILE W5500_MEM_BALANCED
+#endif
+
+/**
+ * @brief Completion token of w5500_socket_send_async(): the socket's stream
+ *        offset just past the queued bytes (wraps, compare by difference)
+ */
+typedef uint32_t w5500_send_token_t;
+
+/**
+ * @brief Any socket, for w5500_socket_alloc()
+ */
+#define W5500_SOCK_ANY 0xFFU
+
+/**
+ * @brief Owner of a pooled socket
+ */
+typedef struct {
+    const char*  owner;     /**< Module name, NULL if claimed by w5500_socket_open() */
+    osThreadId_t task;      /**< Task that claimed the socket (NULL before the scheduler) */
+    uint32_t     since;     /**< Kernel tick of the claim */
+} w5500_sock_owner_t;
+
+/**
+ * @brief Socket pool usage counters
+ */
+typedef struct {
+    uint8_t  in_use;        /**< Sockets currently claimed */
+    uint8_t  high_water;    /**< Most sockets claimed at once */
+    uint32_t allocs;        /**< Successful w5500_socket_alloc() calls */
+    uint32_t failures;      /**< w5500_socket_alloc() calls that found no free socket */
+    uint8_t  leaked;        /**< Claimed sockets that are SOCK_CLOSED on the chip */
+    uint8_t  leaked_mask;   /**< Bit n set: socket n counted in leaked */
+} w5500_sock_pool_stats_t;
+
+/**
+ * @brief Latency histogram buckets: bucket 0 holds calls under
+ *        2^W5500_STATS_HIST_SHIFT cycles, bucket k calls under
+ *        2^(W5500_STATS_HIST_SHIFT + k), the last bucket everything above
+ */
+#define W5500_STATS_HIST_BUCKETS    16U
+#define W5500_STATS_HIST_SHIFT      7U
+
+/**
+ * @brief Error counters per w5500_sock_error_t code: index -code - 1
+ */
+#define W5500_STATS_ERR_COUNT       4U
+
+/**
+ * @brief Latency of one kind of call, in DWT cycles (SPI_BUS_CYCLES())
+ *
+ * @note  Histogram counts saturate by halving every bucket of the call kind,
+ *        so percentiles follow recent traffic once a bucket fills up.
+ */
+typedef struct {
+    uint32_t count;         /**< Calls that moved data */
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t sum_cycles;    /**< avg = sum_cycles / count */
+    uint16_t hist[W5500_STATS_HIST_BUCKETS];
+} w5500_latency_stats_t;
+
+/**
+ * @brief Traffic counters of one socket (see w5500_socket_get_stats())
+ *
+ * @details Kept by the data transfer wrappers. A packet is a call that moved
+ *          data: a datagram on UDP, a send/recv/consume call on TCP. SPI
+ *          bytes and cycles are the W5500 bus client's counters accrued
+ *          during the socket's calls; divide spi_bytes by tx_bytes +
+ *          rx_bytes for the framing overhead (w5500_socket_spi_overhead()).
+ *          Counters survive close and re-open until reset.
+ */
+typedef struct {
+    uint32_t tx_bytes;      /**< Payload bytes accepted for sending */
+    uint32_t rx_bytes;      /**< Payload bytes received (UDP ring headers included for consume) */
+    uint32_t tx_packets;
+    uint32_t rx_packets;
+    uint32_t errors[W5500_STATS_ERR_COUNT];     /**< Failed calls by error code */
+    uint32_t spi_bytes;     /**< SPI bytes clocked by the socket's calls */
+    uint64_t spi_cycles;    /**< SPI bus hold time of the socket's calls */
+    w5500_latency_stats_t send;     /**< send/sendto/sendv/sendtov/send_async */
+    w5500_latency_stats_t recv;     /**< recv/recvfrom */
+} w5500_sock_stats_t;
+
+/**
+ * @brief w5500_socket_stats_dump() format, all fields little-endian
+ *
+ * @details Header: 'W' 'S', version, record count, then the W5500 SPI
+ *          client's transactions (u32), bytes (u32) and hold cycles (u64).
+ *          One record per socket with traffic: socket number (u8),
+ *          tx/rx bytes and packets (4 x u32), spi_bytes (u32), spi_cycles
+ *          (u64), errors (4 x u32), then send and recv latency as count,
+ *          min, avg, max, p50, p99 (6 x u32 each).
+ */
+#define W5500_STATS_DUMP_VERSION    1U
+#define W5500_STATS_DUMP_HDR_LEN    20U
+#define W5500_STATS_DUMP_REC_LEN    93U
+#define W5500_STATS_DUMP_MAX_LEN    (W5500_STATS_DUMP_HDR_LEN + \
+                                     (W5500_MAX_SOCKET * W5500_STATS_DUMP_REC_LEN))
+
 /*============================================================================*/
 /* SOCKET INITIALIZATION/DEINITIALIZATION             */
 /*============================================================================*/
@@ -61,15 +370,23 @@ typedef enum {
 /**
  * @brief Open a socket and initialize it
  *
+ * @details Claims the socket until w5500_socket_close() if it is not claimed
+ *          yet (see w5500_socket_alloc()).
+ *
  * @param sock_num  Socket number (0-7)
  * @param type      Socket type (TCP or UDP)
  * @param port      Port number to bind to
- * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUSY if another task
+ *                  took the socket with w5500_socket_alloc(), negative error
+ *                  code on failure
  */
 int8_t w5500_socket_open(uint8_t sock_num, w5500_sock_type_t type, uint16_t port);
 
 /**
  * @brief Close a socket
+ * @note  Ends the implicit claim of a socket opened by number. A claim from
+ *        w5500_socket_alloc() survives, so its owner can reopen the socket;
+ *        only w5500_socket_release() gives that back.
  *
  * @param sock_num  Socket number
  * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
@@ -96,6 +413,74 @@ int8_t w5500_socket_setsockopt(uint8_t sock_num, uint8_t option_type, void *opti
  */
 int8_t w5500_socket_getsockopt(uint8_t sock_num, uint8_t option_type, void *option_value);
 
+/*============================================================================*/
+/* SOCKET POOL                                        */
+/*============================================================================*/
+
+/**
+ * @brief Claim a free hardware socket for a module
+ *
+ * @details Hands out the lowest socket of @p sock_mask that is neither
+ *          claimed nor open on the chip, and records the module and calling
+ *          task as its owner. The claim lasts across close and reopen until
+ *          w5500_socket_release(), so a service that closes and re-listens
+ *          keeps its socket and owner tag; short-lived services (DHCP
+ *          renewal, DNS lookup) release theirs between uses.
+ *          w5500_socket_open() refuses a socket allocated by another task.
+ *          It claims an unclaimed socket implicitly until
+ *          w5500_socket_close(), so legacy fixed numbers never collide with
+ *          pooled ones and go back to the pool when closed; any task may
+ *          reopen them. A claim taken before the scheduler runs has no task
+ *          and can be opened by any task.
+ *
+ * @note    The pool never reclaims a socket by itself: a socket the chip
+ *          closes (peer RST, ARP/TCP timeout) stays claimed until its owner
+ *          calls w5500_socket_release() (w5500_socket_close() for a fixed
+ *          number). Owners must do so on every exit path, including errors,
+ *          or the socket is lost to the pool; w5500_socket_get_pool_stats()
+ *          reports such sockets as leaked.
+ *
+ * @param owner     Module name (static string), reported by w5500_socket_get_owner()
+ * @param sock_mask Acceptable sockets, bit n = socket n (W5500_SOCK_ANY)
+ * @param sock_num  Claimed socket number
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUSY if no socket is free
+ */
+int8_t w5500_socket_alloc(const char* owner, uint8_t sock_mask, uint8_t* sock_num);
+
+/**
+ * @brief Close a socket if open and return it to the pool
+ * @note  The only call that ends a w5500_socket_alloc() claim, whether the
+ *        socket was driven through w5500_socket_close() or the ioLibrary
+ *        directly (DHCP, DNS).
+ *
+ * @param sock_num  Socket number
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_release(uint8_t sock_num);
+
+/**
+ * @brief Get the owner of a claimed socket
+ *
+ * @param sock_num  Socket number
+ * @param info      Owner record
+ * @return bool     true if the socket is claimed
+ */
+bool w5500_socket_get_owner(uint8_t sock_num, w5500_sock_owner_t* info);
+
+/**
+ * @brief Get the pool usage counters and high-water mark
+ *
+ * @details Also reads Sn_SR of every claimed socket: one that is SOCK_CLOSED
+ *          is counted in leaked, and w5500_socket_get_owner() names the
+ *          module holding it. A socket between w5500_socket_alloc() and its
+ *          open, or between a close and the reopen of a server re-listening,
+ *          shows up there briefly as well; one that stays is a claim its
+ *          owner forgot to release.
+ *
+ * @param stats     Counters
+ */
+void w5500_socket_get_pool_stats(w5500_sock_pool_stats_t* stats);
+
 /*============================================================================*/
 /* TCP SPECIFIC OPERATIONS                            */
 /*============================================================================*/
@@ -118,6 +503,21 @@ int8_t w5500_socket_connect(uint8_t sock_num, const uint8_t* dest_ip, uint16_t d
  */
 int8_t w5500_disconnect(uint8_t sock_num);
 
+/**
+ * @brief Start a graceful TCP close without waiting for it
+ *
+ * @details Issues DISCON (FIN after the queued data) in SF_IO_NONBLOCK mode
+ *          and returns: w5500_disconnect() instead spins until SOCK_CLOSED,
+ *          which takes the peer's FIN or the whole retransmission timeout.
+ *          The close completes with Sn_IR DISCON (W5500_POLLHUP) or
+ *          TIMEOUT, after which Sn_SR reads SOCK_CLOSED.
+ *
+ * @param sock_num  Socket number
+ * @return int8_t   W5500_SOCK_OK once DISCON is issued, negative error code
+ *                  on failure
+ */
+int8_t w5500_disconnect_async(uint8_t sock_num);
+
 /**
  * @brief Listen for incoming TCP connections
  *
@@ -176,10 +576,394 @@ int32_t w5500_socket_sendto(uint8_t sock_num, const uint8_t* buffer, uint16_t le
 int32_t w5500_socket_recvfrom(uint8_t sock_num, uint8_t* buffer, uint16_t maxlen,
                               uint8_t* src_ip, uint16_t* src_port);
 
+/**
+ * @brief Ask whether a host answers ARP for @p ip
+ *
+ * @details Sends a small datagram to @p ip on the open UDP socket
+ *          @p sock_num with RCR lowered to @p retries: the chip resolves the
+ *          address first, so a datagram that gets out means someone holds
+ *          it, an ARP timeout means nobody does. The ARP requests carry the
+ *          address currently in SIPR as sender, never @p ip, so probing a
+ *          taken address leaves its owner's entry in peers' ARP caches
+ *          alone; SIPR and SUBR are not touched, as live sockets keep using
+ *          them. @p ip must therefore be on-link under the current address
+ *          and mask, or the chip would ARP the gateway instead.
+ *
+ *          Sleeps on SENDOK/TIMEOUT for (@p retries + 1) x RTR at most,
+ *          without holding the SPI lock. RCR is a common register: other
+ *          sockets retransmit with the lowered count while the probe runs.
+ *
+ * @param sock_num  Open UDP socket
+ * @param ip        Address to probe (4 bytes)
+ * @param retries   ARP retries (RCR) for the probe
+ * @return int8_t   W5500_SOCK_OK if nobody answered, W5500_SOCK_BUSY if a
+ *                  host did, W5500_SOCK_ERROR if @p ip is off-link or the
+ *                  send failed
+ */
+int8_t w5500_socket_arp_probe(uint8_t sock_num, const uint8_t* ip, uint8_t retries);
+
+/**
+ * @brief Send a message gathered from several segments (TCP)
+ *
+ * @details Each segment is written straight into the TX ring at consecutive
+ *          Sn_TX_WR offsets (one CS frame per segment) and the whole message
+ *          goes out with a single SEND command, so headers and payloads need
+ *          no assembly buffer. Blocks until the TX ring has room for the
+ *          whole message. Like w5500_socket_send(), returns once SEND is
+ *          issued; the next call waits for its SENDOK first.
+ *
+ * @note  Do not interleave with w5500_socket_send() on the same socket: the
+ *        ioLibrary tracks its own SEND in flight.
+ *
+ * @param sock_num  Socket number
+ * @param iov       Segments, sent in order
+ * @param iovcnt    Number of segments
+ * @return int32_t  Number of bytes sent, negative error code on failure
+ *                  (W5500_SOCK_BUFFER_ERROR if the message exceeds the TX
+ *                  buffer)
+ */
+int32_t w5500_socket_sendv(uint8_t sock_num, const w5500_iovec_t* iov, uint8_t iovcnt);
+
+/**
+ * @brief Send one UDP datagram gathered from several segments
+ *
+ * @details Same single-SEND gather as w5500_socket_sendv(). Waits for
+ *          SENDOK before returning, like w5500_socket_sendto().
+ *
+ * @param sock_num  Socket number
+ * @param iov       Segments, sent in order
+ * @param iovcnt    Number of segments
+ * @param dest_ip   Destination IP address (4 bytes)
+ * @param dest_port Destination port
+ * @return int32_t  Number of bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_sendtov(uint8_t sock_num, const w5500_iovec_t* iov, uint8_t iovcnt,
+                             const uint8_t* dest_ip, uint16_t dest_port);
+
+/*============================================================================*/
+/* UDP MULTICAST                                      */
+/*============================================================================*/
+
+/**
+ * @brief Open a UDP socket on a multicast group
+ *
+ * @details Programs the group MAC (01:00:5E + low 23 bits of the address),
+ *          group address and port into Sn_DHAR/Sn_DIPR/Sn_DPORT, then opens
+ *          the socket with Sn_MR MULTI. The chip itself sends the IGMP
+ *          membership report on OPEN and the leave on CLOSE, and delivers
+ *          the group's datagrams to w5500_socket_recvfrom(). One datagram
+ *          from w5500_socket_publish() reaches every subscriber.
+ *
+ * @note  A socket joins one group; use one socket per group.
+ *
+ * @param sock_num  Socket number
+ * @param group_ip  Group address, 224.0.0.0 .. 239.255.255.255
+ * @param port      Group port, also the local port
+ * @param options   W5500_MCAST_* options, 0 for IGMPv2 and no filtering
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_open_multicast(uint8_t sock_num, const uint8_t* group_ip, uint16_t port,
+                                   uint8_t options);
+
+/**
+ * @brief Send one datagram to the group a socket joined
+ *
+ * @details w5500_socket_sendto() to the group address and port.
+ *
+ * @param sock_num  Socket number opened with w5500_socket_open_multicast()
+ * @param buffer    Pointer to data to send
+ * @param len       Length of data to send
+ * @return int32_t  Number of bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_publish(uint8_t sock_num, const uint8_t* buffer, uint16_t len);
+
+/*============================================================================*/
+/* IP RAW                                             */
+/*============================================================================*/
+
+/**
+ * @brief Open a socket on the IP payloads of one protocol
+ *
+ * @details Sets Sn_PROTO and opens the socket in IPRAW mode. Each packet in
+ *          the RX ring is W5500_IPRAW_HDR_LEN header bytes followed by the
+ *          IP payload (the IP header is stripped); read it with the peek
+ *          API. Send with w5500_socket_sendto() and W5500_IPRAW_PORT: the
+ *          chip adds the IP header.
+ *
+ * @param sock_num  Socket number
+ * @param protocol  IP protocol number, e.g. W5500_IPPROTO_ICMP
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_open_ipraw(uint8_t sock_num, uint8_t protocol);
+
+/*============================================================================*/
+/* MACRAW STREAMING                                   */
+/*============================================================================*/
+
+/**
+ * @brief Switch socket 0 to raw Ethernet frames of one EtherType
+ *
+ * @details Gives socket 0 the whole 16 KB of TX and RX buffer memory and
+ *          opens it in MACRAW mode: no IP/UDP headers, no per-socket split.
+ *          Sockets 1..7 must be closed (DHCP, ICMP) and stay without buffer
+ *          memory until w5500_socket_macraw_close().
+ *
+ * @param ethertype EtherType of the frames sent, and of the frames received
+ *                  unless a filter is set (0 accepts any)
+ * @param options   W5500_MACRAW_* chip-side filters
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUSY if another
+ *                  socket is open, negative error code on failure
+ */
+int8_t w5500_socket_macraw_open(uint16_t ethertype, uint8_t options);
+
+/**
+ * @brief Close socket 0 and restore the ETH_CONFIG_MEM_PROFILE layout
+ *
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_macraw_close(void);
+
+/**
+ * @brief Replace the software filter of incoming frames
+ *
+ * @details Runs on the header alone, before the payload is read: dropped
+ *          frames cost only their 16 header bytes of SPI. Frames of another
+ *          EtherType never reach the filter.
+ *
+ * @param filter    Filter, NULL to accept every frame of the EtherType
+ * @param ctx       Passed to @p filter
+ */
+void w5500_socket_macraw_set_filter(w5500_macraw_filter_t filter, void* ctx);
+
+/**
+ * @brief Send a batch of frames
+ *
+ * @details The frames are written into the TX ring in one pass, ahead of
+ *          Sn_TX_WR, while the SEND of the previous frame is on the wire;
+ *          each frame then costs only its Sn_TX_WR update, SEND and SENDOK.
+ *          Frames are padded to the 60-byte Ethernet minimum. The last SEND
+ *          is left in flight; the next call waits for it.
+ *
+ * @param frames    Frames, sent in order
+ * @param count     Number of frames
+ * @return int32_t  Frames sent, negative error code on failure
+ */
+int32_t w5500_socket_macraw_send_batch(const w5500_macraw_frame_t* frames, uint8_t count);
+
+/**
+ * @brief Send one frame (see w5500_socket_macraw_send_batch())
+ *
+ * @param dst       Destination MAC, NULL for broadcast
+ * @param data      Payload
+ * @param len       Payload length, at most W5500_MACRAW_MTU
+ * @return int32_t  Payload bytes sent, negative error code on failure
+ */
+int32_t w5500_socket_macraw_send(const uint8_t* dst, const uint8_t* data, uint16_t len);
+
+/**
+ * @brief Receive the pending frames that pass the filters
+ *
+ * @details Walks the RX ring from one Sn_RX_RSR read, reads each frame's
+ *          header, skips rejected frames without reading their payload, and
+ *          returns the ring space of every frame walked with a single RECV.
+ *          Short frames arrive with their padding: the payload is at least
+ *          46 bytes.
+ *
+ * @param frames    Receive slots, filled in order
+ * @param count     Number of slots
+ * @return int32_t  Frames delivered (0 if none pending), negative error code
+ *                  on failure
+ */
+int32_t w5500_socket_macraw_recv_batch(w5500_macraw_rx_t* frames, uint8_t count);
+
+/**
+ * @brief Receive one frame (see w5500_socket_macraw_recv_batch())
+ *
+ * @param hdr       Frame header (may be NULL)
+ * @param buf       Payload destination
+ * @param size      Size of @p buf; longer payloads are truncated
+ * @return int32_t  Payload bytes stored, 0 if no frame is pending, negative
+ *                  error code on failure
+ */
+int32_t w5500_socket_macraw_recv(w5500_eth_hdr_t* hdr, uint8_t* buf, uint16_t size);
+
+/*============================================================================*/
+/* ASYNCHRONOUS TCP SEND                              */
+/*============================================================================*/
+
+/**
+ * @brief Queue data into a TCP socket's TX ring without waiting for the wire
+ *
+ * @details Copies as much of @p buffer as the ring can take and returns.
+ *          One SEND command is in flight at a time: data queued meanwhile is
+ *          covered by the next SEND, issued on the SENDOK of the current one
+ *          by the INT dispatcher (the socket unmasks SENDOK/TIMEOUT for
+ *          itself) or, without it, by w5500_socket_send_poll(). Producers
+ *          can therefore pipeline several segments per round trip.
+ *
+ * @note  Do not mix with w5500_socket_send()/w5500_socket_sendv() on the
+ *        same socket between open and close.
+ *
+ * @param sock_num  Socket number
+ * @param buffer    Data to queue
+ * @param len       Length of data
+ * @param token     Completion token of the last queued byte (may be NULL)
+ * @return int32_t  Bytes queued (0 if the ring is full: back-pressure),
+ *                  negative error code on failure or after a retransmission
+ *                  timeout
+ */
+int32_t w5500_socket_send_async(uint8_t sock_num, const uint8_t* buffer, uint16_t len,
+                                w5500_send_token_t* token);
+
+/**
+ * @brief Bytes w5500_socket_send_async() would accept now
+ *
+ * @details Sn_TX_FSR less the bytes queued but not yet covered by a SEND.
+ *
+ * @param sock_num  Socket number
+ * @return uint16_t Writable bytes
+ */
+uint16_t w5500_socket_send_writable(uint8_t sock_num);
+
+/**
+ * @brief Check whether the data up to a token has been sent
+ *
+ * @param sock_num  Socket number
+ * @param token     Token from w5500_socket_send_async()
+ * @return int8_t   W5500_SOCK_OK when sent, W5500_SOCK_BUSY while pending,
+ *                  W5500_SOCK_TIMEOUT after a retransmission timeout,
+ *                  W5500_SOCK_ERROR if the socket closed otherwise (RST)
+ */
+int8_t w5500_socket_send_status(uint8_t sock_num, w5500_send_token_t token);
+
+/**
+ * @brief Block until the data up to a token has been sent
+ *
+ * @param sock_num  Socket number
+ * @param token     Token from w5500_socket_send_async()
+ * @param timeout   Timeout in kernel ticks (0 = check once, osWaitForever)
+ * @return int8_t   As w5500_socket_send_status(), W5500_SOCK_BUSY on timeout;
+ *                  a socket that closes ends the wait within 10 ticks,
+ *                  whatever the timeout
+ */
+int8_t w5500_socket_send_wait(uint8_t sock_num, w5500_send_token_t token, uint32_t timeout);
+
+/**
+ * @brief Low-rate poller for sockets whose SENDOK is not dispatched on INT:
+ *        one Sn_IR read, completes the SEND in flight and issues the next
+ *
+ * @param sock_num  Socket number
+ */
+void w5500_socket_send_poll(uint8_t sock_num);
+
+/**
+ * @brief SENDOK/TIMEOUT hook of the INT dispatcher (w5500_irq)
+ *
+ * @param sock_num  Socket number
+ * @param ir        Sn_IR bits read and cleared by the dispatcher
+ */
+void w5500_socket_on_send_event(uint8_t sock_num, uint8_t ir);
+
+/*============================================================================*/
+/* ZERO-COPY RECEIVE                                  */
+/*============================================================================*/
+
+/**
+ * @brief Snapshot the readable span of a socket's RX ring without copying
+ *
+ * @details One CS frame (Sn_RXBUF_SIZE .. Sn_RX_WR). Nothing is consumed.
+ *
+ * @param sock_num  Socket number
+ * @param span      Readable span, len == 0 if nothing is pending
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_peek(uint8_t sock_num, w5500_rx_span_t* span);
+
+/**
+ * @brief Read bytes of a peeked span straight from the chip
+ *
+ * @details One CS frame whatever the position: the chip wraps buffer
+ *          addresses at the socket buffer size.
+ *
+ * @param sock_num  Socket number
+ * @param span      Span from w5500_socket_peek()
+ * @param pos       Position in the span (0 = first unconsumed byte)
+ * @param dst       Destination for the bytes
+ * @param len       Bytes wanted, clamped to the end of the span
+ * @return int32_t  Number of bytes read, negative error code on failure
+ */
+int32_t w5500_socket_peek_read(uint8_t sock_num, const w5500_rx_span_t* span,
+                               uint16_t pos, uint8_t* dst, uint16_t len);
+
+/**
+ * @brief Release the first bytes of a span back to the chip (RECV command)
+ *
+ * @param sock_num  Socket number
+ * @param span      Span from w5500_socket_peek(), advanced past the bytes
+ * @param len       Bytes consumed, at most span->len
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_consume(uint8_t sock_num, w5500_rx_span_t* span, uint16_t len);
+
+/*============================================================================*/
+/* SOCKET MULTIPLEXING                                */
+/*============================================================================*/
+
+/**
+ * @brief Wait until any socket of a set is ready
+ *
+ * @details The first pass reads SIR, then Sn_IR of each socket flagged in
+ *          SIR, Sn_SR of each socket polled for W5500_POLLHUP and Sn_TX_FSR
+ *          of each socket polled for W5500_POLLOUT. Later passes read SIR
+ *          and touch only the sockets flagged in SIR or woken by the INT
+ *          dispatcher (w5500_irq); events it already latched are taken
+ *          without touching the chip. Between passes the caller sleeps on
+ *          the INT notification, so one task can serve every socket.
+ *          POLLOUT wakes on SENDOK for sockets using
+ *          w5500_socket_send_async(); other sockets polled for POLLOUT are
+ *          re-read every tick. POLLSENT is the SENDOK the dispatcher
+ *          latched after completing an async SEND (the async state has
+ *          already moved on: check w5500_socket_send_status() or
+ *          w5500_socket_send_writable()); without INT dispatch the socket
+ *          is polled with w5500_socket_send_poll() every tick instead.
+ *
+ * @note  POLLIN, POLLCON, DISCON and POLLSENT are edge events: reporting them
+ *        consumes them, like w5500_irq_wait(). An owner that leaves data in
+ *        the RX ring must w5500_irq_post() RECV to be woken again.
+ *        POLLHUP is also reported, as a level, while the socket is
+ *        SOCK_CLOSED (RST, retransmission or ARP timeout), checked on entry
+ *        and whenever the socket is flagged. Sn_IR TIMEOUT
+ *        is left to the sender waiting on it; a poller sleeping on a socket
+ *        that times out notices at its next wake-up (the dispatcher wakes
+ *        it when an async send has TIMEOUT unmasked).
+ *
+ * @param fds       Sockets and events of interest, revents filled in
+ * @param nfds      Number of entries in @p fds
+ * @param timeout   Timeout in kernel ticks (0 = check once, osWaitForever)
+ * @return int32_t  Number of entries with revents set, 0 on timeout,
+ *                  negative error code on failure
+ */
+int32_t w5500_socket_poll(w5500_pollfd_t* fds, uint8_t nfds, uint32_t timeout);
+
 /*============================================================================*/
 /* SOCKET STATUS                                      */
 /*============================================================================*/
 
+/**
+ * @brief Read a socket's whole register block (Sn_IR .. Sn_RX_WR) in one
+ *        SPI transaction
+ *
+ * @details One CS frame of 3 + 42 bytes replaces the separate getSn_SR /
+ *          getSn_RX_RSR / getSn_TX_FSR accessors, which cost a frame per
+ *          byte read and re-read the 16-bit counters until two reads agree.
+ *          Reading Sn_IR does not clear it.
+ *
+ * @param sock_num  Socket number
+ * @param regs      Decoded register snapshot
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_read_regs(uint8_t sock_num, w5500_sock_regs_t* regs);
+
 /**
  * @brief Check if a TCP socket is connected
  *
@@ -212,4 +996,106 @@ uint16_t w5500_socket_get_tx_buf_free_size(uint8_t sock_num);
  */
 uint16_t w5500_socket_get_rx_buf_size(uint8_t sock_num);
 
+/*============================================================================*/
+/* SOCKET MEMORY PROFILES                             */
+/*============================================================================*/
+
+/**
+ * @brief Get the layout of a named profile
+ *
+ * @param profile   Profile
+ * @return const w5500_mem_layout_t*  Layout, NULL for an unknown profile
+ */
+const w5500_mem_layout_t* w5500_socket_get_profile(w5500_mem_profile_t profile);
+
+/**
+ * @brief Re-partition the socket buffer memory at runtime
+ *
+ * @details The chip places the buffers back to back in socket order, so
+ *          resizing one socket moves every buffer above it. Each socket
+ *          whose buffer base or size changes must be closed; sockets whose
+ *          buffers stay in place may remain open. Validation and the
+ *          register writes run as one bus transaction, so no socket can be
+ *          opened in between.
+ *
+ * @param layout    New layout
+ * @return int8_t   W5500_SOCK_OK on success, W5500_SOCK_BUFFER_ERROR for an
+ *                  invalid layout, W5500_SOCK_BUSY if an affected socket is
+ *                  open
+ */
+int8_t w5500_socket_apply_layout(const w5500_mem_layout_t* layout);
+
+/**
+ * @brief Apply a named profile (see w5500_socket_apply_layout())
+ *
+ * @param profile   Profile
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_apply_profile(w5500_mem_profile_t profile);
+
+/*============================================================================*/
+/* SOCKET STATISTICS                                  */
+/*============================================================================*/
+
+/**
+ * @brief Copy a socket's traffic and latency counters
+ *
+ * @note  Counters are updated by the socket's owner without locking; a copy
+ *        taken while that task is inside a call may be one call behind.
+ *
+ * @param sock_num  Socket number
+ * @param stats     Counters
+ * @return int8_t   W5500_SOCK_OK on success, negative error code on failure
+ */
+int8_t w5500_socket_get_stats(uint8_t sock_num, w5500_sock_stats_t* stats);
+
+/**
+ * @brief Zero a socket's counters
+ *
+ * @param sock_num  Socket number, W5500_SOCK_ANY for every socket
+ */
+void w5500_socket_reset_stats(uint8_t sock_num);
+
+/**
+ * @brief Latency percentile from the histogram
+ *
+ * @param lat       Latency counters
+ * @param pct       Percentile, 1..100
+ * @return uint32_t Upper bound in cycles of the bucket holding the
+ *                  percentile, capped at max_cycles; 0 without samples
+ */
+uint32_t w5500_socket_latency_percentile(const w5500_latency_stats_t* lat, uint8_t pct);
+
+/**
+ * @brief Add one sample to latency counters
+ *
+ * @details The accounting of the socket calls, for modules that time their
+ *          own operations into a w5500_latency_stats_t.
+ *
+ * @param lat       Latency counters
+ * @param cycles    Sample in DWT cycles
+ */
+void w5500_socket_latency_add(w5500_latency_stats_t* lat, uint32_t cycles);
+
+/**
+ * @brief SPI bytes clocked per 1000 payload bytes
+ *
+ * @param stats     Counters from w5500_socket_get_stats()
+ * @return uint32_t Overhead in per-mille, 0 without payload
+ */
+uint32_t w5500_socket_spi_overhead(const w5500_sock_stats_t* stats);
+
+/**
+ * @brief Serialise every socket's counters into a compact binary record
+ *
+ * @details Layout in W5500_STATS_DUMP_* (header, then one record per socket
+ *          that has seen traffic or errors), suitable for shipping over a
+ *          UART or a UDP socket as is.
+ *
+ * @param buf       Destination
+ * @param size      Size of @p buf, W5500_STATS_DUMP_MAX_LEN always fits
+ * @return size_t   Bytes written, 0 if @p buf cannot hold the header
+ */
+size_t w5500_socket_stats_dump(uint8_t* buf, size_t size);
+
 #endif // _W5500_SOCKET_H_
@@ -23,23 +23,24 @@
  * ==========================================================================*/
 
 #include "w5500_spi.h"
+#include "w5500_irq.h"
+#include "w5500_socket.h"
+#include "spi.h"
 
-/* ==========================================================================
- * CONFIGURATION AND DEFINES
- * ==========================================================================*/
-
-#define W5500_SPI_TIMEOUT      10000
-
+#define BINLOG_MODULE        "w5500_spi"
+#define BINLOG_MODULE_LEVEL  BINLOG_LEVEL_INFO
+#include "binlog.h"
 
 /* ==========================================================================
  * PRIVATE VARIABLES
  * ==========================================================================*/
 
-extern SPI_HandleTypeDef hspi2;
+/* W5500 on the SPI2 bus manager: CS on PB12, occupancy stats per client */
+static spi_client_t w5500_spi_client = SPI_CLIENT_INIT("w5500", &hspi2, W5500_CS_GPIO_Port, W5500_CS_Pin);
 
-/* ==========================================================================
- * PRIVATE FUNCTION PROTOTYPES
- * ==========================================================================*/
+/* Failed bursts since boot, and the count at the last w5500_spi_reset() */
+static volatile uint32_t w5500_spi_errors;
+static uint32_t w5500_spi_errors_at_reset;
 
 /* ==========================================================================
  * SPI INTERFACE FUNCTIONS
@@ -52,8 +53,7 @@ extern SPI_HandleTypeDef hspi2;
  */
 void w5500_cs_select(void)
 {
-    HAL_GPIO_WritePin(W5500_CS_GPIO_Port, W5500_CS_Pin, GPIO_PIN_RESET);
-    printf("W5500_SPI_NCS: LOW\r\n");   // In w5500_cs_select()
+    spi_bus_select(&w5500_spi_client);
 }
 
 /**
@@ -62,18 +62,24 @@ void w5500_cs_select(void)
  */
 void w5500_cs_deselect(void)
 {
-    HAL_GPIO_WritePin(W5500_CS_GPIO_Port, W5500_CS_Pin, GPIO_PIN_SET);
-    printf("W5500_SPI_NCS: HIGH\r\n");  // In w5500_cs_deselect()
+    spi_bus_deselect(&w5500_spi_client);
 }
 
 /**
- * @brief Exchange a single byte over SPI
- * @param data Byte to send
- * @return Byte received
+ * @brief Receive a burst of bytes from the W5500
+ *
+ * @details The SPI2 bus manager runs long bursts on DMA and blocks the
+ *          calling task until they complete; short bursts stay polled.
+ *
+ * @param pBuf Destination buffer
+ * @param len  Number of bytes to receive
  */
 void w5500_spi_readburst(uint8_t* pBuf, uint16_t len)
 {
-    HAL_SPI_Receive(&hspi2, pBuf, len, W5500_SPI_TIMEOUT);
+    if (spi_bus_receive(&w5500_spi_client, pBuf, len) != HAL_OK) {
+        w5500_spi_errors++;
+        BINLOG_ERROR("SPI2 receive of %u bytes failed, error 0x%08x", len, hspi2.ErrorCode);
+    }
 }
 
 uint8_t w5500_spi_read(void) {
@@ -83,17 +89,84 @@ uint8_t w5500_spi_read(void) {
 }
 
 /**
- * @brief Exchange a single byte over SPI
- * @param data Byte to send
- * @return Byte received
+ * @brief Transmit a burst of bytes to the W5500
+ *
+ * @details Same DMA/polled split as w5500_spi_readburst().
+ *
+ * @param pBuf Source buffer
+ * @param len  Number of bytes to transmit
  */
 void w5500_spi_writeburst(uint8_t* pBuf, uint16_t len) {
-    HAL_SPI_Transmit(&hspi2, pBuf, len, W5500_SPI_TIMEOUT);
+    if (spi_bus_transmit(&w5500_spi_client, pBuf, len) != HAL_OK) {
+        w5500_spi_errors++;
+        BINLOG_ERROR("SPI2 transmit of %u bytes failed, error 0x%08x", len, hspi2.ErrorCode);
+    }
 }
 
 void w5500_spi_write(uint8_t byte) {
 	w5500_spi_writeburst(&byte, sizeof(byte));
 }
+
+/**
+ * @brief Take exclusive access to the W5500 (recursive SPI2 bus transaction)
+ * @note  No-op until the scheduler runs: there is a single context then.
+ */
+void w5500_spi_lock(void)
+{
+    spi_bus_acquire(&w5500_spi_client, osWaitForever);
+}
+
+/**
+ * @brief Release access taken with w5500_spi_lock()
+ */
+void w5500_spi_unlock(void)
+{
+    spi_bus_release(&w5500_spi_client);
+}
+
+/**
+ * @brief SPI2 bus client of the W5500 (transactions, bytes, occupancy)
+ */
+const spi_client_t *w5500_spi_get_client(void)
+{
+    return &w5500_spi_client;
+}
+
+/**
+ * @brief Failed SPI bursts since boot
+ * @details The wizchip callbacks return nothing, so a failure cannot reach
+ *          the ioLibrary caller: compare the count before and after a
+ *          sequence (under w5500_spi_lock() only your own bursts count).
+ */
+uint32_t w5500_spi_get_errors(void)
+{
+    return w5500_spi_errors;
+}
+
+/**
+ * @brief Set the SCK divider: SPI_BAUDRATEPRESCALER_n is log2(n) - 1 in BR
+ */
+bool w5500_spi_set_sck_div(uint16_t div)
+{
+    uint32_t br = 0;
+
+    if ((div < 2U) || (div > 256U) || ((div & (div - 1U)) != 0U)) {
+        return false;
+    }
+    while ((2U << br) < div) {
+        br++;
+    }
+    return spi_bus_set_prescaler(&w5500_spi_client, br << SPI_CR1_BR_Pos) == HAL_OK;
+}
+
+/**
+ * @brief Current SCK divider
+ */
+uint16_t w5500_spi_get_sck_div(void)
+{
+    return (uint16_t)(2U << (hspi2.Init.BaudRatePrescaler >> SPI_CR1_BR_Pos));
+}
+
 /* ==========================================================================
  * HARDWARE UTILITY FUNCTIONS
  * These functions provide utility operations for hardware control
@@ -117,42 +190,48 @@ void w5500_spi_write(uint8_t byte) {
  *  - Performs a hardware reset
  *  - Verifies SPI connection (VERSIONR == 0x04)
  *  - Initializes socket TX/RX buffers
- *  - Applies static IP configuration
+ *  - Applies the bring-up IP configuration (ETH_CONFIG_BRINGUP_MODE)
  *  - Reads back the applied network info for verification
  */
 void w5500_spi_init(void) {
-    printf("Initializing W5500...\r\n");
+    BINLOG_INFO("Initializing W5500");
     //__HAL_SPI_ENABLE(&hspi2);
 
 
-    // 1. Register Chip Select callbacks (GPIO control)
-    printf("Registering chip select callbacks...\r\n");
+    // 1. Register Chip Select callbacks (GPIO control) and the bus lock
+    reg_wizchip_cris_cbfunc(w5500_spi_lock, w5500_spi_unlock);
     reg_wizchip_cs_cbfunc(w5500_cs_select, w5500_cs_deselect);
 
     // 2. Register SPI byte-level read/write functions
-    printf("Registering SPI byte read/write callbacks...\r\n");
     reg_wizchip_spi_cbfunc(w5500_spi_read, w5500_spi_write);
 
     // Optional: Burst mode SPI (if implemented)
-    printf("Registering SPI burst read/write callbacks...\r\n");
     reg_wizchip_spiburst_cbfunc(w5500_spi_readburst, w5500_spi_writeburst);
 
 
-    // 5. Initialize socket buffer sizes (2KB for socket 0)
-    printf("Initializing socket buffers...\r\n");
-    uint8_t txsize[8] = {2, 2, 2, 2, 2, 2, 2, 2};  // 2KB TX on socket 0
-    uint8_t rxsize[8] = {2, 2, 2, 2, 2, 2, 2, 2};  // 2KB RX on socket 0
+    // 5. Socket buffer layout (ETH_CONFIG_MEM_PROFILE); re-partition later
+    //    with w5500_socket_apply_profile() while the affected sockets are closed
+    const w5500_mem_layout_t *mem = w5500_socket_get_profile(ETH_CONFIG_MEM_PROFILE);
+    uint8_t txsize[W5500_MAX_SOCKET];
+    uint8_t rxsize[W5500_MAX_SOCKET];
+    memcpy(txsize, mem->tx_kb, sizeof(txsize));
+    memcpy(rxsize, mem->rx_kb, sizeof(rxsize));
 
-    if (wizchip_init(txsize, rxsize) != 0) {
-        printf("Wizchip_Init: Failed\r\n");
+    uint32_t errors = w5500_spi_errors;
+    if ((wizchip_init(txsize, rxsize) != 0) || (w5500_spi_errors != errors)) {
+        BINLOG_ERROR("wizchip_init failed");
         return;
     }
 
-    // 6. Apply static IP configuration
-    printf("Applying static network configuration...\r\n");
+    // 6. Apply the bring-up address (ETH_CONFIG_BRINGUP_MODE) so services can
+    //    start now; DHCP swaps its lease in once it has one
+
+    eth_config_invalidate();    // Unknown register state: write every byte
+    eth_config_init_bringup();  // Initialize Bring-up Network Information Variables
+    eth_config_set_netinfo(&g_network_info);  // Set Bring-up Network Information
 
-    eth_config_init_static();  // Initialize Static Network Information Variables
-    eth_config_set_netinfo(&g_network_info);  // Set Static Network Information
+    // 7. Event dispatch on the INT pin
+    w5500_irq_init();
 
 }
 
@@ -183,15 +262,22 @@ void w5500_spi_init(void) {
  * @brief Restart the W5500 hardware
  * 
  * @details Performs a hardware reset by toggling the reset pin
- *          Can be called to recover from error conditions
+ *          Can be called to recover from error conditions, such as a
+ *          w5500_spi_get_errors() count that keeps rising
  * 
  */
 void w5500_spi_reset(void)
 {
+	uint32_t errors = w5500_spi_errors;
+	if (errors != w5500_spi_errors_at_reset) {
+		BINLOG_WARN("Reset after %u failed SPI bursts", errors - w5500_spi_errors_at_reset);
+	}
+	w5500_spi_errors_at_reset = errors;
 	HAL_GPIO_WritePin(W5500_RST_GPIO_Port, W5500_RST_Pin, GPIO_PIN_RESET);
 	HAL_Delay(10); // At least 1ms = safe for PMODE latching
 	HAL_GPIO_WritePin(W5500_RST_GPIO_Port, W5500_RST_Pin, GPIO_PIN_SET);
 	HAL_Delay(10); // Wait for internal init
+	eth_config_invalidate(); // Registers back to reset values
 }
 
 
@@ -17,11 +17,13 @@
 #ifndef _W5500_SPI_H_
 #define _W5500_SPI_H_
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdio.h>
 #include <cmsis_os2.h>
 #include "stm32g4xx_hal.h" // For HAL (if needed)
+#include "spi.h"             // SPI2 bus manager
 
 /* WIZnet driver includes */
 #include "eth_config.h"
@@ -67,21 +69,58 @@ void w5500_cs_select(void);
 void w5500_cs_deselect(void);
 
 /**
- * @brief Exchange a single byte over SPI
- * @param data Byte to send
- * @return Byte received
+ * @brief Receive a burst of bytes over SPI
+ * @note  Long bursts issued from a task run on DMA (SPI bus manager) and block
+ *        the caller on a task notification instead of spinning
+ * @param pBuf Destination buffer
+ * @param len Number of bytes to receive
  */
 void w5500_spi_readburst(uint8_t* pBuf, uint16_t len);
 uint8_t w5500_spi_read(void);
 
 /**
  * @brief Transmit multiple bytes over SPI
- * @param data Buffer containing data to send
+ * @note  Same DMA/polled split as w5500_spi_readburst()
+ * @param pBuf Buffer containing data to send
  * @param len Number of bytes to transmit
  */
 void w5500_spi_writeburst(uint8_t* pBuf, uint16_t len);
 void w5500_spi_write(uint8_t byte);
 
+/**
+ * @brief Take / release exclusive access to the W5500
+ * @note  A transaction on the SPI2 bus manager. Registered as the wizchip
+ *        critical section by w5500_spi_init(), so single register and buffer
+ *        accesses are already serialised between tasks. Hold it explicitly
+ *        (it is recursive) to keep a multi-access sequence atomic. Task
+ *        context only.
+ */
+void w5500_spi_lock(void);
+void w5500_spi_unlock(void);
+
+/**
+ * @brief Failed bursts (HAL/DMA error or timeout) since boot
+ * @note  The burst callbacks cannot report to the ioLibrary, so they latch
+ *        here: snapshot before a sequence, compare after. w5500_spi_reset()
+ *        logs the failures since the previous reset.
+ */
+uint32_t w5500_spi_get_errors(void);
+
+/**
+ * @brief SPI2 bus client of the W5500: transactions, bytes and occupancy
+ */
+const spi_client_t *w5500_spi_get_client(void);
+
+/**
+ * @brief Change / read the SPI2 SCK divider (2, 4, 8 .. 256 of PCLK1)
+ * @note  Takes effect at the next transaction. The W5500 is specified up to
+ *        33.3 MHz SCK (80 MHz typical).
+ * @return Set: false for a divider that is not a power of two in range,
+ *         or while a transfer runs
+ */
+bool w5500_spi_set_sck_div(uint16_t div);
+uint16_t w5500_spi_get_sck_div(void);
+
 
 /**
  * @brief Initialize the W5500 hardware and network settings
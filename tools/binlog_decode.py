@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Decode binlog records captured from the ITM/SWO stream.
+
+The firmware (Core/Src/binlog.c) emits, on ITM stimulus port 1:
+
+    u8  0xB0 | nargs
+    u16 format ID        (offset of the format string in .binlog_fmt)
+    u32 DWT cycle count
+    u32 args[nargs]
+
+Format strings live in the non-loaded .binlog_fmt section of the firmware
+ELF as "<level>\\x1f<module>\\x1f<format>".
+
+Usage:
+    binlog_decode.py firmware.elf swo.bin            # raw SWO/ITM capture
+    binlog_decode.py firmware.elf port1.bin --raw    # already demultiplexed
+    binlog_decode.py firmware.elf swo.bin --clock 144e6 --port 1
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+FMT_DROPPED = 0xFFFF
+FRAME_SYNC = 0xB0
+MAX_ARGS = 8
+LEVELS = {"E": "ERROR", "W": "WARN ", "I": "INFO ", "D": "DEBUG"}
+
+
+def load_formats(elf_path):
+    """Return {offset: (level, module, fmt)} from the .binlog_fmt section."""
+    with open(elf_path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        sys.exit("%s: not a 32-bit ELF file" % elf_path)
+
+    e_shoff, = struct.unpack_from("<I", elf, 0x20)
+    e_shentsize, e_shnum, e_shstrndx = struct.unpack_from("<HHH", elf, 0x2E)
+
+    def section(idx):
+        return struct.unpack_from("<IIIIIIIIII", elf, e_shoff + idx * e_shentsize)
+
+    shstr = section(e_shstrndx)
+    names_off = shstr[4]
+    for i in range(e_shnum):
+        name, _type, _flags, _addr, off, size = section(i)[:6]
+        end = elf.index(b"\0", names_off + name)
+        if elf[names_off + name:end] == b".binlog_fmt":
+            data = elf[off:off + size]
+            break
+    else:
+        sys.exit("%s: no .binlog_fmt section" % elf_path)
+
+    formats = {}
+    pos = 0
+    while pos < len(data):
+        end = data.find(b"\0", pos)
+        if end < 0:
+            break
+        if end > pos:
+            parts = data[pos:end].decode("ascii", "replace").split("\x1f", 2)
+            if len(parts) == 3:
+                formats[pos] = tuple(parts)
+        pos = end + 1
+    return formats
+
+
+def itm_port_bytes(stream, port):
+    """Demultiplex ITM software-source packets, yield payload bytes of port."""
+    i = 0
+    n = len(stream)
+    while i < n:
+        hdr = stream[i]
+        i += 1
+        if hdr in (0x00, 0x80, 0x70):           # synchronisation, overflow
+            continue
+        size_code = hdr & 0x03
+        if size_code == 0:                      # overflow / timestamp / extension
+            if hdr & 0x80:                      # continuation bytes follow
+                while i < n and stream[i] & 0x80:
+                    i += 1
+                i += 1
+            continue
+        size = {1: 1, 2: 2, 3: 4}[size_code]
+        payload = stream[i:i + size]
+        i += size
+        if (hdr & 0x04) == 0 and (hdr >> 3) == port:
+            for b in payload:
+                yield b
+
+
+_SPEC = re.compile(r"%([-+ 0#]*\d*(?:\.\d+)?)(hh|h|ll|l|z|j|t)?([diuxXoc%p])")
+
+
+def render(fmt, args):
+    """printf-style formatting of raw 32-bit argument words."""
+    it = iter(args)
+
+    def repl(m):
+        flags, _len, conv = m.groups()
+        if conv == "%":
+            return "%"
+        v = next(it, 0)
+        if conv in "di":
+            v = v - (1 << 32) if v & 0x80000000 else v
+            return ("%" + flags + "d") % v
+        if conv == "u":
+            return ("%" + flags + "d") % v
+        if conv == "c":
+            return chr(v & 0xFF)
+        if conv == "p":
+            return "0x%08x" % v
+        return ("%" + flags + conv) % v
+
+    return _SPEC.sub(repl, fmt)
+
+
+def decode(data, formats, clock_hz, out):
+    i = 0
+    n = len(data)
+    base = None
+    while i + 7 <= n:
+        hdr = data[i]
+        nargs = hdr & 0x0F
+        if (hdr & 0xF0) != FRAME_SYNC or nargs > MAX_ARGS:
+            i += 1                              # resynchronise
+            continue
+        fmt_id, ts = struct.unpack_from("<HI", data, i + 1)
+        if fmt_id != FMT_DROPPED and fmt_id not in formats:
+            i += 1
+            continue
+        end = i + 7 + 4 * nargs
+        if end > n:
+            break
+        args = struct.unpack_from("<%dI" % nargs, data, i + 7)
+        i = end
+
+        if base is None:
+            base = ts
+        t = ((ts - base) & 0xFFFFFFFF) / clock_hz
+
+        if fmt_id == FMT_DROPPED:
+            out.write("%12.6f  WARN  %-10s %u record(s) dropped\n" % (t, "binlog", args[0]))
+            continue
+        level, module, fmt = formats[fmt_id]
+        text = render(fmt, args).rstrip("\r\n")
+        out.write("%12.6f  %s %-10s %s\n" % (t, LEVELS.get(level, level), module, text))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("elf", help="firmware ELF containing .binlog_fmt")
+    ap.add_argument("capture", help="SWO capture file ('-' for stdin)")
+    ap.add_argument("--raw", action="store_true",
+                    help="capture holds port payload bytes only (no ITM framing)")
+    ap.add_argument("--port", type=int, default=1, help="ITM stimulus port (default 1)")
+    ap.add_argument("--clock", type=float, default=144e6,
+                    help="core clock in Hz for DWT timestamps (default 144e6)")
+    args = ap.parse_args()
+
+    formats = load_formats(args.elf)
+    if args.capture == "-":
+        stream = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            stream = f.read()
+    if not args.raw:
+        stream = bytes(itm_port_bytes(stream, args.port))
+    decode(stream, formats, args.clock, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
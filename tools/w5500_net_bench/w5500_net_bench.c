@@ -0,0 +1,635 @@
+/**
+ * @file    w5500_net_bench.c
+ * @brief   Host client of the on-board network benchmark (w5500_bench)
+ *
+ * @details Drives the board's benchmark service over its control connection
+ *          (Middlewares/In_House/eth/exc/w5500_bench_proto.h) and prints one
+ *          line per run: payload Mbit/s and packets/s as timed by the board,
+ *          core load, SPI2 bus occupancy and SCK utilisation, loss for UDP
+ *          and the round trip seen from the host for UDP echo.
+ *
+ *          Every combination of the given SCK dividers, buffer profiles and
+ *          modes is run in turn, so one invocation produces a comparable
+ *          table for a stack change. --csv prints machine-readable lines
+ *          (with a header) to keep per-commit results for regression
+ *          tracking. A profile other than "keep" needs the sockets it moves
+ *          closed on the board; otherwise boot the board with it
+ *          (ETH_CONFIG_MEM_PROFILE) and use "keep".
+ *
+ *          The board firmware must be built with the W5500_BENCH_ENABLE
+ *          symbol, which brings in the service and the run-time stats its
+ *          core load comes from. Against the W5500 model (tools/w5500_sim)
+ *          the board address is 127.0.0.1.
+ *
+ *          Build and run:
+ *
+ *            gcc -O2 -std=gnu11 -Wall -IMiddlewares/In_House/eth/exc \
+ *                tools/w5500_net_bench/w5500_net_bench.c -o w5500_net_bench
+ *
+ *            ./w5500_net_bench <board-ip> [-m mode[,mode..]] [-t seconds]
+ *                [-l len] [-r pps] [-d div[,div..]] [-P profile[,profile..]]
+ *                [--csv]
+ *
+ *            mode:    tcp-sink tcp-source udp-sink udp-blast udp-echo all
+ *            div:     SPI2 SCK divider 2..256, 0 = keep (default)
+ *            profile: balanced bulk-stream http-clients keep (default)
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "w5500_bench_proto.h"
+
+#define NB_MAX_LIST         8
+#define NB_CONNECT_MS       3000
+#define NB_RESULT_MS        5000    /* end of the run to the result record */
+#define NB_ECHO_TIMEOUT_MS  200     /* echo datagram considered lost */
+#define NB_RTT_MAX          65536   /* echo samples kept for percentiles */
+
+typedef struct {
+    struct in_addr board;
+    uint8_t  modes[NB_MAX_LIST];
+    uint8_t  nmodes;
+    uint16_t divs[NB_MAX_LIST];
+    uint8_t  ndivs;
+    uint8_t  profiles[NB_MAX_LIST];
+    uint8_t  nprofiles;
+    uint32_t duration_ms;
+    uint16_t len;
+    uint32_t rate_pps;
+    bool     csv;
+} nb_opts_t;
+
+/* What the host saw of a run, next to the board's result */
+typedef struct {
+    uint64_t sent;          /* datagrams sent (UDP sink / echo) */
+    uint64_t received;      /* datagrams received (UDP blast / echo) */
+    uint64_t bytes;         /* TCP source: bytes read */
+    uint32_t rtt_n;
+    double   rtt_min_us;
+    double   rtt_avg_us;
+    double   rtt_p99_us;
+} nb_host_t;
+
+static const char *const nb_mode_names[] = {
+    [W5500_BENCH_TCP_SINK]   = "tcp-sink",
+    [W5500_BENCH_TCP_SOURCE] = "tcp-source",
+    [W5500_BENCH_UDP_SINK]   = "udp-sink",
+    [W5500_BENCH_UDP_BLAST]  = "udp-blast",
+    [W5500_BENCH_UDP_ECHO]   = "udp-echo",
+};
+
+/* Same order as w5500_mem_profile_t */
+static const char *const nb_profile_names[] = { "balanced", "bulk-stream", "http-clients" };
+
+static const char *const nb_status_names[] = {
+    [W5500_BENCH_OK]          = "ok",
+    [W5500_BENCH_ERR_REQUEST] = "bad request",
+    [W5500_BENCH_ERR_SPI]     = "SCK divider refused",
+    [W5500_BENCH_ERR_PROFILE] = "profile refused (sockets open; boot with it)",
+    [W5500_BENCH_ERR_SOCKET]  = "no data socket",
+    [W5500_BENCH_ERR_TIMEOUT] = "no data",
+};
+
+static float nb_rtt[NB_RTT_MAX];
+
+/*============================================================================*/
+/*                         HELPERS                                            */
+/*============================================================================*/
+
+static uint64_t nb_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+static struct sockaddr_in nb_addr(struct in_addr ip, uint16_t port)
+{
+    struct sockaddr_in sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr = ip;
+    sa.sin_port = htons(port);
+    return sa;
+}
+
+static int nb_connect(struct in_addr ip, uint16_t port)
+{
+    struct sockaddr_in sa = nb_addr(ip, port);
+    uint64_t t_end = nb_now_us() + NB_CONNECT_MS * 1000ULL;
+    int one = 1;
+
+    /* The board opens the data socket just before its ack: retry briefly */
+    for (;;) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        if (fd < 0) {
+            return -1;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0) {
+            return fd;
+        }
+        close(fd);
+        if (nb_now_us() >= t_end) {
+            return -1;
+        }
+        usleep(10000);
+    }
+}
+
+/* Read exactly len bytes within timeout_ms; false on EOF, error or timeout */
+static bool nb_read_full(int fd, uint8_t *buf, size_t len, int timeout_ms)
+{
+    size_t got = 0;
+
+    while (got < len) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        ssize_t n;
+
+        if (poll(&p, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        n = recv(fd, buf + got, len - got, 0);
+        if (n <= 0) {
+            return false;
+        }
+        got += (size_t)n;
+    }
+    return true;
+}
+
+static int nb_cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a;
+    float y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*============================================================================*/
+/*                         DATA PHASES                                        */
+/*============================================================================*/
+
+static void nb_tcp_sink(const nb_opts_t *o, uint32_t duration_ms)
+{
+    static uint8_t buf[65536];
+    int fd = nb_connect(o->board, W5500_BENCH_DATA_PORT);
+    uint64_t t_end;
+
+    if (fd < 0) {
+        return;
+    }
+    memset(buf, 0x5A, sizeof(buf));
+    t_end = nb_now_us() + duration_ms * 1000ULL;
+    while (nb_now_us() < t_end) {
+        struct pollfd p = { .fd = fd, .events = POLLOUT };
+
+        if ((poll(&p, 1, 100) > 0) && (send(fd, buf, sizeof(buf), MSG_DONTWAIT | MSG_NOSIGNAL) < 0) &&
+            (errno != EAGAIN)) {
+            break;
+        }
+    }
+    /* FIN ends the run on the board */
+    shutdown(fd, SHUT_WR);
+    close(fd);
+}
+
+static void nb_tcp_source(const nb_opts_t *o, nb_host_t *h)
+{
+    static uint8_t buf[65536];
+    int fd = nb_connect(o->board, W5500_BENCH_DATA_PORT);
+
+    if (fd < 0) {
+        return;
+    }
+    /* Until the board closes at the end of the run */
+    for (;;) {
+        struct pollfd p = { .fd = fd, .events = POLLIN };
+        ssize_t n;
+
+        if (poll(&p, 1, (int)(o->duration_ms + NB_RESULT_MS)) <= 0) {
+            break;
+        }
+        n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        h->bytes += (uint64_t)n;
+    }
+    close(fd);
+}
+
+static void nb_udp_sink(const nb_opts_t *o, nb_host_t *h)
+{
+    uint8_t buf[W5500_BENCH_MAX_LEN];
+    struct sockaddr_in sa = nb_addr(o->board, W5500_BENCH_DATA_PORT);
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    uint64_t t0 = nb_now_us();
+    uint64_t t_end = t0 + o->duration_ms * 1000ULL;
+
+    if (fd < 0) {
+        return;
+    }
+    memset(buf, 0xA5, sizeof(buf));
+    for (uint64_t now = t0; now < t_end; now = nb_now_us()) {
+        if (o->rate_pps != 0U) {
+            uint64_t due = ((now - t0) * o->rate_pps) / 1000000ULL + 1U;
+            if (h->sent >= due) {
+                usleep(100);
+                continue;
+            }
+        }
+        w5500_bench_put32(buf, (uint32_t)h->sent);
+        if (sendto(fd, buf, o->len, 0, (struct sockaddr *)&sa, sizeof(sa)) == (ssize_t)o->len) {
+            h->sent++;
+        } else if ((errno == ENOBUFS) || (errno == EAGAIN)) {
+            usleep(100);
+        }
+    }
+    close(fd);
+}
+
+/* Runs until the result arrives on the control connection */
+static void nb_udp_blast(int ctrl, int fd, nb_host_t *h)
+{
+    uint8_t buf[W5500_BENCH_MAX_LEN];
+
+    for (;;) {
+        struct pollfd p[2] = { { .fd = fd, .events = POLLIN }, { .fd = ctrl, .events = POLLIN } };
+
+        if (poll(p, 2, NB_RESULT_MS) <= 0) {
+            return;
+        }
+        if ((p[0].revents & POLLIN) != 0) {
+            while (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+                h->received++;
+            }
+        }
+        if ((p[1].revents & (POLLIN | POLLHUP)) != 0) {
+            return;
+        }
+    }
+}
+
+/* One datagram in flight: timestamp and sequence number travel in it */
+static void nb_udp_echo(const nb_opts_t *o, nb_host_t *h)
+{
+    uint8_t buf[W5500_BENCH_MAX_LEN];
+    uint8_t rx[W5500_BENCH_MAX_LEN];
+    struct sockaddr_in sa = nb_addr(o->board, W5500_BENCH_DATA_PORT);
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    uint64_t t_end;
+    double sum = 0.0;
+
+    if ((fd < 0) || (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0)) {
+        return;
+    }
+    memset(buf, 0x3C, sizeof(buf));
+    h->rtt_min_us = 1e30;
+    t_end = nb_now_us() + o->duration_ms * 1000ULL;
+    while (nb_now_us() < t_end) {
+        uint32_t seq = (uint32_t)h->sent;
+        uint64_t t_tx = nb_now_us();
+
+        w5500_bench_put32(buf, seq);
+        if (send(fd, buf, o->len, 0) != (ssize_t)o->len) {
+            usleep(1000);
+            continue;
+        }
+        h->sent++;
+        for (;;) {
+            struct pollfd p = { .fd = fd, .events = POLLIN };
+            ssize_t n;
+
+            if (poll(&p, 1, NB_ECHO_TIMEOUT_MS) <= 0) {
+                break;      /* lost */
+            }
+            n = recv(fd, rx, sizeof(rx), 0);
+            if ((n >= 4) && (w5500_bench_get32(rx) == seq)) {
+                double rtt = (double)(nb_now_us() - t_tx);
+
+                h->received++;
+                sum += rtt;
+                if (rtt < h->rtt_min_us) {
+                    h->rtt_min_us = rtt;
+                }
+                if (h->rtt_n < NB_RTT_MAX) {
+                    nb_rtt[h->rtt_n++] = (float)rtt;
+                }
+                break;
+            }
+            /* A late echo of an earlier datagram: keep waiting */
+        }
+    }
+    close(fd);
+    if (h->rtt_n != 0U) {
+        qsort(nb_rtt, h->rtt_n, sizeof(nb_rtt[0]), nb_cmp_float);
+        h->rtt_avg_us = sum / (double)h->received;
+        h->rtt_p99_us = nb_rtt[(h->rtt_n * 99U) / 100U];
+    } else {
+        h->rtt_min_us = 0.0;
+    }
+}
+
+/*============================================================================*/
+/*                         RUN AND REPORT                                     */
+/*============================================================================*/
+
+static void nb_print_header(bool csv)
+{
+    if (csv) {
+        printf("mode,status,sck_div,sck_hz,profile,tx_kb,rx_kb,len,elapsed_us,"
+               "rx_bytes,rx_packets,tx_bytes,tx_packets,mbps,pps,cpu_pct,spi_busy_pct,"
+               "sck_pct,spi_bytes,spi_transactions,lost,reordered,errors,"
+               "host_sent,host_received,rtt_min_us,rtt_avg_us,rtt_p99_us,"
+               "service_p50_us,service_p99_us,service_max_us\n");
+    } else {
+        printf("%-10s %6s %6s %-12s %5s %5s %9s %9s %6s %6s %6s %8s %22s\n",
+               "mode", "sck", "MHz", "profile", "txKB", "rxKB", "Mbit/s", "pkt/s",
+               "cpu%", "spi%", "sck%", "loss", "rtt min/avg/p99 us");
+    }
+}
+
+static void nb_print(const nb_opts_t *o, const w5500_bench_result_t *r, const nb_host_t *h)
+{
+    double sec   = (r->elapsed_us != 0U) ? (double)r->elapsed_us / 1e6 : 0.0;
+    uint32_t bytes   = (r->rx_bytes > r->tx_bytes) ? r->rx_bytes : r->tx_bytes;
+    uint32_t packets = (r->rx_packets > r->tx_packets) ? r->rx_packets : r->tx_packets;
+    double mbps  = (sec > 0.0) ? ((double)bytes * 8.0) / sec / 1e6 : 0.0;
+    double pps   = (sec > 0.0) ? (double)packets / sec : 0.0;
+    double cyc_us = (r->core_hz != 0U) ? 1e6 / (double)r->core_hz : 0.0;
+    const char *profile = (r->profile < 3U) ? nb_profile_names[r->profile] : "keep";
+    uint64_t lost = 0;
+
+    /* Loss as the host counts it: datagrams sent that never arrived */
+    if (r->mode == W5500_BENCH_UDP_SINK) {
+        lost = (h->sent > r->rx_packets) ? h->sent - r->rx_packets : 0U;
+    } else if (r->mode == W5500_BENCH_UDP_BLAST) {
+        lost = (r->tx_packets > h->received) ? r->tx_packets - h->received : 0U;
+    } else if (r->mode == W5500_BENCH_UDP_ECHO) {
+        lost = h->sent - h->received;
+    }
+
+    if (o->csv) {
+        printf("%s,%u,%u,%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%.3f,%.1f,%.1f,%.1f,%.1f,%u,%u,%u,%u,%u,"
+               "%llu,%llu,%.1f,%.1f,%.1f,%.2f,%.2f,%.2f\n",
+               nb_mode_names[r->mode], r->status, r->sck_div, r->sck_hz, profile, r->tx_kb, r->rx_kb,
+               r->len, r->elapsed_us, r->rx_bytes, r->rx_packets, r->tx_bytes, r->tx_packets,
+               mbps, pps, r->cpu_permille / 10.0, r->spi_busy_permille / 10.0, r->sck_permille / 10.0,
+               r->spi_bytes, r->spi_transactions, r->lost, r->reordered, r->errors,
+               (unsigned long long)h->sent, (unsigned long long)h->received,
+               h->rtt_min_us, h->rtt_avg_us, h->rtt_p99_us,
+               r->service_p50 * cyc_us, r->service_p99 * cyc_us, r->service_max * cyc_us);
+        return;
+    }
+    printf("%-10s %6u %6.2f %-12s %5u %5u %9.3f %9.0f %6.1f %6.1f %6.1f %8llu",
+           nb_mode_names[r->mode], r->sck_div, r->sck_hz / 1e6, profile, r->tx_kb, r->rx_kb,
+           mbps, pps, r->cpu_permille / 10.0, r->spi_busy_permille / 10.0, r->sck_permille / 10.0,
+           (unsigned long long)lost);
+    if (r->mode == W5500_BENCH_UDP_ECHO) {
+        printf(" %7.0f/%6.0f/%6.0f   board %.1f/%.1f us",
+               h->rtt_min_us, h->rtt_avg_us, h->rtt_p99_us, r->service_p50 * cyc_us, r->service_p99 * cyc_us);
+    }
+    if ((r->mode == W5500_BENCH_TCP_SOURCE) && (h->bytes != r->tx_bytes)) {
+        printf("   host read %llu B", (unsigned long long)h->bytes);
+    }
+    printf("\n");
+}
+
+static int nb_run(const nb_opts_t *o, uint8_t mode, uint16_t div, uint8_t profile)
+{
+    w5500_bench_req_t req = {
+        .mode = mode, .profile = profile, .sck_div = div, .len = o->len,
+        .duration_ms = o->duration_ms, .rate_pps = o->rate_pps,
+    };
+    w5500_bench_result_t res;
+    nb_host_t host;
+    uint8_t msg[W5500_BENCH_RES_LEN];
+    int udp = -1;
+    int ctrl;
+
+    memset(&host, 0, sizeof(host));
+    if (mode == W5500_BENCH_UDP_BLAST) {
+        struct sockaddr_in sa = nb_addr((struct in_addr){ .s_addr = htonl(INADDR_ANY) }, 0);
+        socklen_t slen = sizeof(sa);
+        int size = 4 * 1024 * 1024;
+
+        udp = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        setsockopt(udp, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        if ((udp < 0) || (bind(udp, (struct sockaddr *)&sa, sizeof(sa)) != 0) ||
+            (getsockname(udp, (struct sockaddr *)&sa, &slen) != 0)) {
+            perror("udp socket");
+            return -1;
+        }
+        req.udp_port = ntohs(sa.sin_port);
+    }
+
+    ctrl = nb_connect(o->board, W5500_BENCH_PORT);
+    if (ctrl < 0) {
+        fprintf(stderr, "%s: cannot connect to %s:%u\n", nb_mode_names[mode], inet_ntoa(o->board),
+                W5500_BENCH_PORT);
+        return -1;
+    }
+    w5500_bench_req_encode(&req, msg);
+    if ((send(ctrl, msg, W5500_BENCH_REQ_LEN, MSG_NOSIGNAL) != (ssize_t)W5500_BENCH_REQ_LEN) ||
+        !nb_read_full(ctrl, msg, W5500_BENCH_ACK_LEN, NB_CONNECT_MS)) {
+        fprintf(stderr, "%s: no answer to the request\n", nb_mode_names[mode]);
+        close(ctrl);
+        return -1;
+    }
+    if (msg[0] != W5500_BENCH_OK) {
+        fprintf(stderr, "%s: %s\n", nb_mode_names[mode],
+                (msg[0] <= W5500_BENCH_ERR_TIMEOUT) ? nb_status_names[msg[0]] : "refused");
+        close(ctrl);
+        return -1;
+    }
+
+    switch (mode) {
+    case W5500_BENCH_TCP_SINK:   nb_tcp_sink(o, o->duration_ms); break;
+    case W5500_BENCH_TCP_SOURCE: nb_tcp_source(o, &host);        break;
+    case W5500_BENCH_UDP_SINK:   nb_udp_sink(o, &host);          break;
+    case W5500_BENCH_UDP_BLAST:  nb_udp_blast(ctrl, udp, &host); break;
+    case W5500_BENCH_UDP_ECHO:   nb_udp_echo(o, &host);          break;
+    default: break;
+    }
+
+    /* UDP modes end on the board's clock */
+    if (!nb_read_full(ctrl, msg, W5500_BENCH_RES_LEN, (int)(o->duration_ms + NB_RESULT_MS))) {
+        fprintf(stderr, "%s: no result\n", nb_mode_names[mode]);
+        close(ctrl);
+        return -1;
+    }
+    if (mode == W5500_BENCH_UDP_BLAST) {
+        /* Stragglers queued behind the result */
+        uint8_t buf[W5500_BENCH_MAX_LEN];
+        usleep(50000);
+        while (recv(udp, buf, sizeof(buf), MSG_DONTWAIT) > 0) {
+            host.received++;
+        }
+        close(udp);
+    }
+    close(ctrl);
+    w5500_bench_res_decode(msg, &res);
+    if (res.status != W5500_BENCH_OK) {
+        fprintf(stderr, "%s: %s\n", nb_mode_names[mode],
+                (res.status <= W5500_BENCH_ERR_TIMEOUT) ? nb_status_names[res.status] : "failed");
+        return -1;
+    }
+    nb_print(o, &res, &host);
+    return 0;
+}
+
+/*============================================================================*/
+/*                         COMMAND LINE                                       */
+/*============================================================================*/
+
+static void nb_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s <board-ip> [-m mode[,mode..]] [-t seconds] [-l len] [-r pps]\n"
+            "       [-d div[,div..]] [-P profile[,profile..]] [--csv]\n"
+            "  mode:    tcp-sink tcp-source udp-sink udp-blast udp-echo all (default all)\n"
+            "  -t:      run length, default 5 s, at most %u s\n"
+            "  -l:      bytes per send / datagram, 4..%u (default 1460 TCP, 1472 UDP)\n"
+            "  -r:      UDP sink/blast datagrams per second, 0 = flat out (default)\n"
+            "  div:     SPI2 SCK divider 2..256, 0 = keep (default)\n"
+            "  profile: balanced bulk-stream http-clients keep (default)\n",
+            argv0, W5500_BENCH_MAX_MS / 1000U, W5500_BENCH_MAX_LEN);
+}
+
+/* Parse a comma list through one item parser; false on a bad item */
+static bool nb_parse_list(char *arg, int (*item)(const char *), void *out, size_t width, uint8_t *count)
+{
+    *count = 0;
+    for (char *tok = strtok(arg, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        int v = item(tok);
+
+        if ((v < 0) || (*count >= NB_MAX_LIST)) {
+            return false;
+        }
+        if (width == 1U) {
+            ((uint8_t *)out)[(*count)++] = (uint8_t)v;
+        } else {
+            ((uint16_t *)out)[(*count)++] = (uint16_t)v;
+        }
+    }
+    return *count != 0U;
+}
+
+static int nb_parse_mode(const char *s)
+{
+    for (int m = W5500_BENCH_TCP_SINK; m <= W5500_BENCH_UDP_ECHO; m++) {
+        if (strcmp(s, nb_mode_names[m]) == 0) {
+            return m;
+        }
+    }
+    return -1;
+}
+
+static int nb_parse_div(const char *s)
+{
+    char *end;
+    long v = strtol(s, &end, 0);
+
+    return ((*end == '\0') && (v >= 0) && (v <= 256)) ? (int)v : -1;
+}
+
+static int nb_parse_profile(const char *s)
+{
+    if (strcmp(s, "keep") == 0) {
+        return W5500_BENCH_KEEP;
+    }
+    for (int p = 0; p < 3; p++) {
+        if (strcmp(s, nb_profile_names[p]) == 0) {
+            return p;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    nb_opts_t o = {
+        .nmodes = 0, .divs = { 0 }, .ndivs = 1, .profiles = { W5500_BENCH_KEEP }, .nprofiles = 1,
+        .duration_ms = 5000, .len = 0, .rate_pps = 0,
+    };
+    int failed = 0;
+
+    if ((argc < 2) || (inet_aton(argv[1], &o.board) == 0)) {
+        nb_usage(argv[0]);
+        return 2;
+    }
+    for (int i = 2; i < argc; i++) {
+        bool more = (i + 1 < argc);
+        bool ok = true;
+
+        if (strcmp(argv[i], "--csv") == 0) {
+            o.csv = true;
+        } else if ((strcmp(argv[i], "-m") == 0) && more) {
+            i++;
+            if (strcmp(argv[i], "all") != 0) {
+                ok = nb_parse_list(argv[i], nb_parse_mode, o.modes, 1U, &o.nmodes);
+            }
+        } else if ((strcmp(argv[i], "-t") == 0) && more) {
+            o.duration_ms = (uint32_t)(atof(argv[++i]) * 1000.0);
+            ok = (o.duration_ms > 0U) && (o.duration_ms <= W5500_BENCH_MAX_MS);
+        } else if ((strcmp(argv[i], "-l") == 0) && more) {
+            o.len = (uint16_t)atoi(argv[++i]);
+            ok = (o.len >= 4U) && (o.len <= W5500_BENCH_MAX_LEN);
+        } else if ((strcmp(argv[i], "-r") == 0) && more) {
+            o.rate_pps = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if ((strcmp(argv[i], "-d") == 0) && more) {
+            ok = nb_parse_list(argv[++i], nb_parse_div, o.divs, 2U, &o.ndivs);
+        } else if ((strcmp(argv[i], "-P") == 0) && more) {
+            ok = nb_parse_list(argv[++i], nb_parse_profile, o.profiles, 1U, &o.nprofiles);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            nb_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (o.nmodes == 0U) {
+        for (int m = W5500_BENCH_TCP_SINK; m <= W5500_BENCH_UDP_ECHO; m++) {
+            o.modes[o.nmodes++] = (uint8_t)m;
+        }
+    }
+
+    nb_print_header(o.csv);
+    for (uint8_t d = 0; d < o.ndivs; d++) {
+        for (uint8_t p = 0; p < o.nprofiles; p++) {
+            for (uint8_t m = 0; m < o.nmodes; m++) {
+                nb_opts_t run = o;
+                bool tcp = (o.modes[m] == W5500_BENCH_TCP_SINK) || (o.modes[m] == W5500_BENCH_TCP_SOURCE);
+
+                if (run.len == 0U) {
+                    run.len = tcp ? 1460U : W5500_BENCH_MAX_LEN;
+                }
+                if (nb_run(&run, o.modes[m], o.divs[d], o.profiles[p]) != 0) {
+                    failed++;
+                }
+                fflush(stdout);
+            }
+        }
+    }
+    return (failed != 0) ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""Compile the HTTP route list into a perfect-hash table for w5500_router.
+
+The route list (Middlewares/In_House/eth/exc/w5500_routes.txt) has one
+route per line:
+
+    GET     /api/led        http_led_get
+    PUT     /api/led        http_led_put
+
+method (GET, HEAD, POST, PUT, DELETE), path (no query) and the C handler,
+a w5500_http_route_fn_t defined somewhere in the firmware. '#' starts a
+comment.
+
+The output holds one entry per path, with a handler per method, placed by
+a minimal perfect hash ("hash and displace"):
+
+  - h is the FNV-1a hash of the path,
+  - the path's bucket is mix(h) % buckets, about two paths per bucket,
+  - each bucket gets the smallest displacement d that sends all its paths
+    to free entries: entry = mix(h + d * 0x9E3779B9) % entries,
+
+largest buckets first. There are exactly as many entries as paths unless
+no displacement fits, in which case the table grows by one free entry at
+a time. The hash must match w5500_router.c.
+
+The output is a C file to commit next to w5500_router.c; regenerate it
+whenever the route list changes.
+
+Usage:
+    w5500_route_gen.py Middlewares/In_House/eth/exc/w5500_routes.txt \\
+        -o Middlewares/In_House/eth/exc/w5500_routes_data.c
+"""
+
+import argparse
+import os
+import re
+import sys
+
+METHODS = ["GET", "HEAD", "POST", "PUT", "DELETE"]   # w5500_http_method_t order
+METHOD_ENUM = ["W5500_HTTP_GET", "W5500_HTTP_HEAD", "W5500_HTTP_POST",
+               "W5500_HTTP_PUT", "W5500_HTTP_DELETE"]
+FNV_BASIS = 0x811C9DC5
+FNV_PRIME = 0x01000193
+DISP_STEP = 0x9E3779B9
+DISP_MAX = 0xFFFF
+MASK32 = 0xFFFFFFFF
+HANDLER_RE = re.compile(r"^[A-Za-z_][A-Za-z0-9_]*$")
+
+
+def fnv(path):
+    h = FNV_BASIS
+    for b in path.encode("utf-8"):
+        h = ((h ^ b) * FNV_PRIME) & MASK32
+    return h
+
+
+def mix(h):
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & MASK32
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & MASK32
+    h ^= h >> 16
+    return h
+
+
+def slot(h, disp, size):
+    return mix((h + disp * DISP_STEP) & MASK32) % size
+
+
+def parse(source):
+    """Return {path: {method index: handler}} in file order."""
+    routes = {}
+    with open(source, encoding="utf-8") as f:
+        for num, line in enumerate(f, 1):
+            fields = line.split("#", 1)[0].split()
+            if not fields:
+                continue
+            where = "%s:%d" % (source, num)
+            if len(fields) != 3:
+                sys.exit("%s: expected <method> <path> <handler>" % where)
+            method, path, handler = fields
+            if method not in METHODS:
+                sys.exit("%s: unknown method %s" % (where, method))
+            if not path.startswith("/") or "?" in path:
+                sys.exit("%s: path must start with '/' and have no query" % where)
+            if len(path.encode("utf-8")) > 0xFFFF:
+                sys.exit("%s: path too long" % where)
+            if not HANDLER_RE.match(handler):
+                sys.exit("%s: %s is not a C identifier" % (where, handler))
+            per_method = routes.setdefault(path, {})
+            m = METHODS.index(method)
+            if m in per_method:
+                sys.exit("%s: %s %s routed twice" % (where, method, path))
+            per_method[m] = handler
+    return routes
+
+
+def place(members, order, hashes, size):
+    """Displace the buckets into size entries; None if one does not fit."""
+    table = [None] * size
+    disp = [0] * len(members)
+    for b in order:
+        if not members[b]:
+            break       # largest first: the rest are empty
+        for d in range(1, DISP_MAX + 1):
+            slots = [slot(hashes[p], d, size) for p in members[b]]
+            if len(set(slots)) == len(slots) and all(table[s] is None for s in slots):
+                break
+        else:
+            return None
+        disp[b] = d
+        for p, s in zip(members[b], slots):
+            table[s] = p
+    return disp, table
+
+
+def build(paths):
+    """Return (displacement per bucket, entries: path or None)."""
+    if not paths:
+        return [0], [None]
+    hashes = {p: fnv(p) for p in paths}
+    if len(set(hashes.values())) != len(paths):
+        sys.exit("two paths share an FNV-1a hash: rename one")
+
+    buckets = max(1, (len(paths) + 1) // 2)
+    members = [[] for _ in range(buckets)]
+    for p in paths:
+        members[mix(hashes[p]) % buckets].append(p)
+    order = sorted(range(buckets), key=lambda b: (-len(members[b]), b))
+
+    for size in range(len(paths), 0x10000):
+        result = place(members, order, hashes, size)
+        if result is not None:
+            return result
+    sys.exit("no perfect hash found")
+
+
+def c_string(s):
+    return '"%s"' % s.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def emit(out, source, routes, disp, table):
+    handlers = sorted({h for per in routes.values() for h in per.values()})
+    w = out.write
+    w("/**\n")
+    w(" * @file    %s\n" % os.path.basename(out.name))
+    w(" * @brief   HTTP route table for w5500_router (generated, do not edit)\n")
+    w(" *\n")
+    w(" * @details Generated by tools/w5500_route_gen.py from %s.\n" % source)
+    w(" *          %d paths, %d routes, %d entries, %d buckets.\n"
+      % (len(routes), sum(len(p) for p in routes.values()), len(table), len(disp)))
+    w(" */\n\n")
+    w(' #include "w5500_router.h"\n\n')
+
+    for h in handlers:
+        w(" void %s(const w5500_http_req_t* req, w5500_http_resp_t* resp);\n" % h)
+    if handlers:
+        w("\n")
+
+    w(" static const w5500_route_t route_entries[%d] = {\n" % len(table))
+    for path in table:
+        if path is None:
+            w("     { NULL, 0U, 0U, { NULL } },\n")
+            continue
+        per = routes[path]
+        allow = " | ".join("W5500_ROUTE_BIT(%s)" % METHOD_ENUM[m] for m in sorted(per))
+        fns = ", ".join(per.get(m, "NULL") for m in range(len(METHODS)))
+        w("     { %s, %dU, %s,\n       { %s } },\n"
+          % (c_string(path), len(path.encode("utf-8")), allow, fns))
+    w(" };\n\n")
+
+    w(" static const uint16_t route_disp[%d] = {" % len(disp))
+    for i, d in enumerate(disp):
+        w("\n    " if i % 12 == 0 else "")
+        w(" %dU," % d)
+    w("\n };\n\n")
+
+    w(" const w5500_route_table_t w5500_route_table = {\n")
+    w("     .routes       = route_entries,\n")
+    w("     .disp         = route_disp,\n")
+    w("     .route_count  = %dU,\n" % (len(table) if routes else 0))
+    w("     .bucket_count = %dU,\n" % len(disp))
+    w(" };\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("source", help="route list")
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    args = parser.parse_args()
+
+    routes = parse(args.source)
+    disp, table = build(list(routes))
+
+    with open(args.output, "w", newline="\n") as out:
+        emit(out, args.source, routes, disp, table)
+
+    print("%d paths in %d entries, %d buckets, largest displacement %d"
+          % (len(routes), len(table), len(disp), max(disp)))
+
+
+if __name__ == "__main__":
+    main()
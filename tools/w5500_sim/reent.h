@@ -0,0 +1,20 @@
+/**
+ * @file    reent.h
+ * @brief   Host build: stand-in for newlib's <reent.h>
+ *
+ * @details FreeRTOSConfig.h enables configUSE_NEWLIB_REENTRANT, so FreeRTOS.h
+ *          includes <reent.h> and embeds a struct _reent in every TCB. glibc
+ *          has neither; the host bench only needs the types to be complete.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _W5500_SIM_REENT_H_
+#define _W5500_SIM_REENT_H_
+
+struct _reent {
+    int _errno;
+};
+
+#endif /* _W5500_SIM_REENT_H_ */
@@ -0,0 +1,1233 @@
+/**
+ * @file    w5500_sim.c
+ * @brief   Host-side behavioral model of the W5500 behind the SPI callbacks
+ *
+ * @details One lock protects the whole chip: SPI frames from the firmware
+ *          and the model thread servicing the Linux sockets both run under
+ *          it, so every frame sees a consistent chip. The INT handler is
+ *          called after the lock is dropped, like an EXTI interrupt that
+ *          preempts whoever caused the edge.
+ *
+ *          Register layout and command semantics follow the W5500 datasheet
+ *          v1.1. Timing (RTR/RCR retransmission, PHY) is not modelled: the
+ *          link is always up at 100 Mbit/s full duplex.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#define _GNU_SOURCE
+
+#include "w5500_sim.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+/*============================================================================*/
+/*                         CHIP LAYOUT                                        */
+/*============================================================================*/
+
+#define SIM_SOCKETS             8U
+#define SIM_MEM_SIZE            16384U
+
+/* Control byte: BSB[7:3] RWB[2] OM[1:0] */
+#define SIM_CTRL_BSB(c)         ((uint8_t)((c) >> 3))
+#define SIM_CTRL_WRITE          0x04U
+
+/* Block select: 0 = common, 1 + 4n = Sn regs, 2 + 4n = Sn TX, 3 + 4n = Sn RX */
+#define SIM_BSB_COMMON          0x00U
+#define SIM_BSB_SOCK(b)         (((b) - 1U) >> 2)
+#define SIM_BSB_KIND(b)         (((b) - 1U) & 0x03U)
+#define SIM_KIND_REG            0U
+#define SIM_KIND_TX             1U
+#define SIM_KIND_RX             2U
+
+/* Common registers */
+#define SIM_MR                  0x0000U
+#define SIM_IR                  0x0015U
+#define SIM_IMR                 0x0016U
+#define SIM_SIR                 0x0017U
+#define SIM_SIMR                0x0018U
+#define SIM_RTR                 0x0019U
+#define SIM_RCR                 0x001BU
+#define SIM_PHYCFGR             0x002EU
+#define SIM_VERSIONR            0x0039U
+#define SIM_COMMON_SIZE         0x0040U
+
+#define SIM_MR_RST              0x80U
+#define SIM_PHYCFGR_UP          0xBFU   /* RST, all capable, 100 FD, link  */
+#define SIM_VERSION             0x04U
+
+/* Socket registers */
+#define SIM_Sn_MR               0x00U
+#define SIM_Sn_CR               0x01U
+#define SIM_Sn_IR               0x02U
+#define SIM_Sn_SR               0x03U
+#define SIM_Sn_PORT             0x04U
+#define SIM_Sn_DIPR             0x0CU
+#define SIM_Sn_DPORT            0x10U
+#define SIM_Sn_MSSR             0x12U
+#define SIM_Sn_PROTO            0x14U
+#define SIM_Sn_TTL              0x16U
+#define SIM_Sn_RXBUF_SIZE       0x1EU
+#define SIM_Sn_TXBUF_SIZE       0x1FU
+#define SIM_Sn_TX_FSR           0x20U
+#define SIM_Sn_TX_RD            0x22U
+#define SIM_Sn_TX_WR            0x24U
+#define SIM_Sn_RX_RSR           0x26U
+#define SIM_Sn_RX_RD            0x28U
+#define SIM_Sn_RX_WR            0x2AU
+#define SIM_Sn_IMR              0x2CU
+#define SIM_Sn_FRAG             0x2DU
+#define SIM_Sn_KPALVTR          0x2FU
+#define SIM_SOCK_REG_SIZE       0x30U
+
+#define SIM_Sn_MR_PROTO         0x0FU
+#define SIM_PROTO_TCP           0x01U
+#define SIM_PROTO_UDP           0x02U
+#define SIM_PROTO_IPRAW         0x03U
+#define SIM_PROTO_MACRAW        0x04U
+
+#define SIM_CR_OPEN             0x01U
+#define SIM_CR_LISTEN           0x02U
+#define SIM_CR_CONNECT          0x04U
+#define SIM_CR_DISCON           0x08U
+#define SIM_CR_CLOSE            0x10U
+#define SIM_CR_SEND             0x20U
+#define SIM_CR_SEND_MAC         0x21U
+#define SIM_CR_SEND_KEEP        0x22U
+#define SIM_CR_RECV             0x40U
+
+#define SIM_IR_CON              0x01U
+#define SIM_IR_DISCON           0x02U
+#define SIM_IR_RECV             0x04U
+#define SIM_IR_TIMEOUT          0x08U
+#define SIM_IR_SENDOK           0x10U
+
+#define SIM_SR_CLOSED           0x00U
+#define SIM_SR_INIT             0x13U
+#define SIM_SR_LISTEN           0x14U
+#define SIM_SR_SYNSENT          0x15U
+#define SIM_SR_ESTABLISHED      0x17U
+#define SIM_SR_CLOSE_WAIT       0x1CU
+#define SIM_SR_UDP              0x22U
+#define SIM_SR_IPRAW            0x32U
+#define SIM_SR_MACRAW           0x42U
+
+/* UDP datagrams in RX memory: 4-byte source IP, 2-byte port, 2-byte length */
+#define SIM_UDP_HDR_LEN         8U
+#define SIM_IPRAW_HDR_LEN       6U
+
+#define SIM_DEFAULT_PORT_OFFSET 10000U
+#define SIM_DEFAULT_POLL_MS     1U
+
+/*============================================================================*/
+/*                         STATE                                              */
+/*============================================================================*/
+
+typedef struct {
+    uint8_t  regs[SIM_SOCK_REG_SIZE];
+    int      fd;                /* Linux socket, -1 when none                */
+    bool     eof;               /* TCP peer sent FIN                         */
+    uint32_t tx_pending;        /* TCP bytes from TX_RD not yet in the kernel */
+} sim_sock_t;
+
+typedef enum {
+    SIM_PHASE_ADDR_HI,
+    SIM_PHASE_ADDR_LO,
+    SIM_PHASE_CTRL,
+    SIM_PHASE_DATA,
+} sim_phase_t;
+
+static struct {
+    pthread_mutex_t    lock;
+    pthread_t          thread;
+    bool               running;
+    int                wake[2];         /* pipe: state changed, re-poll      */
+    w5500_sim_config_t cfg;
+
+    uint8_t            common[SIM_COMMON_SIZE];
+    sim_sock_t         sock[SIM_SOCKETS];
+    uint8_t            tx_mem[SIM_MEM_SIZE];
+    uint8_t            rx_mem[SIM_MEM_SIZE];
+
+    /* SPI frame decoder */
+    bool               cs;
+    sim_phase_t        phase;
+    uint16_t           addr;
+    uint8_t            ctrl;
+
+    bool               int_level;
+    uint32_t           int_edges_pending;
+    void             (*int_handler)(void);
+
+    w5500_sim_stats_t  stats;
+} sim = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = { -1, -1 },
+};
+
+/*============================================================================*/
+/*                         REGISTER HELPERS                                   */
+/*============================================================================*/
+
+static inline uint16_t sim_get16(const uint8_t *p)
+{
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static inline void sim_set16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+static uint32_t sim_tx_size(uint8_t sn)
+{
+    return (uint32_t)sim.sock[sn].regs[SIM_Sn_TXBUF_SIZE] * 1024U;
+}
+
+static uint32_t sim_rx_size(uint8_t sn)
+{
+    return (uint32_t)sim.sock[sn].regs[SIM_Sn_RXBUF_SIZE] * 1024U;
+}
+
+/* Start of a socket's buffer: the sockets below it come first */
+static uint32_t sim_tx_base(uint8_t sn)
+{
+    uint32_t base = 0;
+    for (uint8_t i = 0; i < sn; i++) {
+        base += sim_tx_size(i);
+    }
+    return base;
+}
+
+static uint32_t sim_rx_base(uint8_t sn)
+{
+    uint32_t base = 0;
+    for (uint8_t i = 0; i < sn; i++) {
+        base += sim_rx_size(i);
+    }
+    return base;
+}
+
+/* Buffer-block addresses wrap at the socket buffer size */
+static uint8_t *sim_tx_byte(uint8_t sn, uint16_t ptr)
+{
+    uint32_t size = sim_tx_size(sn);
+    uint32_t off = (size != 0U) ? (ptr % size) : 0U;
+    return &sim.tx_mem[(sim_tx_base(sn) + off) % SIM_MEM_SIZE];
+}
+
+static uint8_t *sim_rx_byte(uint8_t sn, uint16_t ptr)
+{
+    uint32_t size = sim_rx_size(sn);
+    uint32_t off = (size != 0U) ? (ptr % size) : 0U;
+    return &sim.rx_mem[(sim_rx_base(sn) + off) % SIM_MEM_SIZE];
+}
+
+static uint16_t sim_tx_used(uint8_t sn)
+{
+    const uint8_t *r = sim.sock[sn].regs;
+    return (uint16_t)(sim_get16(&r[SIM_Sn_TX_WR]) - sim_get16(&r[SIM_Sn_TX_RD]));
+}
+
+static uint16_t sim_tx_fsr(uint8_t sn)
+{
+    uint32_t size = sim_tx_size(sn);
+    uint16_t used = sim_tx_used(sn);
+    return (used >= size) ? 0U : (uint16_t)(size - used);
+}
+
+static uint16_t sim_rx_rsr(uint8_t sn)
+{
+    const uint8_t *r = sim.sock[sn].regs;
+    return (uint16_t)(sim_get16(&r[SIM_Sn_RX_WR]) - sim_get16(&r[SIM_Sn_RX_RD]));
+}
+
+static uint16_t sim_rx_free(uint8_t sn)
+{
+    uint32_t size = sim_rx_size(sn);
+    uint16_t used = sim_rx_rsr(sn);
+    return (used >= size) ? 0U : (uint16_t)(size - used);
+}
+
+static uint16_t sim_port_to_host(uint16_t port)
+{
+    return (port < 1024U) ? (uint16_t)(port + sim.cfg.port_offset) : port;
+}
+
+static uint16_t sim_port_from_host(uint16_t port)
+{
+    uint16_t off = sim.cfg.port_offset;
+    return ((off != 0U) && (port >= off) && (port < off + 1024U)) ? (uint16_t)(port - off) : port;
+}
+
+static uint8_t sim_sir(void)
+{
+    uint8_t sir = 0;
+    for (uint8_t sn = 0; sn < SIM_SOCKETS; sn++) {
+        if ((sim.sock[sn].regs[SIM_Sn_IR] & sim.sock[sn].regs[SIM_Sn_IMR]) != 0U) {
+            sir |= (uint8_t)(1U << sn);
+        }
+    }
+    return sir;
+}
+
+/* Recompute the INT level; called with the lock held after any change */
+static void sim_update_int(void)
+{
+    bool level = ((sim.common[SIM_IR] & sim.common[SIM_IMR]) != 0U) ||
+                 ((sim_sir() & sim.common[SIM_SIMR]) != 0U);
+
+    if (level && !sim.int_level) {
+        sim.stats.int_edges++;
+        sim.int_edges_pending++;
+    }
+    sim.int_level = level;
+}
+
+/* Drop the lock, then deliver the INT edges raised while it was held */
+static void sim_unlock(void)
+{
+    uint32_t edges = sim.int_edges_pending;
+    void (*handler)(void) = sim.int_handler;
+
+    sim.int_edges_pending = 0;
+    pthread_mutex_unlock(&sim.lock);
+
+    while ((handler != NULL) && (edges-- > 0U)) {
+        handler();
+    }
+}
+
+static void sim_wake(void)
+{
+    if (sim.wake[1] >= 0) {
+        (void)!write(sim.wake[1], "w", 1);
+    }
+}
+
+/*============================================================================*/
+/*                         RESET                                              */
+/*============================================================================*/
+
+static void sim_sock_close_fd(sim_sock_t *s)
+{
+    if (s->fd >= 0) {
+        close(s->fd);
+        s->fd = -1;
+    }
+    s->eof = false;
+    s->tx_pending = 0;
+}
+
+static void sim_reset_chip(void)
+{
+    for (uint8_t sn = 0; sn < SIM_SOCKETS; sn++) {
+        sim_sock_t *s = &sim.sock[sn];
+
+        sim_sock_close_fd(s);
+        memset(s->regs, 0, sizeof(s->regs));
+        s->regs[SIM_Sn_TTL]        = 0x80U;
+        s->regs[SIM_Sn_RXBUF_SIZE] = 2U;
+        s->regs[SIM_Sn_TXBUF_SIZE] = 2U;
+        s->regs[SIM_Sn_IMR]        = 0xFFU;
+        s->regs[SIM_Sn_KPALVTR]    = 0x00U;
+        sim_set16(&s->regs[SIM_Sn_MSSR], 0x0000U);
+        sim_set16(&s->regs[SIM_Sn_FRAG], 0x4000U);
+    }
+    memset(sim.common, 0, sizeof(sim.common));
+    sim_set16(&sim.common[SIM_RTR], 0x07D0U);
+    sim.common[SIM_RCR]      = 0x08U;
+    sim.common[SIM_PHYCFGR]  = SIM_PHYCFGR_UP;
+    sim.common[SIM_VERSIONR] = SIM_VERSION;
+    memset(sim.tx_mem, 0, sizeof(sim.tx_mem));
+    memset(sim.rx_mem, 0, sizeof(sim.rx_mem));
+    sim_update_int();
+}
+
+/*============================================================================*/
+/*                         SOCKET COMMANDS                                    */
+/*============================================================================*/
+
+static void sim_raise(uint8_t sn, uint8_t ir)
+{
+    sim.sock[sn].regs[SIM_Sn_IR] |= ir;
+}
+
+static void sim_set_sr(uint8_t sn, uint8_t sr)
+{
+    sim.sock[sn].regs[SIM_Sn_SR] = sr;
+}
+
+static void sim_fill_addr(uint8_t sn, struct sockaddr_in *sa)
+{
+    const uint8_t *r = sim.sock[sn].regs;
+
+    memset(sa, 0, sizeof(*sa));
+    sa->sin_family = AF_INET;
+    memcpy(&sa->sin_addr.s_addr, &r[SIM_Sn_DIPR], 4);
+    sa->sin_port = htons(sim_port_to_host(sim_get16(&r[SIM_Sn_DPORT])));
+}
+
+/* A closed socket, TCP error or refused connection ends in CLOSED + TIMEOUT */
+static void sim_sock_fail(uint8_t sn)
+{
+    sim_sock_close_fd(&sim.sock[sn]);
+    sim_set_sr(sn, SIM_SR_CLOSED);
+    sim_raise(sn, SIM_IR_TIMEOUT);
+}
+
+static int sim_open_fd(uint8_t sn, int type)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    struct sockaddr_in sa;
+    int one = 1;
+
+    s->fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->fd < 0) {
+        return -1;
+    }
+    setsockopt(s->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    /* The chip lets several sockets listen on one port (HTTP server pool) */
+    setsockopt(s->fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+    if (type == SOCK_DGRAM) {
+        setsockopt(s->fd, SOL_SOCKET, SO_BROADCAST, &one, sizeof(one));
+    } else {
+        setsockopt(s->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_ANY);
+    sa.sin_port = htons(sim_port_to_host(sim_get16(&s->regs[SIM_Sn_PORT])));
+    if (bind(s->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        sim_sock_close_fd(s);
+        return -1;
+    }
+    return 0;
+}
+
+static void sim_cmd_open(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+
+    sim_sock_close_fd(s);
+    sim_set16(&r[SIM_Sn_TX_RD], 0);
+    sim_set16(&r[SIM_Sn_TX_WR], 0);
+    sim_set16(&r[SIM_Sn_RX_RD], 0);
+    sim_set16(&r[SIM_Sn_RX_WR], 0);
+
+    switch (r[SIM_Sn_MR] & SIM_Sn_MR_PROTO) {
+    case SIM_PROTO_TCP:
+        /* The Linux socket is created by LISTEN or CONNECT */
+        sim_set_sr(sn, SIM_SR_INIT);
+        break;
+    case SIM_PROTO_UDP:
+        sim_set_sr(sn, (sim_open_fd(sn, SOCK_DGRAM) == 0) ? SIM_SR_UDP : SIM_SR_CLOSED);
+        break;
+    case SIM_PROTO_IPRAW:
+        /* Opens without a Linux socket too (no CAP_NET_RAW): the socket
+         * then carries no traffic */
+        s->fd = socket(AF_INET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, r[SIM_Sn_PROTO]);
+        sim_set_sr(sn, SIM_SR_IPRAW);
+        break;
+    case SIM_PROTO_MACRAW:
+        sim_set_sr(sn, (sn == 0U) ? SIM_SR_MACRAW : SIM_SR_CLOSED);
+        break;
+    default:
+        sim_set_sr(sn, SIM_SR_CLOSED);
+        break;
+    }
+}
+
+static void sim_cmd_listen(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+
+    if (s->regs[SIM_Sn_SR] != SIM_SR_INIT) {
+        return;
+    }
+    if ((sim_open_fd(sn, SOCK_STREAM) != 0) || (listen(s->fd, 1) != 0)) {
+        sim_sock_fail(sn);
+        return;
+    }
+    sim_set_sr(sn, SIM_SR_LISTEN);
+}
+
+static void sim_cmd_connect(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    struct sockaddr_in sa;
+
+    if (s->regs[SIM_Sn_SR] != SIM_SR_INIT) {
+        return;
+    }
+    if (sim_open_fd(sn, SOCK_STREAM) != 0) {
+        sim_sock_fail(sn);
+        return;
+    }
+    sim_fill_addr(sn, &sa);
+    if ((connect(s->fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) && (errno != EINPROGRESS)) {
+        sim_sock_fail(sn);
+        return;
+    }
+    sim_set_sr(sn, SIM_SR_SYNSENT);
+}
+
+/* Push the TCP bytes between TX_RD and TX_WR into the kernel; SENDOK once
+ * they are all gone. Called by SEND and by the model thread on POLLOUT. */
+static void sim_tcp_flush(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+
+    if (sim_tx_size(sn) == 0U) {
+        s->tx_pending = 0;
+    }
+    while (s->tx_pending > 0U) {
+        uint16_t rd = sim_get16(&r[SIM_Sn_TX_RD]);
+        uint32_t size = sim_tx_size(sn);
+        uint32_t off = rd % size;
+        uint32_t chunk = size - off;
+        ssize_t n;
+
+        if (chunk > s->tx_pending) {
+            chunk = s->tx_pending;
+        }
+        n = send(s->fd, sim_tx_byte(sn, rd), chunk, MSG_NOSIGNAL);
+        if (n < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                sim_sock_fail(sn);
+            }
+            return;
+        }
+        sim_set16(&r[SIM_Sn_TX_RD], (uint16_t)(rd + (uint16_t)n));
+        s->tx_pending -= (uint32_t)n;
+        sim.stats.net_tx_bytes += (uint64_t)n;
+    }
+    sim.stats.net_tx_packets++;
+    sim_raise(sn, SIM_IR_SENDOK);
+}
+
+static void sim_udp_send(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+    uint16_t rd = sim_get16(&r[SIM_Sn_TX_RD]);
+    uint16_t len = sim_tx_used(sn);
+    uint8_t dgram[SIM_MEM_SIZE];
+    struct sockaddr_in sa;
+
+    for (uint16_t i = 0; i < len; i++) {
+        dgram[i] = *sim_tx_byte(sn, (uint16_t)(rd + i));
+    }
+    sim_fill_addr(sn, &sa);
+    if (sendto(s->fd, dgram, len, 0, (struct sockaddr *)&sa, sizeof(sa)) < 0) {
+        /* The chip times out ARP for an unreachable destination */
+        sim_raise(sn, SIM_IR_TIMEOUT);
+    } else {
+        sim.stats.net_tx_bytes += len;
+        sim.stats.net_tx_packets++;
+        sim_raise(sn, SIM_IR_SENDOK);
+    }
+    sim_set16(&r[SIM_Sn_TX_RD], sim_get16(&r[SIM_Sn_TX_WR]));
+}
+
+/* MACRAW frames come straight back into the RX ring, as through a loopback
+ * plug, behind the 2-byte length the chip puts in front of each frame.
+ * Frames that do not fit are dropped, like on an RX overrun. */
+static void sim_macraw_loopback(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+    uint16_t rd = sim_get16(&r[SIM_Sn_TX_RD]);
+    uint16_t len = sim_tx_used(sn);
+    uint16_t wr;
+
+    sim.stats.net_tx_bytes += len;
+    sim.stats.net_tx_packets++;
+    if ((uint32_t)len + 2U > sim_rx_free(sn)) {
+        return;
+    }
+    wr = sim_get16(&r[SIM_Sn_RX_WR]);
+    *sim_rx_byte(sn, wr++) = (uint8_t)((len + 2U) >> 8);
+    *sim_rx_byte(sn, wr++) = (uint8_t)(len + 2U);
+    for (uint16_t i = 0; i < len; i++) {
+        *sim_rx_byte(sn, wr++) = *sim_tx_byte(sn, (uint16_t)(rd + i));
+    }
+    sim_set16(&r[SIM_Sn_RX_WR], wr);
+    sim.stats.net_rx_bytes += len;
+    sim.stats.net_rx_packets++;
+    sim_raise(sn, SIM_IR_RECV);
+}
+
+static void sim_cmd_send(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t sr = s->regs[SIM_Sn_SR];
+
+    if (((sr == SIM_SR_UDP) || (sr == SIM_SR_IPRAW)) && (s->fd >= 0)) {
+        /* Linux raw sockets take the IP payload and ignore the port too */
+        sim_udp_send(sn);
+    } else if (((sr == SIM_SR_ESTABLISHED) || (sr == SIM_SR_CLOSE_WAIT)) && (s->fd >= 0)) {
+        s->tx_pending = sim_tx_used(sn);
+        sim_tcp_flush(sn);
+    } else if (sr == SIM_SR_MACRAW) {
+        sim_macraw_loopback(sn);
+        sim_set16(&s->regs[SIM_Sn_TX_RD], sim_get16(&s->regs[SIM_Sn_TX_WR]));
+        sim_raise(sn, SIM_IR_SENDOK);
+    } else if (sr == SIM_SR_IPRAW) {
+        /* IPRAW without a raw socket: the packet is dropped on the wire */
+        sim_set16(&s->regs[SIM_Sn_TX_RD], sim_get16(&s->regs[SIM_Sn_TX_WR]));
+        sim_raise(sn, SIM_IR_SENDOK);
+    }
+}
+
+static void sim_cmd_discon(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t sr = s->regs[SIM_Sn_SR];
+
+    if ((sr == SIM_SR_ESTABLISHED) || (sr == SIM_SR_CLOSE_WAIT) || (sr == SIM_SR_SYNSENT)) {
+        if (s->fd >= 0) {
+            /* FIN goes out after the queued data, as on the chip */
+            if (s->tx_pending > 0U) {
+                fcntl(s->fd, F_SETFL, fcntl(s->fd, F_GETFL) & ~O_NONBLOCK);
+                sim_tcp_flush(sn);
+            }
+            if (s->fd >= 0) {
+                shutdown(s->fd, SHUT_WR);
+            }
+        }
+        sim_sock_close_fd(s);
+        sim_set_sr(sn, SIM_SR_CLOSED);
+        sim_raise(sn, SIM_IR_DISCON);
+    }
+}
+
+static void sim_cmd_recv(uint8_t sn)
+{
+    /* RX_RD has moved: the model thread can fill the freed space. Data still
+     * pending after the command raises RECV again, as on the chip. */
+    if (sim_rx_rsr(sn) != 0U) {
+        sim_raise(sn, SIM_IR_RECV);
+    }
+}
+
+static void sim_command(uint8_t sn, uint8_t cmd)
+{
+    sim.stats.commands++;
+
+    switch (cmd) {
+    case SIM_CR_OPEN:      sim_cmd_open(sn);    break;
+    case SIM_CR_LISTEN:    sim_cmd_listen(sn);  break;
+    case SIM_CR_CONNECT:   sim_cmd_connect(sn); break;
+    case SIM_CR_DISCON:    sim_cmd_discon(sn);  break;
+    case SIM_CR_SEND:
+    case SIM_CR_SEND_MAC:  sim_cmd_send(sn);    break;
+    case SIM_CR_SEND_KEEP: break;
+    case SIM_CR_RECV:      sim_cmd_recv(sn);    break;
+    case SIM_CR_CLOSE:
+        sim_sock_close_fd(&sim.sock[sn]);
+        sim_set_sr(sn, SIM_SR_CLOSED);
+        break;
+    default:
+        break;
+    }
+    sim_wake();
+}
+
+/*============================================================================*/
+/*                         REGISTER ACCESS                                    */
+/*============================================================================*/
+
+static uint8_t sim_read_common(uint16_t addr)
+{
+    if (addr == SIM_SIR) {
+        return sim_sir();
+    }
+    return (addr < SIM_COMMON_SIZE) ? sim.common[addr] : 0U;
+}
+
+static void sim_write_common(uint16_t addr, uint8_t v)
+{
+    switch (addr) {
+    case SIM_MR:
+        if ((v & SIM_MR_RST) != 0U) {
+            sim_reset_chip();
+            return;
+        }
+        sim.common[addr] = v;
+        break;
+    case SIM_IR:
+        sim.common[addr] &= (uint8_t)~v;
+        break;
+    case SIM_SIR:
+    case SIM_PHYCFGR:
+    case SIM_VERSIONR:
+        break;
+    default:
+        if (addr < SIM_COMMON_SIZE) {
+            sim.common[addr] = v;
+        }
+        break;
+    }
+}
+
+static uint8_t sim_read_sock(uint8_t sn, uint16_t addr)
+{
+    const uint8_t *r = sim.sock[sn].regs;
+    uint8_t tmp[2];
+
+    switch (addr) {
+    case SIM_Sn_CR:
+        return 0U;      /* commands complete immediately */
+    case SIM_Sn_TX_FSR:
+    case SIM_Sn_TX_FSR + 1U:
+        sim_set16(tmp, sim_tx_fsr(sn));
+        return tmp[addr - SIM_Sn_TX_FSR];
+    case SIM_Sn_RX_RSR:
+    case SIM_Sn_RX_RSR + 1U:
+        sim_set16(tmp, sim_rx_rsr(sn));
+        return tmp[addr - SIM_Sn_RX_RSR];
+    default:
+        return (addr < SIM_SOCK_REG_SIZE) ? r[addr] : 0U;
+    }
+}
+
+static void sim_write_sock(uint8_t sn, uint16_t addr, uint8_t v)
+{
+    uint8_t *r = sim.sock[sn].regs;
+
+    switch (addr) {
+    case SIM_Sn_CR:
+        sim_command(sn, v);
+        break;
+    case SIM_Sn_IR:
+        r[addr] &= (uint8_t)~v;
+        break;
+    case SIM_Sn_SR:
+    case SIM_Sn_TX_FSR:
+    case SIM_Sn_TX_FSR + 1U:
+    case SIM_Sn_TX_RD:
+    case SIM_Sn_TX_RD + 1U:
+    case SIM_Sn_RX_RSR:
+    case SIM_Sn_RX_RSR + 1U:
+    case SIM_Sn_RX_WR:
+    case SIM_Sn_RX_WR + 1U:
+        break;
+    default:
+        if (addr < SIM_SOCK_REG_SIZE) {
+            r[addr] = v;
+        }
+        break;
+    }
+}
+
+/* One data-phase byte at the current address; returns the MISO byte */
+static uint8_t sim_data_byte(uint8_t mosi)
+{
+    uint8_t bsb = SIM_CTRL_BSB(sim.ctrl);
+    bool write = (sim.ctrl & SIM_CTRL_WRITE) != 0U;
+    uint8_t miso = 0;
+
+    if (bsb == SIM_BSB_COMMON) {
+        sim.stats.reg_bytes++;
+        if (write) {
+            sim_write_common(sim.addr, mosi);
+        } else {
+            miso = sim_read_common(sim.addr);
+        }
+    } else if (SIM_BSB_SOCK(bsb) < SIM_SOCKETS) {
+        uint8_t sn = (uint8_t)SIM_BSB_SOCK(bsb);
+
+        switch (SIM_BSB_KIND(bsb)) {
+        case SIM_KIND_REG:
+            sim.stats.reg_bytes++;
+            if (write) {
+                sim_write_sock(sn, sim.addr, mosi);
+            } else {
+                miso = sim_read_sock(sn, sim.addr);
+            }
+            break;
+        case SIM_KIND_TX:
+            sim.stats.buf_bytes++;
+            if (write) {
+                *sim_tx_byte(sn, sim.addr) = mosi;
+            } else {
+                miso = *sim_tx_byte(sn, sim.addr);
+            }
+            break;
+        case SIM_KIND_RX:
+            sim.stats.buf_bytes++;
+            if (write) {
+                *sim_rx_byte(sn, sim.addr) = mosi;
+            } else {
+                miso = *sim_rx_byte(sn, sim.addr);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    sim.addr++;
+    return miso;
+}
+
+/*============================================================================*/
+/*                         MODEL THREAD                                       */
+/*============================================================================*/
+
+static void sim_tcp_accept(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    struct sockaddr_in peer;
+    socklen_t plen = sizeof(peer);
+    int one = 1;
+    int fd = accept4(s->fd, (struct sockaddr *)&peer, &plen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd < 0) {
+        return;
+    }
+    /* The chip socket becomes the connection; the listener goes away */
+    close(s->fd);
+    s->fd = fd;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    memcpy(&s->regs[SIM_Sn_DIPR], &peer.sin_addr.s_addr, 4);
+    sim_set16(&s->regs[SIM_Sn_DPORT], sim_port_from_host(ntohs(peer.sin_port)));
+    sim_set_sr(sn, SIM_SR_ESTABLISHED);
+    sim_raise(sn, SIM_IR_CON);
+}
+
+static void sim_tcp_connected(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    int err = 0;
+    socklen_t elen = sizeof(err);
+
+    if ((getsockopt(s->fd, SOL_SOCKET, SO_ERROR, &err, &elen) != 0) || (err != 0)) {
+        sim_sock_fail(sn);
+        return;
+    }
+    sim_set_sr(sn, SIM_SR_ESTABLISHED);
+    sim_raise(sn, SIM_IR_CON);
+}
+
+static void sim_tcp_receive(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+    uint16_t room = (sim_rx_size(sn) != 0U) ? sim_rx_free(sn) : 0U;
+    bool got = false;
+
+    while (room > 0U) {
+        uint16_t wr = sim_get16(&r[SIM_Sn_RX_WR]);
+        uint32_t size = sim_rx_size(sn);
+        uint32_t chunk = size - (wr % size);
+        ssize_t n;
+
+        if (chunk > room) {
+            chunk = room;
+        }
+        n = recv(s->fd, sim_rx_byte(sn, wr), chunk, 0);
+        if (n == 0) {
+            s->eof = true;
+            sim_set_sr(sn, SIM_SR_CLOSE_WAIT);
+            sim_raise(sn, SIM_IR_DISCON);
+            break;
+        }
+        if (n < 0) {
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+                sim_sock_fail(sn);
+            }
+            break;
+        }
+        sim_set16(&r[SIM_Sn_RX_WR], (uint16_t)(wr + (uint16_t)n));
+        room -= (uint16_t)n;
+        sim.stats.net_rx_bytes += (uint64_t)n;
+        got = true;
+    }
+    if (got) {
+        sim.stats.net_rx_packets++;
+        sim_raise(sn, SIM_IR_RECV);
+    }
+}
+
+static void sim_udp_receive(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+    uint8_t dgram[SIM_MEM_SIZE];
+
+    for (;;) {
+        struct sockaddr_in peer;
+        socklen_t plen = sizeof(peer);
+        ssize_t n = recvfrom(s->fd, dgram, sizeof(dgram), MSG_PEEK | MSG_TRUNC,
+                             (struct sockaddr *)&peer, &plen);
+        uint8_t hdr[SIM_UDP_HDR_LEN];
+        uint16_t wr;
+
+        if (n < 0) {
+            return;
+        }
+        if ((size_t)n + SIM_UDP_HDR_LEN > sim_rx_free(sn)) {
+            /* Stays in the kernel until the firmware frees enough space */
+            return;
+        }
+        n = recv(s->fd, dgram, sizeof(dgram), 0);
+        if (n < 0) {
+            return;
+        }
+        memcpy(&hdr[0], &peer.sin_addr.s_addr, 4);
+        sim_set16(&hdr[4], sim_port_from_host(ntohs(peer.sin_port)));
+        sim_set16(&hdr[6], (uint16_t)n);
+
+        wr = sim_get16(&r[SIM_Sn_RX_WR]);
+        for (uint16_t i = 0; i < SIM_UDP_HDR_LEN; i++) {
+            *sim_rx_byte(sn, wr++) = hdr[i];
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            *sim_rx_byte(sn, wr++) = dgram[i];
+        }
+        sim_set16(&r[SIM_Sn_RX_WR], wr);
+        sim.stats.net_rx_bytes += (uint64_t)n;
+        sim.stats.net_rx_packets++;
+        sim_raise(sn, SIM_IR_RECV);
+    }
+}
+
+/* IPRAW packets land behind a 6-byte header (source IP, length) with the
+ * IP header stripped, as on the chip */
+static void sim_ipraw_receive(uint8_t sn)
+{
+    sim_sock_t *s = &sim.sock[sn];
+    uint8_t *r = s->regs;
+    uint8_t pkt[SIM_MEM_SIZE];
+
+    for (;;) {
+        ssize_t n = recv(s->fd, pkt, sizeof(pkt), MSG_PEEK | MSG_TRUNC);
+        uint8_t hdr[SIM_IPRAW_HDR_LEN];
+        size_t ihl;
+        uint16_t len;
+        uint16_t wr;
+
+        if (n < 20) {
+            if (n >= 0) {
+                (void)recv(s->fd, pkt, sizeof(pkt), 0);
+                continue;
+            }
+            return;
+        }
+        if ((size_t)n + SIM_IPRAW_HDR_LEN > sim_rx_free(sn) + 20U) {
+            /* Stays in the kernel until the firmware frees enough space */
+            return;
+        }
+        n = recv(s->fd, pkt, sizeof(pkt), 0);
+        ihl = (size_t)(pkt[0] & 0x0FU) * 4U;
+        if ((n < 0) || ((size_t)n < ihl) ||
+            ((size_t)n - ihl + SIM_IPRAW_HDR_LEN > sim_rx_free(sn))) {
+            continue;
+        }
+        len = (uint16_t)((size_t)n - ihl);
+        memcpy(&hdr[0], &pkt[12], 4);
+        sim_set16(&hdr[4], len);
+
+        wr = sim_get16(&r[SIM_Sn_RX_WR]);
+        for (uint16_t i = 0; i < SIM_IPRAW_HDR_LEN; i++) {
+            *sim_rx_byte(sn, wr++) = hdr[i];
+        }
+        for (uint16_t i = 0; i < len; i++) {
+            *sim_rx_byte(sn, wr++) = pkt[ihl + i];
+        }
+        sim_set16(&r[SIM_Sn_RX_WR], wr);
+        sim.stats.net_rx_bytes += len;
+        sim.stats.net_rx_packets++;
+        sim_raise(sn, SIM_IR_RECV);
+    }
+}
+
+/* Events the model thread waits for on a socket, 0 to skip it */
+static short sim_poll_events(uint8_t sn)
+{
+    const sim_sock_t *s = &sim.sock[sn];
+    short ev = 0;
+
+    if (s->fd < 0) {
+        return 0;
+    }
+    switch (s->regs[SIM_Sn_SR]) {
+    case SIM_SR_LISTEN:
+        ev = POLLIN;
+        break;
+    case SIM_SR_SYNSENT:
+        ev = POLLOUT;
+        break;
+    case SIM_SR_ESTABLISHED:
+    case SIM_SR_CLOSE_WAIT:
+        if (!s->eof && (sim_rx_free(sn) > 0U)) {
+            ev |= POLLIN;
+        }
+        if (s->tx_pending > 0U) {
+            ev |= POLLOUT;
+        }
+        break;
+    case SIM_SR_UDP:
+        if (sim_rx_free(sn) > SIM_UDP_HDR_LEN) {
+            ev = POLLIN;
+        }
+        break;
+    case SIM_SR_IPRAW:
+        if (sim_rx_free(sn) > SIM_IPRAW_HDR_LEN) {
+            ev = POLLIN;
+        }
+        break;
+    default:
+        break;
+    }
+    return ev;
+}
+
+static void sim_service(uint8_t sn, int fd, short revents)
+{
+    sim_sock_t *s = &sim.sock[sn];
+
+    /* Skip readiness of a socket the firmware closed while we were polling */
+    if (s->fd != fd) {
+        return;
+    }
+    switch (s->regs[SIM_Sn_SR]) {
+    case SIM_SR_LISTEN:
+        sim_tcp_accept(sn);
+        break;
+    case SIM_SR_SYNSENT:
+        sim_tcp_connected(sn);
+        break;
+    case SIM_SR_ESTABLISHED:
+    case SIM_SR_CLOSE_WAIT:
+        if ((revents & POLLOUT) != 0) {
+            sim_tcp_flush(sn);
+        }
+        if ((s->fd == fd) && ((revents & (POLLIN | POLLHUP | POLLERR)) != 0)) {
+            sim_tcp_receive(sn);
+        }
+        break;
+    case SIM_SR_UDP:
+        sim_udp_receive(sn);
+        break;
+    case SIM_SR_IPRAW:
+        sim_ipraw_receive(sn);
+        break;
+    default:
+        break;
+    }
+}
+
+static void *sim_thread(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        struct pollfd pfd[SIM_SOCKETS + 1U];
+        uint8_t owner[SIM_SOCKETS + 1U];
+        nfds_t n = 0;
+        int ready;
+
+        pthread_mutex_lock(&sim.lock);
+        if (!sim.running) {
+            pthread_mutex_unlock(&sim.lock);
+            break;
+        }
+        pfd[n].fd = sim.wake[0];
+        pfd[n].events = POLLIN;
+        owner[n++] = 0xFFU;
+        for (uint8_t sn = 0; sn < SIM_SOCKETS; sn++) {
+            short ev = sim_poll_events(sn);
+            if (ev != 0) {
+                pfd[n].fd = sim.sock[sn].fd;
+                pfd[n].events = ev;
+                owner[n++] = sn;
+            }
+        }
+        pthread_mutex_unlock(&sim.lock);
+
+        ready = poll(pfd, n, (int)sim.cfg.poll_timeout_ms);
+        if (ready <= 0) {
+            continue;
+        }
+        if ((pfd[0].revents & POLLIN) != 0) {
+            char drain[64];
+            (void)!read(sim.wake[0], drain, sizeof(drain));
+        }
+
+        pthread_mutex_lock(&sim.lock);
+        for (nfds_t i = 1; i < n; i++) {
+            if (pfd[i].revents != 0) {
+                sim_service(owner[i], pfd[i].fd, pfd[i].revents);
+            }
+        }
+        sim_update_int();
+        sim_unlock();
+    }
+    return NULL;
+}
+
+/*============================================================================*/
+/*                         API                                                */
+/*============================================================================*/
+
+int w5500_sim_start(const w5500_sim_config_t *cfg)
+{
+    pthread_mutex_lock(&sim.lock);
+    if (sim.running) {
+        pthread_mutex_unlock(&sim.lock);
+        return 0;
+    }
+    sim.cfg.port_offset     = (cfg != NULL) ? cfg->port_offset : SIM_DEFAULT_PORT_OFFSET;
+    sim.cfg.poll_timeout_ms = ((cfg != NULL) && (cfg->poll_timeout_ms != 0U))
+                              ? cfg->poll_timeout_ms : SIM_DEFAULT_POLL_MS;
+    for (uint8_t sn = 0; sn < SIM_SOCKETS; sn++) {
+        sim.sock[sn].fd = -1;
+    }
+    sim_reset_chip();
+    sim.int_level = false;
+    sim.int_edges_pending = 0;
+    sim.cs = false;
+    memset(&sim.stats, 0, sizeof(sim.stats));
+
+    if (pipe2(sim.wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+        pthread_mutex_unlock(&sim.lock);
+        return -1;
+    }
+    sim.running = true;
+    if (pthread_create(&sim.thread, NULL, sim_thread, NULL) != 0) {
+        sim.running = false;
+        close(sim.wake[0]);
+        close(sim.wake[1]);
+        sim.wake[0] = sim.wake[1] = -1;
+        pthread_mutex_unlock(&sim.lock);
+        return -1;
+    }
+    pthread_mutex_unlock(&sim.lock);
+    return 0;
+}
+
+void w5500_sim_stop(void)
+{
+    pthread_mutex_lock(&sim.lock);
+    if (!sim.running) {
+        pthread_mutex_unlock(&sim.lock);
+        return;
+    }
+    sim.running = false;
+    sim_wake();
+    pthread_mutex_unlock(&sim.lock);
+
+    pthread_join(sim.thread, NULL);
+
+    pthread_mutex_lock(&sim.lock);
+    for (uint8_t sn = 0; sn < SIM_SOCKETS; sn++) {
+        sim_sock_close_fd(&sim.sock[sn]);
+    }
+    close(sim.wake[0]);
+    close(sim.wake[1]);
+    sim.wake[0] = sim.wake[1] = -1;
+    pthread_mutex_unlock(&sim.lock);
+}
+
+void w5500_sim_cs(bool asserted)
+{
+    pthread_mutex_lock(&sim.lock);
+    if (asserted && !sim.cs) {
+        sim.stats.frames++;
+        sim.phase = SIM_PHASE_ADDR_HI;
+    }
+    sim.cs = asserted;
+    sim_update_int();
+    sim_unlock();
+}
+
+void w5500_sim_spi(const uint8_t *mosi, uint8_t *miso, size_t len)
+{
+    pthread_mutex_lock(&sim.lock);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t in = (mosi != NULL) ? mosi[i] : 0U;
+        uint8_t out = 0;
+
+        if (!sim.cs) {
+            /* MISO is high-Z and nothing is decoded without CS */
+            if (miso != NULL) {
+                miso[i] = 0xFFU;
+            }
+            continue;
+        }
+        sim.stats.spi_bytes++;
+        switch (sim.phase) {
+        case SIM_PHASE_ADDR_HI:
+            sim.stats.hdr_bytes++;
+            sim.addr = (uint16_t)in << 8;
+            sim.phase = SIM_PHASE_ADDR_LO;
+            break;
+        case SIM_PHASE_ADDR_LO:
+            sim.stats.hdr_bytes++;
+            sim.addr |= in;
+            sim.phase = SIM_PHASE_CTRL;
+            break;
+        case SIM_PHASE_CTRL:
+            sim.stats.hdr_bytes++;
+            sim.ctrl = in;
+            sim.phase = SIM_PHASE_DATA;
+            break;
+        case SIM_PHASE_DATA:
+        default:
+            out = sim_data_byte(in);
+            break;
+        }
+        if (miso != NULL) {
+            miso[i] = out;
+        }
+    }
+    sim_update_int();
+    sim_unlock();
+}
+
+bool w5500_sim_int_asserted(void)
+{
+    bool level;
+
+    pthread_mutex_lock(&sim.lock);
+    level = sim.int_level;
+    pthread_mutex_unlock(&sim.lock);
+    return level;
+}
+
+void w5500_sim_set_int_handler(void (*handler)(void))
+{
+    pthread_mutex_lock(&sim.lock);
+    sim.int_handler = handler;
+    pthread_mutex_unlock(&sim.lock);
+}
+
+void w5500_sim_get_stats(w5500_sim_stats_t *stats)
+{
+    pthread_mutex_lock(&sim.lock);
+    *stats = sim.stats;
+    pthread_mutex_unlock(&sim.lock);
+}
+
+void w5500_sim_reset_stats(void)
+{
+    pthread_mutex_lock(&sim.lock);
+    memset(&sim.stats, 0, sizeof(sim.stats));
+    pthread_mutex_unlock(&sim.lock);
+}
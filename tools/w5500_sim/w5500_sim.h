@@ -0,0 +1,117 @@
+/**
+ * @file    w5500_sim.h
+ * @brief   Host-side behavioral model of the W5500 behind the SPI callbacks
+ *
+ * @details The model sees exactly what the MCU clocks out: it decodes VDM
+ *          frames (16-bit address, control byte with BSB/RWB/OM, data phase
+ *          with address auto-increment) between CS edges and keeps
+ *
+ *          - the common register block (MR reset, netinfo, IR/IMR, SIR/SIMR,
+ *            RTR/RCR, PHYCFGR, VERSIONR),
+ *          - the eight socket register blocks, with live Sn_TX_FSR and
+ *            Sn_RX_RSR and the Sn_CR commands OPEN, LISTEN, CONNECT, DISCON,
+ *            CLOSE, SEND, SEND_MAC, SEND_KEEP and RECV,
+ *          - the 16 KB TX and 16 KB RX memories, partitioned by
+ *            Sn_TXBUF_SIZE/Sn_RXBUF_SIZE like the chip (socket 0 first,
+ *            buffer-block addresses wrap at the socket buffer size).
+ *
+ *          TCP and UDP sockets are backed by non-blocking Linux sockets
+ *          serviced by a model thread, so the chip runs asynchronously to the
+ *          firmware as on the board: received data lands in the RX memory
+ *          (UDP with the 8-byte W5500 header), Sn_IR/SIR are raised and the
+ *          INT line falls. MACRAW frames sent on socket 0 loop back into
+ *          its RX memory (behind the 2-byte length). IPRAW sockets use a
+ *          Linux raw socket of protocol Sn_PROTO (root or CAP_NET_RAW;
+ *          without it they open but carry no traffic).
+ *
+ *          Ports below 1024 (local and destination) are shifted by
+ *          port_offset so the firmware's DHCP/HTTP/... ports can be bound
+ *          without privileges.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _W5500_SIM_H_
+#define _W5500_SIM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*============================================================================*/
+/*                         TYPES                                              */
+/*============================================================================*/
+
+typedef struct {
+    uint16_t port_offset;       /* added to ports < 1024, 0 = bind as is     */
+    uint32_t poll_timeout_ms;   /* model thread idle wait                    */
+} w5500_sim_config_t;
+
+/* SPI and network accounting, all since start or the last reset */
+typedef struct {
+    uint64_t frames;            /* CS-low periods                            */
+    uint64_t spi_bytes;         /* every byte clocked while CS was low       */
+    uint64_t hdr_bytes;         /* address + control phase                   */
+    uint64_t reg_bytes;         /* data phase to/from register blocks        */
+    uint64_t buf_bytes;         /* data phase to/from TX/RX memory           */
+    uint64_t commands;          /* Sn_CR writes                              */
+    uint64_t net_tx_bytes;      /* payload handed to Linux sockets           */
+    uint64_t net_rx_bytes;      /* payload copied into RX memory             */
+    uint64_t net_tx_packets;
+    uint64_t net_rx_packets;
+    uint64_t int_edges;         /* INT falling edges                         */
+} w5500_sim_stats_t;
+
+/*============================================================================*/
+/*                         API                                                */
+/*============================================================================*/
+
+/**
+ * @brief Reset the chip model and start the thread servicing Linux sockets
+ * @param cfg Configuration, NULL for defaults (offset 10000, 1 ms poll)
+ * @return 0 on success, -1 if the thread could not be started
+ */
+int w5500_sim_start(const w5500_sim_config_t *cfg);
+
+/**
+ * @brief Stop the model thread and close every Linux socket
+ */
+void w5500_sim_stop(void);
+
+/**
+ * @brief Drive the CS line (true = asserted / low); deasserting ends the frame
+ */
+void w5500_sim_cs(bool asserted);
+
+/**
+ * @brief Clock bytes through the SPI port while CS is asserted
+ * @param mosi Bytes sent to the chip, NULL to send zeros (read phase)
+ * @param miso Bytes returned by the chip, NULL to discard
+ * @param len  Number of bytes
+ */
+void w5500_sim_spi(const uint8_t *mosi, uint8_t *miso, size_t len);
+
+/**
+ * @brief Level of the INT line: true while an unmasked interrupt is pending
+ */
+bool w5500_sim_int_asserted(void);
+
+/**
+ * @brief Register the handler called (outside the model lock) on every
+ *        falling edge of INT; plays the role of the EXTI line
+ */
+void w5500_sim_set_int_handler(void (*handler)(void));
+
+void w5500_sim_get_stats(w5500_sim_stats_t *stats);
+void w5500_sim_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _W5500_SIM_H_ */
@@ -0,0 +1,495 @@
+/**
+ * @file    w5500_sim_bench.c
+ * @brief   Host benchmark of the in-house Ethernet stack on the W5500 model
+ *
+ * @details Runs the real w5500_spi.c / w5500_socket.c / ioLibrary stack
+ *          (w5500_sim_fw.c) against the behavioral W5500 (w5500_sim.c) and
+ *          drives it from Linux peers over loopback:
+ *
+ *          - UDP echo on port 7: round-trip latency of small datagrams,
+ *          - TCP discard on port 9: firmware receive throughput,
+ *          - TCP source on port 19: firmware send throughput, through the
+ *            ioLibrary send() and through w5500_socket_send_async(),
+ *          - both TCP runs again under each socket memory profile
+ *            (w5500_socket_apply_profile()),
+ *          - MACRAW frames on socket 0 looped back by the model, one frame
+ *            and eight frames per w5500_socket_macraw_send_batch(),
+ *          - a pass/fail check: a poller and an async sender on one socket
+ *            that the peer resets while a SEND is stalled must see
+ *            POLLHUP and W5500_SOCK_TIMEOUT respectively (exit status 1
+ *            if not).
+ *
+ *          For each run it reports payload throughput on this host, SPI bytes
+ *          and CS frames per payload byte as counted by the model, and the
+ *          throughput the SPI link alone would allow at the given SCK. The
+ *          last figure is what carries over to the board: the host runs the
+ *          stack far faster than the STM32G431, the SPI traffic is the same.
+ *          The firmware's own per-socket counters (w5500_socket_stats_dump())
+ *          follow the first table as a cross-check; they miss the frames
+ *          spent outside the socket calls (INT handling, polling).
+ *
+ *          Build (from the repository root, ioLibrary submodule checked out).
+ *          Firmware objects get the ioLibrary rename header, the model and
+ *          this file must not:
+ *
+ *            FW_FLAGS="-O2 -std=gnu11 -DSTM32G431xx -DUSE_HAL_DRIVER \
+ *                -D'SPI_BUS_CYCLES()=0U' \
+ *                -include tools/w5500_sim/w5500_sim_iolib.h \
+ *                -Itools/w5500_sim -ICore/Inc -IMiddlewares/In_House/eth \
+ *                -IMiddlewares/Third_Party/ioLibrary_Driver/Ethernet \
+ *                -IMiddlewares/Third_Party/ioLibrary_Driver/Ethernet/W5500 \
+ *                -IDrivers/STM32G4xx_HAL_Driver/Inc \
+ *                -IDrivers/CMSIS/Device/ST/STM32G4xx/Include \
+ *                -IDrivers/CMSIS/Include \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F"
+ *            for f in tools/w5500_sim/w5500_sim_fw.c \
+ *                     Middlewares/In_House/eth/w5500_spi.c \
+ *                     Middlewares/In_House/eth/w5500_socket.c \
+ *                     Core/Src/spi.c Core/Src/eth_config.c \
+ *                     Middlewares/Third_Party/ioLibrary_Driver/Ethernet/socket.c \
+ *                     Middlewares/Third_Party/ioLibrary_Driver/Ethernet/wizchip_conf.c \
+ *                     Middlewares/Third_Party/ioLibrary_Driver/Ethernet/W5500/w5500.c; do
+ *                obj=/tmp/$(basename $f .c).o; OBJS="$OBJS $obj"
+ *                eval gcc $FW_FLAGS -c $f -o $obj
+ *            done
+ *            gcc -O2 -std=gnu11 -pthread -Itools/w5500_sim \
+ *                tools/w5500_sim/w5500_sim_bench.c tools/w5500_sim/w5500_sim.c \
+ *                $OBJS -o w5500_sim_bench
+ *
+ *            ./w5500_sim_bench [sck_mhz] [tcp_mbytes]
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "w5500_sim.h"
+#include "w5500_sim_fw.h"
+
+/*============================================================================*/
+/*                         CONFIGURATION                                      */
+/*============================================================================*/
+
+#define BENCH_PORT_OFFSET       10000U
+#define BENCH_PORT_ECHO         7U
+#define BENCH_PORT_DISCARD      9U
+#define BENCH_PORT_SOURCE       19U
+#define BENCH_PORT_HUP          20U
+
+#define BENCH_UDP_COUNT         2000U
+#define BENCH_UDP_LEN           64U
+#define BENCH_TCP_CHUNK         1460U
+#define BENCH_MACRAW_LEN        1400U
+
+#define BENCH_CONNECT_TRIES     1000U
+
+/*============================================================================*/
+/*                         HELPERS                                            */
+/*============================================================================*/
+
+typedef struct {
+    const char *name;
+    uint64_t    payload;
+    uint64_t    elapsed_ns;
+    w5500_sim_stats_t sim;
+} bench_run_t;
+
+static double bench_sck_hz = 18e6;
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static struct sockaddr_in bench_addr(uint16_t fw_port)
+{
+    struct sockaddr_in sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons((uint16_t)(fw_port + BENCH_PORT_OFFSET));
+    return sa;
+}
+
+/* The firmware opens its listener asynchronously: retry until it is up */
+static int bench_tcp_connect(uint16_t fw_port)
+{
+    struct sockaddr_in sa = bench_addr(fw_port);
+
+    for (uint32_t i = 0; i < BENCH_CONNECT_TRIES; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0) {
+            return fd;
+        }
+        close(fd);
+        usleep(1000);
+    }
+    return -1;
+}
+
+static void bench_print_header(const char *first)
+{
+    fprintf(stdout, "\n%-20s %9s %9s %9s %9s %9s\n",
+            first, "host Mb/s", "SPI B/B", "ovh B/B", "frm/KB", "link Mb/s");
+}
+
+static void bench_print(const bench_run_t *run)
+{
+    double payload = (double)run->payload;
+    double secs = (double)run->elapsed_ns / 1e9;
+
+    if (run->payload == 0U) {
+        fprintf(stdout, "%-20s no payload transferred\n", run->name);
+        return;
+    }
+    fprintf(stdout, "%-20s %9.2f %9.3f %9.3f %9.3f %9.2f\n",
+            run->name,
+            payload * 8.0 / secs / 1e6,
+            (double)run->sim.spi_bytes / payload,
+            (double)(run->sim.hdr_bytes + run->sim.reg_bytes) / payload,
+            (double)run->sim.frames * 1024.0 / payload,
+            bench_sck_hz * payload / (double)run->sim.spi_bytes / 1e6);
+}
+
+/*============================================================================*/
+/*                         WORKLOADS                                          */
+/*============================================================================*/
+
+typedef struct {
+    uint16_t port;
+    uint16_t chunk;
+    uint64_t total;
+    uint64_t result;
+} bench_fw_arg_t;
+
+static void *bench_fw_echo(void *arg)
+{
+    bench_fw_arg_t *a = arg;
+    fw_udp_echo(a->port, (uint32_t)a->total);
+    return NULL;
+}
+
+static void *bench_fw_sink(void *arg)
+{
+    bench_fw_arg_t *a = arg;
+    a->result = fw_tcp_sink(a->port);
+    return NULL;
+}
+
+static void *bench_fw_source(void *arg)
+{
+    bench_fw_arg_t *a = arg;
+    a->result = fw_tcp_source(a->port, a->total, a->chunk);
+    return NULL;
+}
+
+static void *bench_fw_source_async(void *arg)
+{
+    bench_fw_arg_t *a = arg;
+    a->result = fw_tcp_source_async(a->port, a->total, a->chunk);
+    return NULL;
+}
+
+static int bench_hup_fd = -1;
+
+/* One byte first, so the poller finds the socket flagged in SIR and reads
+ * Sn_IR; then RST instead of FIN: SO_LINGER with a zero timeout */
+static void bench_reset_peer(void)
+{
+    struct linger lg = { .l_onoff = 1, .l_linger = 0 };
+
+    (void)send(bench_hup_fd, "x", 1, MSG_NOSIGNAL);
+    usleep(20000);
+    (void)setsockopt(bench_hup_fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(bench_hup_fd);
+    bench_hup_fd = -1;
+}
+
+typedef struct {
+    int    result;
+    int8_t send_ret;
+} bench_hup_arg_t;
+
+static void *bench_fw_hup(void *arg)
+{
+    bench_hup_arg_t *a = arg;
+    a->result = fw_tcp_hup_shared(BENCH_PORT_HUP, bench_reset_peer, &a->send_ret);
+    return NULL;
+}
+
+/* Connect and never read; the firmware side resets the connection */
+static bool bench_hup_shared(void)
+{
+    bench_hup_arg_t arg = { .result = -1 };
+    pthread_t fw;
+
+    pthread_create(&fw, NULL, bench_fw_hup, &arg);
+    bench_hup_fd = bench_tcp_connect(BENCH_PORT_HUP);
+    pthread_join(fw, NULL);
+    if (bench_hup_fd >= 0) {
+        close(bench_hup_fd);
+        bench_hup_fd = -1;
+    }
+    fprintf(stdout, "\nShared socket hang-up (poller + async sender, peer RST): %s "
+                    "(step %d, send_wait %d)\n",
+            (arg.result == 0) ? "PASS" : "FAIL", arg.result, arg.send_ret);
+    return arg.result == 0;
+}
+
+static int bench_cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void bench_udp_echo(bench_run_t *run)
+{
+    static uint64_t rtt[BENCH_UDP_COUNT];
+    bench_fw_arg_t arg = { .port = BENCH_PORT_ECHO, .total = BENCH_UDP_COUNT };
+    struct sockaddr_in sa = bench_addr(BENCH_PORT_ECHO);
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 100000 };
+    uint8_t out[BENCH_UDP_LEN];
+    uint8_t in[BENCH_UDP_LEN];
+    uint32_t done = 0;
+    uint64_t sum = 0;
+    pthread_t fw;
+    int fd;
+
+    run->name = "udp echo";
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    memset(out, 0xA5, sizeof(out));
+
+    pthread_create(&fw, NULL, bench_fw_echo, &arg);
+    w5500_sim_reset_stats();
+    run->elapsed_ns = bench_now_ns();
+    while (done < BENCH_UDP_COUNT) {
+        uint64_t t0 = bench_now_ns();
+        sendto(fd, out, sizeof(out), 0, (struct sockaddr *)&sa, sizeof(sa));
+        if (recv(fd, in, sizeof(in), 0) != (ssize_t)sizeof(in)) {
+            /* Firmware socket not open yet: the datagram was refused */
+            continue;
+        }
+        rtt[done++] = bench_now_ns() - t0;
+    }
+    run->elapsed_ns = bench_now_ns() - run->elapsed_ns;
+    w5500_sim_get_stats(&run->sim);
+    pthread_join(fw, NULL);
+    close(fd);
+
+    run->payload = (uint64_t)done * BENCH_UDP_LEN * 2U;
+    qsort(rtt, done, sizeof(rtt[0]), bench_cmp_u64);
+    for (uint32_t i = 0; i < done; i++) {
+        sum += rtt[i];
+    }
+    fprintf(stdout, "UDP echo RTT (%u x %u B): min %.1f us, avg %.1f us, p99 %.1f us, max %.1f us\n",
+            BENCH_UDP_COUNT, BENCH_UDP_LEN,
+            rtt[0] / 1e3, (double)sum / done / 1e3,
+            rtt[(done * 99U) / 100U] / 1e3, rtt[done - 1U] / 1e3);
+}
+
+static void bench_tcp_sink(bench_run_t *run, uint64_t total)
+{
+    bench_fw_arg_t arg = { .port = BENCH_PORT_DISCARD };
+    static uint8_t buf[65536];
+    uint64_t sent = 0;
+    pthread_t fw;
+    int fd;
+
+    run->name = "tcp rx";
+    memset(buf, 0x5A, sizeof(buf));
+    pthread_create(&fw, NULL, bench_fw_sink, &arg);
+    fd = bench_tcp_connect(BENCH_PORT_DISCARD);
+
+    w5500_sim_reset_stats();
+    run->elapsed_ns = bench_now_ns();
+    while ((fd >= 0) && (sent < total)) {
+        size_t len = ((total - sent) < sizeof(buf)) ? (size_t)(total - sent) : sizeof(buf);
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += (uint64_t)n;
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    pthread_join(fw, NULL);
+    run->elapsed_ns = bench_now_ns() - run->elapsed_ns;
+    w5500_sim_get_stats(&run->sim);
+    run->payload = arg.result;
+}
+
+static void bench_tcp_source(bench_run_t *run, uint64_t total, uint16_t chunk, bool async)
+{
+    bench_fw_arg_t arg = { .port = BENCH_PORT_SOURCE, .chunk = chunk, .total = total };
+    static uint8_t buf[65536];
+    uint64_t got = 0;
+    pthread_t fw;
+    int fd;
+
+    run->name = async ? "tcp tx async" : "tcp tx";
+    /* The firmware starts sending as soon as it accepts: count from before
+     * the connect so no SEND escapes the stats */
+    w5500_sim_reset_stats();
+    run->elapsed_ns = bench_now_ns();
+    pthread_create(&fw, NULL, async ? bench_fw_source_async : bench_fw_source, &arg);
+    fd = bench_tcp_connect(BENCH_PORT_SOURCE);
+    while (fd >= 0) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) {
+            break;
+        }
+        got += (uint64_t)n;
+    }
+    run->elapsed_ns = bench_now_ns() - run->elapsed_ns;
+    w5500_sim_get_stats(&run->sim);
+    if (fd >= 0) {
+        close(fd);
+    }
+    pthread_join(fw, NULL);
+    run->payload = got;
+}
+
+static uint32_t bench_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Decode the firmware's own counters (w5500_socket_stats_dump()): SPI bytes
+ * per payload byte as the sockets see them, next to the model's figures */
+static void bench_print_sock_stats(void)
+{
+    uint8_t dump[1024];
+    size_t len = fw_stats_dump(dump, sizeof(dump));
+
+    if ((len < 20U) || (dump[0] != 'W') || (dump[1] != 'S')) {
+        fprintf(stdout, "\nno socket counters\n");
+        return;
+    }
+    fprintf(stdout, "\nSocket counters (w5500_socket_stats_dump v%u)\n%-4s %12s %12s %9s %9s %9s %6s\n",
+            dump[2], "sock", "tx bytes", "rx bytes", "tx calls", "rx calls", "SPI B/B", "errors");
+    const uint8_t *rec = dump + 20;
+    for (uint8_t i = 0; i < dump[3]; i++, rec += 93) {
+        uint32_t tx = bench_get_u32(rec + 1);
+        uint32_t rx = bench_get_u32(rec + 5);
+        uint32_t spi = bench_get_u32(rec + 17);
+        uint32_t errors = 0;
+        for (int e = 0; e < 4; e++) {
+            errors += bench_get_u32(rec + 29 + 4 * e);
+        }
+        fprintf(stdout, "%-4u %12u %12u %9u %9u %9.3f %6u\n", rec[0], tx, rx,
+                bench_get_u32(rec + 9), bench_get_u32(rec + 13),
+                ((tx + rx) != 0U) ? (double)spi / ((double)tx + rx) : 0.0, errors);
+    }
+}
+
+/*============================================================================*/
+/*                         MAIN                                               */
+/*============================================================================*/
+
+int main(int argc, char **argv)
+{
+    const w5500_sim_config_t cfg = { .port_offset = BENCH_PORT_OFFSET, .poll_timeout_ms = 1U };
+    uint64_t tcp_bytes;
+    bench_run_t runs[4];
+
+    bench_sck_hz = ((argc > 1) ? strtod(argv[1], NULL) : 18.0) * 1e6;
+    tcp_bytes = ((argc > 2) ? strtoull(argv[2], NULL, 0) : 4ULL) * 1024ULL * 1024ULL;
+
+    if (w5500_sim_start(&cfg) != 0) {
+        fprintf(stderr, "cannot start the W5500 model\n");
+        return 1;
+    }
+    if (fw_init() != 0) {
+        fprintf(stderr, "firmware did not find the W5500 (VERSIONR)\n");
+        w5500_sim_stop();
+        return 1;
+    }
+
+    memset(runs, 0, sizeof(runs));
+    bench_udp_echo(&runs[0]);
+    bench_tcp_sink(&runs[1], tcp_bytes);
+    bench_tcp_source(&runs[2], tcp_bytes, BENCH_TCP_CHUNK, false);
+    bench_tcp_source(&runs[3], tcp_bytes, BENCH_TCP_CHUNK, true);
+
+    bench_print_header("run");
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        bench_print(&runs[i]);
+    }
+    bench_print_sock_stats();
+
+    /* TCP on the application socket under each buffer layout; the source
+     * hands the whole TX buffer to each SEND */
+    fprintf(stdout, "\nSocket memory profiles (TCP on socket 2)\n");
+    bench_print_header("profile/run");
+    for (uint8_t p = 0; ; p++) {
+        const char *name = fw_mem_profile(p);
+        bench_run_t prof[2];
+        char label[2][32];
+
+        if (name == NULL) {
+            break;
+        }
+        memset(prof, 0, sizeof(prof));
+        bench_tcp_sink(&prof[0], tcp_bytes);
+        bench_tcp_source(&prof[1], tcp_bytes, 0U, false);
+        snprintf(label[0], sizeof(label[0]), "%s rx", name);
+        snprintf(label[1], sizeof(label[1]), "%s tx", name);
+        prof[0].name = label[0];
+        prof[1].name = label[1];
+        bench_print(&prof[0]);
+        bench_print(&prof[1]);
+    }
+    (void)fw_mem_profile(0U);
+
+    /* Raw frames on socket 0 with the whole buffer memory, looped back by
+     * the model: payload counts both directions */
+    fprintf(stdout, "\nMACRAW loopback (socket 0, %u B frames)\n", BENCH_MACRAW_LEN);
+    bench_print_header("batch");
+    for (uint8_t batch = 1U; batch <= 8U; batch = (uint8_t)(batch * 8U)) {
+        bench_run_t raw;
+        char label[32];
+
+        memset(&raw, 0, sizeof(raw));
+        snprintf(label, sizeof(label), "macraw x%u", batch);
+        raw.name = label;
+        w5500_sim_reset_stats();
+        raw.elapsed_ns = bench_now_ns();
+        raw.payload = fw_macraw_loop(tcp_bytes, BENCH_MACRAW_LEN, batch);
+        raw.elapsed_ns = bench_now_ns() - raw.elapsed_ns;
+        w5500_sim_get_stats(&raw.sim);
+        bench_print(&raw);
+    }
+
+    fprintf(stdout, "SPI B/B: SPI bytes per payload byte; ovh: header + register bytes only;\n"
+                    "link Mb/s: payload rate the SPI alone allows at %.1f MHz SCK\n",
+            bench_sck_hz / 1e6);
+
+    bool ok = bench_hup_shared();
+
+    w5500_sim_stop();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,519 @@
+/**
+ * @file    w5500_sim_fw.c
+ * @brief   Firmware side of the host W5500 bench: HAL/RTOS port and workloads
+ *
+ * @details Built like the firmware. The SPI2 HAL calls and the PB12 chip
+ *          select land in the W5500 model (w5500_sim.c); PA8 reads the
+ *          model's INT line. The scheduler is reported as not running, so
+ *          the SPI bus manager takes its single-context path (polled bursts,
+ *          no mutex): every workload runs on one host thread, like one
+ *          firmware task owning the chip.
+ *
+ *          Workloads wait the way a socket owner does with w5500_irq: block
+ *          until INT falls, then read and clear Sn_IR. The chip is not
+ *          polled between events, so the SPI traffic counted by the model
+ *          is what the stack itself needs per payload byte. The TCP sink
+ *          waits through w5500_socket_poll() like a multi-socket task.
+ *
+ *          Must not include <unistd.h> or <sys/socket.h>: the ioLibrary
+ *          names are remapped to wiz_* here (w5500_sim_iolib.h).
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "w5500_sim.h"
+#include "w5500_sim_fw.h"
+
+#include "w5500_spi.h"
+#include "w5500_socket.h"
+#include "binlog.h"
+
+/*============================================================================*/
+/*                         PRIVATE DEFINES                                    */
+/*============================================================================*/
+
+#define FW_SOCK_UDP             0U
+/* TCP runs use the application socket that the memory profiles size */
+#define FW_SOCK_SINK            2U
+#define FW_SOCK_SOURCE          2U
+
+/* fw_tcp_hup_shared(): queue until no room for this long, wait this long
+ * for the model to close the socket after the reset */
+#define FW_STALL_US             200000U
+#define FW_CLOSE_WAIT_US        1000000U
+
+/* Safety net if an INT edge is missed: re-check Sn_IR at least this often */
+#define FW_WAIT_MAX_US          1000U
+
+#define FW_BUF_SIZE             16384U
+
+#define FW_MACRAW_ETHERTYPE     0x88B5U     /* IEEE local experimental */
+#define FW_MACRAW_BATCH         8U
+
+/*============================================================================*/
+/*                         INT LINE (EXTI STAND-IN)                           */
+/*============================================================================*/
+
+static pthread_mutex_t fw_int_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  fw_int_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t        fw_int_edges;
+
+/* Called by the model on every INT falling edge */
+static void fw_int_handler(void)
+{
+    pthread_mutex_lock(&fw_int_lock);
+    fw_int_edges++;
+    pthread_cond_broadcast(&fw_int_cond);
+    pthread_mutex_unlock(&fw_int_lock);
+}
+
+static uint32_t fw_int_seq(void)
+{
+    uint32_t seq;
+
+    pthread_mutex_lock(&fw_int_lock);
+    seq = fw_int_edges;
+    pthread_mutex_unlock(&fw_int_lock);
+    return seq;
+}
+
+static void fw_int_wait(uint32_t seq)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += FW_WAIT_MAX_US * 1000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&fw_int_lock);
+    while ((fw_int_edges == seq) &&
+           (pthread_cond_timedwait(&fw_int_cond, &fw_int_lock, &deadline) == 0)) {
+    }
+    pthread_mutex_unlock(&fw_int_lock);
+}
+
+/**
+ * @brief Stand-in for w5500_irq_wait(): block until one of @p events is
+ *        pending on the socket, clear it on the chip and return it
+ */
+static uint8_t fw_wait_event(uint8_t sn, uint8_t events)
+{
+    for (;;) {
+        uint32_t seq = fw_int_seq();
+        uint8_t ir = getSn_IR(sn) & events;
+
+        if (ir != 0U) {
+            setSn_IR(sn, ir);
+            return ir;
+        }
+        fw_int_wait(seq);
+    }
+}
+
+/*============================================================================*/
+/*                         HAL / CMSIS-RTOS2 PORT                             */
+/*============================================================================*/
+
+static uint64_t fw_now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
+
+void binlog_write(uint16_t fmt_id, uint8_t nargs, const uint32_t *args)
+{
+    (void)fmt_id; (void)nargs; (void)args;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    if ((GPIOx == W5500_CS_GPIO_Port) && (GPIO_Pin == W5500_CS_Pin)) {
+        w5500_sim_cs(PinState == GPIO_PIN_RESET);
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    if ((GPIOx == W5500_INT_GPIO_Port) && (GPIO_Pin == W5500_INT_Pin)) {
+        return w5500_sim_int_asserted() ? GPIO_PIN_RESET : GPIO_PIN_SET;
+    }
+    return GPIO_PIN_RESET;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(fw_now_us() / 1000ULL);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    struct timespec ts = { .tv_sec = Delay / 1000U, .tv_nsec = (long)(Delay % 1000U) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)hspi; (void)Timeout;
+    w5500_sim_spi(pData, NULL, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)hspi; (void)Timeout;
+    w5500_sim_spi(NULL, pData, Size);
+    return HAL_OK;
+}
+
+/* Single firmware context: the bus manager neither locks nor uses DMA */
+osKernelState_t osKernelGetState(void)
+{
+    return osKernelInactive;
+}
+
+/* The host bench services INT itself (fw_wait_event); only the chip side of
+ * w5500_irq_init() is needed: unmask the dispatched socket events */
+void w5500_irq_init(void)
+{
+    for (uint8_t sn = 0; sn < W5500_MAX_SOCKET; sn++) {
+        setSn_IMR(sn, Sn_IR_CON | Sn_IR_DISCON | Sn_IR_RECV);
+    }
+    setSIMR(0xFFU);
+}
+
+/* Link-time stubs for spi.c (init, DMA and RTOS paths never taken here) */
+void Error_Handler(void) { abort(); }
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size) { (void)hspi; (void)pData; (void)Size; return HAL_ERROR; }
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size) { (void)hspi; (void)pData; (void)Size; return HAL_ERROR; }
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) { (void)hdma; return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma) { (void)hdma; return HAL_OK; }
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) { (void)GPIOx; (void)GPIO_Init; }
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin) { (void)GPIOx; (void)GPIO_Pin; }
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) { (void)IRQn; (void)PreemptPriority; (void)SubPriority; }
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+osMutexId_t osMutexNew(const osMutexAttr_t *attr) { (void)attr; return NULL; }
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout) { (void)mutex_id; (void)timeout; return osOK; }
+osStatus_t osMutexRelease(osMutexId_t mutex_id) { (void)mutex_id; return osOK; }
+osThreadId_t osThreadGetId(void) { return NULL; }
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags) { (void)thread_id; return flags; }
+uint32_t osThreadFlagsClear(uint32_t flags) { (void)flags; return 0U; }
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout) { (void)flags; (void)options; (void)timeout; return (uint32_t)osFlagsErrorTimeout; }
+uint32_t osKernelGetTickCount(void) { return HAL_GetTick(); }
+osStatus_t osDelay(uint32_t ticks) { HAL_Delay(ticks); return osOK; }
+
+/* No dispatcher latches events here: w5500_socket_poll() finds them through
+ * SIR/Sn_IR and sleeps on the INT line between passes */
+uint32_t w5500_irq_wait(uint8_t sock_num, uint32_t events, uint32_t timeout)
+{
+    (void)sock_num; (void)events; (void)timeout;
+    return 0U;
+}
+
+/* SENDOK stays with the pollers: w5500_socket_send_async() runs on
+ * w5500_socket_send_poll() here */
+bool w5500_irq_unmask(uint8_t sock_num, uint8_t events)
+{
+    (void)sock_num; (void)events;
+    return false;
+}
+
+void w5500_irq_mask(uint8_t sock_num, uint8_t events)
+{
+    (void)sock_num; (void)events;
+}
+
+uint32_t w5500_irq_wait_any(uint8_t sock_mask, uint32_t timeout)
+{
+    (void)sock_mask;
+    if (timeout != 0U) {
+        fw_int_wait(fw_int_seq());
+    }
+    return 0U;
+}
+
+uint32_t w5500_irq_get_stamp(uint8_t sock_num)
+{
+    (void)sock_num;
+    return 0U;
+}
+
+/*============================================================================*/
+/*                         WORKLOADS                                          */
+/*============================================================================*/
+
+static uint8_t fw_buf[FW_BUF_SIZE];
+
+const char *fw_mem_profile(uint8_t profile)
+{
+    const w5500_mem_layout_t *layout = w5500_socket_get_profile((w5500_mem_profile_t)profile);
+
+    if ((layout == NULL) || (w5500_socket_apply_layout(layout) != W5500_SOCK_OK)) {
+        return NULL;
+    }
+    return layout->name;
+}
+
+uint64_t fw_macraw_loop(uint64_t total, uint16_t len, uint8_t batch)
+{
+    w5500_macraw_frame_t frames[FW_MACRAW_BATCH];
+    w5500_macraw_rx_t slots[FW_MACRAW_BATCH];
+    uint64_t sent = 0;
+    uint64_t moved = 0;
+
+    if (batch > FW_MACRAW_BATCH) {
+        batch = FW_MACRAW_BATCH;
+    }
+    if (len > W5500_MACRAW_MTU) {
+        len = W5500_MACRAW_MTU;
+    }
+    if (w5500_socket_macraw_open(FW_MACRAW_ETHERTYPE, 0U) != W5500_SOCK_OK) {
+        return 0;
+    }
+    for (uint8_t i = 0; i < batch; i++) {
+        frames[i] = (w5500_macraw_frame_t){ .dst = NULL, .data = fw_buf, .len = len };
+        /* Every slot shares the buffer: only the SPI traffic matters here */
+        slots[i] = (w5500_macraw_rx_t){ .buf = fw_buf + sizeof(fw_buf) / 2U,
+                                        .size = (uint16_t)(sizeof(fw_buf) / 2U) };
+    }
+    while (sent < total) {
+        int32_t n = w5500_socket_macraw_send_batch(frames, batch);
+        if (n < 0) {
+            break;
+        }
+        sent += (uint64_t)n * len;
+        moved += (uint64_t)n * len;
+        /* Drain before the next batch so the loopback never overruns */
+        for (int32_t got = 0; got < n; ) {
+            int32_t r = w5500_socket_macraw_recv_batch(slots, batch);
+            if (r <= 0) {
+                break;
+            }
+            for (int32_t i = 0; i < r; i++) {
+                moved += slots[i].len;
+            }
+            got += r;
+        }
+    }
+    (void)w5500_socket_macraw_close();
+    return moved;
+}
+
+size_t fw_stats_dump(uint8_t *buf, size_t size)
+{
+    return w5500_socket_stats_dump(buf, size);
+}
+
+int fw_init(void)
+{
+    w5500_sim_set_int_handler(fw_int_handler);
+    hspi2.Instance = SPI2;
+
+    w5500_spi_init();
+    if (getVERSIONR() != 0x04U) {
+        return -1;
+    }
+    return 0;
+}
+
+static bool fw_tcp_accept(uint8_t sn, uint16_t port)
+{
+    if ((w5500_socket_open(sn, W5500_SOCK_TCP, port) != W5500_SOCK_OK) ||
+        (w5500_socket_listen(sn) != W5500_SOCK_OK)) {
+        return false;
+    }
+    return (fw_wait_event(sn, Sn_IR_CON | Sn_IR_DISCON) & Sn_IR_CON) != 0U;
+}
+
+void fw_udp_echo(uint16_t port, uint32_t count)
+{
+    uint8_t ip[4];
+    uint16_t src_port;
+
+    if (w5500_socket_open(FW_SOCK_UDP, W5500_SOCK_UDP, port) != W5500_SOCK_OK) {
+        return;
+    }
+    while (count > 0U) {
+        (void)fw_wait_event(FW_SOCK_UDP, Sn_IR_RECV);
+        while ((count > 0U) && (w5500_socket_get_rx_buf_size(FW_SOCK_UDP) > 0U)) {
+            int32_t n = w5500_socket_recvfrom(FW_SOCK_UDP, fw_buf, sizeof(fw_buf), ip, &src_port);
+            if (n <= 0) {
+                break;
+            }
+            (void)w5500_socket_sendto(FW_SOCK_UDP, fw_buf, (uint16_t)n, ip, src_port);
+            count--;
+        }
+    }
+    (void)w5500_socket_close(FW_SOCK_UDP);
+}
+
+uint64_t fw_tcp_sink(uint16_t port)
+{
+    uint64_t total = 0;
+    uint8_t ev;
+
+    if (!fw_tcp_accept(FW_SOCK_SINK, port)) {
+        (void)w5500_socket_close(FW_SOCK_SINK);
+        return 0;
+    }
+    do {
+        uint16_t pending;
+        w5500_pollfd_t pfd = { .sock_num = FW_SOCK_SINK, .events = W5500_POLLIN | W5500_POLLHUP };
+
+        (void)w5500_socket_poll(&pfd, 1U, osWaitForever);
+        ev = pfd.revents;
+        while ((pending = w5500_socket_get_rx_buf_size(FW_SOCK_SINK)) > 0U) {
+            int32_t n = w5500_socket_recv(FW_SOCK_SINK, fw_buf,
+                                          (pending < sizeof(fw_buf)) ? pending : (uint16_t)sizeof(fw_buf));
+            if (n <= 0) {
+                break;
+            }
+            total += (uint64_t)n;
+        }
+    } while ((ev & W5500_POLLHUP) == 0U);
+
+    (void)w5500_socket_close(FW_SOCK_SINK);
+    return total;
+}
+
+uint64_t fw_tcp_source(uint16_t port, uint64_t total, uint16_t chunk)
+{
+    uint64_t sent = 0;
+
+    for (uint32_t i = 0; i < sizeof(fw_buf); i++) {
+        fw_buf[i] = (uint8_t)('0' + (i % 64U));
+    }
+    if (!fw_tcp_accept(FW_SOCK_SOURCE, port)) {
+        (void)w5500_socket_close(FW_SOCK_SOURCE);
+        return 0;
+    }
+    if (chunk == 0U) {
+        /* Whole TX buffer per SEND: nothing is in flight yet */
+        chunk = w5500_socket_get_tx_buf_free_size(FW_SOCK_SOURCE);
+    }
+    if (chunk > sizeof(fw_buf)) {
+        chunk = sizeof(fw_buf);
+    }
+    while (sent < total) {
+        uint16_t len = ((total - sent) < chunk) ? (uint16_t)(total - sent) : chunk;
+        int32_t n = w5500_socket_send(FW_SOCK_SOURCE, fw_buf, len);
+
+        if (n < 0) {
+            break;
+        }
+        if (n == 0) {
+            /* SOCK_BUSY: the previous SEND has not completed yet */
+            sched_yield();
+            continue;
+        }
+        sent += (uint64_t)n;
+    }
+    (void)w5500_disconnect(FW_SOCK_SOURCE);
+    (void)w5500_socket_close(FW_SOCK_SOURCE);
+    return sent;
+}
+
+uint64_t fw_tcp_source_async(uint16_t port, uint64_t total, uint16_t chunk)
+{
+    uint64_t sent = 0;
+    w5500_send_token_t token = 0;
+
+    if (chunk > sizeof(fw_buf)) {
+        chunk = sizeof(fw_buf);
+    }
+    for (uint32_t i = 0; i < sizeof(fw_buf); i++) {
+        fw_buf[i] = (uint8_t)('0' + (i % 64U));
+    }
+    if (!fw_tcp_accept(FW_SOCK_SOURCE, port)) {
+        (void)w5500_socket_close(FW_SOCK_SOURCE);
+        return 0;
+    }
+    while (sent < total) {
+        uint16_t len = ((total - sent) < chunk) ? (uint16_t)(total - sent) : chunk;
+        int32_t n = w5500_socket_send_async(FW_SOCK_SOURCE, fw_buf, len, &token);
+
+        if (n < 0) {
+            break;
+        }
+        if (n == 0) {
+            /* Ring full: the SEND in flight has to complete first */
+            sched_yield();
+            continue;
+        }
+        sent += (uint64_t)n;
+    }
+    (void)w5500_socket_send_wait(FW_SOCK_SOURCE, token, osWaitForever);
+    (void)w5500_disconnect(FW_SOCK_SOURCE);
+    (void)w5500_socket_close(FW_SOCK_SOURCE);
+    return sent;
+}
+
+int fw_tcp_hup_shared(uint16_t port, void (*reset_peer)(void), int8_t *send_ret)
+{
+    w5500_send_token_t token = 0;
+    w5500_pollfd_t pfd = { .sock_num = FW_SOCK_SOURCE, .events = W5500_POLLIN | W5500_POLLHUP };
+    uint64_t idle_since;
+    int ret = 0;
+
+    *send_ret = W5500_SOCK_OK;
+    if (!fw_tcp_accept(FW_SOCK_SOURCE, port)) {
+        (void)w5500_socket_close(FW_SOCK_SOURCE);
+        return -1;
+    }
+
+    /* The peer does not read: queue until its window holds a SEND on the wire */
+    idle_since = fw_now_us();
+    while ((fw_now_us() - idle_since) < FW_STALL_US) {
+        int32_t n = w5500_socket_send_async(FW_SOCK_SOURCE, fw_buf, sizeof(fw_buf) / 4U, &token);
+        if (n < 0) {
+            break;
+        }
+        if (n > 0) {
+            idle_since = fw_now_us();
+        }
+        sched_yield();
+    }
+    if (w5500_socket_send_status(FW_SOCK_SOURCE, token) != W5500_SOCK_BUSY) {
+        ret = -2;
+    }
+
+    if (ret == 0) {
+        uint64_t start = fw_now_us();
+
+        reset_peer();
+        /* Sn_SR only: Sn_IR (TIMEOUT) is for the two parties below */
+        while ((w5500_socket_get_status(FW_SOCK_SOURCE) != SOCK_CLOSED) &&
+               ((fw_now_us() - start) < FW_CLOSE_WAIT_US)) {
+            sched_yield();
+        }
+        if (w5500_socket_get_status(FW_SOCK_SOURCE) != SOCK_CLOSED) {
+            ret = -3;
+        }
+    }
+    if (ret == 0) {
+        /* The poller goes first, as when another task's poll wakes earlier */
+        (void)w5500_socket_poll(&pfd, 1U, 0U);
+        if ((pfd.revents & W5500_POLLHUP) == 0U) {
+            ret = -4;
+        }
+        /* The sender must still learn why its data will never be ACKed */
+        *send_ret = w5500_socket_send_wait(FW_SOCK_SOURCE, token, 1000U);
+        if ((ret == 0) && (*send_ret != W5500_SOCK_TIMEOUT)) {
+            ret = -5;
+        }
+    }
+    (void)w5500_socket_close(FW_SOCK_SOURCE);
+    return ret;
+}
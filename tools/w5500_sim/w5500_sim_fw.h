@@ -0,0 +1,96 @@
+/**
+ * @file    w5500_sim_fw.h
+ * @brief   Firmware side of the host W5500 bench
+ *
+ * @details Implemented in w5500_sim_fw.c, which is built like the firmware
+ *          (HAL and ioLibrary headers, ioLibrary names remapped by
+ *          w5500_sim_iolib.h). The Linux peer side in w5500_sim_bench.c only
+ *          sees this interface, so the two never share a header that
+ *          declares socket().
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _W5500_SIM_FW_H_
+#define _W5500_SIM_FW_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Bring up the firmware stack on the simulator: w5500_spi_init(),
+ *        a loopback-friendly netinfo and the interrupt masks
+ * @return 0 on success, -1 if the chip did not answer
+ */
+int fw_init(void);
+
+/**
+ * @brief Apply socket memory profile @p profile (w5500_mem_profile_t)
+ * @return Profile name, NULL past the last profile or if it was refused
+ */
+const char *fw_mem_profile(uint8_t profile);
+
+/**
+ * @brief Serialise the socket counters (w5500_socket_stats_dump())
+ * @return Bytes written to @p buf
+ */
+size_t fw_stats_dump(uint8_t *buf, size_t size);
+
+/**
+ * @brief UDP echo server on socket 0: answer @p count datagrams, then close
+ */
+void fw_udp_echo(uint16_t port, uint32_t count);
+
+/**
+ * @brief TCP discard server on socket 2: accept one connection and read
+ *        until the peer closes
+ * @return Payload bytes received
+ */
+uint64_t fw_tcp_sink(uint16_t port);
+
+/**
+ * @brief TCP source server on socket 2: accept one connection, send
+ *        @p total bytes in @p chunk sized calls (0 = the socket's TX buffer
+ *        size), then disconnect
+ * @return Payload bytes accepted by send()
+ */
+uint64_t fw_tcp_source(uint16_t port, uint64_t total, uint16_t chunk);
+
+/**
+ * @brief Same as fw_tcp_source() through w5500_socket_send_async(): segments
+ *        are queued while the previous SEND is still on the wire
+ * @return Payload bytes queued
+ */
+uint64_t fw_tcp_source_async(uint16_t port, uint64_t total, uint16_t chunk);
+
+/**
+ * @brief Poller and sender sharing socket 2 when it times out: accept one
+ *        connection, queue data with w5500_socket_send_async() until the
+ *        peer's window stalls the SEND, call @p reset_peer (abort the
+ *        connection), then poll the socket for W5500_POLLHUP before the
+ *        sender looks at its completion
+ * @param send_ret  w5500_socket_send_wait() result for the last token
+ * @return 0 if the poller saw POLLHUP and the sender W5500_SOCK_TIMEOUT;
+ *         -1 no connection, -2 the SEND never stalled, -3 the socket did
+ *         not close, -4 no POLLHUP, -5 wrong send result
+ */
+int fw_tcp_hup_shared(uint16_t port, void (*reset_peer)(void), int8_t *send_ret);
+
+/**
+ * @brief MACRAW on socket 0 through the model's loopback: send @p total
+ *        payload bytes in @p len byte frames, @p batch frames per
+ *        w5500_socket_macraw_send_batch(), and receive them back
+ * @return Payload bytes sent plus received, 0 if MACRAW could not be opened
+ */
+uint64_t fw_macraw_loop(uint64_t total, uint16_t len, uint8_t batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _W5500_SIM_FW_H_ */
@@ -0,0 +1,32 @@
+/**
+ * @file    w5500_sim_iolib.h
+ * @brief   Host build: keep the ioLibrary socket API off the libc names
+ *
+ * @details The ioLibrary names its socket API after BSD sockets (socket,
+ *          close, send, recv, ...). Linked into a Linux executable those
+ *          definitions would replace libc's for every caller, including the
+ *          simulator itself. This header is force-included (-include) into
+ *          the firmware translation units only, so the ioLibrary and its
+ *          callers agree on prefixed names and libc stays intact.
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#ifndef _W5500_SIM_IOLIB_H_
+#define _W5500_SIM_IOLIB_H_
+
+#define socket          wiz_socket
+#define close           wiz_close
+#define listen          wiz_listen
+#define connect         wiz_connect
+#define disconnect      wiz_disconnect
+#define send            wiz_send
+#define recv            wiz_recv
+#define sendto          wiz_sendto
+#define recvfrom        wiz_recvfrom
+#define ctlsocket       wiz_ctlsocket
+#define setsockopt      wiz_setsockopt
+#define getsockopt      wiz_getsockopt
+
+#endif /* _W5500_SIM_IOLIB_H_ */
@@ -0,0 +1,308 @@
+/**
+ * @file    w5500_spi_bench.c
+ * @brief   Host-side SPI mock: polled vs DMA W5500 burst transport
+ *
+ * @details Links the real Middlewares/In_House/eth/w5500_spi.c and the SPI bus
+ *          manager in Core/Src/spi.c against a
+ *          mocked HAL SPI/GPIO and CMSIS-RTOS2 layer that keeps a simulated
+ *          clock. Each mocked call charges the CPU for the work it really
+ *          does on the STM32G431 (register setup, polling loop, ISR + context
+ *          switch); a DMA transfer advances wall time without charging the
+ *          CPU, so the difference shows up as CPU time available to other
+ *          tasks.
+ *
+ *          The workload repeats what WIZCHIP_READ_BUF/WIZCHIP_WRITE_BUF do for
+ *          one socket payload: CS low, 3-byte address/control phase, data
+ *          burst, CS high.
+ *
+ *          Build (from the repository root, ioLibrary submodule checked out):
+ *
+ *            gcc -O2 -std=gnu11 -DSTM32G431xx -DUSE_HAL_DRIVER \
+ *                -D'SPI_BUS_CYCLES()=0U' \
+ *                -ICore/Inc -IMiddlewares/In_House/eth \
+ *                -IMiddlewares/Third_Party/ioLibrary_Driver/Ethernet \
+ *                -IMiddlewares/Third_Party/ioLibrary_Driver/Ethernet/W5500 \
+ *                -IDrivers/STM32G4xx_HAL_Driver/Inc \
+ *                -IDrivers/CMSIS/Device/ST/STM32G4xx/Include \
+ *                -IDrivers/CMSIS/Include \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/CMSIS_RTOS_V2 \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/include \
+ *                -IMiddlewares/Third_Party/FreeRTOS/Source/portable/GCC/ARM_CM4F \
+ *                tools/w5500_spi_bench/w5500_spi_bench.c \
+ *                Middlewares/In_House/eth/w5500_spi.c Core/Src/spi.c \
+ *                -o w5500_spi_bench
+ *
+ *            ./w5500_spi_bench [spi_prescaler]
+ *
+ * @author  Narudol T.
+ * @date    2025-06-10
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "w5500_spi.h"
+#include "binlog.h"
+
+/*============================================================================*/
+/*                         TIMING MODEL (STM32G431 @ 144 MHz)                 */
+/*============================================================================*/
+
+#define BENCH_SYSCLK_HZ         144000000ULL
+#define BENCH_CYCLES_TO_NS(c)   (((c) * 1000000000ULL) / BENCH_SYSCLK_HZ)
+
+#define BENCH_GPIO_CYCLES       20    /* HAL_GPIO_WritePin call             */
+#define BENCH_HAL_POLL_CYCLES   150   /* HAL_SPI_Transmit/Receive entry/exit */
+#define BENCH_HAL_DMA_CYCLES    450   /* HAL_SPI_*_DMA channel programming  */
+#define BENCH_ISR_CYCLES        300   /* DMA IRQ + HAL callback + notify    */
+#define BENCH_CTXSW_CYCLES      250   /* PendSV task switch                 */
+#define BENCH_RTOS_CALL_CYCLES  60    /* osThreadFlags* / osThreadGetId     */
+
+#define BENCH_BYTES_TOTAL       (256U * 1024U)
+
+/*============================================================================*/
+/*                         SIMULATED CLOCK                                    */
+/*============================================================================*/
+
+static uint64_t sim_now_ns;     /* wall clock                               */
+static uint64_t sim_cpu_ns;     /* time the CPU spent on the transport      */
+static uint64_t sim_byte_ns;    /* SPI byte time for the selected prescaler */
+static uint32_t sim_cs_edges;
+static uint32_t sim_log_records;
+
+static uint32_t sim_thread_flags;
+static uint64_t sim_dma_done_ns;
+static bool     sim_dma_active;
+
+static void sim_cpu(uint64_t cycles)
+{
+    uint64_t ns = BENCH_CYCLES_TO_NS(cycles);
+    sim_now_ns += ns;
+    sim_cpu_ns += ns;
+}
+
+/*============================================================================*/
+/*                         HAL / CMSIS-RTOS2 MOCKS                            */
+/*============================================================================*/
+
+static DMA_HandleTypeDef mock_dma_rx;
+static DMA_HandleTypeDef mock_dma_tx;
+
+wiz_NetInfo g_network_info;
+
+void binlog_write(uint16_t fmt_id, uint8_t nargs, const uint32_t *args)
+{
+    (void)fmt_id; (void)nargs; (void)args;
+    sim_log_records++;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    (void)GPIOx; (void)GPIO_Pin; (void)PinState;
+    sim_cs_edges++;
+    sim_cpu(BENCH_GPIO_CYCLES);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    sim_now_ns += (uint64_t)Delay * 1000000ULL;
+}
+
+/* Polled transfers: the CPU spins in the HAL loop for the whole burst */
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)hspi; (void)pData; (void)Timeout;
+    sim_cpu(BENCH_HAL_POLL_CYCLES);
+    sim_now_ns += Size * sim_byte_ns;
+    sim_cpu_ns += Size * sim_byte_ns;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    return HAL_SPI_Transmit(hspi, pData, Size, Timeout);
+}
+
+/* DMA transfers: the CPU only programs the channels, the bus runs alone */
+static HAL_StatusTypeDef mock_dma_start(uint16_t Size)
+{
+    sim_cpu(BENCH_HAL_DMA_CYCLES);
+    sim_dma_done_ns = sim_now_ns + Size * sim_byte_ns;
+    sim_dma_active = true;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *hspi, const uint8_t *pData, uint16_t Size)
+{
+    (void)hspi; (void)pData;
+    return mock_dma_start(Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Receive_DMA(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size)
+{
+    (void)hspi; (void)pData;
+    return mock_dma_start(Size);
+}
+
+HAL_StatusTypeDef HAL_SPI_Abort(SPI_HandleTypeDef *hspi)
+{
+    (void)hspi;
+    sim_dma_active = false;
+    return HAL_OK;
+}
+
+osKernelState_t osKernelGetState(void)
+{
+    return osKernelRunning;
+}
+
+osThreadId_t osThreadGetId(void)
+{
+    sim_cpu(BENCH_RTOS_CALL_CYCLES);
+    return (osThreadId_t)&sim_thread_flags;
+}
+
+uint32_t osThreadFlagsSet(osThreadId_t thread_id, uint32_t flags)
+{
+    (void)thread_id;
+    sim_cpu(BENCH_RTOS_CALL_CYCLES);
+    sim_thread_flags |= flags;
+    return sim_thread_flags;
+}
+
+uint32_t osThreadFlagsClear(uint32_t flags)
+{
+    uint32_t old = sim_thread_flags;
+    sim_cpu(BENCH_RTOS_CALL_CYCLES);
+    sim_thread_flags &= ~flags;
+    return old;
+}
+
+/* The waiting task is switched out; the CPU is idle (free for other tasks)
+ * until the DMA completion interrupt fires and switches it back in. */
+uint32_t osThreadFlagsWait(uint32_t flags, uint32_t options, uint32_t timeout)
+{
+    uint32_t got;
+    (void)options; (void)timeout;
+
+    sim_cpu(BENCH_RTOS_CALL_CYCLES + BENCH_CTXSW_CYCLES);
+    if (sim_dma_active) {
+        if (sim_now_ns < sim_dma_done_ns) {
+            sim_now_ns = sim_dma_done_ns;
+        }
+        sim_dma_active = false;
+        sim_cpu(BENCH_ISR_CYCLES);
+        HAL_SPI_TxRxCpltCallback(&hspi2);
+        sim_cpu(BENCH_CTXSW_CYCLES);
+    }
+    got = sim_thread_flags & flags;
+    if (got == 0U) {
+        return (uint32_t)osFlagsErrorTimeout;
+    }
+    sim_thread_flags &= ~got;
+    return got;
+}
+
+/* Link-time stubs for the init path, never called by the bench */
+void reg_wizchip_cs_cbfunc(void (*cs_sel)(void), void (*cs_desel)(void)) { (void)cs_sel; (void)cs_desel; }
+void reg_wizchip_spi_cbfunc(uint8_t (*spi_rb)(void), void (*spi_wb)(uint8_t wb)) { (void)spi_rb; (void)spi_wb; }
+void reg_wizchip_spiburst_cbfunc(void (*spi_rb)(uint8_t *pBuf, uint16_t len),
+                                 void (*spi_wb)(uint8_t *pBuf, uint16_t len)) { (void)spi_rb; (void)spi_wb; }
+int8_t wizchip_init(uint8_t *txsize, uint8_t *rxsize) { (void)txsize; (void)rxsize; return 0; }
+void eth_config_init_bringup(void) {}
+bool eth_config_set_netinfo(const wiz_NetInfo *net_info) { (void)net_info; return true; }
+void eth_config_invalidate(void) {}
+void reg_wizchip_cris_cbfunc(void (*cris_en)(void), void (*cris_ex)(void)) { (void)cris_en; (void)cris_ex; }
+void w5500_irq_init(void) {}
+osMutexId_t osMutexNew(const osMutexAttr_t *attr) { (void)attr; return NULL; }
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout) { (void)mutex_id; (void)timeout; return osOK; }
+osStatus_t osMutexRelease(osMutexId_t mutex_id) { (void)mutex_id; return osOK; }
+
+/* spi.c: MX_SPIx_Init / MSP code is linked but never called by the bench */
+void Error_Handler(void) { abort(); }
+HAL_StatusTypeDef HAL_SPI_Init(SPI_HandleTypeDef *hspi) { (void)hspi; return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) { (void)hdma; return HAL_OK; }
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma) { (void)hdma; return HAL_OK; }
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) { (void)GPIOx; (void)GPIO_Init; }
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin) { (void)GPIOx; (void)GPIO_Pin; }
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority) { (void)IRQn; (void)PreemptPriority; (void)SubPriority; }
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+
+/*============================================================================*/
+/*                         WORKLOAD                                           */
+/*============================================================================*/
+
+typedef struct {
+    double mbit_s;      /* payload throughput                  */
+    double cpu_pct;     /* CPU share consumed by the transport */
+} bench_result_t;
+
+static uint8_t bench_buf[16384];
+
+/* One socket payload transfer, framed the way WIZCHIP_READ_BUF does it */
+static void bench_burst(bool write, uint16_t len)
+{
+    uint8_t hdr[3] = {0x00, 0x00, 0x00};
+
+    w5500_cs_select();
+    w5500_spi_writeburst(hdr, sizeof(hdr));
+    if (write) {
+        w5500_spi_writeburst(bench_buf, len);
+    } else {
+        w5500_spi_readburst(bench_buf, len);
+    }
+    w5500_cs_deselect();
+}
+
+static bench_result_t bench_run(bool use_dma, bool write, uint16_t len)
+{
+    bench_result_t res;
+    uint32_t bursts = BENCH_BYTES_TOTAL / len;
+
+    hspi2.Instance = SPI2;
+    hspi2.hdmarx = use_dma ? &mock_dma_rx : NULL;
+    hspi2.hdmatx = use_dma ? &mock_dma_tx : NULL;
+    sim_now_ns = 0;
+    sim_cpu_ns = 0;
+
+    for (uint32_t i = 0; i < bursts; i++) {
+        bench_burst(write, len);
+    }
+
+    res.mbit_s  = (double)bursts * len * 8.0 * 1000.0 / (double)sim_now_ns;
+    res.cpu_pct = 100.0 * (double)sim_cpu_ns / (double)sim_now_ns;
+    return res;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint16_t sizes[] = {16, 64, 128, 256, 512, 1024, 1460, 2048, 8192};
+    uint32_t prescaler = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 8U;
+
+    if (prescaler < 2U) {
+        prescaler = 2U;
+    }
+    sim_byte_ns = (8ULL * prescaler * 1000000000ULL) / BENCH_SYSCLK_HZ;
+
+    fprintf(stdout, "W5500 SPI2 transport, SYSCLK %llu MHz, prescaler %lu (SCK %.2f MHz)\n",
+            (unsigned long long)(BENCH_SYSCLK_HZ / 1000000ULL), (unsigned long)prescaler,
+            (double)BENCH_SYSCLK_HZ / prescaler / 1e6);
+    fprintf(stdout, "%6s %5s | %10s %7s | %10s %7s\n",
+            "bytes", "dir", "poll Mb/s", "CPU%", "dma Mb/s", "CPU%");
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (int dir = 0; dir < 2; dir++) {
+            bench_result_t poll = bench_run(false, dir != 0, sizes[i]);
+            bench_result_t dma  = bench_run(true,  dir != 0, sizes[i]);
+            fprintf(stdout, "%6u %5s | %10.2f %6.1f%% | %10.2f %6.1f%%\n",
+                    sizes[i], dir ? "write" : "read",
+                    poll.mbit_s, poll.cpu_pct, dma.mbit_s, dma.cpu_pct);
+        }
+    }
+
+    fprintf(stdout, "CS edges: %lu, log records on the transfer path: %lu\n",
+            (unsigned long)sim_cs_edges, (unsigned long)sim_log_records);
+    return 0;
+}
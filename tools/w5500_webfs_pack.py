@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Pack a directory of web assets into a flash image for w5500_webfs.
+
+Every file under the web directory becomes one entry of a read-only
+filesystem compiled into the firmware (Middlewares/In_House/eth/exc/
+w5500_webfs.h):
+
+  - each body is gzip-compressed (level 9, no timestamp, so the output is
+    reproducible) and stored compressed when that is smaller; the server
+    sends the stored bytes as they are, with Content-Encoding: gzip,
+  - identical bodies are stored once, whatever their paths,
+  - "index.html" is also reachable as its directory ("/", "/docs/"),
+  - the index is sorted by path (bytewise, like strcmp) for a binary
+    search at run time,
+  - each entry carries a strong ETag: the first 64 bits of the SHA-256 of
+    the stored bytes, so it changes exactly when the response body does.
+
+The output is a C file to commit next to w5500_webfs.c; regenerate it
+whenever a source file changes.
+
+Usage:
+    w5500_webfs_pack.py Middlewares/In_House/eth/exc/web \\
+        -o Middlewares/In_House/eth/exc/w5500_webfs_data.c
+"""
+
+import argparse
+import gzip
+import hashlib
+import os
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html; charset=utf-8",
+    ".htm": "text/html; charset=utf-8",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".txt": "text/plain; charset=utf-8",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".gif": "image/gif",
+    ".ico": "image/x-icon",
+}
+DEFAULT_TYPE = "application/octet-stream"
+INDEX_NAME = "index.html"
+BYTES_PER_LINE = 16
+
+
+def collect(root):
+    """Return [(url path, file path)] for every file under root."""
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for name in sorted(filenames):
+            if name.startswith("."):
+                continue
+            full = os.path.join(dirpath, name)
+            rel = os.path.relpath(full, root).replace(os.sep, "/")
+            files.append(("/" + rel, full))
+    return files
+
+
+def pack(root, aliases):
+    """Return (entries sorted by path, list of unique stored bodies)."""
+    bodies = []     # [(stored bytes, gzip, etag)]
+    by_digest = {}  # sha256 of stored bytes -> index in bodies
+    entries = []    # [(path, type, body index, raw length)]
+
+    for path, full in collect(root):
+        with open(full, "rb") as f:
+            raw = f.read()
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        is_gzip = len(packed) < len(raw)
+        stored = packed if is_gzip else raw
+        digest = hashlib.sha256(stored).digest()
+        if digest not in by_digest:
+            by_digest[digest] = len(bodies)
+            bodies.append((stored, is_gzip, digest[:8].hex()))
+        ext = os.path.splitext(path)[1].lower()
+        ctype = CONTENT_TYPES.get(ext, DEFAULT_TYPE)
+        body = by_digest[digest]
+        entries.append((path, ctype, body, len(raw)))
+        if aliases and path.rsplit("/", 1)[1] == INDEX_NAME:
+            entries.append((path[: -len(INDEX_NAME)], ctype, body, len(raw)))
+
+    paths = [e[0] for e in entries]
+    dup = {p for p in paths if paths.count(p) > 1}
+    if dup:
+        sys.exit("duplicate paths: %s" % ", ".join(sorted(dup)))
+    entries.sort(key=lambda e: e[0].encode("utf-8"))
+    return entries, bodies
+
+
+def c_string(s):
+    return '"%s"' % s.replace("\\", "\\\\").replace('"', '\\"')
+
+
+def emit(out, root, entries, bodies):
+    offsets = []
+    blob = bytearray()
+    for stored, _, _ in bodies:
+        offsets.append(len(blob))
+        blob += stored
+
+    w = out.write
+    w("/**\n")
+    w(" * @file    %s\n" % os.path.basename(out.name))
+    w(" * @brief   Web assets for w5500_webfs (generated, do not edit)\n")
+    w(" *\n")
+    w(" * @details Generated by tools/w5500_webfs_pack.py from %s.\n" % root)
+    w(" *          %d paths, %d stored bodies, %d bytes of flash data.\n"
+      % (len(entries), len(bodies), len(blob)))
+    w(" */\n\n")
+    w(' #include "w5500_webfs.h"\n\n')
+
+    w(" static const uint8_t webfs_blob[%d] = {\n" % max(len(blob), 1))
+    for i, (stored, is_gzip, etag) in enumerate(bodies):
+        names = [e[0] for e in entries if e[2] == i]
+        w("     /* %s: %d bytes%s */\n"
+          % (", ".join(names), len(stored), " gzip" if is_gzip else ""))
+        for pos in range(0, len(stored), BYTES_PER_LINE):
+            chunk = stored[pos:pos + BYTES_PER_LINE]
+            w("     " + " ".join("0x%02X," % b for b in chunk) + "\n")
+    if not blob:
+        w("     0x00,\n")
+    w(" };\n\n")
+
+    w(" const w5500_webfs_file_t w5500_webfs_files[] = {\n")
+    for path, ctype, body, raw_len in entries:
+        stored, is_gzip, etag = bodies[body]
+        w("     { %s, %s, \"\\\"%s\\\"\", &webfs_blob[%d], %dU, %dU, %s },\n"
+          % (c_string(path), c_string(ctype), etag, offsets[body], len(stored),
+             raw_len, "W5500_WEBFS_GZIP" if is_gzip else "0U"))
+    w(" };\n\n")
+    w(" const uint16_t w5500_webfs_file_count = %dU;\n" % len(entries))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("root", help="directory of web assets")
+    parser.add_argument("-o", "--output", required=True, help="C file to write")
+    parser.add_argument("--no-index-alias", action="store_true",
+                        help="do not serve index.html as its directory")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.root):
+        sys.exit("%s: not a directory" % args.root)
+    entries, bodies = pack(args.root, not args.no_index_alias)
+    if len(entries) > 0xFFFF:
+        sys.exit("too many files")
+
+    with open(args.output, "w", newline="\n") as out:
+        emit(out, args.root, entries, bodies)
+
+    raw = sum(e[3] for e in entries)
+    stored = sum(len(b[0]) for b in bodies)
+    print("%d paths, %d bodies: %d bytes raw, %d bytes stored"
+          % (len(entries), len(bodies), raw, stored))
+
+
+if __name__ == "__main__":
+    main()